@@ -624,6 +624,7 @@ struct sr_input;
 struct sr_input_module;
 struct sr_output;
 struct sr_output_module;
+struct sr_output_sink;
 struct sr_transform;
 struct sr_transform_module;
 
@@ -1192,6 +1193,25 @@ enum sr_configkey {
 	/** Number of powerline cycles for ADC integration time. */
 	SR_CONF_ADC_POWERLINE_CYCLES,
 
+	/**
+	 * Number of data chunks which get read ahead of their submission
+	 * to the session. Zero disables the background read-ahead.
+	 * @arg type: uint64_t
+	 * @arg get: get current prefetch depth
+	 * @arg set: set prefetch depth
+	 */
+	SR_CONF_PREFETCH_DEPTH,
+
+	/**
+	 * Replay speed relative to the original samplerate. 1.0 replays
+	 * at the original rate, 2.0 at twice that rate, and so on. Zero
+	 * replays as fast as possible.
+	 * @arg type: double
+	 * @arg get: get current replay speed
+	 * @arg set: set replay speed
+	 */
+	SR_CONF_REPLAY_SPEED,
+
 	/* Update sr_key_info_config[] (hwdriver.c) upon changes! */
 
 	/*--- Acquisition modes, sample limiting ----------------------------*/
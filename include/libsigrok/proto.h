@@ -173,9 +173,15 @@ SR_API struct sr_input *sr_input_new(const struct sr_input_module *imod,
 		GHashTable *options);
 SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in);
 SR_API int sr_input_scan_file(const char *filename, const struct sr_input **in);
+SR_API int sr_input_scan_stream(FILE *stream, const char *filename,
+		const struct sr_input **in);
 SR_API const struct sr_input_module *sr_input_module_get(const struct sr_input *in);
 SR_API struct sr_dev_inst *sr_input_dev_inst_get(const struct sr_input *in);
 SR_API int sr_input_send(const struct sr_input *in, GString *buf);
+SR_API int sr_input_open_mapped(const struct sr_input *in, const char *filename);
+SR_API int sr_input_send_mapped(const struct sr_input *in, gboolean *done);
+SR_API int sr_input_threads_set(const struct sr_input *in,
+		unsigned int num_threads);
 SR_API int sr_input_end(const struct sr_input *in);
 SR_API int sr_input_reset(const struct sr_input *in);
 SR_API void sr_input_free(const struct sr_input *in);
@@ -200,6 +206,21 @@ SR_API int sr_output_send(const struct sr_output *o,
 		const struct sr_datafeed_packet *packet, GString **out);
 SR_API int sr_output_free(const struct sr_output *o);
 
+typedef int (*sr_output_sink_callback)(const uint8_t *data, size_t length,
+		void *cb_data);
+SR_API struct sr_output_sink *sr_output_sink_new_fd(int fd);
+SR_API struct sr_output_sink *sr_output_sink_new_file(FILE *file);
+SR_API struct sr_output_sink *sr_output_sink_new_callback(
+		sr_output_sink_callback cb, void *cb_data);
+SR_API void sr_output_sink_free(struct sr_output_sink *sink);
+SR_API const struct sr_output *sr_output_new_sink(
+		const struct sr_output_module *omod, GHashTable *params,
+		const struct sr_dev_inst *sdi, const char *filename,
+		struct sr_output_sink *sink);
+SR_API int sr_output_flush(const struct sr_output *o);
+SR_API int sr_output_threads_set(const struct sr_output *o,
+		unsigned int num_threads);
+
 /*--- transform/transform.c -------------------------------------------------*/
 
 SR_API const struct sr_transform_module **sr_transform_list(void);
@@ -236,6 +236,10 @@ static struct sr_key_info sr_key_info_config[] = {
 		"Probe factor", NULL},
 	{SR_CONF_ADC_POWERLINE_CYCLES, SR_T_FLOAT, "nplc",
 		"Number of ADC powerline cycles", NULL},
+	{SR_CONF_PREFETCH_DEPTH, SR_T_UINT64, "prefetch_depth",
+		"Prefetch depth", NULL},
+	{SR_CONF_REPLAY_SPEED, SR_T_FLOAT, "replay_speed",
+		"Replay speed", NULL},
 
 	/* Acquisition modes, sample limiting */
 	{SR_CONF_LIMIT_MSEC, SR_T_UINT64, "limit_time",
@@ -66,13 +66,14 @@ static int init(struct sr_input *in, GHashTable *options)
 	return SR_OK;
 }
 
-static int process_buffer(struct sr_input *in)
+/* Send logic data from a span, return the number of bytes consumed. */
+static size_t process_data(struct sr_input *in,
+	const uint8_t *data, size_t length)
 {
 	struct sr_datafeed_packet packet;
 	struct sr_datafeed_logic logic;
 	struct context *inc;
-	gsize chunk_size, i;
-	int chunk;
+	size_t chunk_size, chunk, i;
 
 	inc = in->priv;
 	if (!inc->started) {
@@ -91,36 +92,89 @@ static int process_buffer(struct sr_input *in)
 	logic.unitsize = inc->unitsize;
 
 	/* Cut off at multiple of unitsize. */
-	chunk_size = in->buf->len / logic.unitsize * logic.unitsize;
+	chunk_size = length / logic.unitsize * logic.unitsize;
 
 	for (i = 0; i < chunk_size; i += chunk) {
-		logic.data = in->buf->str + i;
+		logic.data = (void *)(data + i);
 		chunk = MIN(CHUNK_SIZE, chunk_size - i);
 		chunk /= logic.unitsize;
 		chunk *= logic.unitsize;
 		logic.length = chunk;
 		sr_session_send(in->sdi, &packet);
 	}
-	g_string_erase(in->buf, 0, chunk_size);
+
+	return chunk_size;
+}
+
+static int process_buffer(struct sr_input *in)
+{
+	size_t used;
+
+	used = process_data(in, (const uint8_t *)in->buf->str, in->buf->len);
+	g_string_erase(in->buf, 0, used);
 
 	return SR_OK;
 }
 
+/*
+ * Samples are sent from the caller's buffer where possible, without
+ * copying them. Only data which is not processed yet is kept in the
+ * input buffer: the first chunk, and incomplete samples at the end.
+ */
 static int receive(struct sr_input *in, GString *buf)
 {
+	struct context *inc;
+	const uint8_t *data;
+	size_t length, fill, used;
 	int ret;
 
-	g_string_append_len(in->buf, buf->str, buf->len);
+	if (!in->sdi_ready) {
+		g_string_append_len(in->buf, buf->str, buf->len);
+		/* sdi is ready, notify frontend. */
+		in->sdi_ready = TRUE;
+		return SR_OK;
+	}
+
+	inc = in->priv;
+	data = (const uint8_t *)buf->str;
+	length = buf->len;
+
+	/* Complete a pending partial sample, then send pending data. */
+	if (in->buf->len) {
+		fill = in->buf->len % inc->unitsize;
+		fill = fill ? inc->unitsize - fill : 0;
+		fill = MIN(fill, length);
+		g_string_append_len(in->buf, (const char *)data, fill);
+		data += fill;
+		length -= fill;
+		ret = process_buffer(in);
+		if (ret != SR_OK)
+			return ret;
+		if (in->buf->len) {
+			g_string_append_len(in->buf, (const char *)data, length);
+			return SR_OK;
+		}
+	}
+
+	used = process_data(in, data, length);
+	g_string_append_len(in->buf, (const char *)data + used, length - used);
 
+	return SR_OK;
+}
+
+static int receive_span(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
+{
+	*used = 0;
 	if (!in->sdi_ready) {
 		/* sdi is ready, notify frontend. */
 		in->sdi_ready = TRUE;
 		return SR_OK;
 	}
 
-	ret = process_buffer(in);
+	*used = process_data(in, data, length);
 
-	return ret;
+	return SR_OK;
 }
 
 static int end(struct sr_input *in)
@@ -174,6 +228,7 @@ SR_PRIV struct sr_input_module input_binary = {
 	.options = get_options,
 	.init = init,
 	.receive = receive,
+	.receive_span = receive_span,
 	.end = end,
 	.reset = reset,
 };
@@ -127,13 +127,15 @@ static int init(struct sr_input *in, GHashTable *options)
 	return SR_OK;
 }
 
-static int process_buffer(struct sr_input *in)
+/* Send logic data from a span, return the number of bytes consumed. */
+static size_t process_data(struct sr_input *in,
+	const uint8_t *data, size_t length)
 {
 	struct sr_datafeed_packet packet;
 	struct sr_datafeed_logic logic;
 	struct context *inc;
-	gsize chunk_size, i;
-	gsize chunk;
+	size_t chunk_size, i;
+	size_t chunk;
 	uint16_t unitsize;
 
 	inc = in->priv;
@@ -158,11 +160,11 @@ static int process_buffer(struct sr_input *in)
 	logic.unitsize = unitsize;
 
 	/* Cut off at multiple of unitsize. Avoid sending the "header". */
-	chunk_size = in->buf->len / logic.unitsize * logic.unitsize;
+	chunk_size = length / logic.unitsize * logic.unitsize;
 	chunk_size = MIN(chunk_size, inc->samples_remain * unitsize);
 
 	for (i = 0; i < chunk_size; i += chunk) {
-		logic.data = in->buf->str + i;
+		logic.data = (void *)(data + i);
 		chunk = MIN(CHUNK_SIZE, chunk_size - i);
 		if (chunk) {
 			logic.length = chunk;
@@ -170,7 +172,16 @@ static int process_buffer(struct sr_input *in)
 			inc->samples_remain -= chunk / unitsize;
 		}
 	}
-	g_string_erase(in->buf, 0, chunk_size);
+
+	return chunk_size;
+}
+
+static int process_buffer(struct sr_input *in)
+{
+	size_t used;
+
+	used = process_data(in, (const uint8_t *)in->buf->str, in->buf->len);
+	g_string_erase(in->buf, 0, used);
 
 	return SR_OK;
 }
@@ -192,6 +203,22 @@ static int receive(struct sr_input *in, GString *buf)
 	return ret;
 }
 
+static int receive_span(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
+{
+	*used = 0;
+	if (!in->sdi_ready) {
+		/* sdi is ready, notify frontend. */
+		in->sdi_ready = TRUE;
+		return SR_OK;
+	}
+
+	/* The "header" after the sample data is left to end(). */
+	*used = process_data(in, data, length);
+
+	return SR_OK;
+}
+
 static int end(struct sr_input *in)
 {
 	struct context *inc;
@@ -245,6 +272,7 @@ SR_PRIV struct sr_input_module input_chronovu_la8 = {
 	.format_match = format_match,
 	.init = init,
 	.receive = receive,
+	.receive_span = receive_span,
 	.end = end,
 	.reset = reset,
 };
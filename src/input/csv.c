@@ -22,6 +22,7 @@
 
 #include <ctype.h>
 #include <glib.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
@@ -34,6 +35,9 @@
 
 #define CHUNK_SIZE	(4 * 1024 * 1024)
 
+/* Minimum size of the text ranges which get parsed on separate threads. */
+#define PARALLEL_MIN_SIZE	(256 * 1024)
+
 /*
  * The CSV input module has the following options:
  *
@@ -225,6 +229,8 @@ struct context {
 	const char *column_formats;
 	size_t column_want_count;
 	struct column_details *column_details;
+	char **columns;			/**!< Current line's column texts. */
+	gboolean bits_only;		/**!< Only single-bit logic columns. */
 
 	/* Line number to start processing. */
 	size_t start_line;
@@ -252,6 +258,8 @@ struct context {
 
 	/* Current line number. */
 	size_t line_number;
+	/* First parse error of a line range, NULL when not in a range. */
+	GString *range_error;
 
 	/* List of previously created sigrok channels. */
 	GSList *prev_sr_channels;
@@ -276,8 +284,6 @@ static int flush_samplerate(const struct sr_input *in)
 	struct context *inc;
 
 	inc = in->priv;
-	if (!inc->calc_samplerate && inc->samplerate)
-		inc->calc_samplerate = inc->samplerate;
 	if (inc->calc_samplerate && !inc->samplerate_sent) {
 		(void)sr_session_send_meta(in->sdi, SR_CONF_SAMPLERATE,
 			g_variant_new_uint64(inc->calc_samplerate));
@@ -772,6 +778,103 @@ static char **split_line(char *buf, struct context *inc)
 	return fields;
 }
 
+/**
+ * Splits a text line into columns, in place and without allocation.
+ *
+ * @param[in] buf	The input text line to split. Gets modified.
+ * @param[in] inc	The input module's context.
+ * @param[in] want	The number of leading columns of interest.
+ *
+ * @returns The number of columns found, at most @a want.
+ *
+ * The columns' text gets referenced from inc->columns[], with trailing
+ * whitespace removed like split_line() does. Text after the last column
+ * of interest is not inspected. This is the routine for sample data,
+ * which runs for every input line.
+ */
+static size_t split_line_inplace(char *buf, struct context *inc, size_t want)
+{
+	const char *delim;
+	size_t delim_len, count;
+	char *next, *end;
+
+	delim = inc->delimiter->str;
+	delim_len = inc->delimiter->len;
+	count = 0;
+	while (count < want) {
+		if (delim_len == 1)
+			next = strchr(buf, delim[0]);
+		else
+			next = strstr(buf, delim);
+		end = next ? next : buf + strlen(buf);
+		while (end > buf && g_ascii_isspace(end[-1]))
+			end--;
+		*end = '\0';
+		inc->columns[count++] = buf;
+		if (!next)
+			break;
+		buf = next + delim_len;
+	}
+
+	return count;
+}
+
+/*
+ * Report a parse error in the current text line. Line ranges keep
+ * their first message instead, only the first failing range's message
+ * gets logged after all ranges were parsed.
+ */
+static void parse_error(struct context *inc, const char *format, ...)
+{
+	va_list args;
+	char *msg;
+
+	if (inc->range_error && inc->range_error->len)
+		return;
+	va_start(args, format);
+	msg = g_strdup_vprintf(format, args);
+	va_end(args);
+	if (inc->range_error)
+		g_string_assign(inc->range_error, msg);
+	else
+		sr_err("%s", msg);
+	g_free(msg);
+}
+
+/**
+ * Parse a text line which only has single-bit logic columns.
+ *
+ * @param[in] line	The input text line.
+ * @param[in] inc	The input module's context.
+ *
+ * @returns TRUE when the line was handled, FALSE otherwise.
+ *
+ * This is a fast path for the default format. It only accepts the
+ * strict "0,1,1,0" layout with single digits and no whitespace. Any
+ * other text, including invalid input, is left to the generic code
+ * path which also provides the diagnostics.
+ */
+static gboolean parse_bits_line(const char *line, struct context *inc)
+{
+	size_t ch_idx;
+	char delim, c;
+
+	delim = inc->delimiter->str[0];
+	for (ch_idx = 0; ch_idx < inc->column_want_count; ch_idx++) {
+		c = *line++;
+		if (c == '1')
+			inc->sample_buffer[ch_idx / 8] |= 1 << (ch_idx % 8);
+		else if (c != '0')
+			return FALSE;
+		c = *line++;
+		if (c == delim)
+			continue;
+		return c == '\0' && ch_idx + 1 == inc->column_want_count;
+	}
+
+	return TRUE;
+}
+
 /**
  * Parse a multi-bit field into several logic channels.
  *
@@ -795,6 +898,13 @@ static int parse_logic(const char *column, struct context *inc,
 	const char *type_text;
 	uint8_t bits;
 
+	/* Fast path for the most common case, single-bit columns. */
+	if (details->text_format == FORMAT_BIN && details->channel_count == 1 &&
+			(column[0] == '0' || column[0] == '1') && !column[1]) {
+		set_logic_level(inc, details->channel_offset, column[0] == '1');
+		return SR_OK;
+	}
+
 	/*
 	 * Prepare to read the digits from the text end towards the start.
 	 * A digit corresponds to a variable number of channels (depending
@@ -803,8 +913,8 @@ static int parse_logic(const char *column, struct context *inc,
 	 */
 	length = strlen(column);
 	if (!length) {
-		sr_err("Column %zu in line %zu is empty.", details->col_nr,
-			inc->line_number);
+		parse_error(inc, "Column %zu in line %zu is empty.",
+			details->col_nr, inc->line_number);
 		return SR_ERR;
 	}
 	rdptr = &column[length];
@@ -838,7 +948,7 @@ static int parse_logic(const char *column, struct context *inc,
 		}
 		if (!valid) {
 			type_text = col_format_text[details->text_format];
-			sr_err("Invalid text '%s' in %s type column %zu in line %zu.",
+			parse_error(inc, "Invalid text '%s' in %s type column %zu in line %zu.",
 				column, type_text, details->col_nr, inc->line_number);
 			return SR_ERR;
 		}
@@ -908,8 +1018,8 @@ static int parse_analog(const char *column, struct context *inc,
 
 	length = strlen(column);
 	if (!length) {
-		sr_err("Column %zu in line %zu is empty.", details->col_nr,
-			inc->line_number);
+		parse_error(inc, "Column %zu in line %zu is empty.",
+			details->col_nr, inc->line_number);
 		return SR_ERR;
 	}
 	if (sizeof(value) == sizeof(double)) {
@@ -922,7 +1032,7 @@ static int parse_analog(const char *column, struct context *inc,
 		ret = SR_ERR_BUG;
 	}
 	if (ret != SR_OK) {
-		sr_err("Cannot parse analog text %s in column %zu in line %zu.",
+		parse_error(inc, "Cannot parse analog text %s in column %zu in line %zu.",
 			column, details->col_nr, inc->line_number);
 		return SR_ERR_DATA;
 	}
@@ -1211,6 +1321,8 @@ static int init(struct sr_input *in, GHashTable *options)
 		g_string_truncate(inc->comment, 0);
 	}
 	inc->samplerate = g_variant_get_uint64(g_hash_table_lookup(options, "samplerate"));
+	/* A user provided rate takes precedence over timestamp columns. */
+	inc->calc_samplerate = inc->samplerate;
 	first_column = g_variant_get_uint32(g_hash_table_lookup(options, "first_column"));
 	inc->use_header = g_variant_get_boolean(g_hash_table_lookup(options, "header"));
 	inc->start_line = g_variant_get_uint32(g_hash_table_lookup(options, "start_line"));
@@ -1344,8 +1456,9 @@ static const char *get_line_termination(GString *buf)
 static int initial_parse(const struct sr_input *in, GString *buf)
 {
 	struct context *inc;
-	size_t num_columns;
+	size_t num_columns, column_idx;
 	size_t line_number, line_idx;
+	const struct column_details *details;
 	int ret;
 	char **lines, *line, **columns;
 
@@ -1418,6 +1531,16 @@ static int initial_parse(const struct sr_input *in, GString *buf)
 		ret = SR_ERR_DATA;
 		goto out;
 	}
+	inc->columns = g_malloc0_n(inc->column_want_count + 1,
+		sizeof(inc->columns[0]));
+	inc->bits_only = inc->delimiter->len == 1 && !inc->analog_channels;
+	for (column_idx = 0; column_idx < inc->column_want_count; column_idx++) {
+		details = &inc->column_details[column_idx];
+		if (details->text_format != FORMAT_BIN ||
+				details->channel_count != 1 ||
+				details->channel_offset != column_idx)
+			inc->bits_only = FALSE;
+	}
 
 	/*
 	 * Allocate buffer memory for datafeed submission of sample data.
@@ -1527,16 +1650,372 @@ static int initial_receive(const struct sr_input *in)
 	return ret;
 }
 
-static int process_buffer(struct sr_input *in, gboolean is_eof)
+/*
+ * Process one text line. Keeps the line's sample values in the context's
+ * sample buffers. Returns SR_ERR_NA for lines without sample data.
+ */
+static int parse_line(char *line, struct context *inc)
 {
-	struct context *inc;
-	gsize num_columns;
-	size_t line_idx, col_idx, col_nr;
+	size_t num_columns;
+	size_t col_idx, col_nr;
 	const struct column_details *details;
 	col_parse_cb parse_func;
+	char *column;
+	int ret;
+
+	inc->line_number++;
+	if (inc->line_number < inc->start_line) {
+		sr_spew("Line %zu skipped (before start).", inc->line_number);
+		return SR_ERR_NA;
+	}
+	if (line[0] == '\0') {
+		sr_spew("Blank line %zu skipped.", inc->line_number);
+		return SR_ERR_NA;
+	}
+
+	/* Remove trailing comment. */
+	strip_comment(line, inc->comment);
+	if (line[0] == '\0') {
+		sr_spew("Comment-only line %zu skipped.", inc->line_number);
+		return SR_ERR_NA;
+	}
+
+	/* Skip the header line, its content was used as the channel names. */
+	if (inc->use_header && !inc->header_seen) {
+		sr_spew("Header line %zu skipped.", inc->line_number);
+		inc->header_seen = TRUE;
+		return SR_ERR_NA;
+	}
+
+	/* Try the fast path for single-bit logic columns. */
+	clear_logic_samples(inc);
+	if (inc->bits_only && parse_bits_line(line, inc))
+		return SR_OK;
+
+	/* Split the line into columns, check for minimum length. */
+	num_columns = split_line_inplace(line, inc, inc->column_want_count);
+	if (num_columns < inc->column_want_count) {
+		parse_error(inc, "Insufficient column count %zu in line %zu.",
+			num_columns, inc->line_number);
+		return SR_ERR;
+	}
+
+	/* Have the columns of the current text line processed. */
+	clear_logic_samples(inc);
+	clear_analog_samples(inc);
+	for (col_idx = 0; col_idx < inc->column_want_count; col_idx++) {
+		column = inc->columns[col_idx];
+		col_nr = col_idx + 1;
+		details = lookup_column_details(inc, col_nr);
+		if (!details || !details->text_format)
+			continue;
+		parse_func = col_parse_funcs[details->text_format];
+		if (!parse_func)
+			continue;
+		ret = parse_func(column, inc, details);
+		if (ret != SR_OK)
+			return SR_ERR;
+	}
+
+	return SR_OK;
+}
+
+/* Returns the start of the next line, after terminating the current. */
+static char *next_line(char *line, const char *termination, size_t term_len)
+{
+	char *next;
+
+	if (term_len == 1)
+		next = strchr(line, termination[0]);
+	else
+		next = strstr(line, termination);
+	if (next) {
+		*next = '\0';
+		next += term_len;
+	}
+
+	return next;
+}
+
+/*
+ * Split input text lines and process their columns. Lines and columns
+ * get terminated in place in the receive buffer, which avoids
+ * allocations in this hot path. The library's string search routines
+ * are vectorized, and run over the text as a whole instead of per
+ * character.
+ */
+static int process_lines(struct sr_input *in, char *text)
+{
+	struct context *inc;
+	size_t term_len;
+	char *line, *next;
+	int ret;
+
+	inc = in->priv;
+	term_len = strlen(inc->termination);
+	for (line = text; line; line = next) {
+		next = next_line(line, inc->termination, term_len);
+		ret = parse_line(line, inc);
+		if (ret == SR_ERR_NA)
+			continue;
+		if (ret != SR_OK)
+			return SR_ERR;
+
+		/* Send sample data to the session bus (buffered). */
+		ret = queue_logic_samples(in);
+		ret += queue_analog_samples(in);
+		if (ret != SR_OK) {
+			sr_err("Sending samples failed.");
+			return SR_ERR;
+		}
+	}
+
+	return SR_OK;
+}
+
+/*
+ * A range of text lines, which gets parsed on a worker thread. The
+ * range's copy of the context keeps its own sample buffers, which
+ * take all of the range's samples.
+ */
+struct line_range {
+	struct context ctx;
+	char *text;
+	size_t line_count;
+	size_t sample_count;
+	int ret;
+};
+
+static void count_range_lines(gpointer data, gpointer user_data)
+{
+	struct line_range *range;
+	const char *termination, *pos;
+	size_t term_len;
+
+	(void)user_data;
+
+	range = data;
+	termination = range->ctx.termination;
+	term_len = strlen(termination);
+	range->line_count = 1;
+	pos = range->text;
+	while ((pos = strstr(pos, termination))) {
+		range->line_count++;
+		pos += term_len;
+	}
+}
+
+static void parse_range_lines(gpointer data, gpointer user_data)
+{
+	struct line_range *range;
+	struct context *inc;
+	size_t term_len;
+	char *line, *next;
+	int ret;
+
+	(void)user_data;
+
+	range = data;
+	inc = &range->ctx;
+	term_len = strlen(inc->termination);
+	range->ret = SR_OK;
+	for (line = range->text; line; line = next) {
+		next = next_line(line, inc->termination, term_len);
+		ret = parse_line(line, inc);
+		if (ret == SR_ERR_NA)
+			continue;
+		if (ret != SR_OK) {
+			range->ret = SR_ERR;
+			break;
+		}
+		if (inc->logic_channels)
+			inc->datafeed_buf_fill += inc->sample_unit_size;
+		if (inc->analog_channels)
+			inc->analog_datafeed_buf_fill++;
+		range->sample_count++;
+	}
+}
+
+/* Queue a parsed range's samples in the order which serial parsing has. */
+static int queue_range_samples(const struct sr_input *in,
+	const struct line_range *range)
+{
+	struct context *inc;
+	size_t done, count, space, ch_idx;
+	csv_analog_t *dst;
+	const csv_analog_t *src;
+	int rc;
+
+	inc = in->priv;
+	for (done = 0; done < range->sample_count; done += count) {
+		count = range->sample_count - done;
+		if (inc->logic_channels) {
+			space = inc->datafeed_buf_size - inc->datafeed_buf_fill;
+			space /= inc->sample_unit_size;
+			count = MIN(count, space);
+		}
+		if (inc->analog_channels) {
+			space = inc->analog_datafeed_buf_size;
+			space -= inc->analog_datafeed_buf_fill;
+			count = MIN(count, space);
+		}
+
+		if (inc->logic_channels) {
+			memcpy(&inc->datafeed_buffer[inc->datafeed_buf_fill],
+				&range->ctx.datafeed_buffer[done * inc->sample_unit_size],
+				count * inc->sample_unit_size);
+			inc->datafeed_buf_fill += count * inc->sample_unit_size;
+			if (inc->datafeed_buf_fill == inc->datafeed_buf_size) {
+				rc = flush_logic_samples(in);
+				if (rc != SR_OK)
+					return rc;
+			}
+		}
+		if (inc->analog_channels) {
+			for (ch_idx = 0; ch_idx < inc->analog_channels; ch_idx++) {
+				dst = inc->analog_datafeed_buffer;
+				dst += ch_idx * inc->analog_datafeed_buf_size;
+				dst += inc->analog_datafeed_buf_fill;
+				src = range->ctx.analog_datafeed_buffer;
+				src += ch_idx * range->ctx.analog_datafeed_buf_size;
+				src += done;
+				memcpy(dst, src, count * sizeof(*dst));
+			}
+			inc->analog_datafeed_buf_fill += count;
+			if (inc->analog_datafeed_buf_fill == inc->analog_datafeed_buf_size) {
+				rc = flush_analog_samples(in);
+				if (rc != SR_OK)
+					return rc;
+			}
+		}
+	}
+
+	return SR_OK;
+}
+
+/* Timestamp columns are only of interest until the rate is known. */
+static gboolean timestamp_pending(const struct context *inc)
+{
+	size_t col_idx;
+
+	if (inc->calc_samplerate)
+		return FALSE;
+	for (col_idx = 0; col_idx < inc->column_want_count; col_idx++) {
+		if (format_is_timestamp(inc->column_details[col_idx].text_format))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*
+ * Process the text's lines on several threads. Lines are independent
+ * of each other after the header was seen and the samplerate is known.
+ * The text gets split into ranges at line boundaries. The ranges' line
+ * counts are determined first, which yields their first line numbers.
+ * Then each range is parsed into its own sample buffers, which get
+ * queued in order. Returns SR_ERR_NA when the text is not split.
+ */
+static int process_lines_parallel(struct sr_input *in, char *text, size_t len)
+{
+	struct context *inc;
+	struct line_range *ranges;
+	gpointer *jobs;
+	size_t num_ranges, range_idx, term_len, line_number, size;
+	char *end, *pos;
+	int ret;
+
+	inc = in->priv;
+	num_ranges = MIN(sr_input_threads_get(in), len / PARALLEL_MIN_SIZE);
+	if (num_ranges < 2)
+		return SR_ERR_NA;
+	if (inc->use_header && !inc->header_seen)
+		return SR_ERR_NA;
+	if (timestamp_pending(inc))
+		return SR_ERR_NA;
+	sr_dbg("Parsing %zu bytes in %zu ranges.", len, num_ranges);
+
+	ranges = g_malloc0_n(num_ranges, sizeof(ranges[0]));
+	jobs = g_malloc0_n(num_ranges, sizeof(jobs[0]));
+	term_len = strlen(inc->termination);
+	end = text + len;
+	pos = text;
+	for (range_idx = 0; range_idx < num_ranges; range_idx++) {
+		ranges[range_idx].ctx = *inc;
+		ranges[range_idx].text = pos;
+		jobs[range_idx] = &ranges[range_idx];
+		if (range_idx == num_ranges - 1)
+			break;
+		pos = MAX(pos, text + len / num_ranges * (range_idx + 1));
+		pos = strstr(pos, inc->termination);
+		if (!pos || pos >= end) {
+			num_ranges = range_idx + 1;
+			break;
+		}
+		*pos = '\0';
+		pos += term_len;
+	}
+
+	sr_input_parallel_start(in, count_range_lines, &jobs[1], num_ranges - 1);
+	count_range_lines(jobs[0], NULL);
+	sr_input_parallel_wait(in);
+
+	line_number = inc->line_number;
+	for (range_idx = 0; range_idx < num_ranges; range_idx++) {
+		inc = &ranges[range_idx].ctx;
+		inc->line_number = line_number;
+		line_number += ranges[range_idx].line_count;
+		size = ranges[range_idx].line_count;
+		inc->columns = g_malloc0_n(inc->column_want_count + 1,
+			sizeof(inc->columns[0]));
+		inc->datafeed_buf_fill = 0;
+		inc->datafeed_buf_size = size * inc->sample_unit_size;
+		inc->datafeed_buffer = g_malloc(inc->datafeed_buf_size);
+		inc->analog_datafeed_buf_fill = 0;
+		inc->analog_datafeed_buf_size = size;
+		inc->analog_datafeed_buffer = g_malloc_n(size * inc->analog_channels,
+			sizeof(inc->analog_datafeed_buffer[0]));
+		inc->range_error = g_string_new(NULL);
+	}
+
+	sr_input_parallel_start(in, parse_range_lines, &jobs[1], num_ranges - 1);
+	parse_range_lines(jobs[0], NULL);
+	sr_input_parallel_wait(in);
+
+	inc = in->priv;
+	ret = SR_OK;
+	for (range_idx = 0; range_idx < num_ranges; range_idx++) {
+		if (ret == SR_OK) {
+			ret = queue_range_samples(in, &ranges[range_idx]);
+			if (ret != SR_OK) {
+				sr_err("Sending samples failed.");
+				ret = SR_ERR;
+			}
+		}
+		if (ret == SR_OK && ranges[range_idx].ret != SR_OK) {
+			ret = ranges[range_idx].ret;
+			if (ranges[range_idx].ctx.range_error->len)
+				sr_err("%s", ranges[range_idx].ctx.range_error->str);
+		}
+		if (ret == SR_OK)
+			inc->line_number = ranges[range_idx].ctx.line_number;
+		g_string_free(ranges[range_idx].ctx.range_error, TRUE);
+		g_free(ranges[range_idx].ctx.columns);
+		g_free(ranges[range_idx].ctx.datafeed_buffer);
+		g_free(ranges[range_idx].ctx.analog_datafeed_buffer);
+	}
+	g_free(jobs);
+	g_free(ranges);
+
+	return ret;
+}
+
+static int process_buffer(struct sr_input *in, gboolean is_eof)
+{
+	struct context *inc;
+	size_t term_len, len;
 	int ret;
 	char *processed_up_to;
-	char **lines, *line, **columns, *column;
 
 	inc = in->priv;
 	if (!inc->started) {
@@ -1559,97 +2038,28 @@ static int process_buffer(struct sr_input *in, gboolean is_eof)
 	 */
 	if (!in->buf->len)
 		return SR_OK;
+	term_len = strlen(inc->termination);
 	if (is_eof) {
 		processed_up_to = in->buf->str + in->buf->len;
+		len = in->buf->len;
 	} else {
 		processed_up_to = g_strrstr_len(in->buf->str, in->buf->len,
 			inc->termination);
 		if (!processed_up_to)
 			return SR_OK;
 		*processed_up_to = '\0';
-		processed_up_to += strlen(inc->termination);
+		len = processed_up_to - in->buf->str;
+		processed_up_to += term_len;
 	}
 
-	/* Split input text lines and process their columns. */
-	ret = SR_OK;
-	lines = g_strsplit(in->buf->str, inc->termination, 0);
-	for (line_idx = 0; (line = lines[line_idx]); line_idx++) {
-		inc->line_number++;
-		if (inc->line_number < inc->start_line) {
-			sr_spew("Line %zu skipped (before start).", inc->line_number);
-			continue;
-		}
-		if (line[0] == '\0') {
-			sr_spew("Blank line %zu skipped.", inc->line_number);
-			continue;
-		}
-
-		/* Remove trailing comment. */
-		strip_comment(line, inc->comment);
-		if (line[0] == '\0') {
-			sr_spew("Comment-only line %zu skipped.", inc->line_number);
-			continue;
-		}
-
-		/* Skip the header line, its content was used as the channel names. */
-		if (inc->use_header && !inc->header_seen) {
-			sr_spew("Header line %zu skipped.", inc->line_number);
-			inc->header_seen = TRUE;
-			continue;
-		}
-
-		/* Split the line into columns, check for minimum length. */
-		columns = split_line(line, inc);
-		if (!columns) {
-			sr_err("Error while parsing line %zu.", inc->line_number);
-			g_strfreev(lines);
-			return SR_ERR;
-		}
-		num_columns = g_strv_length(columns);
-		if (num_columns < inc->column_want_count) {
-			sr_err("Insufficient column count %zu in line %zu.",
-				num_columns, inc->line_number);
-			g_strfreev(columns);
-			g_strfreev(lines);
-			return SR_ERR;
-		}
-
-		/* Have the columns of the current text line processed. */
-		clear_logic_samples(inc);
-		clear_analog_samples(inc);
-		for (col_idx = 0; col_idx < inc->column_want_count; col_idx++) {
-			column = columns[col_idx];
-			col_nr = col_idx + 1;
-			details = lookup_column_details(inc, col_nr);
-			if (!details || !details->text_format)
-				continue;
-			parse_func = col_parse_funcs[details->text_format];
-			if (!parse_func)
-				continue;
-			ret = parse_func(column, inc, details);
-			if (ret != SR_OK) {
-				g_strfreev(columns);
-				g_strfreev(lines);
-				return SR_ERR;
-			}
-		}
-
-		/* Send sample data to the session bus (buffered). */
-		ret = queue_logic_samples(in);
-		ret += queue_analog_samples(in);
-		if (ret != SR_OK) {
-			sr_err("Sending samples failed.");
-			g_strfreev(columns);
-			g_strfreev(lines);
-			return SR_ERR;
-		}
-
-		g_strfreev(columns);
-	}
-	g_strfreev(lines);
+	ret = process_lines_parallel(in, in->buf->str, len);
+	if (ret == SR_ERR_NA)
+		ret = process_lines(in, in->buf->str);
+	if (ret != SR_OK)
+		return ret;
 	g_string_erase(in->buf, 0, processed_up_to - in->buf->str);
 
-	return ret;
+	return SR_OK;
 }
 
 static int receive(struct sr_input *in, GString *buf)
@@ -1724,11 +2134,14 @@ static void cleanup(struct sr_input *in)
 	/* TODO Release channel names (before releasing details). */
 	g_free(inc->column_details);
 	inc->column_details = NULL;
+	g_free(inc->columns);
+	inc->columns = NULL;
 
 	/* Clear internal state, but keep what .init() has provided. */
 	save_ctx = *inc;
 	memset(inc, 0, sizeof(*inc));
 	inc->samplerate = save_ctx.samplerate;
+	inc->calc_samplerate = save_ctx.samplerate;
 	inc->delimiter = save_ctx.delimiter;
 	inc->comment = save_ctx.comment;
 	inc->column_formats = save_ctx.column_formats;
@@ -1856,4 +2269,5 @@ SR_PRIV struct sr_input_module input_csv = {
 	.end = end,
 	.cleanup = cleanup,
 	.reset = reset,
+	.parallel = TRUE,
 };
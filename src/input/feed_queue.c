@@ -57,28 +57,112 @@ SR_API struct feed_queue_logic *feed_queue_logic_alloc(
 	return q;
 }
 
-SR_API int feed_queue_logic_submit_one(struct feed_queue_logic *q,
+/*
+ * Fill a buffer with copies of one sample. Uses memset() when all bytes
+ * of the sample are equal. Common unit sizes use plain stores of a
+ * broadcast value, which compilers turn into vector stores.
+ * Other sizes double the filled part by copying it. The buffer position
+ * is a multiple of the unit size in an allocated buffer, thus aligned.
+ */
+static void fill_samples(uint8_t *wrptr, const uint8_t *data,
+	size_t unit_size, size_t count)
+{
+	uint16_t value16, *wr16;
+	uint32_t value32, *wr32;
+	uint64_t value64, *wr64;
+	size_t idx, filled, copy;
+
+	/*
+	 * All bytes are the same for idle levels, and always for single
+	 * byte units. Only check longer runs, short ones are cheap anyway.
+	 */
+	if (unit_size == 1 || (count >= 64 &&
+			!memcmp(data, &data[1], unit_size - 1))) {
+		memset(wrptr, data[0], count * unit_size);
+		return;
+	}
+
+	switch (unit_size) {
+	case sizeof(uint16_t):
+		memcpy(&value16, data, sizeof(value16));
+		wr16 = (uint16_t *)wrptr;
+		for (idx = 0; idx < count; idx++)
+			wr16[idx] = value16;
+		return;
+	case sizeof(uint32_t):
+		memcpy(&value32, data, sizeof(value32));
+		wr32 = (uint32_t *)wrptr;
+		for (idx = 0; idx < count; idx++)
+			wr32[idx] = value32;
+		return;
+	case sizeof(uint64_t):
+		memcpy(&value64, data, sizeof(value64));
+		wr64 = (uint64_t *)wrptr;
+		for (idx = 0; idx < count; idx++)
+			wr64[idx] = value64;
+		return;
+	}
+
+	memcpy(wrptr, data, unit_size);
+	filled = 1;
+	while (filled < count) {
+		copy = MIN(filled, count - filled);
+		memcpy(&wrptr[filled * unit_size], wrptr, copy * unit_size);
+		filled += copy;
+	}
+}
+
+/* Queue a run of one sample value, flush when the buffer is full. */
+static int logic_fill(struct feed_queue_logic *q,
 	const uint8_t *data, size_t repeat_count)
 {
 	uint8_t *wrptr;
+	size_t space, fill_count;
 	int ret;
 
-	wrptr = &q->data_bytes[q->fill_count * q->unit_size];
-	while (repeat_count--) {
-		memcpy(wrptr, data, q->unit_size);
-		wrptr += q->unit_size;
-		q->fill_count++;
+	while (repeat_count) {
+		space = q->alloc_count - q->fill_count;
+		fill_count = MIN(repeat_count, space);
+		wrptr = &q->data_bytes[q->fill_count * q->unit_size];
+		fill_samples(wrptr, data, q->unit_size, fill_count);
+		repeat_count -= fill_count;
+		q->fill_count += fill_count;
 		if (q->fill_count == q->alloc_count) {
 			ret = feed_queue_logic_flush(q);
 			if (ret != SR_OK)
 				return ret;
-			wrptr = &q->data_bytes[0];
 		}
 	}
 
 	return SR_OK;
 }
 
+SR_API int feed_queue_logic_submit_one(struct feed_queue_logic *q,
+	const uint8_t *data, size_t repeat_count)
+{
+	return logic_fill(q, data, repeat_count);
+}
+
+/*
+ * Submit run length encoded data: Sample values of the queue's unit
+ * size, and the number of repetitions for each of them. Runs with a
+ * count of zero are accepted, and don't contribute samples.
+ */
+SR_API int feed_queue_logic_submit_runs(struct feed_queue_logic *q,
+	const uint8_t *data, const size_t *counts, size_t run_count)
+{
+	int ret;
+
+	while (run_count--) {
+		ret = logic_fill(q, data, *counts++);
+		if (ret != SR_OK)
+			return ret;
+		data += q->unit_size;
+	}
+
+	return SR_OK;
+}
+
 SR_API int feed_queue_logic_submit_many(struct feed_queue_logic *q,
 	const uint8_t *data, size_t samples_count)
 {
@@ -153,7 +237,9 @@ struct feed_queue_analog {
 	const struct sr_dev_inst *sdi;
 	size_t alloc_count;
 	size_t fill_count;
-	float *data_values;
+	size_t set_size;
+	gboolean is_native;
+	uint8_t *data_bytes;
 	int digits;
 	struct sr_datafeed_packet packet;
 	struct sr_datafeed_analog analog;
@@ -168,25 +254,62 @@ SR_API struct feed_queue_analog *feed_queue_analog_alloc(
 	size_t sample_count, int digits, struct sr_channel *ch)
 {
 	struct feed_queue_analog *q;
+	GSList *channels;
+	gboolean is_bigendian;
+
+#ifdef WORDS_BIGENDIAN
+	is_bigendian = TRUE;
+#else
+	is_bigendian = FALSE;
+#endif
+	channels = g_slist_append(NULL, ch);
+	q = feed_queue_analog_alloc_encoded(sdi, sample_count, digits,
+		channels, sizeof(float), TRUE, TRUE, is_bigendian);
+	g_slist_free(channels);
+
+	return q;
+}
+
+/*
+ * Allocate a queue for raw sample data in the given encoding. Each of
+ * the queued samples is a set of interleaved values, one value for each
+ * of the channels, like the session feed's analog packets hold them.
+ * Callers may specify scale and offset for integer data.
+ */
+SR_API struct feed_queue_analog *feed_queue_analog_alloc_encoded(
+	const struct sr_dev_inst *sdi, size_t sample_count, int digits,
+	GSList *channels, size_t unit_size, gboolean is_signed,
+	gboolean is_float, gboolean is_bigendian)
+{
+	struct feed_queue_analog *q;
+
+	if (!channels || !unit_size)
+		return NULL;
 
 	q = g_malloc0(sizeof(*q));
 	q->sdi = sdi;
 	q->alloc_count = sample_count;
-	q->data_values = g_try_malloc(q->alloc_count * sizeof(float));
-	if (!q->data_values) {
+	q->set_size = unit_size * g_slist_length(channels);
+	q->data_bytes = g_try_malloc(q->alloc_count * q->set_size);
+	if (!q->data_bytes) {
 		g_free(q);
 		return NULL;
 	}
 	q->digits = digits;
-	q->channels = g_slist_append(NULL, ch);
+	q->channels = g_slist_copy(channels);
 
 	memset(&q->packet, 0, sizeof(q->packet));
 	sr_analog_init(&q->analog, &q->encoding, &q->meaning, &q->spec, digits);
 	q->packet.type = SR_DF_ANALOG;
 	q->packet.payload = &q->analog;
-	q->encoding.is_signed = TRUE;
+	q->encoding.unitsize = unit_size;
+	q->encoding.is_signed = is_signed;
+	q->encoding.is_float = is_float;
+	q->is_native = q->set_size == sizeof(float) && is_float &&
+		is_bigendian == q->encoding.is_bigendian;
+	q->encoding.is_bigendian = is_bigendian;
 	q->meaning.channels = q->channels;
-	q->analog.data = q->data_values;
+	q->analog.data = q->data_bytes;
 
 	return q;
 }
@@ -230,13 +353,50 @@ SR_API int feed_queue_analog_scale_offset(struct feed_queue_analog *q,
 	return SR_OK;
 }
 
+/* Only applies to queues for one channel's float values. */
 SR_API int feed_queue_analog_submit_one(struct feed_queue_analog *q,
 	float data, size_t repeat_count)
 {
+	float *wrptr;
+	size_t space, fill_count;
+	int ret;
+
+	if (!q->is_native)
+		return SR_ERR_ARG;
+
+	while (repeat_count) {
+		space = q->alloc_count - q->fill_count;
+		fill_count = MIN(repeat_count, space);
+		wrptr = &((float *)q->data_bytes)[q->fill_count];
+		repeat_count -= fill_count;
+		q->fill_count += fill_count;
+		while (fill_count--)
+			*wrptr++ = data;
+		if (q->fill_count == q->alloc_count) {
+			ret = feed_queue_analog_flush(q);
+			if (ret != SR_OK)
+				return ret;
+		}
+	}
+
+	return SR_OK;
+}
+
+/* Submit sets of values in the queue's encoding, see alloc_encoded(). */
+SR_API int feed_queue_analog_submit_many(struct feed_queue_analog *q,
+	const uint8_t *data, size_t samples_count)
+{
+	size_t space, copy_count;
 	int ret;
 
-	while (repeat_count--) {
-		q->data_values[q->fill_count++] = data;
+	while (samples_count) {
+		space = q->alloc_count - q->fill_count;
+		copy_count = MIN(samples_count, space);
+		memcpy(&q->data_bytes[q->fill_count * q->set_size], data,
+			copy_count * q->set_size);
+		data += copy_count * q->set_size;
+		samples_count -= copy_count;
+		q->fill_count += copy_count;
 		if (q->fill_count == q->alloc_count) {
 			ret = feed_queue_analog_flush(q);
 			if (ret != SR_OK)
@@ -269,7 +429,7 @@ SR_API void feed_queue_analog_free(struct feed_queue_analog *q)
 	if (!q)
 		return;
 
-	g_free(q->data_values);
+	g_free(q->data_bytes);
 	g_slist_free(q->channels);
 	g_free(q);
 }
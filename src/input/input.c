@@ -22,6 +22,9 @@
 #include <errno.h>
 #include <glib.h>
 #include <glib/gstdio.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
 
@@ -33,6 +36,23 @@
 #define CHUNK_SIZE	(4 * 1024 * 1024)
 /** @endcond */
 
+/*
+ * Amount of input data the format detection gets to see. Large enough
+ * for the text formats' first section, without reading the whole file.
+ */
+#define PEEK_SIZE	(256 * 1024)
+
+/* Worker threads, see sr_input_threads_set(). */
+struct input_parallel {
+	GThreadPool *pool;
+	size_t num_threads;
+	GFunc func;
+	GMutex mutex;
+	GCond cond;
+	size_t pending;
+	size_t jobs_done;
+};
+
 /**
  * @file
  *
@@ -73,6 +93,7 @@ extern SR_PRIV struct sr_input_module input_raw_analog;
 extern SR_PRIV struct sr_input_module input_saleae;
 extern SR_PRIV struct sr_input_module input_stf;
 extern SR_PRIV struct sr_input_module input_trace32_ad;
+extern SR_PRIV struct sr_input_module input_transitions;
 extern SR_PRIV struct sr_input_module input_vcd;
 extern SR_PRIV struct sr_input_module input_wav;
 extern SR_PRIV struct sr_input_module input_isf;
@@ -91,6 +112,7 @@ static const struct sr_input_module *input_module_list[] = {
 	&input_stf,
 #endif
 	&input_trace32_ad,
+	&input_transitions,
 	&input_vcd,
 	&input_wav,
 	&input_isf,
@@ -348,41 +370,59 @@ static gboolean check_required_metadata(const uint8_t *metadata, uint8_t *avail)
 	return TRUE;
 }
 
-/**
- * Try to find an input module that can parse the given buffer.
- *
- * The buffer must contain enough of the beginning of the file for
- * the input modules to find a match. This is format-dependent. When
- * magic strings get checked, 128 bytes normally could be enough. Note
- * that some formats try to parse larger header sections, and benefit
- * from seeing a larger scope.
- *
- * If an input module is found, an instance is created into *in.
- * Otherwise, *in contains NULL. When multiple input moduless claim
- * support for the format, the one with highest confidence takes
- * precedence. Applications will see at most one input module spec.
- *
- * If an instance is created, it has the given buffer used for scanning
- * already submitted to it, to be processed before more data is sent.
- * This allows a frontend to submit an initial chunk of a non-seekable
- * stream, such as stdin, without having to keep it around and submit
- * it again later.
- *
+/* Returns TRUE if any of the module's meta items is available. */
+static gboolean check_any_metadata(const uint8_t *metadata, uint8_t *avail)
+{
+	int m, a;
+	uint8_t item;
+
+	for (m = 0; metadata[m]; m++) {
+		item = metadata[m] & ~SR_INPUT_META_REQUIRED;
+		for (a = 0; avail[a]; a++) {
+			if (avail[a] == item)
+				return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/* Returns TRUE unless the module declares signatures and none matches. */
+static gboolean check_magic(const struct sr_input_magic *magic,
+	const GString *header)
+{
+	if (!magic)
+		return TRUE;
+
+	for (; magic->bytes; magic++) {
+		if (magic->offset + magic->length > header->len)
+			continue;
+		if (memcmp(header->str + magic->offset,
+				magic->bytes, magic->length) == 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*
+ * Run the format detection of all input modules, and return the module
+ * which claims the stream with the highest confidence, or NULL. The
+ * metadata table holds all items listed in avail_metadata, including
+ * the header which the callers always provide.
  */
-SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in)
+static const struct sr_input_module *detect_format(GHashTable *meta,
+	uint8_t *avail_metadata)
 {
 	const struct sr_input_module *imod, *best_imod;
-	GHashTable *meta;
-	unsigned int m, i;
+	const GString *header;
+	unsigned int i;
 	unsigned int conf, best_conf;
 	int ret;
-	uint8_t mitem, avail_metadata[8];
 
-	/* No more metadata to be had from a buffer. */
-	avail_metadata[0] = SR_INPUT_META_HEADER;
-	avail_metadata[1] = 0;
+	header = g_hash_table_lookup(meta,
+		GINT_TO_POINTER(SR_INPUT_META_HEADER));
 
-	*in = NULL;
 	best_imod = NULL;
 	best_conf = ~0;
 	for (i = 0; input_module_list[i]; i++) {
@@ -395,21 +435,15 @@ SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in)
 		if (!check_required_metadata(imod->metadata, avail_metadata))
 			/* Cannot satisfy this module's requirements. */
 			continue;
-
-		meta = g_hash_table_new(NULL, NULL);
-		for (m = 0; m < sizeof(imod->metadata); m++) {
-			mitem = imod->metadata[m] & ~SR_INPUT_META_REQUIRED;
-			if (mitem == SR_INPUT_META_HEADER)
-				g_hash_table_insert(meta, GINT_TO_POINTER(mitem), buf);
-		}
-		if (g_hash_table_size(meta) == 0) {
+		if (!check_any_metadata(imod->metadata, avail_metadata))
 			/* No metadata for this module, so nothing to match. */
-			g_hash_table_destroy(meta);
 			continue;
-		}
+		if (!check_magic(imod->magic, header))
+			/* None of the module's signatures is present. */
+			continue;
+
 		sr_spew("Trying module %s.", imod->id);
 		ret = imod->format_match(meta, &conf);
-		g_hash_table_destroy(meta);
 		if (ret == SR_ERR_DATA) {
 			/* Module recognized this buffer, but cannot handle it. */
 			continue;
@@ -422,13 +456,54 @@ SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in)
 		}
 
 		/* Found a matching module. */
-		sr_spew("Module %s matched, confidence %u.", imod->id, conf);
+		sr_dbg("Module %s matched, confidence %u.", imod->id, conf);
 		if (conf >= best_conf)
 			continue;
 		best_imod = imod;
 		best_conf = conf;
 	}
 
+	return best_imod;
+}
+
+/**
+ * Try to find an input module that can parse the given buffer.
+ *
+ * The buffer must contain enough of the beginning of the file for
+ * the input modules to find a match. This is format-dependent. When
+ * magic strings get checked, 128 bytes normally could be enough. Note
+ * that some formats try to parse larger header sections, and benefit
+ * from seeing a larger scope.
+ *
+ * If an input module is found, an instance is created into *in.
+ * Otherwise, *in contains NULL. When multiple input moduless claim
+ * support for the format, the one with highest confidence takes
+ * precedence. Applications will see at most one input module spec.
+ *
+ * If an instance is created, it has the given buffer used for scanning
+ * already submitted to it, to be processed before more data is sent.
+ * This allows a frontend to submit an initial chunk of a non-seekable
+ * stream, such as stdin, without having to keep it around and submit
+ * it again later.
+ *
+ */
+SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in)
+{
+	const struct sr_input_module *best_imod;
+	GHashTable *meta;
+	uint8_t avail_metadata[8];
+
+	*in = NULL;
+
+	/* No more metadata to be had from a buffer. */
+	meta = g_hash_table_new(NULL, NULL);
+	g_hash_table_insert(meta, GINT_TO_POINTER(SR_INPUT_META_HEADER), buf);
+	avail_metadata[0] = SR_INPUT_META_HEADER;
+	avail_metadata[1] = 0;
+
+	best_imod = detect_format(meta, avail_metadata);
+	g_hash_table_destroy(meta);
+
 	if (best_imod) {
 		*in = sr_input_new(best_imod, NULL);
 		g_string_insert_len((*in)->buf, 0, buf->str, buf->len);
@@ -438,6 +513,65 @@ SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in)
 	return SR_ERR;
 }
 
+/*
+ * Read up to PEEK_SIZE bytes from the stream's current position, and
+ * run the format detection on them. The optional filename and filesize
+ * get passed to the input modules as well. The peeked bytes are
+ * returned in *header for the caller to free or keep.
+ */
+static const struct sr_input_module *detect_stream(FILE *stream,
+	const char *filename, int64_t filesize, GString **header)
+{
+	const struct sr_input_module *best_imod;
+	GHashTable *meta;
+	GString *buf;
+	size_t count;
+	unsigned int midx;
+	uint8_t avail_metadata[8];
+
+	*header = NULL;
+
+	buf = g_string_sized_new(PEEK_SIZE);
+	count = fread(buf->str, 1, PEEK_SIZE, stream);
+	if (ferror(stream)) {
+		sr_err("Failed to read %s: %s", filename ? filename : "stream",
+			g_strerror(errno));
+		g_string_free(buf, TRUE);
+		return NULL;
+	}
+	if (!count) {
+		sr_err("Cannot detect the format of %s, it is empty.",
+			filename ? filename : "stream");
+		g_string_free(buf, TRUE);
+		return NULL;
+	}
+	g_string_set_size(buf, count);
+
+	meta = g_hash_table_new(NULL, NULL);
+	midx = 0;
+	if (filename) {
+		g_hash_table_insert(meta,
+			GINT_TO_POINTER(SR_INPUT_META_FILENAME), (char *)filename);
+		avail_metadata[midx++] = SR_INPUT_META_FILENAME;
+	}
+	if (filesize >= 0) {
+		g_hash_table_insert(meta,
+			GINT_TO_POINTER(SR_INPUT_META_FILESIZE),
+			GSIZE_TO_POINTER(MIN(filesize, G_MAXSSIZE)));
+		avail_metadata[midx++] = SR_INPUT_META_FILESIZE;
+	}
+	g_hash_table_insert(meta, GINT_TO_POINTER(SR_INPUT_META_HEADER), buf);
+	avail_metadata[midx++] = SR_INPUT_META_HEADER;
+	avail_metadata[midx] = 0;
+	/* TODO: MIME type */
+
+	best_imod = detect_format(meta, avail_metadata);
+	g_hash_table_destroy(meta);
+	*header = buf;
+
+	return best_imod;
+}
+
 /**
  * Try to find an input module that can parse the given file.
  *
@@ -451,14 +585,8 @@ SR_API int sr_input_scan_file(const char *filename, const struct sr_input **in)
 {
 	int64_t filesize;
 	FILE *stream;
-	const struct sr_input_module *imod, *best_imod;
-	GHashTable *meta;
+	const struct sr_input_module *best_imod;
 	GString *header;
-	size_t count;
-	unsigned int midx, i;
-	unsigned int conf, best_conf;
-	int ret;
-	uint8_t avail_metadata[8];
 
 	*in = NULL;
 
@@ -478,70 +606,94 @@ SR_API int sr_input_scan_file(const char *filename, const struct sr_input **in)
 		fclose(stream);
 		return SR_ERR;
 	}
-	header = g_string_sized_new(CHUNK_SIZE);
-	count = fread(header->str, 1, header->allocated_len - 1, stream);
-	if (count < 1 || ferror(stream)) {
-		sr_err("Failed to read %s: %s", filename, g_strerror(errno));
-		fclose(stream);
-		g_string_free(header, TRUE);
+	best_imod = detect_stream(stream, filename, filesize, &header);
+	fclose(stream);
+	if (!header)
 		return SR_ERR;
+	g_string_free(header, TRUE);
+
+	if (best_imod) {
+		*in = sr_input_new(best_imod, NULL);
+		return SR_OK;
 	}
-	fclose(stream);
-	g_string_set_size(header, count);
 
-	meta = g_hash_table_new(NULL, NULL);
-	g_hash_table_insert(meta, GINT_TO_POINTER(SR_INPUT_META_FILENAME),
-			(char *)filename);
-	g_hash_table_insert(meta, GINT_TO_POINTER(SR_INPUT_META_FILESIZE),
-			GSIZE_TO_POINTER(MIN(filesize, G_MAXSSIZE)));
-	g_hash_table_insert(meta, GINT_TO_POINTER(SR_INPUT_META_HEADER),
-			header);
-	midx = 0;
-	avail_metadata[midx++] = SR_INPUT_META_FILENAME;
-	avail_metadata[midx++] = SR_INPUT_META_FILESIZE;
-	avail_metadata[midx++] = SR_INPUT_META_HEADER;
-	avail_metadata[midx] = 0;
-	/* TODO: MIME type */
+	return SR_ERR;
+}
 
-	best_imod = NULL;
-	best_conf = ~0;
-	for (i = 0; input_module_list[i]; i++) {
-		imod = input_module_list[i];
-		if (!imod->metadata[0]) {
-			/* Module has no metadata for matching so will take
-			 * any input. No point in letting it try to match. */
-			continue;
-		}
-		if (!check_required_metadata(imod->metadata, avail_metadata))
-			/* Cannot satisfy this module's requirements. */
-			continue;
+/**
+ * Try to find an input module that can parse the given stream.
+ *
+ * A bounded amount of data gets read from the stream's current position
+ * to detect the format. The filename is optional and only serves as a
+ * hint for the input modules. The stream's size is passed to the input
+ * modules when the stream is seekable, pipes like stdin work as well.
+ *
+ * If an input module is found, an instance is created into *in.
+ * Otherwise, *in contains NULL. When multiple input moduless claim
+ * support for the format, the one with highest confidence takes
+ * precedence. Applications will see at most one input module spec.
+ *
+ * Like with sr_input_scan_buffer(), the data which was read for the
+ * detection already is submitted to the created instance, and gets
+ * processed before more data is sent. The caller continues reading
+ * the stream from where the detection stopped. The stream is not
+ * closed. When no input module is found, a seekable stream gets put
+ * back to its previous position.
+ *
+ * A stream which is not seekable (a pipe, stdin) cannot be put back.
+ * When no input module is found, the data which was read for the
+ * detection is lost, up to 256 KiB from the stream's position. Callers
+ * which want to fall back to a specific input module for such streams
+ * should read the data themselves, and use sr_input_scan_buffer()
+ * instead.
+ *
+ * @retval SR_OK An input module was found.
+ * @retval SR_ERR_ARG Invalid arguments.
+ * @retval SR_ERR No input module was found, or the stream cannot be read.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_input_scan_stream(FILE *stream, const char *filename,
+		const struct sr_input **in)
+{
+	const struct sr_input_module *best_imod;
+	GString *header;
+	int64_t filesize;
+	off_t filepos;
 
-		sr_dbg("Trying module %s.", imod->id);
+	if (!in)
+		return SR_ERR_ARG;
+	*in = NULL;
+	if (!stream)
+		return SR_ERR_ARG;
 
-		ret = imod->format_match(meta, &conf);
-		if (ret == SR_ERR) {
-			/* Module didn't recognize this buffer. */
-			continue;
-		} else if (ret != SR_OK) {
-			/* Module recognized this buffer, but cannot handle it. */
-			continue;
-		}
-		/* Found a matching module. */
-		sr_dbg("Module %s matched, confidence %u.", imod->id, conf);
-		if (conf >= best_conf)
-			continue;
-		best_imod = imod;
-		best_conf = conf;
+	/* Only seekable streams have a known (remaining) size. */
+	filesize = -1;
+	filepos = ftello(stream);
+	if (filepos >= 0) {
+		filesize = sr_file_get_size(stream);
+		if (filesize >= 0)
+			filesize -= filepos;
 	}
-	g_hash_table_destroy(meta);
-	g_string_free(header, TRUE);
 
+	best_imod = detect_stream(stream, filename, filesize, &header);
 	if (best_imod) {
 		*in = sr_input_new(best_imod, NULL);
-		return SR_OK;
+		if (*in)
+			g_string_append_len((*in)->buf, header->str, header->len);
 	}
 
-	return SR_ERR;
+	/* Let the caller try something else with what was read. */
+	if (!*in && filepos >= 0 && fseeko(stream, filepos, SEEK_SET) < 0)
+		sr_err("Cannot restore the stream position: %s",
+			g_strerror(errno));
+	if (!*in && filepos < 0 && header)
+		sr_warn("Dropping %zu bytes which were read from %s.",
+			header->len, filename ? filename : "stream");
+	if (header)
+		g_string_free(header, TRUE);
+
+	return *in ? SR_OK : SR_ERR;
 }
 
 /**
@@ -601,6 +753,294 @@ SR_API int sr_input_send(const struct sr_input *in, GString *buf)
 	return in->module->receive((struct sr_input *)in, buf);
 }
 
+/**
+ * Map an input file into memory, for use with sr_input_send_mapped().
+ *
+ * This is an alternative to reading the file and passing its content
+ * to sr_input_send(). Input modules which support it process the file
+ * content in place, others receive copies of it in chunks. An input
+ * instance should either use a mapped file, or sr_input_send(), not
+ * both. A previously mapped file gets released.
+ *
+ * @param in The input instance, as returned by sr_input_new() or
+ *           sr_input_scan_file().
+ * @param filename The name of the file to map.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid arguments.
+ * @retval SR_ERR The file could not be mapped.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_input_open_mapped(const struct sr_input *in_ro,
+		const char *filename)
+{
+	struct sr_input *in;
+	GMappedFile *map;
+	GError *error;
+
+	in = (struct sr_input *)in_ro;	/* "un-const" */
+	if (!in || !filename || !filename[0])
+		return SR_ERR_ARG;
+
+	error = NULL;
+	map = g_mapped_file_new(filename, FALSE, &error);
+	if (!map) {
+		sr_err("Failed to map %s: %s", filename, error->message);
+		g_error_free(error);
+		return SR_ERR;
+	}
+	sr_dbg("Mapped %" G_GSIZE_FORMAT " bytes of %s.",
+		g_mapped_file_get_length(map), filename);
+#ifdef HAVE_SYS_MMAN_H
+	/* The content gets consumed front to back, have it read ahead. */
+	if (g_mapped_file_get_length(map)) {
+		(void)madvise(g_mapped_file_get_contents(map),
+			g_mapped_file_get_length(map), MADV_SEQUENTIAL);
+	}
+#endif
+
+	if (in->map)
+		g_mapped_file_unref(in->map);
+	in->map = map;
+	in->map_pos = 0;
+
+	return SR_OK;
+}
+
+/**
+ * Send the content of a mapped file to the specified input instance.
+ *
+ * Like sr_input_send(), this returns the moment the device instance
+ * became ready, so that the caller can examine it and set up the
+ * session. Call this function until *done is set, then call
+ * sr_input_end().
+ *
+ * @param in The input instance, with a file mapped by
+ *           sr_input_open_mapped().
+ * @param done Set to TRUE when the input module won't take more data.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid arguments, or no mapped file.
+ * @retval other Error code from the input module.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_input_send_mapped(const struct sr_input *in_ro, gboolean *done)
+{
+	struct sr_input *in;
+	const uint8_t *data;
+	size_t length, avail, used;
+	gboolean was_ready;
+	GString *chunk;
+	int rc;
+
+	in = (struct sr_input *)in_ro;	/* "un-const" */
+	if (done)
+		*done = FALSE;
+	if (!in || !in->map)
+		return SR_ERR_ARG;
+
+	data = (const uint8_t *)g_mapped_file_get_contents(in->map);
+	length = g_mapped_file_get_length(in->map);
+	was_ready = in->sdi_ready;
+	while (in->map_pos < length) {
+		avail = length - in->map_pos;
+		if (in->module->receive_span) {
+			sr_spew("Offering %zu mapped bytes to %s module.",
+				avail, in->module->id);
+			used = 0;
+			rc = in->module->receive_span(in,
+				data + in->map_pos, avail, &used);
+			if (rc != SR_OK)
+				return rc;
+			in->map_pos += MIN(used, avail);
+			/* Remaining data is left to end(). */
+			if (!used && in->sdi_ready == was_ready)
+				break;
+		} else {
+			/* Modules without span support get copies. */
+			used = MIN(avail, CHUNK_SIZE);
+			chunk = g_string_new_len((const char *)data + in->map_pos,
+				used);
+			rc = sr_input_send(in, chunk);
+			g_string_free(chunk, TRUE);
+			if (rc != SR_OK)
+				return rc;
+			in->map_pos += used;
+		}
+		if (in->sdi_ready && !was_ready)
+			return SR_OK;
+	}
+	if (done)
+		*done = TRUE;
+
+	return SR_OK;
+}
+
+static void parallel_job_run(gpointer data, gpointer user_data)
+{
+	struct input_parallel *par;
+
+	par = user_data;
+	par->func(data, NULL);
+
+	g_mutex_lock(&par->mutex);
+	par->jobs_done++;
+	if (!--par->pending)
+		g_cond_signal(&par->cond);
+	g_mutex_unlock(&par->mutex);
+}
+
+static void parallel_free(struct sr_input *in)
+{
+	struct input_parallel *par;
+
+	if (!(par = in->parallel))
+		return;
+	in->parallel = NULL;
+
+	if (par->pool)
+		g_thread_pool_free(par->pool, FALSE, TRUE);
+	g_mutex_clear(&par->mutex);
+	g_cond_clear(&par->cond);
+	g_free(par);
+}
+
+/**
+ * Parse large amounts of input data on several threads.
+ *
+ * Input modules which support it split the received data into ranges,
+ * which get parsed concurrently. Their samples are sent in order, the
+ * result is the same as without threads. This is meant for the import
+ * of large files, and pays off when the input is passed in chunks of
+ * several megabytes.
+ *
+ * Not all input modules support this. Modules fall back to serial
+ * parsing where the input doesn't allow to split it, e.g. within the
+ * header, or where the content of one range depends on the previous.
+ *
+ * @param in The input instance.
+ * @param num_threads Number of threads, 0 or 1 to parse serially.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid arguments.
+ * @retval SR_ERR_NA The input module doesn't support threads.
+ * @retval other Negative error code.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_input_threads_set(const struct sr_input *in_ro,
+		unsigned int num_threads)
+{
+	struct sr_input *in;
+	struct input_parallel *par;
+	GError *error;
+
+	in = (struct sr_input *)in_ro;	/* "un-const" */
+	if (!in)
+		return SR_ERR_ARG;
+
+	parallel_free(in);
+	if (num_threads < 2)
+		return SR_OK;
+	if (!in->module->parallel)
+		return SR_ERR_NA;
+
+	par = g_malloc0(sizeof(*par));
+	g_mutex_init(&par->mutex);
+	g_cond_init(&par->cond);
+	par->num_threads = num_threads;
+	in->parallel = par;
+
+	/* The calling thread runs one of the jobs itself. */
+	error = NULL;
+	par->pool = g_thread_pool_new(parallel_job_run, par,
+		num_threads - 1, FALSE, &error);
+	if (!par->pool) {
+		sr_err("Cannot create input threads: %s.", error->message);
+		g_error_free(error);
+		parallel_free(in);
+		return SR_ERR;
+	}
+
+	return SR_OK;
+}
+
+/**
+ * Get the number of threads an input module may parse data on.
+ *
+ * @return The number of threads including the caller's, or 1.
+ *
+ * @private
+ */
+SR_PRIV size_t sr_input_threads_get(const struct sr_input *in)
+{
+	return in->parallel ? in->parallel->num_threads : 1;
+}
+
+/**
+ * Run jobs on the input instance's worker threads.
+ *
+ * The function gets called with each job as its first argument. The
+ * caller can do other work, e.g. run one more job itself, before it
+ * waits for the jobs to complete in sr_input_parallel_wait().
+ *
+ * @private
+ */
+SR_PRIV void sr_input_parallel_start(const struct sr_input *in,
+	GFunc func, gpointer *jobs, size_t num_jobs)
+{
+	struct input_parallel *par;
+	size_t i;
+
+	par = in->parallel;
+	par->func = func;
+	par->pending = num_jobs;
+	for (i = 0; i < num_jobs; i++)
+		g_thread_pool_push(par->pool, jobs[i], NULL);
+}
+
+/**
+ * Wait for the jobs of sr_input_parallel_start() to complete.
+ *
+ * @private
+ */
+SR_PRIV void sr_input_parallel_wait(const struct sr_input *in)
+{
+	struct input_parallel *par;
+
+	par = in->parallel;
+	g_mutex_lock(&par->mutex);
+	while (par->pending)
+		g_cond_wait(&par->cond, &par->mutex);
+	g_mutex_unlock(&par->mutex);
+}
+
+/**
+ * Get the number of jobs which ran on the input's worker threads.
+ *
+ * Tells whether an input module did split its input, since the result
+ * is the same either way.
+ *
+ * @return The job count since sr_input_threads_set(), or 0.
+ *
+ * @private
+ */
+SR_PRIV size_t sr_input_parallel_jobs_get(const struct sr_input *in)
+{
+	struct input_parallel *par;
+	size_t jobs;
+
+	if (!(par = in->parallel))
+		return 0;
+	g_mutex_lock(&par->mutex);
+	jobs = par->jobs_done;
+	g_mutex_unlock(&par->mutex);
+
+	return jobs;
+}
+
 /**
  * Signal the input module no more data will come.
  *
@@ -609,10 +1049,27 @@ SR_API int sr_input_send(const struct sr_input *in, GString *buf)
  *
  * @since 0.4.0
  */
-SR_API int sr_input_end(const struct sr_input *in)
+SR_API int sr_input_end(const struct sr_input *in_ro)
 {
+	struct sr_input *in;
+	const char *data;
+	size_t length;
+
+	in = (struct sr_input *)in_ro;	/* "un-const" */
+
+	/* Pass mapped data which the module didn't take to end(). */
+	if (in->map) {
+		data = g_mapped_file_get_contents(in->map);
+		length = g_mapped_file_get_length(in->map);
+		if (in->map_pos < length) {
+			g_string_append_len(in->buf, data + in->map_pos,
+				length - in->map_pos);
+			in->map_pos = length;
+		}
+	}
+
 	sr_spew("Calling end() on %s module.", in->module->id);
-	return in->module->end((struct sr_input *)in);
+	return in->module->end(in);
 }
 
 /**
@@ -665,6 +1122,7 @@ SR_API int sr_input_reset(const struct sr_input *in_ro)
 	if (in->buf)
 		g_string_truncate(in->buf, 0);
 	in->sdi_ready = FALSE;
+	in->map_pos = 0;
 
 	return rc;
 }
@@ -699,6 +1157,9 @@ SR_API void sr_input_free(const struct sr_input *in)
 			" unprocessed bytes at free time.", in->buf->len);
 	}
 	g_string_free(in->buf, TRUE);
+	if (in->map)
+		g_mapped_file_unref(in->map);
+	parallel_free((struct sr_input *)in);
 	g_free(in->priv);
 	g_free((gpointer)in);
 }
@@ -746,22 +746,11 @@ static int send_idle_interframe(struct context *inc)
 static int send_frame(struct sr_input *in)
 {
 	struct context *inc;
-	size_t count, index;
-	uint8_t data;
-	int ret;
 
 	inc = in->priv;
 
-	for (index = 0; index < inc->top_frame_bits; index++) {
-		data = inc->sample_levels[index];
-		count = inc->sample_widths[index];
-		ret = feed_queue_logic_submit_one(inc->feed_logic,
-			&data, count);
-		if (ret != SR_OK)
-			return ret;
-	}
-
-	return SR_OK;
+	return feed_queue_logic_submit_runs(inc->feed_logic,
+		inc->sample_levels, inc->sample_widths, inc->top_frame_bits);
 }
 
 /* }}} frame bits manipulation */
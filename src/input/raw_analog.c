@@ -152,10 +152,12 @@ static int init(struct sr_input *in, GHashTable *options)
 	return SR_OK;
 }
 
-static int process_buffer(struct sr_input *in)
+/* Send analog data from a span, return the number of bytes consumed. */
+static size_t process_data(struct sr_input *in,
+	const uint8_t *data, size_t length)
 {
 	struct context *inc;
-	unsigned int offset, chunk_size;
+	size_t offset, chunk_size;
 
 	inc = in->priv;
 	if (!inc->started) {
@@ -174,21 +176,29 @@ static int process_buffer(struct sr_input *in)
 	chunk_size = inc->analog.num_samples * inc->samplesize;
 	offset = 0;
 
-	while ((offset + chunk_size) < in->buf->len) {
-		inc->analog.data = in->buf->str + offset;
+	while ((offset + chunk_size) < length) {
+		inc->analog.data = (void *)(data + offset);
 		sr_session_send(in->sdi, &inc->packet);
 		offset += chunk_size;
 	}
 
-	inc->analog.num_samples = (in->buf->len - offset) / inc->samplesize;
+	inc->analog.num_samples = (length - offset) / inc->samplesize;
 	chunk_size = inc->analog.num_samples * inc->samplesize;
 	if (chunk_size > 0) {
-		inc->analog.data = in->buf->str + offset;
+		inc->analog.data = (void *)(data + offset);
 		sr_session_send(in->sdi, &inc->packet);
 		offset += chunk_size;
 	}
 
-	if ((unsigned int)offset < in->buf->len) {
+	return offset;
+}
+
+static int process_buffer(struct sr_input *in)
+{
+	size_t offset;
+
+	offset = process_data(in, (const uint8_t *)in->buf->str, in->buf->len);
+	if (offset < in->buf->len) {
 		/*
 		 * The incoming buffer wasn't processed completely. Stash
 		 * the leftover data for next time.
@@ -218,6 +228,21 @@ static int receive(struct sr_input *in, GString *buf)
 	return ret;
 }
 
+static int receive_span(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
+{
+	*used = 0;
+	if (!in->sdi_ready) {
+		/* sdi is ready, notify frontend. */
+		in->sdi_ready = TRUE;
+		return SR_OK;
+	}
+
+	*used = process_data(in, data, length);
+
+	return SR_OK;
+}
+
 static int end(struct sr_input *in)
 {
 	struct context *inc;
@@ -287,6 +312,7 @@ SR_PRIV struct sr_input_module input_raw_analog = {
 	.options = get_options,
 	.init = init,
 	.receive = receive,
+	.receive_span = receive_span,
 	.end = end,
 	.cleanup = cleanup,
 	.reset = reset,
@@ -79,6 +79,9 @@
 
 #define CHUNK_SIZE  (4 * 1024 * 1024)
 
+/* Number of Logic2 digital transitions which get converted at once. */
+#define L2D_BATCH_SIZE (64 * 1024)
+
 #define LOGIC2_MAGIC "<SALEAE>"
 #define LOGIC2_VERSION 0
 #define LOGIC2_TYPE_DIGITAL 0
@@ -161,6 +164,8 @@ struct context {
 		uint8_t *buffer_digital;
 		float *buffer_analog;
 		uint8_t *write_pos;
+		uint8_t **block_buffers;
+		size_t block_count;
 		struct {
 			uint64_t stamp;
 			double time;
@@ -287,6 +292,10 @@ static int relse_feed_buffer(struct sr_input *in)
 	g_free(inc->feed.buffer_analog);
 	inc->feed.buffer_analog = NULL;
 	inc->feed.write_pos = NULL;
+	while (inc->feed.block_count)
+		g_free(inc->feed.block_buffers[--inc->feed.block_count]);
+	g_free(inc->feed.block_buffers);
+	inc->feed.block_buffers = NULL;
 
 	return SR_OK;
 }
@@ -310,23 +319,14 @@ static int setup_feed_buffer_channel(struct sr_input *in, size_t ch_idx)
 	return SR_OK;
 }
 
-static int flush_feed_buffer(struct sr_input *in)
+/* Automatically send a datafeed header and the rate before samples. */
+static int send_feed_start(struct sr_input *in)
 {
 	struct context *inc;
-	struct sr_datafeed_packet packet;
-	struct sr_datafeed_logic logic;
-	struct sr_datafeed_analog analog;
-	struct sr_analog_encoding encoding;
-	struct sr_analog_meaning meaning;
-	struct sr_analog_spec spec;
 	int rc;
 
 	inc = in->priv;
 
-	if (!inc->feed.samples_in_buffer)
-		return SR_OK;
-
-	/* Automatically send a datafeed header before meta and samples. */
 	if (!inc->module_state.header_sent) {
 		rc = std_session_send_df_header(in->sdi);
 		if (rc)
@@ -341,6 +341,29 @@ static int flush_feed_buffer(struct sr_input *in)
 		inc->module_state.rate_sent = TRUE;
 	}
 
+	return SR_OK;
+}
+
+static int flush_feed_buffer(struct sr_input *in)
+{
+	struct context *inc;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	int rc;
+
+	inc = in->priv;
+
+	if (!inc->feed.samples_in_buffer)
+		return SR_OK;
+
+	rc = send_feed_start(in);
+	if (rc)
+		return rc;
+
 	/*
 	 * Create a packet with either logic or analog payload. Rewind
 	 * the caller's write position.
@@ -374,6 +397,32 @@ static int flush_feed_buffer(struct sr_input *in)
 	return sr_session_send(in->sdi, &packet);
 }
 
+/* Send logic samples which were filled outside of the feed buffer. */
+static int send_logic_block(struct sr_input *in,
+	const uint8_t *data, size_t count)
+{
+	struct context *inc;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	int rc;
+
+	inc = in->priv;
+
+	rc = send_feed_start(in);
+	if (rc)
+		return rc;
+
+	memset(&logic, 0, sizeof(logic));
+	logic.length = count * inc->feed.unit_size;
+	logic.unitsize = inc->feed.unit_size;
+	logic.data = (void *)data;
+	memset(&packet, 0, sizeof(packet));
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+
+	return sr_session_send(in->sdi, &packet);
+}
+
 static int addto_feed_buffer_logic(struct sr_input *in,
 	uint64_t data, size_t count)
 {
@@ -428,6 +477,160 @@ static int addto_feed_buffer_analog(struct sr_input *in,
 	return SR_OK;
 }
 
+/*
+ * A range of samples which gets expanded from runs of alternating logic
+ * levels. The first run's leading 'skip' samples belong to the previous
+ * range.
+ */
+struct run_block {
+	uint8_t *buffer;
+	size_t unit_size;
+	size_t sample_count;
+	const uint64_t *counts;
+	uint64_t skip;
+	uint32_t value;
+};
+
+/* Expand a range of runs into samples. Can execute on worker threads. */
+static void fill_run_block(gpointer data, gpointer user_data)
+{
+	struct run_block *block;
+	const uint64_t *counts;
+	uint8_t *write_pos;
+	uint64_t skip;
+	size_t remain, fill, idx, unit_size;
+	uint32_t value;
+
+	(void)user_data;
+
+	block = data;
+	write_pos = block->buffer;
+	unit_size = block->unit_size;
+	remain = block->sample_count;
+	counts = block->counts;
+	skip = block->skip;
+	value = block->value;
+
+	/* Levels are 0 or 1, the LSB in little endian samples. */
+	memset(write_pos, 0, remain * unit_size);
+	while (remain) {
+		fill = MIN(*counts - skip, remain);
+		counts++;
+		skip = 0;
+		if (value && unit_size == 1) {
+			memset(write_pos, 1, fill);
+		} else if (value) {
+			for (idx = 0; idx < fill; idx++)
+				write_pos[idx * unit_size] = 1;
+		}
+		write_pos += fill * unit_size;
+		remain -= fill;
+		value = 1 - value;
+	}
+}
+
+/* Advance a position in a list of runs by the given number of samples. */
+static void skip_runs(const uint64_t *counts, size_t *run_idx,
+	uint64_t *skip, uint64_t samples)
+{
+	uint64_t left;
+
+	while (samples) {
+		left = counts[*run_idx] - *skip;
+		if (samples < left) {
+			*skip += samples;
+			return;
+		}
+		samples -= left;
+		(*run_idx)++;
+		*skip = 0;
+	}
+}
+
+/*
+ * Add runs of alternating logic levels to the session feed. The first
+ * run has the given level. Partial chunks are filled in the feed buffer.
+ * When several complete chunks of samples are pending and the input has
+ * threads, the chunks get filled concurrently, and are sent in order.
+ */
+static int addto_feed_buffer_runs(struct sr_input *in, uint32_t value,
+	const uint64_t *counts, uint64_t total)
+{
+	struct context *inc;
+	struct run_block blocks[16], *block;
+	gpointer jobs[ARRAY_SIZE(blocks)];
+	size_t run_idx, block_idx, num_blocks, chunk;
+	uint64_t skip;
+	int rc;
+
+	inc = in->priv;
+
+	if (inc->feed.is_analog)
+		return SR_ERR_ARG;
+
+	chunk = inc->feed.samples_per_chunk;
+	run_idx = 0;
+	skip = 0;
+	while (total) {
+		num_blocks = MIN(sr_input_threads_get(in), ARRAY_SIZE(blocks));
+		num_blocks = MIN(num_blocks, total / chunk);
+		if (inc->feed.samples_in_buffer || num_blocks < 2) {
+			block = &blocks[0];
+			block->buffer = inc->feed.write_pos;
+			block->unit_size = inc->feed.unit_size;
+			block->sample_count = chunk - inc->feed.samples_in_buffer;
+			block->sample_count = MIN(block->sample_count, total);
+			block->counts = &counts[run_idx];
+			block->skip = skip;
+			block->value = value ^ (run_idx & 1);
+			fill_run_block(block, NULL);
+			skip_runs(counts, &run_idx, &skip, block->sample_count);
+			total -= block->sample_count;
+			inc->feed.write_pos += block->sample_count * block->unit_size;
+			inc->feed.samples_in_buffer += block->sample_count;
+			if (inc->feed.samples_in_buffer == chunk) {
+				rc = flush_feed_buffer(in);
+				if (rc)
+					return rc;
+			}
+			continue;
+		}
+
+		/* Worker buffers are kept until the feed buffer is released. */
+		if (inc->feed.block_count < num_blocks) {
+			inc->feed.block_buffers = g_renew(uint8_t *,
+				inc->feed.block_buffers, num_blocks);
+			while (inc->feed.block_count < num_blocks) {
+				inc->feed.block_buffers[inc->feed.block_count++] =
+					g_malloc(chunk * inc->feed.unit_size);
+			}
+		}
+		for (block_idx = 0; block_idx < num_blocks; block_idx++) {
+			block = &blocks[block_idx];
+			block->buffer = inc->feed.block_buffers[block_idx];
+			block->unit_size = inc->feed.unit_size;
+			block->sample_count = chunk;
+			block->counts = &counts[run_idx];
+			block->skip = skip;
+			block->value = value ^ (run_idx & 1);
+			jobs[block_idx] = block;
+			skip_runs(counts, &run_idx, &skip, chunk);
+			total -= chunk;
+		}
+		sr_input_parallel_start(in, fill_run_block, &jobs[1], num_blocks - 1);
+		fill_run_block(jobs[0], NULL);
+		sr_input_parallel_wait(in);
+		for (block_idx = 0; block_idx < num_blocks; block_idx++) {
+			block = &blocks[block_idx];
+			rc = send_logic_block(in, block->buffer, block->sample_count);
+			if (rc)
+				return rc;
+		}
+	}
+
+	return SR_OK;
+}
+
 static enum logic_format check_format(const uint8_t *data, size_t dlen)
 {
 	const char *s;
@@ -468,7 +671,7 @@ static enum logic_format check_format(const uint8_t *data, size_t dlen)
 }
 
 /* Check for availability of required header data. */
-static gboolean have_header(struct context *inc, GString *buf)
+static gboolean have_header(struct context *inc, size_t length)
 {
 
 	/*
@@ -489,11 +692,15 @@ static gboolean have_header(struct context *inc, GString *buf)
 	 * binary).
 	 */
 	(void)inc;
-	return buf->len >= LOGIC2_MIN_SIZE;
+	return length >= LOGIC2_MIN_SIZE;
 }
 
-/* Process/inspect previously received input data. Get header parameters. */
-static int parse_header(struct sr_input *in)
+/*
+ * Process/inspect previously received input data. Get header parameters.
+ * The number of consumed header bytes is passed to the caller in *used.
+ */
+static int parse_header(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
 {
 	struct context *inc;
 	const uint8_t *read_pos, *start_pos;
@@ -504,8 +711,9 @@ static int parse_header(struct sr_input *in)
 	uint64_t sample_rate;
 
 	inc = in->priv;
-	read_pos = (const uint8_t *)in->buf->str;
-	read_len = in->buf->len;
+	read_pos = data;
+	read_len = length;
+	*used = 0;
 
 	/*
 	 * Clear internal state. Normalize user specified option values
@@ -664,9 +872,8 @@ static int parse_header(struct sr_input *in)
 		return SR_ERR_NA;
 	}
 
-	/* Remove the consumed header fields from the receive buffer. */
-	read_len = read_pos - start_pos;
-	g_string_erase(in->buf, 0, read_len);
+	/* Tell the caller how many header bytes were consumed. */
+	*used = read_pos - start_pos;
 
 	return SR_OK;
 }
@@ -707,9 +914,6 @@ static gboolean have_next_item(struct sr_input *in,
 	case STAGE_L1A_SAMPLE:
 		want_len = sizeof(float);
 		break;
-	case STAGE_L2D_CHANGE_VALUE:
-		want_len = sizeof(double);
-		break;
 	case STAGE_L2A_FIRST_VALUE:
 	case STAGE_L2A_EVERY_VALUE:
 		want_len = sizeof(float);
@@ -738,7 +942,6 @@ static int parse_next_item(struct sr_input *in,
 	uint64_t next_stamp, count;
 	uint64_t digital;
 	float analog;
-	double next_time, diff_time;
 	int rc;
 
 	inc = in->priv;
@@ -805,23 +1008,6 @@ static int parse_next_item(struct sr_input *in,
 		if (inc->logic_state.l1a.current_channel_idx == inc->logic_state.l1a.samples_per_channel)
 			inc->logic_state.stage = STAGE_L1A_NEW_CHANNEL;
 		return SR_OK;
-	case STAGE_L2D_CHANGE_VALUE:
-		next_time = read_dblle_inc(&curr);
-		diff_time = next_time - inc->feed.last.time;
-		if (inc->logic_state.l2d.min_time_step > diff_time)
-			inc->logic_state.l2d.min_time_step = diff_time;
-		diff_time /= inc->logic_state.l2d.sample_period;
-		diff_time += 0.5;
-		count = (uint64_t)diff_time;
-		if (count) {
-			digital = inc->feed.last.digital;
-			rc = addto_feed_buffer_logic(in, digital, count);
-			if (rc)
-				return rc;
-			inc->feed.last.time = next_time;
-		}
-		inc->feed.last.digital = 1 - inc->feed.last.digital;
-		return SR_OK;
 	case STAGE_L2A_FIRST_VALUE:
 	case STAGE_L2A_EVERY_VALUE:
 		analog = read_fltle_inc(&curr);
@@ -845,18 +1031,76 @@ static int parse_next_item(struct sr_input *in,
 	/* UNREACH */
 }
 
-static int parse_samples(struct sr_input *in)
+/*
+ * Convert Logic2 digital transitions in batches. Timestamps become run
+ * lengths in a serial pass, which is cheap. Expanding the runs into
+ * samples is what takes time at high sample rates, and can use threads.
+ */
+static int parse_l2d_transitions(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
+{
+	struct context *inc;
+	uint64_t *counts, total;
+	size_t count, batch, idx;
+	double next_time, diff_time;
+	uint32_t value;
+	int rc;
+
+	inc = in->priv;
+	*used = 0;
+
+	count = length / sizeof(double);
+	if (!count)
+		return SR_OK;
+	counts = g_malloc_n(MIN(count, L2D_BATCH_SIZE), sizeof(counts[0]));
+	rc = SR_OK;
+	while (count) {
+		batch = MIN(count, L2D_BATCH_SIZE);
+		value = inc->feed.last.digital;
+		total = 0;
+		for (idx = 0; idx < batch; idx++) {
+			next_time = read_dblle_inc(&data);
+			diff_time = next_time - inc->feed.last.time;
+			if (inc->logic_state.l2d.min_time_step > diff_time)
+				inc->logic_state.l2d.min_time_step = diff_time;
+			diff_time /= inc->logic_state.l2d.sample_period;
+			diff_time += 0.5;
+			counts[idx] = (uint64_t)diff_time;
+			if (counts[idx])
+				inc->feed.last.time = next_time;
+			total += counts[idx];
+		}
+		if (batch & 1)
+			inc->feed.last.digital = 1 - inc->feed.last.digital;
+		rc = addto_feed_buffer_runs(in, value, counts, total);
+		if (rc)
+			break;
+		*used += batch * sizeof(double);
+		count -= batch;
+	}
+	g_free(counts);
+
+	return rc;
+}
+
+static int parse_samples(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
 {
-	const uint8_t *buff, *start;
+	struct context *inc;
+	const uint8_t *buff;
 	size_t blen;
 
 	const uint8_t *curr, *next;
 	size_t len;
 	int rc;
 
-	start = (const uint8_t *)in->buf->str;
-	buff = start;
-	blen = in->buf->len;
+	inc = in->priv;
+	if (inc->logic_state.stage == STAGE_L2D_CHANGE_VALUE)
+		return parse_l2d_transitions(in, data, length, used);
+
+	buff = data;
+	blen = length;
+	*used = 0;
 	while (have_next_item(in, buff, blen, &curr, &next)) {
 		len = next - curr;
 		rc = parse_next_item(in, curr, len);
@@ -864,13 +1108,25 @@ static int parse_samples(struct sr_input *in)
 			return rc;
 		buff += len;
 		blen -= len;
+		*used += len;
 	}
-	len = buff - start;
-	g_string_erase(in->buf, 0, len);
 
 	return SR_OK;
 }
 
+/* Process the samples in the receive buffer, drop what was consumed. */
+static int parse_buffer(struct sr_input *in)
+{
+	size_t used;
+	int rc;
+
+	rc = parse_samples(in, (const uint8_t *)in->buf->str,
+		in->buf->len, &used);
+	g_string_erase(in->buf, 0, used);
+
+	return rc;
+}
+
 /*
  * Try to auto detect an input's file format. Mismatch is non-fatal.
  * Silent operation by design. Not all details need to be available.
@@ -989,44 +1245,72 @@ static int init(struct sr_input *in, GHashTable *options)
 	return SR_OK;
 }
 
-static int receive(struct sr_input *in, GString *buf)
+/*
+ * Wait for the full header's availability, then process it in a single
+ * call, and set the "ready" flag. Make sure sample data and the header
+ * get processed in disjoint receive() calls, the backend requires those
+ * separate phases.
+ */
+static int process_header(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
 {
 	struct context *inc;
 	int rc;
 	const char *text;
 
+	inc = in->priv;
+	*used = 0;
+	if (!have_header(inc, length))
+		return SR_OK;
+	rc = parse_header(in, data, length, used);
+	if (rc)
+		return rc;
+	inc->module_state.got_header = TRUE;
+	text = get_format_text(inc->logic_state.format) ? : "<unknown>";
+	sr_info("Using file format: '%s'.", text);
+	rc = create_channels(in);
+	if (rc)
+		return rc;
+	rc = alloc_feed_buffer(in);
+	if (rc)
+		return rc;
+	in->sdi_ready = TRUE;
+
+	return SR_OK;
+}
+
+static int receive(struct sr_input *in, GString *buf)
+{
+	struct context *inc;
+	size_t used;
+	int rc;
+
 	inc = in->priv;
 
 	/* Accumulate another chunk of input data. */
 	g_string_append_len(in->buf, buf->str, buf->len);
 
-	/*
-	 * Wait for the full header's availability, then process it in
-	 * a single call, and set the "ready" flag. Make sure sample data
-	 * and the header get processed in disjoint receive() calls, the
-	 * backend requires those separate phases.
-	 */
 	if (!inc->module_state.got_header) {
-		if (!have_header(inc, in->buf))
-			return SR_OK;
-		rc = parse_header(in);
-		if (rc)
-			return rc;
-		inc->module_state.got_header = TRUE;
-		text = get_format_text(inc->logic_state.format) ? : "<unknown>";
-		sr_info("Using file format: '%s'.", text);
-		rc = create_channels(in);
-		if (rc)
-			return rc;
-		rc = alloc_feed_buffer(in);
-		if (rc)
-			return rc;
-		in->sdi_ready = TRUE;
-		return SR_OK;
+		rc = process_header(in, (const uint8_t *)in->buf->str,
+			in->buf->len, &used);
+		g_string_erase(in->buf, 0, used);
+		return rc;
 	}
 
 	/* Process sample data, after the header got processed. */
-	return parse_samples(in);
+	return parse_buffer(in);
+}
+
+static int receive_span(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
+{
+	struct context *inc;
+
+	inc = in->priv;
+	if (!inc->module_state.got_header)
+		return process_header(in, data, length, used);
+
+	return parse_samples(in, data, length, used);
 }
 
 static int end(struct sr_input *in)
@@ -1042,7 +1326,7 @@ static int end(struct sr_input *in)
 	 * Process input data which may not have been inspected before.
 	 * Flush any potentially queued samples.
 	 */
-	rc = parse_samples(in);
+	rc = parse_buffer(in);
 	if (rc)
 		return rc;
 	rc = flush_feed_buffer(in);
@@ -1209,6 +1493,8 @@ SR_PRIV struct sr_input_module input_saleae = {
 	.format_match = format_match,
 	.init = init,
 	.receive = receive,
+	.receive_span = receive_span,
+	.parallel = TRUE,
 	.end = end,
 	.cleanup = cleanup,
 	.reset = reset,
@@ -897,6 +897,11 @@ static const struct sr_option *get_options(void)
 	return options;
 }
 
+static const struct sr_input_magic trace32_ad_magic[] = {
+	{ 0, sizeof(TRACE32) - 1, TRACE32, },
+	ALL_ZERO
+};
+
 SR_PRIV struct sr_input_module input_trace32_ad = {
 	.id = "trace32_ad",
 	.name = "Trace32_ad",
@@ -904,6 +909,7 @@ SR_PRIV struct sr_input_module input_trace32_ad = {
 	.exts = (const char*[]){"ad", NULL},
 	.options = get_options,
 	.metadata = { SR_INPUT_META_HEADER | SR_INPUT_META_REQUIRED },
+	.magic = trace32_ad_magic,
 	.format_match = format_match,
 	.init = init,
 	.receive = receive,
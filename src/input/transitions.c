@@ -0,0 +1,489 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Import the compact binary stream of value changes which the
+ * "transitions" output module creates. See output/transitions.c for
+ * a description of the format. Runs of unchanged values get expanded
+ * to sample data again, so that captures round-trip.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "input/transitions"
+
+#define CHUNK_SIZE	(4 * 1024 * 1024)
+
+struct in_analog {
+	struct sr_channel *ch;
+	struct feed_queue_analog *feed;
+	int digits;
+	uint64_t pos;
+	uint64_t rec_pos;
+	uint32_t bits;
+};
+
+struct context {
+	gboolean header_done;
+	gboolean started;
+	gboolean ended;
+	size_t num_logic;
+	size_t logic_bytes;
+	uint8_t *logic_state;
+	struct feed_queue_logic *logic_feed;
+	uint64_t logic_pos;
+	uint64_t logic_rec_pos;
+	size_t num_analog;
+	struct in_analog *analog;
+};
+
+static int format_match(GHashTable *metadata, unsigned int *confidence)
+{
+	GString *buf;
+
+	buf = g_hash_table_lookup(metadata, GINT_TO_POINTER(SR_INPUT_META_HEADER));
+	if (!buf || buf->len < TRANSITIONS_MAGIC_LEN + 1)
+		return SR_ERR;
+	if (memcmp(buf->str, TRANSITIONS_MAGIC, TRANSITIONS_MAGIC_LEN) != 0)
+		return SR_ERR;
+	if (buf->str[TRANSITIONS_MAGIC_LEN] != TRANSITIONS_VERSION)
+		return SR_ERR;
+
+	*confidence = 1;
+
+	return SR_OK;
+}
+
+static int init(struct sr_input *in, GHashTable *options)
+{
+	(void)options;
+
+	in->sdi = g_malloc0(sizeof(*in->sdi));
+	in->priv = g_malloc0(sizeof(struct context));
+
+	return SR_OK;
+}
+
+/*
+ * Parse the header, create channels. Returns SR_ERR_NA when more data
+ * is needed.
+ */
+static int parse_header(struct sr_input *in)
+{
+	struct context *inc;
+	const uint8_t *rdptr, *end;
+	uint64_t count, len, i;
+	uint8_t type;
+	char *name;
+	size_t analog_idx;
+	struct sr_channel *ch;
+	gboolean keep_channels;
+
+	inc = in->priv;
+	rdptr = (const uint8_t *)in->buf->str;
+	end = rdptr + in->buf->len;
+	if (in->buf->len < TRANSITIONS_MAGIC_LEN + 1)
+		return SR_ERR_NA;
+	if (memcmp(rdptr, TRANSITIONS_MAGIC, TRANSITIONS_MAGIC_LEN) != 0 ||
+			rdptr[TRANSITIONS_MAGIC_LEN] != TRANSITIONS_VERSION) {
+		sr_err("Unsupported file format, or format version.");
+		return SR_ERR_DATA;
+	}
+	rdptr += TRANSITIONS_MAGIC_LEN + 1;
+
+	/* Check for the complete header before creating channels. */
+	if (!read_varint_inc(&rdptr, end, &count))
+		return SR_ERR_NA;
+	inc->num_logic = inc->num_analog = 0;
+	for (i = 0; i < count; i++) {
+		if (rdptr >= end)
+			return SR_ERR_NA;
+		type = *rdptr++;
+		if (!read_varint_inc(&rdptr, end, &len))
+			return SR_ERR_NA;
+		if (len > (uint64_t)(end - rdptr))
+			return SR_ERR_NA;
+		rdptr += len;
+		if (type == TRANSITIONS_CHANNEL_LOGIC && !inc->num_analog) {
+			inc->num_logic++;
+		} else if (type == TRANSITIONS_CHANNEL_ANALOG) {
+			inc->num_analog++;
+		} else {
+			sr_err("Unexpected channel type or order.");
+			return SR_ERR_DATA;
+		}
+	}
+
+	/* Re-imports keep the previously created channels. */
+	keep_channels = in->sdi->channels != NULL;
+	if (keep_channels && g_slist_length(in->sdi->channels) != count) {
+		sr_err("Channel count differs from previous import.");
+		return SR_ERR_DATA;
+	}
+	inc->logic_bytes = (inc->num_logic + 7) / 8;
+	inc->logic_state = g_malloc0(inc->logic_bytes);
+	inc->analog = g_malloc0(inc->num_analog * sizeof(inc->analog[0]));
+	rdptr = (const uint8_t *)in->buf->str + TRANSITIONS_MAGIC_LEN + 1;
+	read_varint_inc(&rdptr, end, &count);
+	analog_idx = 0;
+	for (i = 0; i < count; i++) {
+		type = *rdptr++;
+		read_varint_inc(&rdptr, end, &len);
+		if (keep_channels) {
+			ch = g_slist_nth_data(in->sdi->channels, i);
+		} else {
+			name = g_strndup((const char *)rdptr, len);
+			ch = sr_channel_new(in->sdi, i,
+				(type == TRANSITIONS_CHANNEL_LOGIC) ?
+				SR_CHANNEL_LOGIC : SR_CHANNEL_ANALOG, TRUE, name);
+			g_free(name);
+		}
+		rdptr += len;
+		if (type == TRANSITIONS_CHANNEL_ANALOG)
+			inc->analog[analog_idx++].ch = ch;
+	}
+	g_string_erase(in->buf, 0, (const char *)rdptr - in->buf->str);
+	inc->header_done = TRUE;
+
+	return SR_OK;
+}
+
+static int logic_fill(struct context *inc, uint64_t pos)
+{
+	int ret;
+
+	if (pos < inc->logic_pos) {
+		sr_err("Logic position moves backwards.");
+		return SR_ERR_DATA;
+	}
+	if (!inc->logic_feed || pos == inc->logic_pos)
+		return SR_OK;
+	ret = feed_queue_logic_submit_one(inc->logic_feed, inc->logic_state,
+		pos - inc->logic_pos);
+	inc->logic_pos = pos;
+
+	return ret;
+}
+
+static int analog_feed_prep(struct sr_input *in, struct in_analog *a,
+	int digits)
+{
+	int ret;
+
+	if (a->feed && a->digits == digits)
+		return SR_OK;
+	if (a->feed) {
+		ret = feed_queue_analog_flush(a->feed);
+		if (ret != SR_OK)
+			return ret;
+		feed_queue_analog_free(a->feed);
+	}
+	a->digits = digits;
+	a->feed = feed_queue_analog_alloc(in->sdi, CHUNK_SIZE / sizeof(float),
+		digits, a->ch);
+	if (!a->feed)
+		return SR_ERR_MALLOC;
+
+	return SR_OK;
+}
+
+static int analog_fill(struct sr_input *in, struct in_analog *a, uint64_t pos)
+{
+	float value;
+	int ret;
+
+	if (pos < a->pos) {
+		sr_err("Analog position moves backwards.");
+		return SR_ERR_DATA;
+	}
+	if (pos == a->pos)
+		return SR_OK;
+	ret = analog_feed_prep(in, a, a->digits);
+	if (ret != SR_OK)
+		return ret;
+	memcpy(&value, &a->bits, sizeof(value));
+	ret = feed_queue_analog_submit_one(a->feed, value, pos - a->pos);
+	a->pos = pos;
+
+	return ret;
+}
+
+static int flush_all(struct context *inc)
+{
+	size_t i;
+	int ret;
+
+	if (inc->logic_feed) {
+		ret = feed_queue_logic_flush(inc->logic_feed);
+		if (ret != SR_OK)
+			return ret;
+	}
+	for (i = 0; i < inc->num_analog; i++) {
+		if (!inc->analog[i].feed)
+			continue;
+		ret = feed_queue_analog_flush(inc->analog[i].feed);
+		if (ret != SR_OK)
+			return ret;
+	}
+
+	return SR_OK;
+}
+
+/*
+ * Process one record. Returns SR_ERR_NA when the record is incomplete,
+ * the read position is only advanced for completely processed records.
+ */
+static int process_record(struct sr_input *in, const uint8_t **p,
+	const uint8_t *end)
+{
+	struct context *inc;
+	const uint8_t *rdptr;
+	uint64_t delta, chan, mq, mqflags, unit, digits, bits, total;
+	struct in_analog *a;
+	size_t i;
+	uint8_t type;
+	int ret;
+
+	inc = in->priv;
+	rdptr = *p;
+	type = *rdptr++;
+	switch (type) {
+	case TRANSITIONS_REC_END:
+		/* Check for completeness first, then fill up to the end. */
+		for (i = 0; i <= inc->num_analog; i++) {
+			if (!read_varint_inc(&rdptr, end, &total))
+				return SR_ERR_NA;
+		}
+		rdptr = *p + 1;
+		read_varint_inc(&rdptr, end, &total);
+		ret = logic_fill(inc, total);
+		for (i = 0; ret == SR_OK && i < inc->num_analog; i++) {
+			read_varint_inc(&rdptr, end, &total);
+			ret = analog_fill(in, &inc->analog[i], total);
+		}
+		if (ret == SR_OK)
+			ret = flush_all(inc);
+		inc->ended = TRUE;
+		break;
+	case TRANSITIONS_REC_SAMPLERATE:
+		if (!read_varint_inc(&rdptr, end, &delta))
+			return SR_ERR_NA;
+		ret = flush_all(inc);
+		if (ret == SR_OK)
+			ret = sr_session_send_meta(in->sdi, SR_CONF_SAMPLERATE,
+				g_variant_new_uint64(delta));
+		break;
+	case TRANSITIONS_REC_LOGIC_VALUES:
+	case TRANSITIONS_REC_LOGIC_TOGGLE:
+	case TRANSITIONS_REC_TRIGGER:
+		if (!read_varint_inc(&rdptr, end, &delta))
+			return SR_ERR_NA;
+		if (type != TRANSITIONS_REC_TRIGGER &&
+				inc->logic_bytes > (size_t)(end - rdptr))
+			return SR_ERR_NA;
+		inc->logic_rec_pos += delta;
+		ret = logic_fill(inc, inc->logic_rec_pos);
+		if (ret != SR_OK)
+			break;
+		if (type == TRANSITIONS_REC_TRIGGER) {
+			ret = flush_all(inc);
+			if (ret == SR_OK)
+				ret = std_session_send_df_trigger(in->sdi);
+			break;
+		}
+		for (i = 0; i < inc->logic_bytes; i++) {
+			if (type == TRANSITIONS_REC_LOGIC_VALUES)
+				inc->logic_state[i] = *rdptr++;
+			else
+				inc->logic_state[i] ^= *rdptr++;
+		}
+		break;
+	case TRANSITIONS_REC_ANALOG_META:
+	case TRANSITIONS_REC_ANALOG_VALUE:
+		if (!read_varint_inc(&rdptr, end, &chan))
+			return SR_ERR_NA;
+		if (!read_varint_inc(&rdptr, end, &delta))
+			return SR_ERR_NA;
+		if (type == TRANSITIONS_REC_ANALOG_META) {
+			if (!read_varint_inc(&rdptr, end, &mq) ||
+					!read_varint_inc(&rdptr, end, &mqflags) ||
+					!read_varint_inc(&rdptr, end, &unit) ||
+					!read_varint_inc(&rdptr, end, &digits))
+				return SR_ERR_NA;
+		} else if (!read_varint_inc(&rdptr, end, &bits)) {
+			return SR_ERR_NA;
+		}
+		if (chan >= inc->num_analog) {
+			sr_err("Unknown analog channel %" PRIu64 ".", chan);
+			return SR_ERR_DATA;
+		}
+		a = &inc->analog[chan];
+		a->rec_pos += delta;
+		ret = analog_fill(in, a, a->rec_pos);
+		if (ret != SR_OK)
+			break;
+		if (type == TRANSITIONS_REC_ANALOG_VALUE) {
+			a->bits ^= bits;
+			break;
+		}
+		ret = analog_feed_prep(in, a, (int)((digits >> 1) ^ -(digits & 1)));
+		if (ret == SR_OK)
+			ret = feed_queue_analog_mq_unit(a->feed, mq, mqflags, unit);
+		break;
+	default:
+		sr_err("Unknown record type %d.", type);
+		return SR_ERR_DATA;
+	}
+	*p = rdptr;
+
+	return ret;
+}
+
+static int process_buffer(struct sr_input *in)
+{
+	struct context *inc;
+	const uint8_t *rdptr, *end;
+	int ret;
+
+	inc = in->priv;
+	if (!inc->started) {
+		std_session_send_df_header(in->sdi);
+		if (inc->num_logic) {
+			inc->logic_feed = feed_queue_logic_alloc(in->sdi,
+				CHUNK_SIZE / inc->logic_bytes, inc->logic_bytes);
+			if (!inc->logic_feed)
+				return SR_ERR_MALLOC;
+		}
+		inc->started = TRUE;
+	}
+
+	rdptr = (const uint8_t *)in->buf->str;
+	end = rdptr + in->buf->len;
+	ret = SR_OK;
+	while (!inc->ended && rdptr < end) {
+		ret = process_record(in, &rdptr, end);
+		if (ret != SR_OK)
+			break;
+	}
+	g_string_erase(in->buf, 0, (const char *)rdptr - in->buf->str);
+	if (inc->ended)
+		g_string_truncate(in->buf, 0);
+
+	return (ret == SR_ERR_NA) ? SR_OK : ret;
+}
+
+static int receive(struct sr_input *in, GString *buf)
+{
+	struct context *inc;
+	int ret;
+
+	g_string_append_len(in->buf, buf->str, buf->len);
+
+	inc = in->priv;
+	if (!inc->header_done) {
+		ret = parse_header(in);
+		if (ret == SR_ERR_NA)
+			return SR_OK;
+		if (ret != SR_OK)
+			return ret;
+	}
+
+	if (!in->sdi_ready) {
+		/* sdi is ready, notify frontend. */
+		in->sdi_ready = TRUE;
+		return SR_OK;
+	}
+
+	return process_buffer(in);
+}
+
+static int end(struct sr_input *in)
+{
+	struct context *inc;
+	int ret;
+
+	inc = in->priv;
+	if (!in->sdi_ready) {
+		sr_err("Incomplete file header.");
+		return SR_ERR_DATA;
+	}
+
+	ret = process_buffer(in);
+	if (in->buf->len)
+		sr_warn("Ignoring %zu bytes of an incomplete record.", in->buf->len);
+	if (!inc->ended)
+		sr_warn("Missing end of data, file was truncated?");
+	if (ret == SR_OK)
+		ret = flush_all(inc);
+
+	if (inc->started)
+		std_session_send_df_end(in->sdi);
+
+	return ret;
+}
+
+static void cleanup(struct sr_input *in)
+{
+	struct context *inc;
+	size_t i;
+
+	inc = in->priv;
+	feed_queue_logic_free(inc->logic_feed);
+	for (i = 0; i < inc->num_analog; i++)
+		feed_queue_analog_free(inc->analog[i].feed);
+	g_free(inc->analog);
+	g_free(inc->logic_state);
+}
+
+static int reset(struct sr_input *in)
+{
+	struct context *inc;
+
+	inc = in->priv;
+	cleanup(in);
+	memset(inc, 0, sizeof(*inc));
+	g_string_truncate(in->buf, 0);
+
+	return SR_OK;
+}
+
+static const char *transitions_extensions[] = { "srtr", NULL, };
+
+static const struct sr_input_magic transitions_magic[] = {
+	{ 0, TRANSITIONS_MAGIC_LEN, TRANSITIONS_MAGIC, },
+	ALL_ZERO
+};
+
+SR_PRIV struct sr_input_module input_transitions = {
+	.id = "transitions",
+	.name = "Transitions",
+	.desc = "Compact binary stream of logic and analog value changes",
+	.exts = transitions_extensions,
+	.metadata = { SR_INPUT_META_HEADER | SR_INPUT_META_REQUIRED },
+	.magic = transitions_magic,
+	.format_match = format_match,
+	.init = init,
+	.receive = receive,
+	.end = end,
+	.cleanup = cleanup,
+	.reset = reset,
+};
@@ -123,6 +123,17 @@
 #define CHUNK_SIZE (4 * 1024 * 1024)
 #define SCOPE_SEP '.'
 
+/* Minimum size of the text ranges which get parsed on separate threads. */
+#define PARALLEL_MIN_SIZE (256 * 1024)
+
+/*
+ * Identifiers of one or two printable characters get looked up in a
+ * table, which covers the identifiers of most generators' output.
+ */
+#define ID_CHAR_FIRST '!'
+#define ID_CHAR_COUNT ('~' - ID_CHAR_FIRST + 1)
+#define SHORT_ID_COUNT (ID_CHAR_COUNT + ID_CHAR_COUNT * ID_CHAR_COUNT)
+
 struct context {
 	struct vcd_user_opt {
 		size_t maxchannels; /* sigrok channels (output) */
@@ -138,7 +149,8 @@ struct context {
 	uint64_t prev_timestamp;
 	uint64_t samplerate;
 	size_t vcdsignals; /* VCD signals (input) */
-	GSList *ignored_signals;
+	GHashTable *signals;
+	struct vcd_signal **short_ids;
 	gboolean data_after_timestamp;
 	gboolean ignore_end_keyword;
 	gboolean skip_until_end;
@@ -172,6 +184,35 @@ struct context {
 		GSList *sr_channels;
 		GSList *sr_groups;
 	} prev;
+	/* Set in the copies which parse a range, see struct vcd_range. */
+	struct vcd_range *range;
+};
+
+/*
+ * A range of text lines which gets parsed on a worker thread. Ranges
+ * start at a timestamp, but the values which carry into the range are
+ * not known while it gets parsed. Value changes get applied to two
+ * sets of values, one starts with all bits low and the other with all
+ * bits high. Where they differ, the carried in value is kept when the
+ * range's samples get submitted.
+ */
+struct vcd_range {
+	struct context ctx;
+	char *text;
+	size_t length;
+	int ret;
+	gboolean have_first;
+	uint64_t first_ts;
+	uint8_t *logic_high;
+	float *floats_high;
+	gboolean all_known;
+	/* Sample count and values for each timestamp within the range. */
+	GByteArray *runs;
+	size_t run_count;
+	/* The 'high' set of values for runs before all_known was set. */
+	GByteArray *unknown;
+	uint8_t *carry_logic;
+	float *carry_floats;
 };
 
 struct vcd_channel {
@@ -188,6 +229,12 @@ struct vcd_channel {
 	struct feed_queue_analog *feed_analog;
 };
 
+/* The channels for a VCD identifier, or whether the signal is ignored. */
+struct vcd_signal {
+	GSList *channels;
+	gboolean ignored;
+};
+
 static void free_channel(void *data)
 {
 	struct vcd_channel *vcd_ch;
@@ -204,6 +251,79 @@ static void free_channel(void *data)
 	g_free(vcd_ch);
 }
 
+static void free_signal(void *data)
+{
+	struct vcd_signal *sig;
+
+	sig = data;
+	g_slist_free(sig->channels);
+	g_free(sig);
+}
+
+/* Get a short identifier's table index, or SHORT_ID_COUNT for others. */
+static size_t short_id_index(const char *id)
+{
+	size_t first, second;
+
+	first = (unsigned char)id[0] - ID_CHAR_FIRST;
+	if (first >= ID_CHAR_COUNT)
+		return SHORT_ID_COUNT;
+	if (!id[1])
+		return first;
+	second = (unsigned char)id[1] - ID_CHAR_FIRST;
+	if (second >= ID_CHAR_COUNT || id[2])
+		return SHORT_ID_COUNT;
+
+	return ID_CHAR_COUNT + first * ID_CHAR_COUNT + second;
+}
+
+static struct vcd_signal *lookup_signal(struct context *inc, const char *id)
+{
+	size_t idx;
+
+	idx = short_id_index(id);
+	if (idx < SHORT_ID_COUNT)
+		return inc->short_ids ? inc->short_ids[idx] : NULL;
+	if (!inc->signals)
+		return NULL;
+
+	return g_hash_table_lookup(inc->signals, id);
+}
+
+/*
+ * Register a channel for a VCD identifier, or register the identifier
+ * as ignored when no channel is passed. The hash table owns the signals,
+ * the table of short identifiers speeds up their lookup.
+ */
+static void add_signal(struct context *inc, const char *id,
+	struct vcd_channel *vcd_ch)
+{
+	struct vcd_signal *sig;
+	size_t idx;
+
+	sig = lookup_signal(inc, id);
+	if (!sig) {
+		if (!inc->signals) {
+			inc->signals = g_hash_table_new_full(g_str_hash,
+				g_str_equal, g_free, free_signal);
+		}
+		sig = g_malloc0(sizeof(*sig));
+		g_hash_table_insert(inc->signals, g_strdup(id), sig);
+		idx = short_id_index(id);
+		if (idx < SHORT_ID_COUNT) {
+			if (!inc->short_ids) {
+				inc->short_ids = g_malloc0_n(SHORT_ID_COUNT,
+					sizeof(inc->short_ids[0]));
+			}
+			inc->short_ids[idx] = sig;
+		}
+	}
+	if (vcd_ch)
+		sig->channels = g_slist_append(sig->channels, vcd_ch);
+	else
+		sig->ignored = TRUE;
+}
+
 /*
  * Another timestamp delta was observed, update statistics: Update the
  * sorted list of minimum values, and increment the occurance counter.
@@ -256,7 +376,7 @@ static size_t ts_stats_update_min(struct ts_stats *stats, uint64_t delta)
  * in the input data. Needs the check become an option, on by default,
  * but suppressable by users?
  */
-static void ts_stats_check_early(struct ts_stats *stats)
+static void ts_stats_check_early(struct ts_stats *stats, size_t prev_total)
 {
 	static const struct {
 		uint64_t delta;
@@ -288,10 +408,10 @@ static void ts_stats_check_early(struct ts_stats *stats)
 	for (cp_idx = 0; cp_idx < ARRAY_SIZE(check_points); cp_idx++) {
 		cp = &check_points[cp_idx];
 		/* No other match can happen below. Done iterating. */
-		if (stats->total_ts_seen > cp->count)
+		if (prev_total >= cp->count)
 			return;
 		/* Advance to the next checkpoint description. */
-		if (stats->total_ts_seen != cp->count)
+		if (stats->total_ts_seen < cp->count)
 			continue;
 		/* First occurance of that timestamp count. Check the value. */
 		sr_dbg("TS early chk: total %zu, min delta %" PRIu64 " / %" PRIu64 ".",
@@ -342,11 +462,42 @@ static int ts_stats_check(struct ts_stats *stats, uint64_t curr_ts)
 	stats->last_ts_delta = delta;
 	(void)ts_stats_update_min(stats, delta);
 
-	ts_stats_check_early(stats);
+	ts_stats_check_early(stats, stats->total_ts_seen - 1);
 
 	return SR_OK;
 }
 
+/*
+ * Merge the statistics of a range of timestamps which was inspected
+ * separately, and which starts at the given timestamp. Runs the early
+ * checks for the check points which the range has crossed.
+ */
+static void ts_stats_merge(struct ts_stats *stats,
+	const struct ts_stats *part, uint64_t first_ts)
+{
+	size_t prev_total, idx, slot;
+
+	if (!part->total_ts_seen)
+		return;
+
+	prev_total = stats->total_ts_seen;
+	if (prev_total) {
+		stats->last_ts_delta = first_ts - stats->last_ts_value;
+		(void)ts_stats_update_min(stats, stats->last_ts_delta);
+	}
+	for (idx = 0; idx < part->min_count; idx++) {
+		slot = ts_stats_update_min(stats, part->min_items[idx].delta);
+		if (slot < ARRAY_SIZE(stats->min_items))
+			stats->min_items[slot].count += part->min_items[idx].count - 1;
+	}
+	stats->total_ts_seen += part->total_ts_seen;
+	stats->last_ts_value = part->last_ts_value;
+	if (part->total_ts_seen >= 2)
+		stats->last_ts_delta = part->last_ts_delta;
+
+	ts_stats_check_early(stats, prev_total);
+}
+
 /* Postprocess internal timestamp tracker state. */
 static int ts_stats_post(struct context *inc, gboolean ignore_terminal)
 {
@@ -725,8 +876,7 @@ static int parse_header_var(struct context *inc, char *contents)
 	} else if (is_str) {
 		sr_warn("Skipping id %s, name '%s%s', unsupported type '%s'.",
 			id, ref, idx ? idx : "", type);
-		inc->ignored_signals = g_slist_append(inc->ignored_signals,
-			g_strdup(id));
+		add_signal(inc, id, NULL);
 		return SR_OK;
 	} else {
 		sr_err("Unsupported signal type: '%s'", type);
@@ -763,8 +913,7 @@ static int parse_header_var(struct context *inc, char *contents)
 	if (inc->options.maxchannels && next_size > inc->options.maxchannels) {
 		sr_warn("Skipping '%s%s', exceeds requested channel count %zu.",
 			ref, idx ? idx : "", inc->options.maxchannels);
-		inc->ignored_signals = g_slist_append(inc->ignored_signals,
-			g_strdup(id));
+		add_signal(inc, id, NULL);
 		return SR_OK;
 	}
 
@@ -793,6 +942,7 @@ static int parse_header_var(struct context *inc, char *contents)
 		vcd_ch->type == SR_CHANNEL_ANALOG ? "A" : "L",
 		vcd_ch->array_index);
 	inc->channels = g_slist_append(inc->channels, vcd_ch);
+	add_signal(inc, id, vcd_ch);
 
 	return SR_OK;
 }
@@ -1181,17 +1331,41 @@ static void add_samples(const struct sr_input *in, size_t count, gboolean flush)
 	}
 }
 
-static gint vcd_compare_id(gconstpointer a, gconstpointer b)
+/*
+ * Keep the sample count and current values of a range, which get
+ * submitted when previous ranges were. Checks whether all values are
+ * known after the range's first value changes.
+ */
+static void range_add_samples(struct vcd_range *range, size_t count)
 {
-	return strcmp((const char *)a, (const char *)b);
+	struct context *inc;
+
+	inc = &range->ctx;
+	g_byte_array_append(range->runs, (const guint8 *)&count, sizeof(count));
+	g_byte_array_append(range->runs, inc->current_logic, inc->unit_size);
+	g_byte_array_append(range->runs, (const guint8 *)inc->current_floats,
+		inc->analog_count * sizeof(inc->current_floats[0]));
+	range->run_count++;
+	if (range->all_known)
+		return;
+
+	g_byte_array_append(range->unknown, range->logic_high, inc->unit_size);
+	g_byte_array_append(range->unknown, (const guint8 *)range->floats_high,
+		inc->analog_count * sizeof(range->floats_high[0]));
+	if (memcmp(inc->current_logic, range->logic_high, inc->unit_size))
+		return;
+	if (memcmp(inc->current_floats, range->floats_high,
+			inc->analog_count * sizeof(inc->current_floats[0])))
+		return;
+	range->all_known = TRUE;
 }
 
 static gboolean is_ignored(struct context *inc, const char *id)
 {
-	GSList *ignored;
+	struct vcd_signal *sig;
 
-	ignored = g_slist_find_custom(inc->ignored_signals, id, vcd_compare_id);
-	return ignored != NULL;
+	sig = lookup_signal(inc, id);
+	return sig && sig->ignored;
 }
 
 /*
@@ -1221,12 +1395,13 @@ static float get_int_val(uint8_t *in_bits_data, size_t in_bits_count)
 }
 
 /*
- * Set a logic channel's level depending on the VCD signal's identifier
+ * Set a logic channel's level depending on the VCD signal's channels
  * and parsed value. Multi-bit VCD values will affect several sigrok
  * channels. One VCD signal name can translate to several sigrok channels.
+ * Returns whether the VCD signal was found.
  */
-static void process_bits(struct context *inc, char *identifier,
-	uint8_t *in_bits_data, size_t in_bits_count)
+static gboolean process_bits(struct context *inc, struct vcd_signal *sig,
+	const char *identifier, uint8_t *in_bits_data, size_t in_bits_count)
 {
 	size_t size;
 	gboolean have_int;
@@ -1241,10 +1416,8 @@ static void process_bits(struct context *inc, char *identifier,
 	size = 0;
 	have_int = FALSE;
 	int_val = 0;
-	for (l = inc->channels; l; l = l->next) {
+	for (l = sig->channels; l; l = l->next) {
 		vcd_ch = l->data;
-		if (g_strcmp0(identifier, vcd_ch->identifier) != 0)
-			continue;
 		if (vcd_ch->type == SR_CHANNEL_ANALOG) {
 			/* Special case for 'integer' VCD signal types. */
 			size = vcd_ch->size; /* Flag for "VCD signal found". */
@@ -1300,27 +1473,26 @@ static void process_bits(struct context *inc, char *identifier,
 			}
 		}
 	}
-	if (!size && !is_ignored(inc, identifier))
-		sr_warn("VCD signal not found for ID '%s'.", identifier);
+	return size != 0;
 }
 
 /*
  * Set an analog channel's value from a floating point number. One
- * VCD signal name can translate to several sigrok channels.
+ * VCD signal name can translate to several sigrok channels. Returns
+ * whether the VCD signal was found.
  */
-static void process_real(struct context *inc, char *identifier, float real_val)
+static gboolean process_real(struct context *inc, struct vcd_signal *sig,
+	const char *identifier, float real_val)
 {
 	gboolean found;
 	GSList *l;
 	struct vcd_channel *vcd_ch;
 
 	found = FALSE;
-	for (l = inc->channels; l; l = l->next) {
+	for (l = sig->channels; l; l = l->next) {
 		vcd_ch = l->data;
 		if (vcd_ch->type != SR_CHANNEL_ANALOG)
 			continue;
-		if (g_strcmp0(identifier, vcd_ch->identifier) != 0)
-			continue;
 
 		/* Found our (analog) channel. */
 		found = TRUE;
@@ -1328,8 +1500,78 @@ static void process_real(struct context *inc, char *identifier, float real_val)
 			identifier, vcd_ch->array_index, real_val);
 		inc->current_floats[vcd_ch->array_index] = real_val;
 	}
-	if (!found && !is_ignored(inc, identifier))
+
+	return found;
+}
+
+/* Swap a range's sets of values, see struct vcd_range. */
+static void swap_range_values(struct context *inc)
+{
+	struct vcd_range *range;
+	uint8_t *logic;
+	float *floats;
+
+	range = inc->range;
+	logic = inc->current_logic;
+	inc->current_logic = range->logic_high;
+	range->logic_high = logic;
+	floats = inc->current_floats;
+	inc->current_floats = range->floats_high;
+	range->floats_high = floats;
+}
+
+/*
+ * Apply a value change of a VCD signal. Ranges apply the change to
+ * both of their sets of values, until all values are known. Ranges
+ * leave unknown signals to serial processing, which warns about them.
+ */
+static int update_bits(struct context *inc, char *identifier,
+	uint8_t *in_bits_data, size_t in_bits_count)
+{
+	struct vcd_signal *sig;
+	gboolean found;
+
+	sig = lookup_signal(inc, identifier);
+	found = FALSE;
+	if (sig) {
+		found = process_bits(inc, sig, identifier,
+			in_bits_data, in_bits_count);
+	}
+	if (sig && inc->range && !inc->range->all_known) {
+		swap_range_values(inc);
+		process_bits(inc, sig, identifier, in_bits_data, in_bits_count);
+		swap_range_values(inc);
+	}
+	if (!found && !(sig && sig->ignored)) {
+		if (inc->range)
+			return SR_ERR_NA;
 		sr_warn("VCD signal not found for ID '%s'.", identifier);
+	}
+
+	return SR_OK;
+}
+
+static int update_real(struct context *inc, char *identifier, float real_val)
+{
+	struct vcd_signal *sig;
+	gboolean found;
+
+	sig = lookup_signal(inc, identifier);
+	found = FALSE;
+	if (sig)
+		found = process_real(inc, sig, identifier, real_val);
+	if (sig && inc->range && !inc->range->all_known) {
+		swap_range_values(inc);
+		process_real(inc, sig, identifier, real_val);
+		swap_range_values(inc);
+	}
+	if (!found && !(sig && sig->ignored)) {
+		if (inc->range)
+			return SR_ERR_NA;
+		sr_warn("VCD signal not found for ID '%s'.", identifier);
+	}
+
+	return SR_OK;
 }
 
 /*
@@ -1466,10 +1708,138 @@ static gboolean vcd_string_valid(const char *s)
 	return TRUE;
 }
 
+/*
+ * Ranges which get parsed on worker threads leave errors to serial
+ * processing, which reports them.
+ */
+#define parse_error(inc, ...) \
+	((inc)->range ? SR_ERR_NA : (sr_err(__VA_ARGS__), SR_ERR_DATA))
+
+/*
+ * Apply optional downsampling and the 'skip' logic to a timestamp, and
+ * check it for plausibility. Gets the number of samples of previously
+ * received data values, which the timestamp completes. A count of zero
+ * means that no samples are to submit.
+ */
+static int handle_timestamp(struct context *inc, uint64_t timestamp,
+	size_t *count)
+{
+	*count = 0;
+	if (inc->options.downsample > 1) {
+		timestamp /= inc->options.downsample;
+		sr_spew("Downsampled timestamp: %" PRIu64, timestamp);
+	}
+
+	/*
+	 * Skip < 0 => skip until first timestamp.
+	 * Skip = 0 => don't skip
+	 * Skip > 0 => skip until timestamp >= skip.
+	 */
+	if (inc->options.skip_specified && !inc->use_skip) {
+		sr_dbg("Seeding skip from user spec %" PRIu64,
+			inc->options.skip_starttime);
+		inc->prev_timestamp = inc->options.skip_starttime;
+		inc->use_skip = TRUE;
+	}
+	if (!inc->use_skip) {
+		sr_dbg("Seeding skip from first timestamp");
+		inc->options.skip_starttime = timestamp;
+		inc->prev_timestamp = timestamp;
+		inc->use_skip = TRUE;
+		return SR_OK;
+	}
+	if (inc->options.skip_starttime && timestamp < inc->options.skip_starttime) {
+		sr_spew("Timestamp skipped, before user spec");
+		inc->prev_timestamp = inc->options.skip_starttime;
+		return SR_OK;
+	}
+	if (timestamp == inc->prev_timestamp) {
+		/*
+		 * Ignore repeated timestamps (e.g. sigrok outputs these).
+		 * Can also happen when downsampling makes distinct input
+		 * values end up at the same scaled down value. Also
+		 * transparently covers the initial timestamp.
+		 */
+		sr_spew("Timestamp is identical to previous timestamp");
+		return SR_OK;
+	}
+	if (timestamp < inc->prev_timestamp)
+		return parse_error(inc, "Invalid timestamp: %" PRIu64 " (leap backwards).", timestamp);
+	if (inc->options.compress) {
+		/* Compress long idle periods */
+		*count = timestamp - inc->prev_timestamp;
+		if (*count > inc->options.compress) {
+			sr_dbg("Long idle period, compressing");
+			*count = timestamp - inc->options.compress;
+			inc->prev_timestamp = *count;
+		}
+	}
+
+	/* Generate samples from prev_timestamp up to timestamp - 1. */
+	*count = timestamp - inc->prev_timestamp;
+	sr_spew("Got a new timestamp, feeding %zu samples", *count);
+	inc->prev_timestamp = timestamp;
+
+	return SR_OK;
+}
+
+/*
+ * The first timestamp of a range only sets the range's start. The
+ * samples up to it depend on the previous range, and get submitted
+ * when the ranges get merged. Leaves ranges which start before the
+ * 'skip' time to serial processing.
+ */
+static int range_first_timestamp(struct context *inc, uint64_t timestamp)
+{
+	struct vcd_range *range;
+
+	range = inc->range;
+	range->have_first = TRUE;
+	range->first_ts = timestamp;
+	if (inc->options.downsample > 1)
+		timestamp /= inc->options.downsample;
+	if (inc->options.skip_starttime && timestamp < inc->options.skip_starttime)
+		return SR_ERR_NA;
+	inc->prev_timestamp = timestamp;
+
+	return SR_OK;
+}
+
+/* Whitespace, like isspace() in the C locale. */
+#define is_space(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+
+/*
+ * Isolate the next space separated word of a text line, and advance
+ * the read position past it. Scans the text only once, in contrast to
+ * the line trimming and word splitting of the common text helpers.
+ */
+static char *next_word(char **pos)
+{
+	char *p, *word;
+
+	p = *pos;
+	if (!p)
+		return NULL;
+	while (is_space(*p))
+		p++;
+	if (!*p) {
+		*pos = NULL;
+		return NULL;
+	}
+	word = p;
+	while (*p && !is_space(*p))
+		p++;
+	if (*p)
+		*p++ = '\0';
+	*pos = p;
+
+	return word;
+}
+
 /* Parse one text line of the data section. */
-static int parse_textline(const struct sr_input *in, char *line)
+static int parse_textline(const struct sr_input *in, struct context *inc,
+	char *line)
 {
-	struct context *inc;
 	int ret;
 	char *curr_word, curr_first;
 	gboolean is_timestamp, is_section;
@@ -1478,8 +1848,6 @@ static int parse_textline(const struct sr_input *in, char *line)
 	char *identifier, *endptr;
 	size_t count;
 
-	inc = in->priv;
-
 	/*
 	 * Consume space separated words from a caller's text line. Note
 	 * that many words are self contained, but some require another
@@ -1502,7 +1870,7 @@ static int parse_textline(const struct sr_input *in, char *line)
 		 * Lookup one word here which is mandatory. Locations
 		 * below conditionally lookup another word as needed.
 		 */
-		curr_word = sr_text_next_word(line, &line);
+		curr_word = next_word(&line);
 		if (!curr_word)
 			break;
 		if (!*curr_word)
@@ -1543,6 +1911,11 @@ static int parse_textline(const struct sr_input *in, char *line)
 		 * $comment sections).
 		 */
 		is_section = curr_first == '$' && curr_word[1];
+		if (is_section && inc->range) {
+			/* Leave sections to serial processing. */
+			ret = SR_ERR_NA;
+			break;
+		}
 		if (is_section) {
 			gboolean inspect_data;
 
@@ -1575,74 +1948,28 @@ static int parse_textline(const struct sr_input *in, char *line)
 			endptr = NULL;
 			timestamp = strtoull(&curr_word[1], &endptr, 10);
 			if (!endptr || *endptr) {
-				sr_err("Invalid timestamp: %s.", curr_word);
-				ret = SR_ERR_DATA;
+				ret = parse_error(inc, "Invalid timestamp: %s.", curr_word);
 				break;
 			}
 			sr_spew("Got timestamp: %" PRIu64, timestamp);
 			ret = ts_stats_check(&inc->ts_stats, timestamp);
 			if (ret != SR_OK)
 				break;
-			if (inc->options.downsample > 1) {
-				timestamp /= inc->options.downsample;
-				sr_spew("Downsampled timestamp: %" PRIu64, timestamp);
-			}
-
-			/*
-			 * Skip < 0 => skip until first timestamp.
-			 * Skip = 0 => don't skip
-			 * Skip > 0 => skip until timestamp >= skip.
-			 */
-			if (inc->options.skip_specified && !inc->use_skip) {
-				sr_dbg("Seeding skip from user spec %" PRIu64,
-					inc->options.skip_starttime);
-				inc->prev_timestamp = inc->options.skip_starttime;
-				inc->use_skip = TRUE;
-			}
-			if (!inc->use_skip) {
-				sr_dbg("Seeding skip from first timestamp");
-				inc->options.skip_starttime = timestamp;
-				inc->prev_timestamp = timestamp;
-				inc->use_skip = TRUE;
-				continue;
-			}
-			if (inc->options.skip_starttime && timestamp < inc->options.skip_starttime) {
-				sr_spew("Timestamp skipped, before user spec");
-				inc->prev_timestamp = inc->options.skip_starttime;
-				continue;
-			}
-			if (timestamp == inc->prev_timestamp) {
-				/*
-				 * Ignore repeated timestamps (e.g. sigrok
-				 * outputs these). Can also happen when
-				 * downsampling makes distinct input values
-				 * end up at the same scaled down value.
-				 * Also transparently covers the initial
-				 * timestamp.
-				 */
-				sr_spew("Timestamp is identical to previous timestamp");
+			if (inc->range && !inc->range->have_first) {
+				ret = range_first_timestamp(inc, timestamp);
+				if (ret != SR_OK)
+					break;
 				continue;
 			}
-			if (timestamp < inc->prev_timestamp) {
-				sr_err("Invalid timestamp: %" PRIu64 " (leap backwards).", timestamp);
-				ret = SR_ERR_DATA;
+			ret = handle_timestamp(inc, timestamp, &count);
+			if (ret != SR_OK)
 				break;
-			}
-			if (inc->options.compress) {
-				/* Compress long idle periods */
-				count = timestamp - inc->prev_timestamp;
-				if (count > inc->options.compress) {
-					sr_dbg("Long idle period, compressing");
-					count = timestamp - inc->options.compress;
-					inc->prev_timestamp = count;
-				}
-			}
-
-			/* Generate samples from prev_timestamp up to timestamp - 1. */
-			count = timestamp - inc->prev_timestamp;
-			sr_spew("Got a new timestamp, feeding %zu samples", count);
-			add_samples(in, count, FALSE);
-			inc->prev_timestamp = timestamp;
+			if (!count)
+				continue;
+			if (inc->range)
+				range_add_samples(inc->range, count);
+			else
+				add_samples(in, count, FALSE);
 			inc->data_after_timestamp = FALSE;
 			continue;
 		}
@@ -1690,20 +2017,20 @@ static int parse_textline(const struct sr_input *in, char *line)
 			float real_val;
 
 			real_text = &curr_word[1];
-			identifier = sr_text_next_word(line, &line);
+			identifier = next_word(&line);
 			if (!*real_text || !identifier || !*identifier) {
-				sr_err("Unexpected real format.");
-				ret = SR_ERR_DATA;
+				ret = parse_error(inc, "Unexpected real format.");
 				break;
 			}
 			sr_spew("Got real data %s for id '%s'.",
 				real_text, identifier);
 			if (sr_atof_ascii(real_text, &real_val) != SR_OK) {
-				sr_err("Cannot convert value: %s.", real_text);
-				ret = SR_ERR_DATA;
+				ret = parse_error(inc, "Cannot convert value: %s.", real_text);
 				break;
 			}
-			process_real(inc, identifier, real_val);
+			ret = update_real(inc, identifier, real_val);
+			if (ret != SR_OK)
+				break;
 			continue;
 		}
 		if (is_multibit) {
@@ -1724,11 +2051,10 @@ static int parse_textline(const struct sr_input *in, char *line)
 			 * we may never unify code paths at all here.
 			 */
 			bits_text = &curr_word[1];
-			identifier = sr_text_next_word(line, &line);
+			identifier = next_word(&line);
 
 			if (!*bits_text || !identifier || !*identifier) {
-				sr_err("Unexpected integer/vector format.");
-				ret = SR_ERR_DATA;
+				ret = parse_error(inc, "Unexpected integer/vector format.");
 				break;
 			}
 			sr_spew("Got integer/vector data %s for id '%s'.",
@@ -1752,9 +2078,8 @@ static int parse_textline(const struct sr_input *in, char *line)
 			bits_text += strlen(bits_text);
 			bit_count = bits_text - bits_text_start;
 			if (bit_count > inc->conv_bits.max_bits) {
-				sr_err("Value exceeds conversion buffer: %s",
+				ret = parse_error(inc, "Value exceeds conversion buffer: %s",
 					bits_text_start);
-				ret = SR_ERR_DATA;
 				break;
 			}
 			memset(inc->conv_bits.value, 0, inc->conv_bits.unit_size);
@@ -1780,9 +2105,8 @@ static int parse_textline(const struct sr_input *in, char *line)
 				}
 			}
 			if (!inc->conv_bits.sig_count) {
-				sr_err("Unexpected vector format: %s",
+				ret = parse_error(inc, "Unexpected vector format: %s",
 					bits_text_start);
-				ret = SR_ERR_DATA;
 				break;
 			}
 			if (sr_log_loglevel_get() >= SR_LOG_SPEW) {
@@ -1792,8 +2116,10 @@ static int parse_textline(const struct sr_input *in, char *line)
 				sr_hexdump_free(bits_val_text);
 			}
 
-			process_bits(inc, identifier,
+			ret = update_bits(inc, identifier,
 				inc->conv_bits.value, inc->conv_bits.sig_count);
+			if (ret != SR_OK)
+				break;
 			continue;
 		}
 		if (is_singlebit) {
@@ -1804,73 +2130,357 @@ static int parse_textline(const struct sr_input *in, char *line)
 			bits_text = &curr_word[0];
 			bit_char = *bits_text;
 			if (!bit_char) {
-				sr_err("Bit value missing.");
-				ret = SR_ERR_DATA;
+				ret = parse_error(inc, "Bit value missing.");
 				break;
 			}
 			identifier = ++bits_text;
 			if (!*identifier)
-				identifier = sr_text_next_word(line, &line);
+				identifier = next_word(&line);
 			if (!identifier || !*identifier) {
-				sr_err("Identifier missing.");
-				ret = SR_ERR_DATA;
+				ret = parse_error(inc, "Identifier missing.");
 				break;
 			}
 
 			/* Convert value text to single-bit number. */
 			bit_value = vcd_char_to_value(bit_char, NULL);
 			if (bit_value != 0 && bit_value != 1) {
-				sr_err("Unsupported bit value '%c'.", bit_char);
-				ret = SR_ERR_DATA;
+				ret = parse_error(inc, "Unsupported bit value '%c'.", bit_char);
 				break;
 			}
 			inc->conv_bits.value[0] = bit_value;
-			process_bits(inc, identifier, inc->conv_bits.value, 1);
+			ret = update_bits(inc, identifier, inc->conv_bits.value, 1);
+			if (ret != SR_OK)
+				break;
 			continue;
 		}
 		if (is_string) {
 			const char *str_value;
 
 			str_value = &curr_word[1];
-			identifier = sr_text_next_word(line, &line);
+			identifier = next_word(&line);
 			if (!vcd_string_valid(str_value)) {
-				sr_err("Invalid string data: %s", str_value);
-				ret = SR_ERR_DATA;
+				ret = parse_error(inc, "Invalid string data: %s", str_value);
 				break;
 			}
 			if (!identifier || !*identifier) {
-				sr_err("String value without identifier.");
-				ret = SR_ERR_DATA;
+				ret = parse_error(inc, "String value without identifier.");
 				break;
 			}
 			sr_spew("Got string data, id '%s', value \"%s\".",
 				identifier, str_value);
 			if (!is_ignored(inc, identifier)) {
-				sr_err("String value for identifier '%s'.",
+				ret = parse_error(inc, "String value for identifier '%s'.",
 					identifier);
-				ret = SR_ERR_DATA;
 				break;
 			}
 			continue;
 		}
 
 		/* Design choice: Consider unsupported input fatal. */
-		sr_err("Unknown token '%s'.", curr_word);
-		ret = SR_ERR_DATA;
+		ret = parse_error(inc, "Unknown token '%s'.", curr_word);
 		break;
 	}
 
 	return ret;
 }
 
+/*
+ * Parse complete text lines. Accumulates the consumed length when the
+ * caller asks for it.
+ */
+static int parse_lines(const struct sr_input *in, struct context *inc,
+	char *text, size_t len, size_t *taken)
+{
+	int ret;
+	char *rdptr, *end, *eol;
+
+	ret = SR_OK;
+	rdptr = text;
+	end = &text[len];
+	while (rdptr < end && *rdptr) {
+		eol = memchr(rdptr, '\n', end - rdptr);
+		if (!eol)
+			break;
+		*eol++ = '\0';
+		if (taken)
+			*taken += eol - rdptr;
+		ret = parse_textline(in, inc, rdptr);
+		if (ret != SR_OK)
+			break;
+		rdptr = eol;
+	}
+
+	return ret;
+}
+
+/* Process complete text lines. Accumulates the consumed length. */
+static int process_lines(const struct sr_input *in, char *text, size_t len,
+	size_t *taken)
+{
+	return parse_lines(in, in->priv, text, len, taken);
+}
+
+static void parse_range(gpointer data, gpointer user_data)
+{
+	struct vcd_range *range;
+
+	(void)user_data;
+
+	range = data;
+	range->ret = parse_lines(NULL, &range->ctx,
+		range->text, range->length, NULL);
+}
+
+static struct vcd_range *range_new(struct context *inc,
+	const char *text, size_t length)
+{
+	struct vcd_range *range;
+	size_t floats_size, idx;
+
+	range = g_malloc0(sizeof(*range));
+	range->ctx = *inc;
+	range->ctx.range = range;
+	range->ctx.data_after_timestamp = FALSE;
+	range->ctx.skip_until_end = FALSE;
+	range->ctx.ignore_end_keyword = FALSE;
+	range->text = g_strndup(text, length);
+	range->length = length;
+
+	floats_size = inc->analog_count * sizeof(inc->current_floats[0]);
+	range->ctx.current_logic = g_malloc0(inc->unit_size);
+	range->logic_high = g_malloc(inc->unit_size);
+	if (inc->unit_size)
+		memset(range->logic_high, 0xff, inc->unit_size);
+	range->ctx.current_floats = g_malloc0(floats_size);
+	range->floats_high = g_malloc(floats_size);
+	for (idx = 0; idx < inc->analog_count; idx++)
+		range->floats_high[idx] = 1.0;
+	range->ctx.conv_bits.value = g_malloc0(inc->conv_bits.unit_size);
+	range->carry_logic = g_malloc(inc->unit_size);
+	range->carry_floats = g_malloc(floats_size);
+	range->runs = g_byte_array_new();
+	range->unknown = g_byte_array_new();
+
+	/* Early checks run when the range's statistics get merged. */
+	memset(&range->ctx.ts_stats, 0, sizeof(range->ctx.ts_stats));
+	range->ctx.ts_stats.early_last_emitted = 1;
+
+	return range;
+}
+
+static void range_free(struct vcd_range *range)
+{
+	g_free(range->text);
+	g_free(range->ctx.current_logic);
+	g_free(range->logic_high);
+	g_free(range->ctx.current_floats);
+	g_free(range->floats_high);
+	g_free(range->ctx.conv_bits.value);
+	g_free(range->carry_logic);
+	g_free(range->carry_floats);
+	g_byte_array_free(range->runs, TRUE);
+	g_byte_array_free(range->unknown, TRUE);
+	g_free(range);
+}
+
+/*
+ * Determine current values from a range's values, and the values which
+ * carried into the range. Bits and analog values which differ in the
+ * 'high' set were not changed within the range.
+ */
+static void resolve_range_values(struct context *inc,
+	const struct vcd_range *range,
+	const uint8_t *logic, const uint8_t *logic_high,
+	const float *floats, const float *floats_high)
+{
+	size_t idx;
+
+	for (idx = 0; idx < inc->unit_size; idx++) {
+		inc->current_logic[idx] = logic[idx];
+		if (logic_high)
+			inc->current_logic[idx] |= range->carry_logic[idx] & logic_high[idx];
+	}
+	for (idx = 0; idx < inc->analog_count; idx++) {
+		inc->current_floats[idx] = floats[idx];
+		if (!floats_high)
+			continue;
+		if (memcmp(&floats[idx], &floats_high[idx], sizeof(floats[idx])))
+			inc->current_floats[idx] = range->carry_floats[idx];
+	}
+}
+
+/* Submit a range's samples, after the previous range's were. */
+static int submit_range(const struct sr_input *in, struct vcd_range *range)
+{
+	struct context *inc;
+	const uint8_t *run, *high;
+	size_t floats_size, run_size, high_size, run_idx, count;
+	int ret;
+
+	inc = in->priv;
+	if (!range->have_first)
+		return range->ret;
+
+	/* Handle the range's first timestamp like serial processing does. */
+	ts_stats_merge(&inc->ts_stats, &range->ctx.ts_stats, range->first_ts);
+	ret = handle_timestamp(inc, range->first_ts, &count);
+	if (ret != SR_OK)
+		return ret;
+	if (count) {
+		add_samples(in, count, FALSE);
+		inc->data_after_timestamp = FALSE;
+	}
+
+	floats_size = inc->analog_count * sizeof(inc->current_floats[0]);
+	memcpy(range->carry_logic, inc->current_logic, inc->unit_size);
+	memcpy(range->carry_floats, inc->current_floats, floats_size);
+	run_size = sizeof(count) + inc->unit_size + floats_size;
+	high_size = inc->unit_size + floats_size;
+	run = range->runs->data;
+	high = range->unknown->data;
+	for (run_idx = 0; run_idx < range->run_count; run_idx++) {
+		memcpy(&count, run, sizeof(count));
+		if (high >= range->unknown->data + range->unknown->len)
+			high = NULL;
+		resolve_range_values(inc, range,
+			run + sizeof(count), high,
+			(const float *)(run + sizeof(count) + inc->unit_size),
+			high ? (const float *)(high + inc->unit_size) : NULL);
+		add_samples(in, count, FALSE);
+		run += run_size;
+		if (high)
+			high += high_size;
+	}
+
+	resolve_range_values(inc, range,
+		range->ctx.current_logic,
+		range->all_known ? NULL : range->logic_high,
+		range->ctx.current_floats,
+		range->all_known ? NULL : range->floats_high);
+	inc->prev_timestamp = range->ctx.prev_timestamp;
+	if (range->ctx.data_after_timestamp || range->run_count)
+		inc->data_after_timestamp = range->ctx.data_after_timestamp;
+
+	return range->ret;
+}
+
+/* Find the start of the next line which starts with a timestamp. */
+static char *next_timestamp_line(char *pos, const char *end)
+{
+	while ((pos = memchr(pos, '\n', end - pos))) {
+		pos++;
+		if (pos < end && pos[0] == '#' && g_ascii_isdigit(pos[1]))
+			return pos;
+	}
+
+	return NULL;
+}
+
+/*
+ * Process the buffer's complete text lines on several threads, when
+ * it is large enough. The text gets split into ranges at timestamps.
+ * The first range is processed on the calling thread, the others get
+ * parsed concurrently, and their samples get submitted in order. The
+ * remaining text is processed serially when a range cannot be parsed
+ * separately, e.g. because it contains sections.
+ */
+static int process_buffer_parallel(struct sr_input *in, size_t *taken)
+{
+	struct context *inc;
+	struct vcd_range **ranges, *range;
+	char **starts;
+	size_t num_ranges, range_idx, len;
+	char *text, *end, *pos;
+	int ret;
+
+	inc = in->priv;
+	text = in->buf->str;
+	end = g_strrstr_len(text, in->buf->len, "\n");
+	if (!end)
+		return SR_OK;
+	len = ++end - text;
+	if (sr_input_threads_get(in) < 2 || len < 2 * PARALLEL_MIN_SIZE)
+		return SR_OK;
+
+	/* The first timestamp seeds the 'skip' logic, process it serially. */
+	if (!inc->use_skip) {
+		pos = text;
+		if (pos[0] != '#' || !g_ascii_isdigit(pos[1]))
+			pos = next_timestamp_line(pos, end);
+		if (!pos)
+			return SR_OK;
+		pos = memchr(pos, '\n', end - pos) + 1;
+		ret = process_lines(in, text, pos - text, taken);
+		if (ret != SR_OK || !inc->use_skip)
+			return ret;
+		text = pos;
+		len = end - text;
+	}
+	num_ranges = MIN(sr_input_threads_get(in), len / PARALLEL_MIN_SIZE);
+	if (num_ranges < 2)
+		return SR_OK;
+
+	/* Split the text before lines which start with a timestamp. */
+	starts = g_malloc0_n(num_ranges + 1, sizeof(starts[0]));
+	starts[0] = text;
+	pos = text;
+	for (range_idx = 1; range_idx < num_ranges; range_idx++) {
+		pos = MAX(pos, text + len / num_ranges * range_idx);
+		pos = next_timestamp_line(pos, end);
+		if (!pos)
+			break;
+		starts[range_idx] = pos;
+	}
+	num_ranges = range_idx;
+	starts[num_ranges] = end;
+	if (num_ranges < 2) {
+		g_free(starts);
+		return SR_OK;
+	}
+
+	ranges = g_malloc0_n(num_ranges, sizeof(ranges[0]));
+	for (range_idx = 1; range_idx < num_ranges; range_idx++) {
+		ranges[range_idx] = range_new(inc, starts[range_idx],
+			starts[range_idx + 1] - starts[range_idx]);
+	}
+	sr_input_parallel_start(in, parse_range,
+		(gpointer *)&ranges[1], num_ranges - 1);
+	ret = process_lines(in, text, starts[1] - text, taken);
+	sr_input_parallel_wait(in);
+
+	/*
+	 * Submit the ranges' samples in order. Process the text of ranges
+	 * serially which could not be parsed separately, or which start
+	 * within a section. Subsequent ranges are not affected, since
+	 * their parse results don't depend on previous values.
+	 */
+	for (range_idx = 1; ret == SR_OK && range_idx < num_ranges; range_idx++) {
+		range = ranges[range_idx];
+		if (range->ret != SR_ERR_NA && !inc->skip_until_end &&
+				!inc->ignore_end_keyword) {
+			ret = submit_range(in, range);
+			*taken += range->length;
+			continue;
+		}
+		sr_spew("Processing line range %zu serially.", range_idx);
+		ret = process_lines(in, starts[range_idx], range->length, taken);
+	}
+
+	for (range_idx = 1; range_idx < num_ranges; range_idx++)
+		range_free(ranges[range_idx]);
+	g_free(ranges);
+	g_free(starts);
+
+	return ret;
+}
+
 static int process_buffer(struct sr_input *in, gboolean is_eof)
 {
 	struct context *inc;
 	uint64_t samplerate;
 	GVariant *gvar;
 	int ret;
-	char *rdptr, *line;
-	size_t taken, rdlen;
+	size_t taken;
 
 	inc = in->priv;
 
@@ -1899,19 +2509,11 @@ static int process_buffer(struct sr_input *in, gboolean is_eof)
 		g_string_append_c(in->buf, '\n');
 
 	/* Find and process complete text lines in the input data. */
-	ret = SR_OK;
-	rdptr = in->buf->str;
 	taken = 0;
-	while (rdptr) {
-		rdlen = &in->buf->str[in->buf->len] - rdptr;
-		line = sr_text_next_line(rdptr, rdlen, &rdptr, &taken);
-		if (!line)
-			break;
-		if (!*line)
-			continue;
-		ret = parse_textline(in, line);
-		if (ret != SR_OK)
-			break;
+	ret = process_buffer_parallel(in, &taken);
+	if (ret == SR_OK) {
+		ret = process_lines(in, &in->buf->str[taken],
+			in->buf->len - taken, &taken);
 	}
 	g_string_erase(in->buf, 0, taken);
 
@@ -2071,8 +2673,11 @@ static void cleanup(struct sr_input *in)
 	inc->current_floats = NULL;
 	g_string_free(inc->scope_prefix, TRUE);
 	inc->scope_prefix = NULL;
-	g_slist_free_full(inc->ignored_signals, g_free);
-	inc->ignored_signals = NULL;
+	if (inc->signals)
+		g_hash_table_destroy(inc->signals);
+	inc->signals = NULL;
+	g_free(inc->short_ids);
+	inc->short_ids = NULL;
 }
 
 static int reset(struct sr_input *in)
@@ -2167,4 +2772,5 @@ SR_PRIV struct sr_input_module input_vcd = {
 	.end = end,
 	.cleanup = cleanup,
 	.reset = reset,
+	.parallel = TRUE,
 };
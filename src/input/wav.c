@@ -51,22 +51,24 @@ struct context {
 	int num_channels;
 	int unitsize;
 	gboolean found_data;
+	struct feed_queue_analog *feed;
 	GSList *prev_sr_channels;
 };
 
-static int parse_wav_header(GString *buf, struct context *inc)
+static int parse_wav_header(const uint8_t *buf, size_t len,
+	struct context *inc)
 {
 	uint64_t samplerate;
 	unsigned int fmt_code, samplesize, num_channels, unitsize;
 
-	if (buf->len < MIN_DATA_CHUNK_OFFSET)
+	if (len < MIN_DATA_CHUNK_OFFSET)
 		return SR_ERR_NA;
 
-	fmt_code = RL16(buf->str + 20);
-	samplerate = RL32(buf->str + 24);
+	fmt_code = RL16(buf + 20);
+	samplerate = RL32(buf + 24);
 
-	samplesize = RL16(buf->str + 32);
-	num_channels = RL16(buf->str + 22);
+	samplesize = RL16(buf + 32);
+	num_channels = RL16(buf + 22);
 	if (num_channels == 0)
 		return SR_ERR;
 	unitsize = samplesize / num_channels;
@@ -82,24 +84,24 @@ static int parse_wav_header(GString *buf, struct context *inc)
 			return SR_ERR_DATA;
 		}
 	} else if (fmt_code == WAVE_FORMAT_EXTENSIBLE_) {
-		if (buf->len < 70)
+		if (len < 70)
 			/* Not enough for extensible header and next chunk. */
 			return SR_ERR_NA;
 
-		if (RL16(buf->str + 16) != 40) {
+		if (RL16(buf + 16) != 40) {
 			sr_err("WAV extensible format chunk must be 40 bytes.");
 			return SR_ERR;
 		}
-		if (RL16(buf->str + 36) != 22) {
+		if (RL16(buf + 36) != 22) {
 			sr_err("WAV extension must be 22 bytes.");
 			return SR_ERR;
 		}
-		if (RL16(buf->str + 34) != RL16(buf->str + 38)) {
+		if (RL16(buf + 34) != RL16(buf + 38)) {
 			sr_err("Reduced valid bits per sample not supported.");
 			return SR_ERR_DATA;
 		}
 		/* Real format code is the first two bytes of the GUID. */
-		fmt_code = RL16(buf->str + 44);
+		fmt_code = RL16(buf + 44);
 		if (fmt_code != WAVE_FORMAT_PCM_ && fmt_code != WAVE_FORMAT_IEEE_FLOAT_) {
 			sr_err("Only PCM and floating point samples are supported.");
 			return SR_ERR_DATA;
@@ -141,7 +143,8 @@ static int format_match(GHashTable *metadata, unsigned int *confidence)
 	 * Only gets called when we already know this is a WAV file, so
 	 * this parser can log error messages.
 	 */
-	if ((ret = parse_wav_header(buf, NULL)) != SR_OK)
+	ret = parse_wav_header((const uint8_t *)buf->str, buf->len, NULL);
+	if (ret != SR_OK)
 		return ret;
 
 	*confidence = 1;
@@ -159,98 +162,81 @@ static int init(struct sr_input *in, GHashTable *options)
 	return SR_OK;
 }
 
-static int find_data_chunk(GString *buf, int initial_offset)
+static int find_data_chunk(const uint8_t *buf, size_t len, int initial_offset)
 {
 	unsigned int offset, i;
 
 	offset = initial_offset;
-	while (offset < MIN(MAX_DATA_CHUNK_OFFSET, buf->len)) {
-		if (!memcmp(buf->str + offset, "data", 4))
+	while (offset + 8 <= MIN(MAX_DATA_CHUNK_OFFSET, len)) {
+		if (!memcmp(buf + offset, "data", 4))
 			/* Skip into the samples. */
 			return offset + 8;
 		for (i = 0; i < 4; i++) {
-			if (!isalnum(buf->str[offset + i])
-					&& !isblank(buf->str[offset + i]))
+			if (!isalnum(buf[offset + i])
+					&& !isblank(buf[offset + i]))
 				/* Doesn't look like a chunk ID. */
 				return -1;
 		}
 		/* Skip past this chunk. */
-		offset += 8 + RL32(buf->str + offset + 4);
+		offset += 8 + RL32(buf + offset + 4);
 	}
 
 	if (offset > MAX_DATA_CHUNK_OFFSET)
 		return -1;
 
-	return offset;
+	/* Not found yet, needs more data. */
+	return 0;
 }
 
-static void send_chunk(const struct sr_input *in, int offset, int num_samples)
+/*
+ * Queue the file's sample data in its native encoding. Integer PCM data
+ * gets scaled to the [-1, 1] range ([0, 1] for unsigned 8-bit samples)
+ * by the consumers of the session feed.
+ */
+static int create_feed(const struct sr_input *in)
 {
-	struct sr_datafeed_packet packet;
-	struct sr_datafeed_analog analog;
-	struct sr_analog_encoding encoding;
-	struct sr_analog_meaning meaning;
-	struct sr_analog_spec spec;
 	struct context *inc;
-	float *fdata;
-	int total_samples, samplenum;
-	char *s, *d;
+	gboolean is_float, is_signed;
+	struct sr_rational scale;
 
 	inc = in->priv;
 
-	total_samples = num_samples * inc->num_channels;
-	fdata = g_malloc0(total_samples * sizeof(float));
-	s = in->buf->str + offset;
-	d = (char *)fdata;
-
-	for (samplenum = 0; samplenum < total_samples; samplenum++) {
-		if (inc->fmt_code == WAVE_FORMAT_PCM_) {
-			switch (inc->unitsize) {
-			case 1:
-				/* 8-bit PCM samples are unsigned. */
-				fdata[samplenum] = *(uint8_t*)(s) / (float)255;
-				break;
-			case 2:
-				fdata[samplenum] = RL16S(s) / (float)INT16_MAX;
-				break;
-			case 4:
-				fdata[samplenum] = RL32S(s) / (float)INT32_MAX;
-				break;
-			}
-		} else {
-			/* BINARY32 float */
-#ifdef WORDS_BIGENDIAN
-			int i;
-			for (i = 0; i < inc->unitsize; i++)
-				d[i] = s[inc->unitsize - 1 - i];
-#else
-			memcpy(d, s, inc->unitsize);
-#endif
-		}
-		s += inc->unitsize;
-		d += inc->unitsize;
+	is_float = inc->fmt_code == WAVE_FORMAT_IEEE_FLOAT_;
+	/* 8-bit PCM samples are unsigned. */
+	is_signed = is_float || inc->unitsize != 1;
+	/* TODO: Use proper 'digits' value for this device (and its modes). */
+	inc->feed = feed_queue_analog_alloc_encoded(in->sdi,
+		CHUNK_SIZE / inc->samplesize, 2, in->sdi->channels,
+		inc->unitsize, is_signed, is_float, FALSE);
+	if (!inc->feed)
+		return SR_ERR_MALLOC;
+	if (is_float)
+		return SR_OK;
+
+	switch (inc->unitsize) {
+	case 1:
+		sr_rational_set(&scale, 1, UINT8_MAX);
+		break;
+	case 2:
+		sr_rational_set(&scale, 1, INT16_MAX);
+		break;
+	default:
+		sr_rational_set(&scale, 1, INT32_MAX);
+		break;
 	}
 
-	/* TODO: Use proper 'digits' value for this device (and its modes). */
-	sr_analog_init(&analog, &encoding, &meaning, &spec, 2);
-	packet.type = SR_DF_ANALOG;
-	packet.payload = &analog;
-	analog.num_samples = num_samples;
-	analog.data = fdata;
-	analog.meaning->channels = in->sdi->channels;
-	analog.meaning->mq = 0;
-	analog.meaning->mqflags = 0;
-	analog.meaning->unit = 0;
-	sr_session_send(in->sdi, &packet);
-	g_free(fdata);
+	return feed_queue_analog_scale_offset(inc->feed, &scale, NULL);
 }
 
-static int process_buffer(struct sr_input *in)
+/* Send samples from a span, the number of bytes consumed goes to *used. */
+static int process_data(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
 {
 	struct context *inc;
-	int offset, chunk_samples, total_samples, processed, max_chunk_samples;
-	int num_samples, i;
+	size_t offset, chunk_samples;
+	int chunk_offset, ret;
 
+	*used = 0;
 	inc = in->priv;
 	if (!inc->started) {
 		std_session_send_df_header(in->sdi);
@@ -261,35 +247,44 @@ static int process_buffer(struct sr_input *in)
 
 	if (!inc->found_data) {
 		/* Skip past size of 'fmt ' chunk. */
-		i = 20 + RL32(in->buf->str + 16);
-		offset = find_data_chunk(in->buf, i);
-		if (offset < 0) {
-			if (in->buf->len > MAX_DATA_CHUNK_OFFSET) {
-				sr_err("Couldn't find data chunk.");
-				return SR_ERR;
-			}
+		chunk_offset = 20 + RL32(data + 16);
+		chunk_offset = find_data_chunk(data, length, chunk_offset);
+		if (chunk_offset == 0 && length <= MAX_DATA_CHUNK_OFFSET)
+			/* Not enough data yet. */
+			return SR_OK;
+		if (chunk_offset <= 0) {
+			sr_err("Couldn't find data chunk.");
+			return SR_ERR;
 		}
 		inc->found_data = TRUE;
-	} else
+		offset = chunk_offset;
+	} else {
 		offset = 0;
+	}
 
 	/* Round off up to the last channels * unitsize boundary. */
-	chunk_samples = (in->buf->len - offset) / inc->samplesize;
-	max_chunk_samples = CHUNK_SIZE / inc->samplesize;
-	processed = 0;
-	total_samples = chunk_samples;
-	while (processed < total_samples) {
-		if (chunk_samples > max_chunk_samples)
-			num_samples = max_chunk_samples;
-		else
-			num_samples = chunk_samples;
-		send_chunk(in, offset, num_samples);
-		offset += num_samples * inc->samplesize;
-		chunk_samples -= num_samples;
-		processed += num_samples;
-	}
+	chunk_samples = (length - offset) / inc->samplesize;
+	ret = feed_queue_analog_submit_many(inc->feed, data + offset,
+		chunk_samples);
+	if (ret != SR_OK)
+		return ret;
+	offset += chunk_samples * inc->samplesize;
+	*used = offset;
+
+	return SR_OK;
+}
+
+static int process_buffer(struct sr_input *in)
+{
+	size_t offset;
+	int ret;
 
-	if ((unsigned int)offset < in->buf->len) {
+	ret = process_data(in, (const uint8_t *)in->buf->str,
+		in->buf->len, &offset);
+	if (ret != SR_OK)
+		return ret;
+
+	if (offset < in->buf->len) {
 		/*
 		 * The incoming buffer wasn't processed completely. Stash
 		 * the leftover data for next time.
@@ -339,15 +334,15 @@ static int check_header_in_reread(const struct sr_input *in)
 	return TRUE;
 }
 
-static int receive(struct sr_input *in, GString *buf)
+/* Parse the header and create the channels, once enough data is seen. */
+static int process_header(struct sr_input *in,
+	const uint8_t *data, size_t length)
 {
 	struct context *inc;
 	int ret;
 	char channelname[16];
 
-	g_string_append_len(in->buf, buf->str, buf->len);
-
-	if (in->buf->len < MIN_DATA_CHUNK_OFFSET) {
+	if (length < MIN_DATA_CHUNK_OFFSET) {
 		/*
 		 * Don't even try until there's enough room
 		 * for the data segment to start.
@@ -356,28 +351,47 @@ static int receive(struct sr_input *in, GString *buf)
 	}
 
 	inc = in->priv;
-	if (!in->sdi_ready) {
-		if ((ret = parse_wav_header(in->buf, inc)) == SR_ERR_NA)
-			/* Not enough data yet. */
-			return SR_OK;
-		else if (ret != SR_OK)
-			return ret;
-
-		for (int i = 0; i < inc->num_channels; i++) {
-			snprintf(channelname, sizeof(channelname), "CH%d", i + 1);
-			sr_channel_new(in->sdi, i, SR_CHANNEL_ANALOG, TRUE, channelname);
-		}
-		if (!check_header_in_reread(in))
-			return SR_ERR_DATA;
-
-		/* sdi is ready, notify frontend. */
-		in->sdi_ready = TRUE;
+	if ((ret = parse_wav_header(data, length, inc)) == SR_ERR_NA)
+		/* Not enough data yet. */
 		return SR_OK;
+	else if (ret != SR_OK)
+		return ret;
+
+	for (int i = 0; i < inc->num_channels; i++) {
+		snprintf(channelname, sizeof(channelname), "CH%d", i + 1);
+		sr_channel_new(in->sdi, i, SR_CHANNEL_ANALOG, TRUE, channelname);
 	}
+	if (!check_header_in_reread(in))
+		return SR_ERR_DATA;
+	ret = create_feed(in);
+	if (ret != SR_OK)
+		return ret;
 
-	ret = process_buffer(in);
+	/* sdi is ready, notify frontend. */
+	in->sdi_ready = TRUE;
 
-	return ret;
+	return SR_OK;
+}
+
+static int receive(struct sr_input *in, GString *buf)
+{
+	g_string_append_len(in->buf, buf->str, buf->len);
+
+	if (!in->sdi_ready)
+		return process_header(in,
+			(const uint8_t *)in->buf->str, in->buf->len);
+
+	return process_buffer(in);
+}
+
+static int receive_span(struct sr_input *in,
+	const uint8_t *data, size_t length, size_t *used)
+{
+	*used = 0;
+	if (!in->sdi_ready)
+		return process_header(in, data, length);
+
+	return process_data(in, data, length, used);
 }
 
 static int end(struct sr_input *in)
@@ -391,16 +405,28 @@ static int end(struct sr_input *in)
 		ret = SR_OK;
 
 	inc = in->priv;
+	if (ret == SR_OK && inc->feed)
+		ret = feed_queue_analog_flush(inc->feed);
 	if (inc->started)
 		std_session_send_df_end(in->sdi);
 
 	return ret;
 }
 
+static void cleanup(struct sr_input *in)
+{
+	struct context *inc;
+
+	inc = in->priv;
+	feed_queue_analog_free(inc->feed);
+	inc->feed = NULL;
+}
+
 static int reset(struct sr_input *in)
 {
 	struct context *inc;
 
+	cleanup(in);
 	inc = in->priv;
 	memset(inc, 0, sizeof(*inc));
 
@@ -417,15 +443,23 @@ static int reset(struct sr_input *in)
 	return SR_OK;
 }
 
+static const struct sr_input_magic wav_magic[] = {
+	{ 0, 4, "RIFF", },
+	ALL_ZERO
+};
+
 SR_PRIV struct sr_input_module input_wav = {
 	.id = "wav",
 	.name = "WAV",
 	.desc = "Microsoft WAV file format data",
 	.exts = (const char*[]){"wav", NULL},
 	.metadata = { SR_INPUT_META_HEADER | SR_INPUT_META_REQUIRED },
+	.magic = wav_magic,
 	.format_match = format_match,
 	.init = init,
 	.receive = receive,
+	.receive_span = receive_span,
 	.end = end,
+	.cleanup = cleanup,
 	.reset = reset,
 };
@@ -1095,6 +1095,64 @@ static inline void write_dblle_inc(uint8_t **p, double x)
 	*p += sizeof(x);
 }
 
+/** Maximum length of a variable length encoded 64bit integer. */
+#define VARINT_MAX_LEN	10
+
+/**
+ * Write unsigned variable length integer to raw memory, increment write position.
+ *
+ * Uses the LEB128 encoding: Seven bits per byte, least significant
+ * group first, the MSB is set in all bytes but the last.
+ *
+ * @param[in, out] p Pointer into byte stream.
+ * @param[in] x Value to write.
+ */
+static inline void write_varint_inc(uint8_t **p, uint64_t x)
+{
+	if (!p || !*p)
+		return;
+	while (x >= 0x80) {
+		*(*p)++ = (x & 0x7f) | 0x80;
+		x >>= 7;
+	}
+	*(*p)++ = x;
+}
+
+/**
+ * Read unsigned variable length integer from raw memory, increment read position.
+ *
+ * @param[in, out] p Pointer into byte stream.
+ * @param[in] end End of the available data.
+ * @param[out] x Value which was read.
+ *
+ * @returns TRUE upon success, FALSE when the data is incomplete or
+ *   malformed. The read position is not changed in that case.
+ */
+static inline gboolean read_varint_inc(const uint8_t **p, const uint8_t *end,
+	uint64_t *x)
+{
+	const uint8_t *rdptr;
+	uint64_t value;
+	unsigned int shift;
+
+	if (!p || !*p || !x)
+		return FALSE;
+	rdptr = *p;
+	value = 0;
+	for (shift = 0; shift < 7 * VARINT_MAX_LEN; shift += 7) {
+		if (rdptr >= end)
+			return FALSE;
+		value |= (uint64_t)(*rdptr & 0x7f) << shift;
+		if (!(*rdptr++ & 0x80)) {
+			*p = rdptr;
+			*x = value;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
 /* Portability fixes for FreeBSD. */
 #ifdef __FreeBSD__
 #define LIBUSB_CLASS_APPLICATION 0xfe
@@ -1228,6 +1286,16 @@ enum sr_input_meta_keys {
 	SR_INPUT_META_REQUIRED = 0x80,
 };
 
+/** Byte signature at a fixed position of an input stream's header. */
+struct sr_input_magic {
+	/** Position of the signature, counted from the start of the stream. */
+	size_t offset;
+	/** Number of bytes to compare. */
+	size_t length;
+	/** The expected content. NULL terminates a list of signatures. */
+	const char *bytes;
+};
+
 /** Input (file) module struct. */
 struct sr_input {
 	/**
@@ -1237,6 +1305,12 @@ struct sr_input {
 	GString *buf;
 	struct sr_dev_inst *sdi;
 	gboolean sdi_ready;
+	/** Memory-mapped input file, see sr_input_open_mapped(). */
+	GMappedFile *map;
+	/** Offset of the first mapped byte not consumed by the module. */
+	size_t map_pos;
+	/** Worker threads, see sr_input_threads_set(). Can be NULL. */
+	struct input_parallel *parallel;
 	void *priv;
 };
 
@@ -1284,6 +1358,18 @@ struct sr_input_module {
 	 */
 	const uint8_t metadata[8];
 
+	/**
+	 * Zero-terminated list of byte signatures, one of which is present
+	 * in every stream the module can identify. Can be NULL, if the
+	 * format has no fixed signature, or the module also identifies
+	 * streams by other metadata (e.g. a filename extension).
+	 *
+	 * The scan routines check the signatures before format_match()
+	 * gets called, and skip the module when none of them is found in
+	 * the header.
+	 */
+	const struct sr_input_magic *magic;
+
 	/**
 	 * Returns a NULL-terminated list of options this module can take.
 	 * Can be NULL, if the module has no options.
@@ -1339,6 +1425,33 @@ struct sr_input_module {
 	 */
 	int (*receive) (struct sr_input *in, GString *buf);
 
+	/**
+	 * Process data from a read-only span, without copying it.
+	 *
+	 * This optional function is used for memory-mapped input files
+	 * (see sr_input_open_mapped()). The span covers all of the input
+	 * which was not consumed before. The module processes as much as
+	 * it can, and stores the number of consumed bytes in *used. The
+	 * remainder gets offered again in the next call, or is passed to
+	 * end() in the 'in->buf' receive buffer. The span's data must not
+	 * be referenced after the call returned.
+	 *
+	 * Like receive(), this returns the moment the device instance
+	 * became ready.
+	 *
+	 * @retval SR_OK Success
+	 * @retval other Negative error code.
+	 */
+	int (*receive_span) (struct sr_input *in,
+		const uint8_t *data, size_t length, size_t *used);
+
+	/**
+	 * Set when the module can parse received data on several threads,
+	 * see sr_input_threads_set(). The module splits its input into
+	 * ranges, and runs them with sr_input_parallel_start().
+	 */
+	gboolean parallel;
+
 	/**
 	 * Signal the input module no more data will come.
 	 *
@@ -1396,6 +1509,48 @@ struct sr_output {
 	 * there, and only flush it when it reaches a certain size.
 	 */
 	void *priv;
+
+	/**
+	 * The destination of the module's output, or NULL when output gets
+	 * returned to the caller of sr_output_send().
+	 */
+	struct sr_output_sink *sink;
+
+	/** The options the instance was created with. */
+	GHashTable *options;
+
+	/** Number of logic samples which were sent to the instance. */
+	uint64_t logic_pos;
+
+	/** Worker instances, see sr_output_threads_set(). Can be NULL. */
+	struct output_parallel *parallel;
+};
+
+/** State which carries into a range of logic samples, see carry_in(). */
+struct sr_output_carry {
+	/** The instance which formatted the samples before the range. */
+	const struct sr_output *from;
+	/** Number of logic samples before the range. */
+	uint64_t pos;
+	/** The last sample before the range, NULL if pos is 0. */
+	const uint8_t *prev;
+	/** Size of a logic sample, in bytes. */
+	size_t unitsize;
+};
+
+/** Destination of an output module's text, owned by an sr_output. */
+struct sr_output_sink {
+	/** File descriptor, or -1. */
+	int fd;
+	/** Stream, or NULL. */
+	FILE *file;
+	/** Callback which gets called with the buffered output, or NULL. */
+	sr_output_sink_callback cb;
+	void *cb_data;
+	/** Buffer which output modules append to, reused across packets. */
+	GString *buf;
+	/** Number of bytes which were passed on so far. */
+	uint64_t written;
 };
 
 /** Output module driver. */
@@ -1478,6 +1633,57 @@ struct sr_output_module {
 	int (*receive) (const struct sr_output *o,
 			const struct sr_datafeed_packet *packet, GString **out);
 
+	/**
+	 * Alternative to receive(), for modules which append their output
+	 * to a buffer that is owned by the caller. The buffer can hold text
+	 * from previous packets, modules must only append to it.
+	 *
+	 * Modules implement either receive() or append(). The output API
+	 * maps both to the caller's choice of a GString per packet, or an
+	 * output sink.
+	 *
+	 * @param o Pointer to the respective 'struct sr_output'.
+	 * @param packet The complete packet.
+	 * @param out The buffer to append output to. Never NULL.
+	 *
+	 * @retval SR_OK Success
+	 * @retval other Negative error code.
+	 */
+	int (*append) (const struct sr_output *o,
+			const struct sr_datafeed_packet *packet, GString *out);
+
+	/**
+	 * Optional, together with carry_in(). Lets the output API format
+	 * large logic packets in parallel, on several instances of the
+	 * module (see sr_output_threads_set()).
+	 *
+	 * Returns the number of samples which the start positions of
+	 * parallel ranges must be a multiple of, e.g. the line width of
+	 * text which is grouped by channel. Returns 0 when the instance's
+	 * current state doesn't allow splitting, e.g. before the header
+	 * was written, or while a trigger marker is pending.
+	 *
+	 * @param o Pointer to the respective 'struct sr_output'.
+	 */
+	size_t (*split_align) (const struct sr_output *o);
+
+	/**
+	 * Optional, see split_align(). Puts the instance into the state
+	 * it would have after formatting all logic samples before a range,
+	 * without generating output. Settings which were learned from the
+	 * session feed (like the samplerate) are taken from the instance
+	 * which formatted the samples before the range, which can be the
+	 * instance itself.
+	 *
+	 * @param o Pointer to the respective 'struct sr_output'.
+	 * @param carry Start of the range, aligned as per split_align().
+	 *
+	 * @retval SR_OK Success
+	 * @retval other Negative error code.
+	 */
+	int (*carry_in) (struct sr_output *o,
+			const struct sr_output_carry *carry);
+
 	/**
 	 * This function is called after the caller is finished using
 	 * the output module, and can be used to free any internal
@@ -1893,6 +2099,21 @@ SR_PRIV void sr_zip_discard(struct zip *archive);
 SR_PRIV GKeyFile *sr_sessionfile_read_metadata(struct zip *archive,
 			const struct zip_stat *entry);
 
+/** Memory mapped session archive, with an index of stored members. */
+struct sr_sessionfile_map {
+	GMappedFile *file;
+	uint8_t *data;
+	size_t size;
+	GHashTable *entries;
+};
+
+SR_PRIV struct sr_sessionfile_map *sr_sessionfile_map_open(const char *filename);
+SR_PRIV gboolean sr_sessionfile_map_lookup(const struct sr_sessionfile_map *map,
+	const char *name, uint8_t **data, size_t *size);
+SR_PRIV void sr_sessionfile_map_free(struct sr_sessionfile_map *map);
+SR_PRIV int sr_sessionfile_append(const char *filename, const char *name,
+	const uint8_t *data, size_t size, gboolean compress);
+
 /*--- analog.c --------------------------------------------------------------*/
 
 SR_PRIV int sr_analog_init(struct sr_datafeed_analog *analog,
@@ -2859,6 +3080,55 @@ SR_PRIV void sr_sw_limits_update_frames_read(struct sr_sw_limits *limits,
 	uint64_t frames_read);
 SR_PRIV void sr_sw_limits_init(struct sr_sw_limits *limits);
 
+/*--- input/input.c --------------------------------------------------------*/
+
+SR_PRIV size_t sr_input_threads_get(const struct sr_input *in);
+SR_PRIV void sr_input_parallel_start(const struct sr_input *in,
+	GFunc func, gpointer *jobs, size_t num_jobs);
+SR_PRIV void sr_input_parallel_wait(const struct sr_input *in);
+SR_PRIV size_t sr_input_parallel_jobs_get(const struct sr_input *in);
+
+/*--- output/output.c ------------------------------------------------------*/
+
+SR_PRIV int sr_output_drain(const struct sr_output *o, GString *out);
+SR_PRIV int sr_output_rewrite(const struct sr_output *o, uint64_t offset,
+	const void *data, size_t len);
+
+/*--- output/logic_text.c --------------------------------------------------*/
+
+SR_PRIV uint64_t sr_logic_text_gather(const uint8_t *data,
+	size_t unitsize, size_t count, size_t index);
+SR_PRIV uint64_t sr_logic_text_chars(uint64_t bits, char low, char high);
+SR_PRIV uint8_t sr_logic_text_pack(uint64_t bits);
+SR_PRIV void sr_logic_text_bitmap(uint8_t *out, size_t bitpos,
+	const uint8_t *data, size_t unitsize, size_t count, size_t index);
+SR_PRIV void sr_logic_text_values(uint8_t *out, size_t stride,
+	const uint8_t *data, size_t unitsize, size_t count, size_t index);
+SR_PRIV void sr_logic_text_format(char *out, const uint8_t *data,
+	size_t unitsize, size_t count, size_t index, char low, char high);
+SR_PRIV void sr_logic_text_hex(char *out, uint8_t value);
+
+/*--- Transitions file format, see output/transitions.c ---------------------*/
+
+#define TRANSITIONS_MAGIC	"SRTRANS"
+#define TRANSITIONS_MAGIC_LEN	7
+#define TRANSITIONS_VERSION	1
+
+enum transitions_channel_type {
+	TRANSITIONS_CHANNEL_LOGIC = 0,
+	TRANSITIONS_CHANNEL_ANALOG = 1,
+};
+
+enum transitions_record {
+	TRANSITIONS_REC_END = 0,
+	TRANSITIONS_REC_SAMPLERATE = 1,
+	TRANSITIONS_REC_LOGIC_VALUES = 2,
+	TRANSITIONS_REC_LOGIC_TOGGLE = 3,
+	TRANSITIONS_REC_TRIGGER = 4,
+	TRANSITIONS_REC_ANALOG_META = 5,
+	TRANSITIONS_REC_ANALOG_VALUE = 6,
+};
+
 /*--- feed_queue.h ----------------------------------------------------------*/
 
 struct feed_queue_logic;
@@ -2871,6 +3141,8 @@ SR_API int feed_queue_logic_submit_one(struct feed_queue_logic *q,
 	const uint8_t *data, size_t repeat_count);
 SR_API int feed_queue_logic_submit_many(struct feed_queue_logic *q,
 	const uint8_t *data, size_t samples_count);
+SR_API int feed_queue_logic_submit_runs(struct feed_queue_logic *q,
+	const uint8_t *data, const size_t *counts, size_t run_count);
 SR_API int feed_queue_logic_flush(struct feed_queue_logic *q);
 SR_API int feed_queue_logic_send_trigger(struct feed_queue_logic *q);
 SR_API void feed_queue_logic_free(struct feed_queue_logic *q);
@@ -2878,12 +3150,18 @@ SR_API void feed_queue_logic_free(struct feed_queue_logic *q);
 SR_API struct feed_queue_analog *feed_queue_analog_alloc(
 	const struct sr_dev_inst *sdi,
 	size_t sample_count, int digits, struct sr_channel *ch);
+SR_API struct feed_queue_analog *feed_queue_analog_alloc_encoded(
+	const struct sr_dev_inst *sdi, size_t sample_count, int digits,
+	GSList *channels, size_t unit_size, gboolean is_signed,
+	gboolean is_float, gboolean is_bigendian);
 SR_API int feed_queue_analog_mq_unit(struct feed_queue_analog *q,
 	enum sr_mq mq, enum sr_mqflag mq_flag, enum sr_unit unit);
 SR_API int feed_queue_analog_scale_offset(struct feed_queue_analog *q,
 	const struct sr_rational *scale, const struct sr_rational *offset);
 SR_API int feed_queue_analog_submit_one(struct feed_queue_analog *q,
 	float data, size_t repeat_count);
+SR_API int feed_queue_analog_submit_many(struct feed_queue_analog *q,
+	const uint8_t *data, size_t samples_count);
 SR_API int feed_queue_analog_flush(struct feed_queue_analog *q);
 SR_API void feed_queue_analog_free(struct feed_queue_analog *q);
 
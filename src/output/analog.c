@@ -18,6 +18,7 @@
  */
 
 #include <config.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -29,11 +30,23 @@
 
 #define BIN_TO_DEC_DIGITS (log(2) / log(10))
 
+/* How the values of a channel get printed, picked per packet. */
+struct value_format {
+	char *label;
+	size_t label_len;
+	char *suffix;
+	size_t suffix_len;
+	float factor;
+	int digits;
+};
+
 struct context {
 	int num_enabled_channels;
 	GPtrArray *channellist;
 	int digits;
 	float *fdata;
+	struct value_format *formats;
+	int num_formats;
 };
 
 enum {
@@ -72,6 +85,157 @@ static int init(struct sr_output *o, GHashTable *options)
 	return SR_OK;
 }
 
+/*
+ * Print a value like "%.*f" does, without going through printf for
+ * the common case. Values which are too large, or too close to the
+ * middle between two results, take the slow path for exact rounding.
+ * Returns the length of the text, like snprintf().
+ */
+static size_t format_fixed(char *buf, size_t size, float value, int digits)
+{
+	static const uint64_t pow10[] = {
+		1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+		10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+		100000000000ULL, 1000000000000ULL,
+	};
+	char tmp[24], *p;
+	double scaled, rem;
+	uint64_t num, frac;
+	size_t len;
+	int i;
+
+	if (!isfinite(value) || digits >= (int)ARRAY_SIZE(pow10))
+		return snprintf(buf, size, "%.*f", digits, value);
+	scaled = fabs((double)value) * pow10[digits];
+	if (scaled >= (double)(1ULL << 40))
+		return snprintf(buf, size, "%.*f", digits, value);
+	num = (uint64_t)scaled;
+	rem = scaled - num;
+	if (fabs(rem - 0.5) < 1e-3)
+		return snprintf(buf, size, "%.*f", digits, value);
+	if (rem > 0.5)
+		num++;
+
+	/* Build the number backwards, fractional digits first. */
+	p = tmp + sizeof(tmp);
+	frac = num % pow10[digits];
+	num /= pow10[digits];
+	for (i = 0; i < digits; i++) {
+		*--p = '0' + frac % 10;
+		frac /= 10;
+	}
+	if (digits)
+		*--p = '.';
+	do {
+		*--p = '0' + num % 10;
+		num /= 10;
+	} while (num);
+	if (signbit(value))
+		*--p = '-';
+
+	len = tmp + sizeof(tmp) - p;
+	if (len < size)
+		memcpy(buf, p, len);
+
+	return len;
+}
+
+/*
+ * The SI prefix is picked per channel, from its largest value in the
+ * packet, so all of the channel's values get printed in the same unit
+ * and with the same number of digits.
+ */
+static void select_formats(struct context *ctx,
+		const struct sr_datafeed_analog *analog, const float *fdata,
+		int num_channels, int digits)
+{
+	struct value_format *fmt;
+	struct sr_channel *ch;
+	const char *prefix;
+	char *unit;
+	GSList *l;
+	gboolean si_friendly;
+	float peak, value;
+	unsigned int i;
+	int c;
+
+	if (num_channels > ctx->num_formats) {
+		ctx->formats = g_realloc(ctx->formats, num_channels * sizeof(*fmt));
+		memset(&ctx->formats[ctx->num_formats], 0,
+			(num_channels - ctx->num_formats) * sizeof(*fmt));
+		ctx->num_formats = num_channels;
+	}
+
+	si_friendly = sr_analog_si_prefix_friendly(analog->meaning->unit);
+	sr_analog_unit_to_string(analog, &unit);
+	for (l = analog->meaning->channels, c = 0; l; l = l->next, c++) {
+		fmt = &ctx->formats[c];
+		ch = l->data;
+		g_free(fmt->label);
+		fmt->label = g_strconcat(ch->name, ": ", NULL);
+		fmt->label_len = strlen(fmt->label);
+		fmt->digits = digits;
+		fmt->factor = 1;
+		prefix = "";
+		if (si_friendly) {
+			peak = 0;
+			for (i = 0; i < analog->num_samples; i++) {
+				value = fabsf(fdata[i * num_channels + c]);
+				if (value > peak)
+					peak = value;
+			}
+			prefix = sr_analog_si_prefix(&peak, &fmt->digits);
+			if (fmt->digits != digits)
+				fmt->factor = powf(10, digits - fmt->digits);
+		}
+		g_free(fmt->suffix);
+		fmt->suffix = g_strconcat(" ", prefix, unit, "\n", NULL);
+		fmt->suffix_len = strlen(fmt->suffix);
+	}
+	g_free(unit);
+}
+
+static GString *format_values(struct context *ctx,
+		const struct sr_datafeed_analog *analog, const float *fdata,
+		int num_channels)
+{
+	const struct value_format *fmt;
+	GString *out;
+	char number[32];
+	size_t len;
+	unsigned int i;
+	float value;
+	int c;
+
+	/* Reserve enough room for typical numbers up front. */
+	len = 0;
+	for (c = 0; c < num_channels; c++) {
+		fmt = &ctx->formats[c];
+		len += fmt->label_len + sizeof(number) + fmt->suffix_len;
+	}
+	out = g_string_sized_new(len * analog->num_samples);
+
+	for (i = 0; i < analog->num_samples; i++) {
+		for (c = 0; c < num_channels; c++) {
+			fmt = &ctx->formats[c];
+			value = fdata[i * num_channels + c];
+			if (fmt->factor != 1)
+				value *= fmt->factor;
+			g_string_append_len(out, fmt->label, fmt->label_len);
+			len = format_fixed(number, sizeof(number), value,
+				MAX(fmt->digits, 0));
+			if (len < sizeof(number))
+				g_string_append_len(out, number, len);
+			else
+				g_string_append_printf(out, "%.*f",
+					MAX(fmt->digits, 0), value);
+			g_string_append_len(out, fmt->suffix, fmt->suffix_len);
+		}
+	}
+
+	return out;
+}
+
 static int receive(const struct sr_output *o, const struct sr_datafeed_packet *packet,
 		GString **out)
 {
@@ -80,12 +244,9 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 	const struct sr_datafeed_meta *meta;
 	const struct sr_config *src;
 	const struct sr_key_info *srci;
-	struct sr_channel *ch;
 	GSList *l;
 	float *fdata;
-	unsigned int i;
-	int num_channels, c, ret, digits, actual_digits;
-	char *number, *suffix;
+	int num_channels, ret, digits;
 
 	*out = NULL;
 	if (!o || !o->sdi)
@@ -134,34 +295,14 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 		ctx->fdata = fdata;
 		if ((ret = sr_analog_to_float(analog, fdata)) != SR_OK)
 			return ret;
-		*out = g_string_sized_new(512);
 		if (ctx->digits == DIGITS_ALL)
 			digits = analog->encoding->digits;
 		else
 			digits = analog->spec->spec_digits;
 		if (!analog->encoding->is_digits_decimal)
 			digits = copysign(ceil(abs(digits) * BIN_TO_DEC_DIGITS), digits);
-		gboolean si_friendly = sr_analog_si_prefix_friendly(analog->meaning->unit);
-		sr_analog_unit_to_string(analog, &suffix);
-		for (i = 0; i < analog->num_samples; i++) {
-			for (l = analog->meaning->channels, c = 0; l; l = l->next, c++) {
-				float value = fdata[i * num_channels + c];
-				const char *prefix = "";
-				actual_digits = digits;
-				if (si_friendly)
-					prefix = sr_analog_si_prefix(&value, &actual_digits);
-				ch = l->data;
-				g_string_append_printf(*out, "%s: ", ch->name);
-				number = g_strdup_printf("%.*f", MAX(actual_digits, 0), value);
-				g_string_append(*out, number);
-				g_free(number);
-				g_string_append(*out, " ");
-				g_string_append(*out, prefix);
-				g_string_append(*out, suffix);
-				g_string_append(*out, "\n");
-			}
-		}
-		g_free(suffix);
+		select_formats(ctx, analog, fdata, num_channels, digits);
+		*out = format_values(ctx, analog, fdata, num_channels);
 		break;
 	}
 
@@ -189,12 +330,18 @@ static const struct sr_option *get_options(void)
 static int cleanup(struct sr_output *o)
 {
 	struct context *ctx;
+	int i;
 
 	if (!o || !o->sdi)
 		return SR_ERR_ARG;
 	ctx = o->priv;
 
 	g_ptr_array_free(ctx->channellist, 1);
+	for (i = 0; i < ctx->num_formats; i++) {
+		g_free(ctx->formats[i].label);
+		g_free(ctx->formats[i].suffix);
+	}
+	g_free(ctx->formats);
 	if (options[0].def) {
 		g_variant_unref(options[0].def);
 		options[0].def = NULL;
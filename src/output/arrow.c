@@ -0,0 +1,686 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Columnar export in the Apache Arrow IPC streaming format.
+ *
+ * The stream holds a schema message, record batches, and an end of
+ * stream marker. Each enabled channel becomes one non-nullable column,
+ * in the device's channel order: logic channels are bit packed Bool
+ * columns, analog channels are Float32 columns. The optional "time"
+ * column comes first, it is a Duration in nanoseconds since the start
+ * of the acquisition. The samplerate is kept in the schema's custom
+ * metadata, when known at the time of the first data packet.
+ *
+ * Column data is kept in the form the IPC body needs (bitmaps and
+ * float arrays), and is written out without any further conversion.
+ * Logic and analog data arrive in separate packets, so rows are only
+ * emitted when all columns have received data for them.
+ *
+ * Metadata is FlatBuffers encoded. The few tables needed here are
+ * written by a minimal front to back encoder, which places every
+ * table's vtable right before the table, and child objects after
+ * their parent (FlatBuffers offsets must point forward).
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "output/arrow"
+
+#define DEFAULT_BATCH_ROWS	65536
+
+/* Schema.fbs and Message.fbs constants. */
+#define ARROW_METADATA_V5	4
+#define ARROW_HEADER_SCHEMA	1
+#define ARROW_HEADER_RECORD_BATCH	3
+#define ARROW_TYPE_FLOATING_POINT	3
+#define ARROW_TYPE_BOOL		6
+#define ARROW_TYPE_DURATION	18
+#define ARROW_PRECISION_SINGLE	1
+#define ARROW_TIME_UNIT_NS	3
+#define ARROW_ENDIAN_LITTLE	0
+#define ARROW_ENDIAN_BIG	1
+#define ARROW_CONTINUATION	0xffffffff
+
+#define FB_MAX_SLOTS		8
+
+struct column {
+	struct sr_channel *ch;
+	/* Bitmap for logic channels, native floats for analog channels. */
+	uint8_t *data;
+	size_t alloc;
+	size_t rows;
+};
+
+struct context {
+	gboolean time;
+	size_t batch_rows;
+	uint64_t samplerate;
+	gboolean header_done;
+	size_t num_columns;
+	struct column *columns;
+	uint64_t rows_done;
+	float *fdata;
+	size_t fdata_size;
+};
+
+/* FlatBuffer under construction, at the end of a GString. */
+struct fbuf {
+	GString *s;
+	size_t base;
+};
+
+static int init(struct sr_output *o, GHashTable *options)
+{
+	struct context *ctx;
+	struct sr_channel *ch;
+	GSList *l;
+	size_t rows;
+
+	if (!o || !o->sdi)
+		return SR_ERR_ARG;
+
+	ctx = g_malloc0(sizeof(*ctx));
+	o->priv = ctx;
+	ctx->time = g_variant_get_boolean(g_hash_table_lookup(options, "time"));
+	rows = g_variant_get_uint32(g_hash_table_lookup(options, "rows"));
+	/* Keep bitmaps byte aligned across batches. */
+	ctx->batch_rows = MAX((rows + 7) / 8 * 8, 8);
+
+	for (l = o->sdi->channels; l; l = l->next) {
+		ch = l->data;
+		if (ch->enabled && (ch->type == SR_CHANNEL_LOGIC ||
+				ch->type == SR_CHANNEL_ANALOG))
+			ctx->num_columns++;
+	}
+	ctx->columns = g_malloc0(ctx->num_columns * sizeof(ctx->columns[0]));
+	ctx->num_columns = 0;
+	for (l = o->sdi->channels; l; l = l->next) {
+		ch = l->data;
+		if (ch->enabled && (ch->type == SR_CHANNEL_LOGIC ||
+				ch->type == SR_CHANNEL_ANALOG))
+			ctx->columns[ctx->num_columns++].ch = ch;
+	}
+
+	return SR_OK;
+}
+
+static size_t fb_pos(const struct fbuf *fb)
+{
+	return fb->s->len - fb->base;
+}
+
+static uint8_t *fb_at(struct fbuf *fb, size_t pos)
+{
+	return (uint8_t *)&fb->s->str[fb->base + pos];
+}
+
+/* Append zeros until (position + extra) is a multiple of align. */
+static void fb_pad(struct fbuf *fb, size_t align, size_t extra)
+{
+	while ((fb_pos(fb) + extra) % align)
+		g_string_append_c(fb->s, 0);
+}
+
+static size_t fb_zeros(struct fbuf *fb, size_t len)
+{
+	size_t pos;
+
+	pos = fb_pos(fb);
+	g_string_set_size(fb->s, fb->s->len + len);
+	memset(fb_at(fb, pos), 0, len);
+
+	return pos;
+}
+
+/* Point the offset field at pos to the object at target. */
+static void fb_link(struct fbuf *fb, size_t pos, size_t target)
+{
+	write_u32le(fb_at(fb, pos), target - pos);
+}
+
+/*
+ * Write a table with the given field sizes (0 for absent fields), and
+ * its vtable. Fields are zero, the caller fills them in at the positions
+ * returned in pos[]. Returns the table's position.
+ */
+static size_t fb_table(struct fbuf *fb, size_t slots, const size_t *sizes,
+	size_t *pos)
+{
+	size_t off[FB_MAX_SLOTS], size, cur, vt_size, vt_pos, tab_pos, i;
+	uint8_t *p;
+
+	/* Largest fields first, after the vtable offset. */
+	cur = sizeof(int32_t);
+	for (size = 8; size; size /= 2) {
+		for (i = 0; i < slots; i++) {
+			if (sizes[i] != size)
+				continue;
+			cur = (cur + size - 1) / size * size;
+			off[i] = cur;
+			cur += size;
+		}
+	}
+
+	/* The table starts 8 byte aligned, right after its vtable. */
+	vt_size = sizeof(uint16_t) * (2 + slots);
+	fb_pad(fb, 8, vt_size);
+	vt_pos = fb_zeros(fb, vt_size + cur);
+	tab_pos = vt_pos + vt_size;
+	p = fb_at(fb, vt_pos);
+	write_u16le(p, vt_size);
+	write_u16le(p + 2, cur);
+	for (i = 0; i < slots; i++) {
+		write_u16le(p + 4 + 2 * i, sizes[i] ? off[i] : 0);
+		pos[i] = sizes[i] ? tab_pos + off[i] : 0;
+	}
+	write_u32le(fb_at(fb, tab_pos), tab_pos - vt_pos);
+
+	return tab_pos;
+}
+
+static size_t fb_string(struct fbuf *fb, const char *text)
+{
+	size_t pos, len;
+
+	len = strlen(text);
+	fb_pad(fb, 4, 0);
+	pos = fb_zeros(fb, sizeof(uint32_t));
+	write_u32le(fb_at(fb, pos), len);
+	g_string_append_len(fb->s, text, len + 1);
+
+	return pos;
+}
+
+/* Vector of count offsets, element i is at the returned position + 4 + 4 * i. */
+static size_t fb_vector(struct fbuf *fb, size_t count)
+{
+	size_t pos;
+
+	fb_pad(fb, 4, 0);
+	pos = fb_zeros(fb, sizeof(uint32_t) * (1 + count));
+	write_u32le(fb_at(fb, pos), count);
+
+	return pos;
+}
+
+/* Vector of structs made of two 64-bit integers (FieldNode, Buffer). */
+static size_t fb_pairs(struct fbuf *fb, const uint64_t *pairs, size_t count)
+{
+	size_t pos, i;
+	uint8_t *p;
+
+	fb_pad(fb, 8, sizeof(uint32_t));
+	pos = fb_zeros(fb, sizeof(uint32_t) + 16 * count);
+	p = fb_at(fb, pos);
+	write_u32le(p, count);
+	for (i = 0; i < 2 * count; i++)
+		write_u64le(p + 4 + 8 * i, pairs[i]);
+
+	return pos;
+}
+
+/*
+ * Start an encapsulated IPC message: continuation marker, metadata
+ * length, and the root offset of the metadata's Message table, which
+ * is written right away. Returns the Message table's position.
+ */
+static size_t message_begin(struct fbuf *fb, GString *out, int header_type,
+	uint64_t body_len, size_t *header_pos)
+{
+	static const size_t sizes[] = { 2, 1, 4, 8, 0, };
+	size_t pos[ARRAY_SIZE(sizes)], root, msg;
+	uint8_t prefix[8];
+
+	write_u32le(prefix, ARROW_CONTINUATION);
+	write_u32le(prefix + 4, 0);
+	g_string_append_len(out, (const char *)prefix, sizeof(prefix));
+	fb->s = out;
+	fb->base = out->len;
+
+	root = fb_zeros(fb, sizeof(uint32_t));
+	msg = fb_table(fb, ARRAY_SIZE(sizes), sizes, pos);
+	fb_link(fb, root, msg);
+	write_u16le(fb_at(fb, pos[0]), ARROW_METADATA_V5);
+	*fb_at(fb, pos[1]) = header_type;
+	write_u64le(fb_at(fb, pos[3]), body_len);
+	*header_pos = pos[2];
+
+	return msg;
+}
+
+/* Pad the metadata, so that the body starts 8 byte aligned. */
+static void message_end(struct fbuf *fb)
+{
+	fb_pad(fb, 8, 0);
+	write_u32le(fb_at(fb, 0) - 4, fb_pos(fb));
+}
+
+static uint8_t host_endianness(void)
+{
+	return G_BYTE_ORDER == G_BIG_ENDIAN ? ARROW_ENDIAN_BIG : ARROW_ENDIAN_LITTLE;
+}
+
+static void append_field(struct fbuf *fb, size_t link, const char *name,
+	int type)
+{
+	static const size_t field_sizes[] = { 4, 1, 1, 4, 0, 4, };
+	static const size_t short_sizes[] = { 2, };
+	size_t pos[ARRAY_SIZE(field_sizes)], tpos[1], tab;
+
+	tab = fb_table(fb, ARRAY_SIZE(field_sizes), field_sizes, pos);
+	fb_link(fb, link, tab);
+	*fb_at(fb, pos[2]) = type;
+
+	fb_link(fb, pos[0], fb_string(fb, name));
+	if (type == ARROW_TYPE_BOOL) {
+		tab = fb_table(fb, 0, NULL, tpos);
+	} else {
+		tab = fb_table(fb, ARRAY_SIZE(short_sizes), short_sizes, tpos);
+		write_u16le(fb_at(fb, tpos[0]), type == ARROW_TYPE_DURATION ?
+			ARROW_TIME_UNIT_NS : ARROW_PRECISION_SINGLE);
+	}
+	fb_link(fb, pos[3], tab);
+	/* Readers insist on a children vector, even an empty one. */
+	fb_link(fb, pos[5], fb_vector(fb, 0));
+}
+
+static void append_schema(struct context *ctx, GString *out)
+{
+	static const size_t schema_sizes[] = { 2, 4, 4, };
+	static const size_t kv_sizes[] = { 4, 4, };
+	struct fbuf fb;
+	struct column *col;
+	size_t pos[ARRAY_SIZE(schema_sizes)], kv_pos[ARRAY_SIZE(kv_sizes)];
+	size_t header, tab, vec, i, n;
+	char *value;
+
+	if (ctx->header_done)
+		return;
+	ctx->header_done = TRUE;
+
+	message_begin(&fb, out, ARROW_HEADER_SCHEMA, 0, &header);
+	tab = fb_table(&fb, ARRAY_SIZE(schema_sizes), schema_sizes, pos);
+	fb_link(&fb, header, tab);
+	write_u16le(fb_at(&fb, pos[0]), host_endianness());
+
+	vec = fb_vector(&fb, ctx->time + ctx->num_columns);
+	fb_link(&fb, pos[1], vec);
+	n = 0;
+	if (ctx->time)
+		append_field(&fb, vec + 4 + 4 * n++, "time", ARROW_TYPE_DURATION);
+	for (i = 0; i < ctx->num_columns; i++) {
+		col = &ctx->columns[i];
+		append_field(&fb, vec + 4 + 4 * n++, col->ch->name,
+			col->ch->type == SR_CHANNEL_LOGIC ?
+			ARROW_TYPE_BOOL : ARROW_TYPE_FLOATING_POINT);
+	}
+
+	vec = fb_vector(&fb, ctx->samplerate ? 1 : 0);
+	fb_link(&fb, pos[2], vec);
+	if (ctx->samplerate) {
+		tab = fb_table(&fb, ARRAY_SIZE(kv_sizes), kv_sizes, kv_pos);
+		fb_link(&fb, vec + 4, tab);
+		fb_link(&fb, kv_pos[0], fb_string(&fb, "samplerate"));
+		value = g_strdup_printf("%" PRIu64, ctx->samplerate);
+		fb_link(&fb, kv_pos[1], fb_string(&fb, value));
+		g_free(value);
+	}
+
+	message_end(&fb);
+}
+
+static size_t column_bytes(const struct column *col, size_t rows)
+{
+	if (col->ch->type == SR_CHANNEL_LOGIC)
+		return (rows + 7) / 8;
+
+	return rows * sizeof(float);
+}
+
+static void append_padded(GString *out, const void *data, size_t len)
+{
+	g_string_append_len(out, data, len);
+	while (len++ % 8)
+		g_string_append_c(out, 0);
+}
+
+/* Write a record batch from the rows at offset (a multiple of 8). */
+static void append_batch(struct context *ctx, GString *out, size_t offset,
+	size_t rows)
+{
+	static const size_t batch_sizes[] = { 8, 4, 4, };
+	struct fbuf fb;
+	struct column *col;
+	uint64_t *nodes, *buffers, body_len, rate, snum;
+	int64_t ns;
+	size_t pos[ARRAY_SIZE(batch_sizes)], header, tab, n, i, len;
+	uint8_t *data, last;
+
+	n = ctx->time + ctx->num_columns;
+	nodes = g_malloc(2 * n * sizeof(nodes[0]));
+	buffers = g_malloc(4 * n * sizeof(buffers[0]));
+	body_len = 0;
+	for (i = 0; i < n; i++) {
+		if (ctx->time && i == 0)
+			len = rows * sizeof(int64_t);
+		else
+			len = column_bytes(&ctx->columns[i - ctx->time], rows);
+		nodes[2 * i + 0] = rows;
+		nodes[2 * i + 1] = 0;
+		/* No validity bitmap, then the values. */
+		buffers[4 * i + 0] = body_len;
+		buffers[4 * i + 1] = 0;
+		buffers[4 * i + 2] = body_len;
+		buffers[4 * i + 3] = len;
+		body_len += (len + 7) / 8 * 8;
+	}
+
+	message_begin(&fb, out, ARROW_HEADER_RECORD_BATCH, body_len, &header);
+	tab = fb_table(&fb, ARRAY_SIZE(batch_sizes), batch_sizes, pos);
+	fb_link(&fb, header, tab);
+	write_u64le(fb_at(&fb, pos[0]), rows);
+	fb_link(&fb, pos[1], fb_pairs(&fb, nodes, n));
+	fb_link(&fb, pos[2], fb_pairs(&fb, buffers, 2 * n));
+	message_end(&fb);
+	g_free(nodes);
+	g_free(buffers);
+
+	if (ctx->time) {
+		rate = ctx->samplerate;
+		len = out->len;
+		g_string_set_size(out, len + rows * sizeof(int64_t));
+		for (i = 0; i < rows; i++) {
+			snum = ctx->rows_done + offset + i;
+			/* Split the division, so that it doesn't overflow. */
+			ns = rate ? (snum / rate) * 1000000000 +
+				(snum % rate) * 1000000000 / rate : 0;
+			memcpy(&out->str[len + i * sizeof(ns)], &ns, sizeof(ns));
+		}
+	}
+	for (i = 0; i < ctx->num_columns; i++) {
+		col = &ctx->columns[i];
+		len = column_bytes(col, rows);
+		if (col->ch->type == SR_CHANNEL_LOGIC) {
+			data = &col->data[offset / 8];
+			if (rows % 8) {
+				/* Clear the padding bits of the last byte. */
+				last = data[len - 1];
+				data[len - 1] &= (1 << (rows % 8)) - 1;
+				append_padded(out, data, len);
+				data[len - 1] = last;
+				continue;
+			}
+		} else {
+			data = &col->data[offset * sizeof(float)];
+		}
+		append_padded(out, data, len);
+	}
+}
+
+/*
+ * Emit complete batches of rows which all columns have data for. At the
+ * end of the stream, the remaining rows are emitted as well.
+ */
+static void append_batches(struct context *ctx, GString *out, gboolean final)
+{
+	struct column *col;
+	size_t rows, offset, count, i, len, drop;
+
+	if (!ctx->num_columns)
+		return;
+	rows = ctx->columns[0].rows;
+	for (i = 1; i < ctx->num_columns; i++)
+		rows = MIN(rows, ctx->columns[i].rows);
+
+	offset = 0;
+	while (rows - offset >= ctx->batch_rows || (final && rows > offset)) {
+		count = MIN(rows - offset, ctx->batch_rows);
+		append_batch(ctx, out, offset, count);
+		offset += count;
+	}
+	if (!offset)
+		return;
+	ctx->rows_done += offset;
+
+	if (final) {
+		for (i = 0; i < ctx->num_columns; i++) {
+			col = &ctx->columns[i];
+			if (col->rows > rows)
+				sr_warn("Dropping %zu samples of channel %s, which "
+					"other channels have no data for.",
+					col->rows - rows, col->ch->name);
+			col->rows = 0;
+		}
+		return;
+	}
+
+	/* Move the remaining rows to the start of the buffers. */
+	for (i = 0; i < ctx->num_columns; i++) {
+		col = &ctx->columns[i];
+		drop = column_bytes(col, offset);
+		len = column_bytes(col, col->rows) - drop;
+		memmove(col->data, col->data + drop, len);
+		memset(col->data + len, 0, drop);
+		col->rows -= offset;
+	}
+}
+
+/* Make room for the given number of rows, new room is zeroed. */
+static int column_reserve(struct column *col, size_t rows)
+{
+	size_t size;
+	uint8_t *data;
+
+	size = column_bytes(col, rows);
+	if (size <= col->alloc)
+		return SR_OK;
+	size = MAX(size, 2 * col->alloc);
+	data = g_try_realloc(col->data, size);
+	if (!data)
+		return SR_ERR_MALLOC;
+	memset(data + col->alloc, 0, size - col->alloc);
+	col->data = data;
+	col->alloc = size;
+
+	return SR_OK;
+}
+
+static int append_logic(struct context *ctx,
+	const struct sr_datafeed_logic *logic)
+{
+	struct column *col;
+	size_t count, i;
+	int ret;
+
+	if (!logic->unitsize)
+		return SR_OK;
+	count = logic->length / logic->unitsize;
+	for (i = 0; i < ctx->num_columns; i++) {
+		col = &ctx->columns[i];
+		if (col->ch->type != SR_CHANNEL_LOGIC)
+			continue;
+		if ((ret = column_reserve(col, col->rows + count)) != SR_OK)
+			return ret;
+		/* Channels beyond the sample's width read as low. */
+		if ((size_t)col->ch->index < 8 * logic->unitsize)
+			sr_logic_text_bitmap(col->data, col->rows, logic->data,
+				logic->unitsize, count, col->ch->index);
+		col->rows += count;
+	}
+
+	return SR_OK;
+}
+
+static int append_analog(struct context *ctx,
+	const struct sr_datafeed_analog *analog)
+{
+	struct column *col;
+	float *values;
+	GSList *l;
+	size_t num_channels, c, i, k, size;
+	int ret;
+
+	num_channels = g_slist_length(analog->meaning->channels);
+	size = analog->num_samples * num_channels;
+	if (!size)
+		return SR_OK;
+	if (ctx->fdata_size < size) {
+		g_free(ctx->fdata);
+		ctx->fdata = g_try_malloc(size * sizeof(ctx->fdata[0]));
+		ctx->fdata_size = ctx->fdata ? size : 0;
+		if (!ctx->fdata)
+			return SR_ERR_MALLOC;
+	}
+	ret = sr_analog_to_float(analog, ctx->fdata);
+	if (ret != SR_OK)
+		return ret;
+
+	for (c = 0, l = analog->meaning->channels; l; l = l->next, c++) {
+		col = NULL;
+		for (i = 0; i < ctx->num_columns; i++) {
+			if (ctx->columns[i].ch == l->data) {
+				col = &ctx->columns[i];
+				break;
+			}
+		}
+		if (!col)
+			continue;
+		ret = column_reserve(col, col->rows + analog->num_samples);
+		if (ret != SR_OK)
+			return ret;
+		values = (float *)col->data + col->rows;
+		if (num_channels == 1) {
+			memcpy(values, ctx->fdata, size * sizeof(float));
+		} else {
+			for (k = 0; k < analog->num_samples; k++)
+				values[k] = ctx->fdata[k * num_channels + c];
+		}
+		col->rows += analog->num_samples;
+	}
+
+	return SR_OK;
+}
+
+static int append(const struct sr_output *o, const struct sr_datafeed_packet *packet,
+		GString *out)
+{
+	struct context *ctx;
+	const struct sr_datafeed_meta *meta;
+	const struct sr_config *src;
+	GSList *l;
+	uint8_t eos[8];
+	int ret;
+
+	if (!o || !o->sdi)
+		return SR_ERR_ARG;
+	if (!(ctx = o->priv))
+		return SR_ERR_ARG;
+
+	switch (packet->type) {
+	case SR_DF_META:
+		meta = packet->payload;
+		for (l = meta->config; l; l = l->next) {
+			src = l->data;
+			if (src->key != SR_CONF_SAMPLERATE)
+				continue;
+			if (ctx->header_done)
+				sr_warn("Samplerate change after the schema, "
+					"ignoring.");
+			else
+				ctx->samplerate = g_variant_get_uint64(src->data);
+		}
+		break;
+	case SR_DF_LOGIC:
+		append_schema(ctx, out);
+		if ((ret = append_logic(ctx, packet->payload)) != SR_OK)
+			return ret;
+		append_batches(ctx, out, FALSE);
+		break;
+	case SR_DF_ANALOG:
+		append_schema(ctx, out);
+		if ((ret = append_analog(ctx, packet->payload)) != SR_OK)
+			return ret;
+		append_batches(ctx, out, FALSE);
+		break;
+	case SR_DF_END:
+		append_schema(ctx, out);
+		append_batches(ctx, out, TRUE);
+		write_u32le(eos, ARROW_CONTINUATION);
+		write_u32le(eos + 4, 0);
+		g_string_append_len(out, (const char *)eos, sizeof(eos));
+		break;
+	}
+
+	return SR_OK;
+}
+
+static struct sr_option options[] = {
+	{"time", "Time column", "Add a column with the sample time in ns", NULL, NULL},
+	{"rows", "Rows per batch", "Maximum number of rows per record batch", NULL, NULL},
+	ALL_ZERO
+};
+
+static const struct sr_option *get_options(void)
+{
+	if (!options[0].def) {
+		options[0].def = g_variant_ref_sink(g_variant_new_boolean(FALSE));
+		options[1].def = g_variant_ref_sink(g_variant_new_uint32(DEFAULT_BATCH_ROWS));
+	}
+
+	return options;
+}
+
+static int cleanup(struct sr_output *o)
+{
+	struct context *ctx;
+	size_t i;
+
+	if (!o)
+		return SR_ERR_ARG;
+
+	if (!(ctx = o->priv))
+		return SR_OK;
+
+	for (i = 0; i < ctx->num_columns; i++)
+		g_free(ctx->columns[i].data);
+	g_free(ctx->columns);
+	g_free(ctx->fdata);
+	g_free(ctx);
+	o->priv = NULL;
+
+	return SR_OK;
+}
+
+SR_PRIV struct sr_output_module output_arrow = {
+	.id = "arrow",
+	.name = "Arrow IPC",
+	.desc = "Apache Arrow IPC stream, one column per channel",
+	.exts = (const char*[]){"arrows", NULL},
+	.flags = 0,
+	.options = get_options,
+	.init = init,
+	.append = append,
+	.cleanup = cleanup,
+};
@@ -121,11 +121,10 @@ static int init(struct sr_output *o, GHashTable *options)
 	return SR_OK;
 }
 
-static GString *gen_header(const struct sr_output *o)
+static void gen_header(const struct sr_output *o, GString *header)
 {
 	struct context *ctx;
 	GVariant *gvar;
-	GString *header;
 	size_t num_channels;
 	char *samplerate_s;
 
@@ -138,8 +137,7 @@ static GString *gen_header(const struct sr_output *o)
 		}
 	}
 
-	header = g_string_sized_new(512);
-	g_string_printf(header, "%s %s\n", PACKAGE_NAME, sr_package_version_string_get());
+	g_string_append_printf(header, "%s %s\n", PACKAGE_NAME, sr_package_version_string_get());
 	num_channels = g_slist_length(o->sdi->channels);
 	g_string_append_printf(header, "Acquisition with %zu/%zu channels",
 			ctx->num_enabled_channels, num_channels);
@@ -149,8 +147,6 @@ static GString *gen_header(const struct sr_output *o)
 		g_free(samplerate_s);
 	}
 	g_string_append_printf(header, "\n");
-
-	return header;
 }
 
 static void maybe_add_trigger(struct context *ctx, GString *out)
@@ -172,23 +168,22 @@ static void maybe_add_trigger(struct context *ctx, GString *out)
 		offset + 1, "^", offset);
 }
 
-static int receive(const struct sr_output *o, const struct sr_datafeed_packet *packet,
-		GString **out)
+static int append(const struct sr_output *o, const struct sr_datafeed_packet *packet,
+		GString *out)
 {
 	const struct sr_datafeed_meta *meta;
 	const struct sr_datafeed_logic *logic;
 	const struct sr_config *src;
 	GSList *l;
 	struct context *ctx;
-	size_t idx, i, j;
+	GString *line;
+	size_t idx, i, j, k, n, len;
 	size_t num_samples;
 	const uint8_t *curr_sample;
-	size_t bytepos;
-	uint8_t bitmask, curbit, prevbit;
-	char c;
+	uint64_t bits, prevbits, edges, mask;
+	gboolean line_start;
 	size_t charidx;
 
-	*out = NULL;
 	if (!o || !o->sdi)
 		return SR_ERR_ARG;
 	if (!(ctx = o->priv))
@@ -209,57 +204,79 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 		break;
 	case SR_DF_LOGIC:
 		if (!ctx->header_done) {
-			*out = gen_header(o);
+			gen_header(o, out);
 			ctx->header_done = TRUE;
-		} else {
-			*out = g_string_sized_new(512);
 		}
 
+		/*
+		 * Format runs of up to eight samples. Edges are detected by
+		 * comparing each sample with its predecessor, which for the
+		 * run's first sample is the previously processed sample. Line
+		 * starts never show edges.
+		 */
 		logic = packet->payload;
 		num_samples = logic->length / logic->unitsize;
 		curr_sample = logic->data;
-		while (num_samples--) {
-			ctx->spl_cnt++;
+		while (num_samples) {
+			n = MIN(num_samples, 8);
+			if (ctx->spl && n > ctx->spl - ctx->spl_cnt)
+				n = ctx->spl - ctx->spl_cnt;
+			line_start = ctx->spl_cnt == 0;
+			mask = (n == 8) ? ~0ULL : (1ULL << (8 * n)) - 1;
+			ctx->spl_cnt += n;
 			for (j = 0; j < ctx->num_enabled_channels; j++) {
 				idx = ctx->channel_index[j];
-				bytepos = idx / 8;
-				bitmask = 1U << (idx % 8);
-				curbit = curr_sample[bytepos] & bitmask;
-				prevbit = ctx->prev_sample[bytepos] & bitmask;
-
-				charidx = curbit ? 1 : 0;
-				if (ctx->edges && ctx->spl_cnt > 1) {
-					if (curbit != prevbit)
-						charidx += 2;
+				line = ctx->lines[j];
+				len = line->len;
+				g_string_set_size(line, len + n);
+				bits = sr_logic_text_gather(curr_sample,
+					logic->unitsize, n, idx);
+				edges = 0;
+				if (ctx->edges) {
+					prevbits = bits << 8;
+					prevbits |= (ctx->prev_sample[idx / 8] >> (idx % 8)) & 1;
+					edges = (bits ^ prevbits) & mask;
+					if (line_start)
+						edges &= ~0xffULL;
+				}
+				if (!edges && n == 8) {
+					write_u64le((uint8_t *)line->str + len,
+						sr_logic_text_chars(bits,
+						ctx->charset[0], ctx->charset[1]));
+				} else {
+					for (k = 0; k < n; k++) {
+						charidx = (bits >> (8 * k)) & 1;
+						charidx += 2 * ((edges >> (8 * k)) & 1);
+						line->str[len + k] = ctx->charset[charidx];
+					}
 				}
-				c = ctx->charset[charidx];
-				g_string_append_c(ctx->lines[j], c);
 
 				if (ctx->spl_cnt == ctx->spl) {
 					/* Flush line buffers. */
-					g_string_append_len(*out, ctx->lines[j]->str, ctx->lines[j]->len);
-					g_string_append_c(*out, '\n');
+					g_string_append_len(out, line->str, line->len);
+					g_string_append_c(out, '\n');
 					if (j + 1 == ctx->num_enabled_channels)
-						maybe_add_trigger(ctx, *out);
-					g_string_printf(ctx->lines[j], "%s:", ctx->aligned_names[j]);
+						maybe_add_trigger(ctx, out);
+					g_string_printf(line, "%s:", ctx->aligned_names[j]);
 				}
 			}
 			if (ctx->spl_cnt == ctx->spl)
 				/* Line buffers were already flushed. */
 				ctx->spl_cnt = 0;
-			memcpy(ctx->prev_sample, curr_sample, logic->unitsize);
-			curr_sample += logic->unitsize;
+			curr_sample += n * logic->unitsize;
+			memcpy(ctx->prev_sample, curr_sample - logic->unitsize,
+				logic->unitsize);
+			num_samples -= n;
 		}
 		break;
 	case SR_DF_END:
 		if (ctx->spl_cnt) {
 			/* Line buffers need flushing. */
-			*out = g_string_sized_new(512);
 			for (i = 0; i < ctx->num_enabled_channels; i++) {
-				g_string_append_len(*out, ctx->lines[i]->str, ctx->lines[i]->len);
-				g_string_append_c(*out, '\n');
+				g_string_append_len(out, ctx->lines[i]->str, ctx->lines[i]->len);
+				g_string_append_c(out, '\n');
 			}
-			maybe_add_trigger(ctx, *out);
+			maybe_add_trigger(ctx, out);
 		}
 		break;
 	}
@@ -267,6 +284,38 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 	return SR_OK;
 }
 
+/* Ranges start on line boundaries, where the line buffers are empty. */
+static size_t split_align(const struct sr_output *o)
+{
+	struct context *ctx;
+
+	ctx = o->priv;
+	if (!ctx->header_done || ctx->trigger > -1)
+		return 0;
+
+	return ctx->spl;
+}
+
+static int carry_in(struct sr_output *o, const struct sr_output_carry *carry)
+{
+	struct context *ctx;
+	const struct context *from;
+
+	ctx = o->priv;
+	from = carry->from->priv;
+	if (!ctx->spl || carry->pos % ctx->spl)
+		return SR_ERR_ARG;
+	if (carry->unitsize > g_slist_length(o->sdi->channels))
+		return SR_ERR_ARG;
+	ctx->samplerate = from->samplerate;
+	ctx->header_done = TRUE;
+	ctx->spl_cnt = 0;
+	if (carry->prev)
+		memcpy(ctx->prev_sample, carry->prev, carry->unitsize);
+
+	return SR_OK;
+}
+
 static int cleanup(struct sr_output *o)
 {
 	struct context *ctx;
@@ -319,6 +368,8 @@ SR_PRIV struct sr_output_module output_ascii = {
 	.flags = 0,
 	.options = get_options,
 	.init = init,
-	.receive = receive,
+	.append = append,
+	.split_align = split_align,
+	.carry_in = carry_in,
 	.cleanup = cleanup,
 };
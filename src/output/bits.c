@@ -84,11 +84,10 @@ static int init(struct sr_output *o, GHashTable *options)
 	return SR_OK;
 }
 
-static GString *gen_header(const struct sr_output *o)
+static void gen_header(const struct sr_output *o, GString *header)
 {
 	struct context *ctx;
 	GVariant *gvar;
-	GString *header;
 	int num_channels;
 	char *samplerate_s;
 
@@ -101,8 +100,7 @@ static GString *gen_header(const struct sr_output *o)
 		}
 	}
 
-	header = g_string_sized_new(512);
-	g_string_printf(header, "%s %s\n", PACKAGE_NAME, sr_package_version_string_get());
+	g_string_append_printf(header, "%s %s\n", PACKAGE_NAME, sr_package_version_string_get());
 	num_channels = g_slist_length(o->sdi->channels);
 	g_string_append_printf(header, "Acquisition with %d/%d channels",
 			ctx->num_enabled_channels, num_channels);
@@ -112,23 +110,21 @@ static GString *gen_header(const struct sr_output *o)
 		g_free(samplerate_s);
 	}
 	g_string_append_printf(header, "\n");
-
-	return header;
 }
 
-static int receive(const struct sr_output *o, const struct sr_datafeed_packet *packet,
-		GString **out)
+static int append(const struct sr_output *o, const struct sr_datafeed_packet *packet,
+		GString *out)
 {
 	const struct sr_datafeed_meta *meta;
 	const struct sr_datafeed_logic *logic;
 	const struct sr_config *src;
 	struct context *ctx;
 	GSList *l;
-	int idx, offset;
-	uint64_t i, j;
-	gchar *p, c;
+	GString *line;
+	const uint8_t *data;
+	int offset;
+	size_t num_samples, n, len, i, j;
 
-	*out = NULL;
 	if (!o || !o->sdi)
 		return SR_ERR_ARG;
 	if (!(ctx = o->priv))
@@ -149,24 +145,35 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 		break;
 	case SR_DF_LOGIC:
 		if (!ctx->header_done) {
-			*out = gen_header(o);
+			gen_header(o, out);
 			ctx->header_done = TRUE;
-		} else
-			*out = g_string_sized_new(512);
+		}
 
+		/*
+		 * Format runs of samples up to the next separator or line
+		 * end. Each run is at most one byte of sample data.
+		 */
 		logic = packet->payload;
-		for (i = 0; i <= logic->length - logic->unitsize; i += logic->unitsize) {
-			ctx->spl_cnt++;
+		data = logic->data;
+		num_samples = logic->length / logic->unitsize;
+		while (num_samples) {
+			n = 8 - (ctx->spl_cnt & 7);
+			if (ctx->spl && n > (size_t)(ctx->spl - ctx->spl_cnt))
+				n = ctx->spl - ctx->spl_cnt;
+			n = MIN(n, num_samples);
+			ctx->spl_cnt += n;
 			for (j = 0; j < ctx->num_enabled_channels; j++) {
-				idx = ctx->channel_index[j];
-				p = logic->data + i + idx / 8;
-				c = (*p & (1 << (idx % 8))) ? '1' : '0';
-				g_string_append_c(ctx->lines[j], c);
+				line = ctx->lines[j];
+				len = line->len;
+				g_string_set_size(line, len + n);
+				sr_logic_text_format(line->str + len, data,
+					logic->unitsize, n, ctx->channel_index[j],
+					'0', '1');
 
 				if (ctx->spl_cnt == ctx->spl) {
 					/* Flush line buffers. */
-					g_string_append_len(*out, ctx->lines[j]->str, ctx->lines[j]->len);
-					g_string_append_c(*out, '\n');
+					g_string_append_len(out, line->str, line->len);
+					g_string_append_c(out, '\n');
 					if (j == ctx->num_enabled_channels - 1 && ctx->trigger > -1) {
 						/*
 						 * Sample data lines have one character per bit,
@@ -174,27 +181,28 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 						 * to this layout.
 						 */
 						offset = ctx->trigger + ctx->trigger / 8;
-						g_string_append_printf(*out, "T:%*s^ %d\n", offset, "", ctx->trigger);
+						g_string_append_printf(out, "T:%*s^ %d\n", offset, "", ctx->trigger);
 						ctx->trigger = -1;
 					}
-					g_string_printf(ctx->lines[j], "%s:", ctx->channel_names[j]);
+					g_string_printf(line, "%s:", ctx->channel_names[j]);
 				} else if ((ctx->spl_cnt & 7) == 0) {
 					/* Add a space every 8th bit. */
-					g_string_append_c(ctx->lines[j], ' ');
+					g_string_append_c(line, ' ');
 				}
 			}
 			if (ctx->spl_cnt == ctx->spl)
 				/* Line buffers were already flushed. */
 				ctx->spl_cnt = 0;
+			data += n * logic->unitsize;
+			num_samples -= n;
 		}
 		break;
 	case SR_DF_END:
 		if (ctx->spl_cnt) {
 			/* Line buffers need flushing. */
-			*out = g_string_sized_new(512);
 			for (i = 0; i < ctx->num_enabled_channels; i++) {
-				g_string_append_len(*out, ctx->lines[i]->str, ctx->lines[i]->len);
-				g_string_append_c(*out, '\n');
+				g_string_append_len(out, ctx->lines[i]->str, ctx->lines[i]->len);
+				g_string_append_c(out, '\n');
 			}
 		}
 		break;
@@ -203,6 +211,34 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 	return SR_OK;
 }
 
+/* Ranges start on line boundaries, where the line buffers are empty. */
+static size_t split_align(const struct sr_output *o)
+{
+	struct context *ctx;
+
+	ctx = o->priv;
+	if (!ctx->header_done || ctx->trigger > -1)
+		return 0;
+
+	return ctx->spl;
+}
+
+static int carry_in(struct sr_output *o, const struct sr_output_carry *carry)
+{
+	struct context *ctx;
+	const struct context *from;
+
+	ctx = o->priv;
+	from = carry->from->priv;
+	if (!ctx->spl || carry->pos % ctx->spl)
+		return SR_ERR_ARG;
+	ctx->samplerate = from->samplerate;
+	ctx->header_done = TRUE;
+	ctx->spl_cnt = 0;
+
+	return SR_OK;
+}
+
 static int cleanup(struct sr_output *o)
 {
 	struct context *ctx;
@@ -248,6 +284,8 @@ SR_PRIV struct sr_output_module output_bits = {
 	.flags = 0,
 	.options = get_options,
 	.init = init,
-	.receive = receive,
+	.append = append,
+	.split_align = split_align,
+	.carry_in = carry_in,
 	.cleanup = cleanup,
 };
@@ -215,19 +215,17 @@ static const char *xlabels[] = {
 	"femtoseconds", "attoseconds",
 };
 
-static GString *gen_header(const struct sr_output *o,
-			   const struct sr_datafeed_header *hdr)
+static void gen_header(const struct sr_output *o,
+			   const struct sr_datafeed_header *hdr, GString *header)
 {
 	struct context *ctx;
 	struct sr_channel *ch;
 	GVariant *gvar;
-	GString *header;
 	GSList *channels, *l;
 	unsigned int num_channels, i;
 	char *samplerate_s;
 
 	ctx = o->priv;
-	header = g_string_sized_new(512);
 
 	if (ctx->sample_rate == 0) {
 		if (sr_config_get(o->sdi->driver, o->sdi, NULL,
@@ -288,8 +286,6 @@ static GString *gen_header(const struct sr_output *o,
 	/* Time column requested but samplerate unknown. Emit a warning. */
 	if (ctx->time && !ctx->sample_rate)
 		sr_warn("Samplerate unknown, cannot provide timestamps.");
-
-	return header;
 }
 
 /*
@@ -377,9 +373,7 @@ static void process_analog(struct context *ctx,
 static void process_logic(struct context *ctx,
 			  const struct sr_datafeed_logic *logic)
 {
-	unsigned int i, j, ch, num_samples;
-	int idx;
-	uint8_t *sample;
+	unsigned int j, ch, num_samples;
 
 	num_samples = logic->length / logic->unitsize;
 	ctx->channels_seen += ctx->logic_channel_count;
@@ -395,19 +389,18 @@ static void process_logic(struct context *ctx,
 
 	for (j = ch = 0; ch < ctx->num_logic_channels; j++) {
 		if (ctx->channels[j].ch->type == SR_CHANNEL_LOGIC) {
-			for (i = 0; i < num_samples; i++) {
-				sample = logic->data + i * logic->unitsize;
-				idx = ctx->channels[j].ch->index;
-				if (ctx->label_do && !ctx->label_names)
-					ctx->channels[j].label = "logic";
-				ctx->logic_samples[i * ctx->num_logic_channels + ch] = sample[idx / 8] & (1 << (idx % 8));
-			}
+			if (ctx->label_do && !ctx->label_names)
+				ctx->channels[j].label = "logic";
+			sr_logic_text_values(&ctx->logic_samples[ch],
+				ctx->num_logic_channels, logic->data,
+				logic->unitsize, num_samples,
+				ctx->channels[j].ch->index);
 			ch++;
 		}
 	}
 }
 
-static void dump_saved_values(struct context *ctx, GString **out)
+static void dump_saved_values(struct context *ctx, GString *out)
 {
 	unsigned int i, j, analog_size, num_channels;
 	double sample_time_dbl;
@@ -421,30 +414,27 @@ static void dump_saved_values(struct context *ctx, GString **out)
 		sr_warn("Discarding partial packet");
 	} else {
 		sr_info("Dumping %u samples", ctx->num_samples);
-
-		if (!*out)
-			*out = g_string_sized_new(512);
 		num_channels =
 		    ctx->num_logic_channels + ctx->num_analog_channels;
 
 		if (ctx->label_do) {
 			if (ctx->time)
-				g_string_append_printf(*out, "%s%s",
+				g_string_append_printf(out, "%s%s",
 					ctx->label_names ? "Time" : ctx->xlabel,
 					ctx->value);
 			for (i = 0; i < num_channels; i++) {
-				g_string_append_printf(*out, "%s%s",
+				g_string_append_printf(out, "%s%s",
 					ctx->channels[i].label, ctx->value);
 				if (ctx->channels[i].ch->type == SR_CHANNEL_ANALOG
 						&& ctx->label_names)
 					g_free(ctx->channels[i].label);
 			}
 			if (ctx->do_trigger)
-				g_string_append_printf(*out, "Trigger%s",
+				g_string_append_printf(out, "Trigger%s",
 						       ctx->value);
 			/* Drop last separator. */
-			g_string_truncate(*out, (*out)->len - 1);
-			g_string_append(*out, ctx->record);
+			g_string_truncate(out, out->len - 1);
+			g_string_append(out, ctx->record);
 
 			ctx->label_do = FALSE;
 		}
@@ -476,13 +466,13 @@ static void dump_saved_values(struct context *ctx, GString **out)
 			}
 
 			if (ctx->time && !ctx->sample_rate) {
-				g_string_append_printf(*out, "0%s", ctx->value);
+				g_string_append_printf(out, "0%s", ctx->value);
 			} else if (ctx->time) {
 				sample_time_dbl = ctx->out_sample_count++;
 				sample_time_dbl /= ctx->sample_rate;
 				sample_time_dbl *= ctx->sample_scale;
 				sample_time_u64 = sample_time_dbl;
-				g_string_append_printf(*out, "%" PRIu64 "%s",
+				g_string_append_printf(out, "%" PRIu64 "%s",
 					sample_time_u64, ctx->value);
 			}
 
@@ -493,11 +483,12 @@ static void dump_saved_values(struct context *ctx, GString **out)
 					    fmax(value, ctx->channels[j].max);
 					ctx->channels[j].min =
 					    fmin(value, ctx->channels[j].min);
-					g_string_append_printf(*out, "%g%s",
+					g_string_append_printf(out, "%g%s",
 						value, ctx->value);
 				} else if (ctx->channels[j].ch->type == SR_CHANNEL_LOGIC) {
-					g_string_append_printf(*out, "%c%s",
-							       ctx->logic_samples[i * ctx->num_logic_channels + j] ? '1' : '0', ctx->value);
+					g_string_append_c(out, '0' +
+						ctx->logic_samples[i * ctx->num_logic_channels + j]);
+					g_string_append(out, ctx->value);
 				} else {
 					sr_warn("Unexpected channel type: %d",
 						ctx->channels[i].ch->type);
@@ -505,12 +496,12 @@ static void dump_saved_values(struct context *ctx, GString **out)
 			}
 
 			if (ctx->do_trigger) {
-				g_string_append_printf(*out, "%d%s",
+				g_string_append_printf(out, "%d%s",
 					ctx->trigger, ctx->value);
 				ctx->trigger = FALSE;
 			}
-			g_string_truncate(*out, (*out)->len - 1);
-			g_string_append(*out, ctx->record);
+			g_string_truncate(out, out->len - 1);
+			g_string_append(out, ctx->record);
 		}
 	}
 
@@ -656,14 +647,13 @@ static void check_input_constraints(struct context *ctx)
 	sr_warn("Resulting CSV output data may be incomplete or incorrect.");
 }
 
-static int receive(const struct sr_output *o,
-		   const struct sr_datafeed_packet *packet, GString **out)
+static int append(const struct sr_output *o,
+		   const struct sr_datafeed_packet *packet, GString *out)
 {
 	struct context *ctx;
 	const struct sr_datafeed_logic *logic;
 	const struct sr_datafeed_analog *analog;
 
-	*out = NULL;
 	if (!o || !o->sdi)
 		return SR_ERR_ARG;
 	if (!(ctx = o->priv))
@@ -675,13 +665,12 @@ static int receive(const struct sr_output *o,
 		ctx->have_checked = FALSE;
 		ctx->have_frames = FALSE;
 		ctx->pkt_snums = FALSE;
-		*out = gen_header(o, packet->payload);
+		gen_header(o, packet->payload, out);
 		break;
 	case SR_DF_TRIGGER:
 		ctx->trigger = TRUE;
 		break;
 	case SR_DF_LOGIC:
-		*out = g_string_sized_new(512);
 		logic = packet->payload;
 		ctx->pkt_snums = logic->length;
 		ctx->pkt_snums /= logic->length;
@@ -689,7 +678,6 @@ static int receive(const struct sr_output *o,
 		process_logic(ctx, logic);
 		break;
 	case SR_DF_ANALOG:
-		*out = g_string_sized_new(512);
 		analog = packet->payload;
 		ctx->pkt_snums = analog->num_samples;
 		ctx->pkt_snums /= g_slist_length(analog->meaning->channels);
@@ -698,7 +686,7 @@ static int receive(const struct sr_output *o,
 		break;
 	case SR_DF_FRAME_BEGIN:
 		ctx->have_frames = TRUE;
-		*out = g_string_new(ctx->frame);
+		g_string_append(out, ctx->frame);
 		/* Fallthrough */
 	case SR_DF_END:
 		/* Got to end of frame/session with part of the data. */
@@ -716,6 +704,44 @@ static int receive(const struct sr_output *o,
 	return SR_OK;
 }
 
+/*
+ * Logic only data without deduplication can be split anywhere. Rows
+ * get emitted per packet then, and only depend on their position.
+ */
+static size_t split_align(const struct sr_output *o)
+{
+	struct context *ctx;
+
+	ctx = o->priv;
+	if (ctx->num_analog_channels || ctx->dedup || ctx->label_do)
+		return 0;
+	if (ctx->trigger || ctx->channels_seen)
+		return 0;
+	if (ctx->logic_channel_count != ctx->channel_count)
+		return 0;
+
+	return 1;
+}
+
+static int carry_in(struct sr_output *o, const struct sr_output_carry *carry)
+{
+	struct context *ctx;
+	const struct context *from;
+
+	ctx = o->priv;
+	from = carry->from->priv;
+	ctx->did_header = from->did_header;
+	ctx->label_do = FALSE;
+	ctx->have_checked = TRUE;
+	ctx->sample_rate = from->sample_rate;
+	ctx->sample_scale = from->sample_scale;
+	ctx->xlabel = from->xlabel;
+	ctx->title = from->title;
+	ctx->out_sample_count = carry->pos;
+
+	return SR_OK;
+}
+
 static int cleanup(struct sr_output *o)
 {
 	struct context *ctx;
@@ -787,6 +813,8 @@ SR_PRIV struct sr_output_module output_csv = {
 	.flags = 0,
 	.options = get_options,
 	.init = init,
-	.receive = receive,
+	.append = append,
+	.split_align = split_align,
+	.carry_in = carry_in,
 	.cleanup = cleanup,
 };
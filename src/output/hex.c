@@ -89,11 +89,10 @@ static int init(struct sr_output *o, GHashTable *options)
 	return SR_OK;
 }
 
-static GString *gen_header(const struct sr_output *o)
+static void gen_header(const struct sr_output *o, GString *header)
 {
 	struct context *ctx;
 	GVariant *gvar;
-	GString *header;
 	int num_channels;
 	char *samplerate_s;
 
@@ -106,8 +105,7 @@ static GString *gen_header(const struct sr_output *o)
 		}
 	}
 
-	header = g_string_sized_new(512);
-	g_string_printf(header, "%s %s\n", PACKAGE_NAME, sr_package_version_string_get());
+	g_string_append_printf(header, "%s %s\n", PACKAGE_NAME, sr_package_version_string_get());
 	num_channels = g_slist_length(o->sdi->channels);
 	g_string_append_printf(header, "Acquisition with %d/%d channels",
 			ctx->num_enabled_channels, num_channels);
@@ -117,23 +115,22 @@ static GString *gen_header(const struct sr_output *o)
 		g_free(samplerate_s);
 	}
 	g_string_append_printf(header, "\n");
-
-	return header;
 }
 
-static int receive(const struct sr_output *o, const struct sr_datafeed_packet *packet,
-		GString **out)
+static int append(const struct sr_output *o, const struct sr_datafeed_packet *packet,
+		GString *out)
 {
 	const struct sr_datafeed_meta *meta;
 	const struct sr_datafeed_logic *logic;
 	const struct sr_config *src;
 	GSList *l;
 	struct context *ctx;
-	int idx, pos, offset;
-	uint64_t i, j;
-	gchar *p;
+	GString *line;
+	const uint8_t *data;
+	uint8_t packed;
+	int offset;
+	size_t num_samples, n, len, i, j;
 
-	*out = NULL;
 	if (!o || !o->sdi)
 		return SR_ERR_ARG;
 	if (!(ctx = o->priv))
@@ -154,32 +151,42 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 		break;
 	case SR_DF_LOGIC:
 		if (!ctx->header_done) {
-			*out = gen_header(o);
+			gen_header(o, out);
 			ctx->header_done = TRUE;
-		} else
-			*out = g_string_sized_new(512);
+		}
 
+		/*
+		 * Collect runs of samples up to the next byte boundary or
+		 * line end, and shift them into the channels' sample buffers.
+		 */
 		logic = packet->payload;
-		for (i = 0; i <= logic->length - logic->unitsize; i += logic->unitsize) {
-			ctx->spl_cnt++;
-			pos = ctx->spl_cnt & 7;
+		data = logic->data;
+		num_samples = logic->length / logic->unitsize;
+		while (num_samples) {
+			n = 8 - (ctx->spl_cnt & 7);
+			if (ctx->spl && n > (size_t)(ctx->spl - ctx->spl_cnt))
+				n = ctx->spl - ctx->spl_cnt;
+			n = MIN(n, num_samples);
+			ctx->spl_cnt += n;
 			for (j = 0; j < ctx->num_enabled_channels; j++) {
-				idx = ctx->channel_index[j];
-				p = logic->data + i + idx / 8;
-				ctx->sample_buf[j] <<= 1;
-				if (*p & (1 << (idx % 8)))
-					ctx->sample_buf[j] |= 1;
-				if (ctx->spl_cnt && pos == 0) {
+				line = ctx->lines[j];
+				packed = sr_logic_text_pack(sr_logic_text_gather(data,
+					logic->unitsize, n, ctx->channel_index[j]));
+				ctx->sample_buf[j] = (ctx->sample_buf[j] << n) |
+					(packed >> (8 - n));
+				if ((ctx->spl_cnt & 7) == 0) {
 					/* Buffered a byte's worth, output hex. */
-					g_string_append_printf(ctx->lines[j], "%.2x ",
-							ctx->sample_buf[j]);
+					len = line->len;
+					g_string_set_size(line, len + 3);
+					sr_logic_text_hex(line->str + len, ctx->sample_buf[j]);
+					line->str[len + 2] = ' ';
 					ctx->sample_buf[j] = 0;
 				}
 
 				if (ctx->spl_cnt == ctx->spl) {
 					/* Flush line buffers. */
-					g_string_append_len(*out, ctx->lines[j]->str, ctx->lines[j]->len);
-					g_string_append_c(*out, '\n');
+					g_string_append_len(out, line->str, line->len);
+					g_string_append_c(out, '\n');
 					if (j == ctx->num_enabled_channels - 1 && ctx->trigger > -1) {
 						/*
 						 * Sample data lines have one character per nibble,
@@ -187,27 +194,28 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 						 * to this layout.
 						 */
 						offset = ctx->trigger / 4 + ctx->trigger / 8;
-						g_string_append_printf(*out, "T:%*s^ %d\n", offset, "", ctx->trigger);
+						g_string_append_printf(out, "T:%*s^ %d\n", offset, "", ctx->trigger);
 						ctx->trigger = -1;
 					}
-					g_string_printf(ctx->lines[j], "%s:", ctx->channel_names[j]);
+					g_string_printf(line, "%s:", ctx->channel_names[j]);
 				}
 			}
 			if (ctx->spl_cnt == ctx->spl)
 				/* Line buffers were already flushed. */
 				ctx->spl_cnt = 0;
+			data += n * logic->unitsize;
+			num_samples -= n;
 		}
 		break;
 	case SR_DF_END:
 		if (ctx->spl_cnt) {
 			/* Line buffers need flushing. */
-			*out = g_string_sized_new(512);
 			for (i = 0; i < ctx->num_enabled_channels; i++) {
 				if (ctx->spl_cnt & 7)
 					g_string_append_printf(ctx->lines[i], "%.2x ",
 							ctx->sample_buf[i] << (8 - (ctx->spl_cnt & 7)));
-				g_string_append_len(*out, ctx->lines[i]->str, ctx->lines[i]->len);
-				g_string_append_c(*out, '\n');
+				g_string_append_len(out, ctx->lines[i]->str, ctx->lines[i]->len);
+				g_string_append_c(out, '\n');
 			}
 		}
 		break;
@@ -216,6 +224,38 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 	return SR_OK;
 }
 
+/*
+ * Ranges start on line boundaries. Lines which don't end on a byte
+ * boundary leave bits in the sample buffers, don't split those.
+ */
+static size_t split_align(const struct sr_output *o)
+{
+	struct context *ctx;
+
+	ctx = o->priv;
+	if (!ctx->header_done || ctx->trigger > -1 || ctx->spl % 8)
+		return 0;
+
+	return ctx->spl;
+}
+
+static int carry_in(struct sr_output *o, const struct sr_output_carry *carry)
+{
+	struct context *ctx;
+	const struct context *from;
+
+	ctx = o->priv;
+	from = carry->from->priv;
+	if (!ctx->spl || ctx->spl % 8 || carry->pos % ctx->spl)
+		return SR_ERR_ARG;
+	ctx->samplerate = from->samplerate;
+	ctx->header_done = TRUE;
+	ctx->spl_cnt = 0;
+	memset(ctx->sample_buf, 0, ctx->num_enabled_channels);
+
+	return SR_OK;
+}
+
 static int cleanup(struct sr_output *o)
 {
 	struct context *ctx;
@@ -262,6 +302,8 @@ SR_PRIV struct sr_output_module output_hex = {
 	.flags = 0,
 	.options = get_options,
 	.init = init,
-	.receive = receive,
+	.append = append,
+	.split_align = split_align,
+	.carry_in = carry_in,
 	.cleanup = cleanup,
 };
@@ -0,0 +1,240 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Helpers for output modules which turn logic data into text.
+ *
+ * Text output typically iterates over channels, and over samples of
+ * each channel. Extracting one bit at a time, and appending one char
+ * at a time, dominates the cost of these modules. The routines here
+ * handle groups of up to eight samples in a 64bit word instead: byte
+ * k of the word holds the bit value (0 or 1) of sample k. This "bits
+ * word" converts to eight text characters, or to a packed byte, with
+ * a few arithmetic operations and without lookup tables.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "output/logic_text"
+
+/* Byte k's least significant bit, for all bytes of a 64bit word. */
+#define BYTE_LSBS	0x0101010101010101ULL
+
+/*
+ * Gathers the first bit of bytes k into the bit (7 - k) of the most
+ * significant byte of the product. All partial products occupy
+ * distinct bit positions, so they cannot generate carries.
+ */
+#define PACK_MSB_FIRST	0x8040201008040201ULL
+
+/* Same as above, gathers byte k's first bit into bit k of the MSB. */
+#define PACK_LSB_FIRST	0x0102040810204080ULL
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/**
+ * Gather a logic channel's values of up to eight consecutive samples.
+ *
+ * @param[in] data Logic data, the first sample of interest.
+ * @param[in] unitsize Number of bytes per sample.
+ * @param[in] count Number of samples, at most 8.
+ * @param[in] index The channel's bit position within a sample.
+ *
+ * @returns A bits word, byte k holds the value of sample k. Bytes
+ *   for samples beyond count are 0.
+ *
+ * @private
+ */
+SR_PRIV uint64_t sr_logic_text_gather(const uint8_t *data,
+	size_t unitsize, size_t count, size_t index)
+{
+	uint64_t word;
+	size_t k;
+
+	data += index / 8;
+	if (unitsize == 1 && count == 8) {
+		word = read_u64le(data);
+	} else {
+		word = 0;
+		for (k = 0; k < count && k < 8; k++) {
+			word |= (uint64_t)*data << (8 * k);
+			data += unitsize;
+		}
+	}
+
+	return (word >> (index % 8)) & BYTE_LSBS;
+}
+
+/**
+ * Convert a bits word to text, one character per sample.
+ *
+ * @param[in] bits The bits word, see sr_logic_text_gather().
+ * @param[in] low Character for low samples.
+ * @param[in] high Character for high samples.
+ *
+ * @returns Eight characters, the first sample's in the least significant
+ *   byte. Store with write_u64le() to get the text in sample order.
+ *
+ * @private
+ */
+SR_PRIV uint64_t sr_logic_text_chars(uint64_t bits, char low, char high)
+{
+	uint64_t highs, lows;
+
+	highs = bits * (uint8_t)high;
+	lows = (bits ^ BYTE_LSBS) * (uint8_t)low;
+
+	return highs | lows;
+}
+
+/**
+ * Pack a bits word into a byte, the first sample in the MSB.
+ *
+ * @param[in] bits The bits word, see sr_logic_text_gather().
+ *
+ * @returns The packed samples. Fewer than eight samples are left aligned.
+ *
+ * @private
+ */
+SR_PRIV uint8_t sr_logic_text_pack(uint64_t bits)
+{
+	return (bits * PACK_MSB_FIRST) >> 56;
+}
+
+/**
+ * Append a logic channel's values to a bitmap, the first sample in the LSB.
+ *
+ * @param[in,out] out The bitmap. Bits from the given position on must
+ *   be zero, and are OR-ed with the channel's values.
+ * @param[in] bitpos Bit position in the bitmap for the first sample.
+ * @param[in] data Logic data.
+ * @param[in] unitsize Number of bytes per sample.
+ * @param[in] count Number of samples.
+ * @param[in] index The channel's bit position within a sample.
+ *
+ * @private
+ */
+SR_PRIV void sr_logic_text_bitmap(uint8_t *out, size_t bitpos,
+	const uint8_t *data, size_t unitsize, size_t count, size_t index)
+{
+	uint64_t bits;
+	unsigned int packed, shift;
+	size_t n;
+
+	out += bitpos / 8;
+	shift = bitpos % 8;
+	while (count) {
+		n = MIN(count, 8);
+		bits = sr_logic_text_gather(data, unitsize, n, index);
+		packed = (bits * PACK_LSB_FIRST) >> 56;
+		packed <<= shift;
+		out[0] |= packed & 0xff;
+		if (packed >> 8)
+			out[1] |= packed >> 8;
+		out++;
+		data += n * unitsize;
+		count -= n;
+	}
+}
+
+/**
+ * Extract a logic channel's values, one byte (0 or 1) per sample.
+ *
+ * @param[out] out Output buffer.
+ * @param[in] stride Distance of consecutive samples' bytes in the output.
+ * @param[in] data Logic data.
+ * @param[in] unitsize Number of bytes per sample.
+ * @param[in] count Number of samples.
+ * @param[in] index The channel's bit position within a sample.
+ *
+ * @private
+ */
+SR_PRIV void sr_logic_text_values(uint8_t *out, size_t stride,
+	const uint8_t *data, size_t unitsize, size_t count, size_t index)
+{
+	uint64_t bits;
+	size_t n, k;
+
+	while (count) {
+		n = MIN(count, 8);
+		bits = sr_logic_text_gather(data, unitsize, n, index);
+		if (stride == 1 && n == 8) {
+			write_u64le(out, bits);
+			out += 8;
+		} else {
+			for (k = 0; k < n; k++) {
+				*out = bits & 1;
+				out += stride;
+				bits >>= 8;
+			}
+		}
+		data += n * unitsize;
+		count -= n;
+	}
+}
+
+/**
+ * Format a logic channel's values as text, one character per sample.
+ *
+ * @param[out] out Output buffer, count characters (not NUL terminated).
+ * @param[in] data Logic data.
+ * @param[in] unitsize Number of bytes per sample.
+ * @param[in] count Number of samples.
+ * @param[in] index The channel's bit position within a sample.
+ * @param[in] low Character for low samples.
+ * @param[in] high Character for high samples.
+ *
+ * @private
+ */
+SR_PRIV void sr_logic_text_format(char *out, const uint8_t *data,
+	size_t unitsize, size_t count, size_t index, char low, char high)
+{
+	uint64_t bits;
+	uint8_t tail[sizeof(bits)];
+
+	while (count >= 8) {
+		bits = sr_logic_text_gather(data, unitsize, 8, index);
+		write_u64le((uint8_t *)out, sr_logic_text_chars(bits, low, high));
+		out += 8;
+		data += 8 * unitsize;
+		count -= 8;
+	}
+	if (count) {
+		bits = sr_logic_text_gather(data, unitsize, count, index);
+		write_u64le(tail, sr_logic_text_chars(bits, low, high));
+		memcpy(out, tail, count);
+	}
+}
+
+/**
+ * Format a byte as two lower case hex digits.
+ *
+ * @param[out] out Output buffer, two characters (not NUL terminated).
+ * @param[in] value The byte value.
+ *
+ * @private
+ */
+SR_PRIV void sr_logic_text_hex(char *out, uint8_t value)
+{
+	out[0] = hex_digits[value >> 4];
+	out[1] = hex_digits[value & 0x0f];
+}
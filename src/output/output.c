@@ -18,7 +18,9 @@
  */
 
 #include <config.h>
+#include <errno.h>
 #include <string.h>
+#include <unistd.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
 
@@ -26,6 +28,34 @@
 #define LOG_PREFIX "output"
 /** @endcond */
 
+/* Output sinks pass on their buffered text in chunks of this size. */
+#define SINK_FLUSH_SIZE (64 * 1024)
+
+/* Minimum number of logic samples per parallel range. */
+#define PARALLEL_MIN_SAMPLES (64 * 1024)
+
+/* A range of logic samples, which a worker instance formats. */
+struct output_job {
+	struct sr_output *o;
+	struct sr_datafeed_logic logic;
+	GString *text;
+	int ret;
+};
+
+/* Worker instances and threads, see sr_output_threads_set(). */
+struct output_parallel {
+	GThreadPool *pool;
+	size_t num_workers;
+	struct output_job *jobs;
+	GMutex mutex;
+	GCond cond;
+	size_t pending;
+	/* The previous packet's last logic sample. */
+	uint8_t *prev_sample;
+	size_t prev_size;
+	gboolean prev_valid;
+};
+
 /**
  * @file
  *
@@ -49,6 +79,16 @@
  * Output modules generate a newly allocated GString. The caller is then
  * expected to free this with g_string_free() when finished with it.
  *
+ * Alternatively, callers can provide an output sink (a file descriptor,
+ * a stdio stream, or a callback) when creating the output instance. Text
+ * then gets accumulated in a buffer which is reused across packets, and
+ * gets passed on in larger chunks. This avoids the allocation and copy of
+ * a GString for each packet.
+ *
+ * For the offline conversion of large captures, output instances can
+ * format large logic packets on several threads, see
+ * sr_output_threads_set().
+ *
  * @{
  */
 
@@ -65,6 +105,8 @@ extern SR_PRIV struct sr_output_module output_analog;
 extern SR_PRIV struct sr_output_module output_srzip;
 extern SR_PRIV struct sr_output_module output_wav;
 extern SR_PRIV struct sr_output_module output_wavedrom;
+extern SR_PRIV struct sr_output_module output_transitions;
+extern SR_PRIV struct sr_output_module output_arrow;
 extern SR_PRIV struct sr_output_module output_null;
 /** @endcond */
 
@@ -81,6 +123,8 @@ static const struct sr_output_module *output_module_list[] = {
 	&output_srzip,
 	&output_wav,
 	&output_wavedrom,
+	&output_transitions,
+	&output_arrow,
 	&output_null,
 	NULL,
 };
@@ -246,22 +290,76 @@ SR_API void sr_output_options_free(const struct sr_option **options)
 	g_free(options);
 }
 
-/**
- * Create a new output instance using the specified output module.
- *
- * <code>options</code> is a *HashTable with the keys corresponding with
- * the module options' <code>id</code> field. The values should be GVariant
- * pointers with sunk * references, of the same GVariantType as the option's
- * default value.
- *
- * The sr_dev_inst passed in can be used by the instance to determine
- * channel names, samplerate, and so on.
- *
- * @since 0.4.0
- */
-SR_API const struct sr_output *sr_output_new(const struct sr_output_module *omod,
+static struct sr_output_sink *sink_new(void)
+{
+	struct sr_output_sink *sink;
+
+	sink = g_malloc0(sizeof(*sink));
+	sink->fd = -1;
+	sink->buf = g_string_sized_new(SINK_FLUSH_SIZE);
+
+	return sink;
+}
+
+/* Pass the sink's buffered text on to its destination. */
+static int sink_write(struct sr_output_sink *sink)
+{
+	const char *data;
+	size_t remain;
+	ssize_t written;
+	int ret;
+
+	data = sink->buf->str;
+	remain = sink->buf->len;
+	ret = SR_OK;
+	if (!remain)
+		return SR_OK;
+
+	if (sink->fd >= 0) {
+		while (remain) {
+			written = write(sink->fd, data, remain);
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written <= 0) {
+				sr_err("Cannot write output: %s.", g_strerror(errno));
+				ret = SR_ERR_IO;
+				break;
+			}
+			data += written;
+			remain -= written;
+			sink->written += written;
+		}
+	} else if (sink->file) {
+		if (fwrite(data, remain, 1, sink->file) != 1) {
+			sr_err("Cannot write output: %s.", g_strerror(errno));
+			ret = SR_ERR_IO;
+		} else {
+			sink->written += remain;
+		}
+	} else if (sink->cb) {
+		ret = sink->cb((const uint8_t *)data, remain, sink->cb_data);
+		sink->written += remain;
+	}
+	g_string_truncate(sink->buf, 0);
+
+	return ret;
+}
+
+static void parallel_free(struct sr_output *op);
+
+static void output_free(struct sr_output *op)
+{
+	parallel_free(op);
+	sr_output_sink_free(op->sink);
+	if (op->options)
+		g_hash_table_destroy(op->options);
+	g_free((char *)op->filename);
+	g_free(op);
+}
+
+static const struct sr_output *output_new(const struct sr_output_module *omod,
 		GHashTable *options, const struct sr_dev_inst *sdi,
-		const char *filename)
+		const char *filename, struct sr_output_sink *sink)
 {
 	struct sr_output *op;
 	const struct sr_option *mod_opts;
@@ -271,10 +369,11 @@ SR_API const struct sr_output *sr_output_new(const struct sr_output_module *omod
 	gpointer key, value;
 	int i;
 
-	op = g_malloc(sizeof(struct sr_output));
+	op = g_malloc0(sizeof(struct sr_output));
 	op->module = omod;
 	op->sdi = sdi;
 	op->filename = g_strdup(filename);
+	op->sink = sink;
 
 	new_opts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
 			(GDestroyNotify)g_variant_unref);
@@ -288,7 +387,8 @@ SR_API const struct sr_output *sr_output_new(const struct sr_output_module *omod
 				if (!g_variant_is_of_type(value, gvt)) {
 					sr_err("Invalid type for '%s' option.",
 						(char *)key);
-					g_free(op);
+					g_hash_table_destroy(new_opts);
+					output_free(op);
 					return NULL;
 				}
 				g_hash_table_insert(new_opts, g_strdup(mod_opts[i].id),
@@ -308,35 +408,592 @@ SR_API const struct sr_output *sr_output_new(const struct sr_output_module *omod
 					sr_err("Output module '%s' has no option '%s'",
 						omod->id, (char *)key);
 					g_hash_table_destroy(new_opts);
-					g_free(op);
+					output_free(op);
 					return NULL;
 				}
 			}
 		}
 	}
 
+	/* Kept around for the creation of worker instances. */
+	op->options = new_opts;
 	if (op->module->init && op->module->init(op, new_opts) != SR_OK) {
-		g_free(op);
+		output_free(op);
 		op = NULL;
 	}
-	if (new_opts)
-		g_hash_table_destroy(new_opts);
 
 	return op;
 }
 
+/**
+ * Create a new output instance using the specified output module.
+ *
+ * <code>options</code> is a *HashTable with the keys corresponding with
+ * the module options' <code>id</code> field. The values should be GVariant
+ * pointers with sunk * references, of the same GVariantType as the option's
+ * default value.
+ *
+ * The sr_dev_inst passed in can be used by the instance to determine
+ * channel names, samplerate, and so on.
+ *
+ * @since 0.4.0
+ */
+SR_API const struct sr_output *sr_output_new(const struct sr_output_module *omod,
+		GHashTable *options, const struct sr_dev_inst *sdi,
+		const char *filename)
+{
+	return output_new(omod, options, sdi, filename, NULL);
+}
+
+/**
+ * Create a new output instance which writes to an output sink.
+ *
+ * Works like sr_output_new(), but the module's output gets written to
+ * the sink instead of being returned from sr_output_send(). The output
+ * instance takes ownership of the sink, also when creation fails.
+ *
+ * @since 0.6.0
+ */
+SR_API const struct sr_output *sr_output_new_sink(
+		const struct sr_output_module *omod, GHashTable *options,
+		const struct sr_dev_inst *sdi, const char *filename,
+		struct sr_output_sink *sink)
+{
+	if (!sink)
+		return NULL;
+
+	return output_new(omod, options, sdi, filename, sink);
+}
+
+/**
+ * Create an output sink which writes to a file descriptor.
+ *
+ * The descriptor is not closed when the sink gets freed.
+ *
+ * @since 0.6.0
+ */
+SR_API struct sr_output_sink *sr_output_sink_new_fd(int fd)
+{
+	struct sr_output_sink *sink;
+
+	if (fd < 0)
+		return NULL;
+
+	sink = sink_new();
+	sink->fd = fd;
+
+	return sink;
+}
+
+/**
+ * Create an output sink which writes to a stdio stream.
+ *
+ * The stream is not closed when the sink gets freed.
+ *
+ * @since 0.6.0
+ */
+SR_API struct sr_output_sink *sr_output_sink_new_file(FILE *file)
+{
+	struct sr_output_sink *sink;
+
+	if (!file)
+		return NULL;
+
+	sink = sink_new();
+	sink->file = file;
+
+	return sink;
+}
+
+/**
+ * Create an output sink which passes text to a callback.
+ *
+ * The callback receives chunks of output. The data is only valid during
+ * the callback's execution.
+ *
+ * @since 0.6.0
+ */
+SR_API struct sr_output_sink *sr_output_sink_new_callback(
+		sr_output_sink_callback cb, void *cb_data)
+{
+	struct sr_output_sink *sink;
+
+	if (!cb)
+		return NULL;
+
+	sink = sink_new();
+	sink->cb = cb;
+	sink->cb_data = cb_data;
+
+	return sink;
+}
+
+/**
+ * Free an output sink which was not passed to sr_output_new_sink().
+ *
+ * Text which is still buffered gets discarded.
+ *
+ * @since 0.6.0
+ */
+SR_API void sr_output_sink_free(struct sr_output_sink *sink)
+{
+	if (!sink)
+		return;
+
+	g_string_free(sink->buf, TRUE);
+	g_free(sink);
+}
+
+/* Pass a packet to the module, which appends its output to a buffer. */
+static int module_send(const struct sr_output *o,
+		const struct sr_datafeed_packet *packet, GString *out)
+{
+	GString *text;
+	int ret;
+
+	if (o->module->append)
+		return o->module->append(o, packet, out);
+
+	text = NULL;
+	ret = o->module->receive(o, packet, &text);
+	if (text) {
+		g_string_append_len(out, text->str, text->len);
+		g_string_free(text, TRUE);
+	}
+
+	return ret;
+}
+
+static int send_logic(const struct sr_output *o, const uint8_t *data,
+		size_t count, size_t unitsize, GString *out)
+{
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+
+	logic.length = count * unitsize;
+	logic.unitsize = unitsize;
+	logic.data = (void *)data;
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+
+	return module_send(o, &packet, out);
+}
+
+static void parallel_job_run(gpointer data, gpointer user_data)
+{
+	struct output_job *job;
+	struct output_parallel *par;
+	struct sr_datafeed_packet packet;
+
+	job = data;
+	par = user_data;
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &job->logic;
+	job->ret = module_send(job->o, &packet, job->text);
+
+	g_mutex_lock(&par->mutex);
+	if (!--par->pending)
+		g_cond_signal(&par->cond);
+	g_mutex_unlock(&par->mutex);
+}
+
+/*
+ * Format a logic packet on the worker instances. The instance itself
+ * formats the head of the packet up to an aligned position, and the
+ * tail after the last aligned position. The aligned middle part gets
+ * split into ranges for the workers, which carry in the state at the
+ * start of their range. Returns SR_ERR_NA when the packet is to be
+ * formatted serially.
+ */
+static int parallel_send(const struct sr_output *o,
+		const struct sr_datafeed_logic *logic, GString *out)
+{
+	struct output_parallel *par;
+	struct output_job *job;
+	struct sr_output_carry carry;
+	const uint8_t *data;
+	size_t unitsize, count, align, head, body, chunk, num, pos, len, i;
+	int ret;
+
+	par = o->parallel;
+	unitsize = logic->unitsize;
+	if (!unitsize)
+		return SR_ERR_NA;
+	count = logic->length / unitsize;
+	if (count < 2 * PARALLEL_MIN_SAMPLES)
+		return SR_ERR_NA;
+	if (o->logic_pos && !par->prev_valid)
+		return SR_ERR_NA;
+	if (!(align = o->module->split_align(o)))
+		return SR_ERR_NA;
+	head = (align - o->logic_pos % align) % align;
+	if (head >= count)
+		return SR_ERR_NA;
+	body = (count - head) / align * align;
+	num = MIN(par->num_workers, body / PARALLEL_MIN_SAMPLES);
+	if (num < 2)
+		return SR_ERR_NA;
+	chunk = (body / num + align - 1) / align * align;
+	sr_spew("Formatting %zu logic samples in %zu ranges.", body, num);
+
+	data = logic->data;
+	if (head && (ret = send_logic(o, data, head, unitsize, out)) != SR_OK)
+		return ret;
+
+	carry.from = o;
+	carry.unitsize = unitsize;
+	pos = head;
+	for (num = 0; pos < head + body; num++) {
+		len = MIN(chunk, head + body - pos);
+		carry.pos = o->logic_pos + pos;
+		carry.prev = NULL;
+		if (pos)
+			carry.prev = &data[(pos - 1) * unitsize];
+		else if (o->logic_pos)
+			carry.prev = par->prev_sample;
+		job = &par->jobs[num];
+		ret = o->module->carry_in(job->o, &carry);
+		if (ret != SR_OK)
+			return ret;
+		g_string_truncate(job->text, 0);
+		job->logic.length = len * unitsize;
+		job->logic.unitsize = unitsize;
+		job->logic.data = (void *)&data[pos * unitsize];
+		pos += len;
+	}
+
+	g_mutex_lock(&par->mutex);
+	par->pending = num;
+	g_mutex_unlock(&par->mutex);
+	for (i = 0; i < num; i++)
+		g_thread_pool_push(par->pool, &par->jobs[i], NULL);
+	g_mutex_lock(&par->mutex);
+	while (par->pending)
+		g_cond_wait(&par->cond, &par->mutex);
+	g_mutex_unlock(&par->mutex);
+
+	/* Reassemble the text in order. */
+	ret = SR_OK;
+	for (i = 0; i < num; i++) {
+		job = &par->jobs[i];
+		if (job->ret != SR_OK && ret == SR_OK)
+			ret = job->ret;
+		g_string_append_len(out, job->text->str, job->text->len);
+	}
+	if (ret != SR_OK)
+		return ret;
+
+	/* Catch up with the workers, and format the tail. */
+	carry.pos = o->logic_pos + pos;
+	carry.prev = &data[(pos - 1) * unitsize];
+	ret = o->module->carry_in((struct sr_output *)o, &carry);
+	if (ret == SR_OK && count > pos)
+		ret = send_logic(o, &data[pos * unitsize], count - pos,
+			unitsize, out);
+
+	return ret;
+}
+
+static int output_append(const struct sr_output *o,
+		const struct sr_datafeed_packet *packet, GString *out)
+{
+	int ret;
+
+	if (packet->type != SR_DF_LOGIC || !o->parallel)
+		return module_send(o, packet, out);
+
+	ret = parallel_send(o, packet->payload, out);
+	if (ret == SR_ERR_NA)
+		ret = module_send(o, packet, out);
+
+	return ret;
+}
+
+/* Keep track of the position in the logic data. */
+static void logic_done(struct sr_output *op,
+		const struct sr_datafeed_packet *packet)
+{
+	const struct sr_datafeed_logic *logic;
+	struct output_parallel *par;
+	size_t count;
+
+	if (packet->type != SR_DF_LOGIC)
+		return;
+	logic = packet->payload;
+	if (!logic->unitsize)
+		return;
+	count = logic->length / logic->unitsize;
+	if (!count)
+		return;
+	op->logic_pos += count;
+
+	if (!(par = op->parallel))
+		return;
+	if (par->prev_size < logic->unitsize) {
+		g_free(par->prev_sample);
+		par->prev_sample = g_malloc(logic->unitsize);
+		par->prev_size = logic->unitsize;
+	}
+	memcpy(par->prev_sample, (const uint8_t *)logic->data +
+		(count - 1) * logic->unitsize, logic->unitsize);
+	par->prev_valid = TRUE;
+}
+
 /**
  * Send a packet to the specified output instance.
  *
  * The instance's output is returned as a newly allocated GString,
  * which must be freed by the caller.
  *
+ * Instances which were created with an output sink write to the sink
+ * instead. Text is buffered, and gets passed on in larger chunks, and
+ * at the end of the session feed. <code>out</code> is set to NULL, or
+ * can be NULL.
+ *
  * @since 0.4.0
  */
 SR_API int sr_output_send(const struct sr_output *o,
 		const struct sr_datafeed_packet *packet, GString **out)
 {
-	return o->module->receive(o, packet, out);
+	struct sr_output_sink *sink;
+	GString *text;
+	int ret;
+
+	sink = o->sink;
+	if (!sink) {
+		if (o->module->receive && !o->parallel) {
+			ret = o->module->receive(o, packet, out);
+		} else {
+			*out = NULL;
+			text = g_string_sized_new(512);
+			ret = output_append(o, packet, text);
+			if (ret == SR_OK && text->len)
+				*out = text;
+			else
+				g_string_free(text, TRUE);
+		}
+		logic_done((struct sr_output *)o, packet);
+		return ret;
+	}
+
+	if (out)
+		*out = NULL;
+	ret = output_append(o, packet, sink->buf);
+	logic_done((struct sr_output *)o, packet);
+	if (ret != SR_OK)
+		return ret;
+	if (sink->buf->len >= SINK_FLUSH_SIZE || packet->type == SR_DF_END)
+		ret = sink_write(sink);
+
+	return ret;
+}
+
+/**
+ * Pass text which an output sink has buffered on to its destination.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_output_flush(const struct sr_output *o)
+{
+	if (!o)
+		return SR_ERR_ARG;
+	if (!o->sink)
+		return SR_OK;
+
+	return sink_write(o->sink);
+}
+
+/**
+ * Pass on text which a module has appended for the current packet.
+ *
+ * Modules which generate a lot of text for a single packet can call
+ * this in between, to keep the memory use bounded. This only has an
+ * effect for instances which write to an output sink, and when there
+ * is enough buffered text.
+ *
+ * @param o The output instance.
+ * @param out The text which the module appends to.
+ *
+ * @private
+ */
+SR_PRIV int sr_output_drain(const struct sr_output *o, GString *out)
+{
+	if (!o || !o->sink || out != o->sink->buf)
+		return SR_OK;
+	if (out->len < SINK_FLUSH_SIZE)
+		return SR_OK;
+
+	return sink_write(o->sink);
+}
+
+/**
+ * Overwrite output which an instance has generated before.
+ *
+ * This lets modules fill in sizes in a file header at the end of the
+ * session feed. Only instances which write to an output sink support
+ * this, and the sink's file or stream must be seekable, unless the
+ * range is still buffered.
+ *
+ * @param o The output instance.
+ * @param offset Position of the range, relative to the start of the
+ *               instance's output.
+ * @param data The new content of the range.
+ * @param len Length of the range in bytes.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_NA The output cannot be rewritten.
+ * @retval SR_ERR_ARG The range was not generated yet.
+ * @retval SR_ERR_IO Write error.
+ *
+ * @private
+ */
+SR_PRIV int sr_output_rewrite(const struct sr_output *o, uint64_t offset,
+		const void *data, size_t len)
+{
+	struct sr_output_sink *sink;
+	off_t end, start;
+	ssize_t written;
+	int ret;
+
+	if (!o || !(sink = o->sink))
+		return SR_ERR_NA;
+	if (offset + len > sink->written + sink->buf->len)
+		return SR_ERR_ARG;
+
+	/* Still in the buffer, just overwrite it there. */
+	if (offset >= sink->written) {
+		memcpy(sink->buf->str + (offset - sink->written), data, len);
+		return SR_OK;
+	}
+	if (sink->fd < 0 && !sink->file)
+		return SR_ERR_NA;
+	if (offset + len > sink->written && (ret = sink_write(sink)) != SR_OK)
+		return ret;
+
+	ret = SR_OK;
+	if (sink->fd >= 0) {
+		if ((end = lseek(sink->fd, 0, SEEK_CUR)) < 0)
+			return SR_ERR_NA;
+		start = end - sink->written;
+		if (lseek(sink->fd, start + offset, SEEK_SET) < 0)
+			return SR_ERR_NA;
+		written = write(sink->fd, data, len);
+		if (written < 0 || (size_t)written != len) {
+			sr_err("Cannot rewrite output: %s.", g_strerror(errno));
+			ret = SR_ERR_IO;
+		}
+		if (lseek(sink->fd, end, SEEK_SET) < 0)
+			ret = SR_ERR_IO;
+	} else {
+		if ((end = ftello(sink->file)) < 0)
+			return SR_ERR_NA;
+		start = end - sink->written;
+		if (fseeko(sink->file, start + offset, SEEK_SET) < 0)
+			return SR_ERR_NA;
+		if (fwrite(data, len, 1, sink->file) != 1) {
+			sr_err("Cannot rewrite output: %s.", g_strerror(errno));
+			ret = SR_ERR_IO;
+		}
+		if (fseeko(sink->file, end, SEEK_SET) < 0)
+			ret = SR_ERR_IO;
+	}
+
+	return ret;
+}
+
+static void parallel_free(struct sr_output *op)
+{
+	struct output_parallel *par;
+	size_t i;
+
+	if (!(par = op->parallel))
+		return;
+	op->parallel = NULL;
+
+	if (par->pool)
+		g_thread_pool_free(par->pool, FALSE, TRUE);
+	for (i = 0; i < par->num_workers; i++) {
+		if (par->jobs[i].o)
+			sr_output_free(par->jobs[i].o);
+		if (par->jobs[i].text)
+			g_string_free(par->jobs[i].text, TRUE);
+	}
+	g_free(par->jobs);
+	g_free(par->prev_sample);
+	g_mutex_clear(&par->mutex);
+	g_cond_clear(&par->cond);
+	g_free(par);
+}
+
+/**
+ * Format large logic packets on several threads.
+ *
+ * Logic packets get split into ranges of samples, which separate
+ * instances of the output module format concurrently. Their text gets
+ * reassembled in order, the output is the same as without threads.
+ * This is meant for the offline conversion of large captures, live
+ * acquisitions rarely send packets which are large enough to benefit.
+ *
+ * Not all output modules support this, a module needs to be able to
+ * carry the state from previous samples into a range. Packets are
+ * formatted serially when the instance's state doesn't allow to split
+ * them, e.g. for the first packet after the header.
+ *
+ * @param o The output instance.
+ * @param num_threads Number of threads, 0 or 1 to format serially.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_NA The output module doesn't support threads.
+ * @retval other Negative error code.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_output_threads_set(const struct sr_output *o,
+		unsigned int num_threads)
+{
+	struct sr_output *op;
+	struct output_parallel *par;
+	GError *error;
+	size_t i;
+
+	if (!o)
+		return SR_ERR_ARG;
+	op = (struct sr_output *)o;
+
+	parallel_free(op);
+	if (num_threads < 2)
+		return SR_OK;
+	if (!o->module->split_align || !o->module->carry_in)
+		return SR_ERR_NA;
+
+	par = g_malloc0(sizeof(*par));
+	g_mutex_init(&par->mutex);
+	g_cond_init(&par->cond);
+	par->num_workers = num_threads;
+	par->jobs = g_malloc0(num_threads * sizeof(par->jobs[0]));
+	op->parallel = par;
+	for (i = 0; i < num_threads; i++) {
+		par->jobs[i].o = (struct sr_output *)output_new(o->module,
+			o->options, o->sdi, o->filename, NULL);
+		if (!par->jobs[i].o) {
+			sr_err("Cannot create worker output instance.");
+			parallel_free(op);
+			return SR_ERR;
+		}
+		par->jobs[i].text = g_string_sized_new(SINK_FLUSH_SIZE);
+	}
+
+	error = NULL;
+	par->pool = g_thread_pool_new(parallel_job_run, par, num_threads,
+		FALSE, &error);
+	if (!par->pool) {
+		sr_err("Cannot create output threads: %s.", error->message);
+		g_error_free(error);
+		parallel_free(op);
+		return SR_ERR;
+	}
+
+	return SR_OK;
 }
 
 /**
@@ -354,8 +1011,9 @@ SR_API int sr_output_free(const struct sr_output *o)
 	ret = SR_OK;
 	if (o->module->cleanup)
 		ret = o->module->cleanup((struct sr_output *)o);
-	g_free((char *)o->filename);
-	g_free((gpointer)o);
+	if (o->sink && sink_write(o->sink) != SR_OK && ret == SR_OK)
+		ret = SR_ERR_IO;
+	output_free((struct sr_output *)o);
 
 	return ret;
 }
@@ -18,6 +18,7 @@
  */
 
 #include <config.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -30,8 +31,17 @@
 #define LOG_PREFIX "output/srzip"
 #define CHUNK_SIZE (4 * 1024 * 1024)
 
+/* Archive member for analog data of all channels, in time lockstep. */
+#define ANALOG_FRAMES_NAME "analog-frames-1"
+/* Marker for "no data" in int16 frames, padding of short channels. */
+#define ANALOG_INT16_NAN G_MININT16
+
 struct out_context {
 	gboolean zip_created;
+	gboolean compress;
+	gboolean append_inplace;
+	gboolean analog_interleaved;
+	gboolean analog_int16;
 	uint64_t samplerate;
 	char *filename;
 	size_t first_analog_index;
@@ -54,8 +64,6 @@ static int init(struct sr_output *o, GHashTable *options)
 {
 	struct out_context *outc;
 
-	(void)options;
-
 	if (!o->filename || o->filename[0] == '\0') {
 		sr_info("srzip output module requires a file name, cannot save.");
 		return SR_ERR_ARG;
@@ -63,6 +71,23 @@ static int init(struct sr_output *o, GHashTable *options)
 
 	outc = g_malloc0(sizeof(*outc));
 	outc->filename = g_strdup(o->filename);
+	outc->compress = g_variant_get_boolean(g_hash_table_lookup(options, "compress"));
+	/* Sample data gets appended in place, unless deflate is missing. */
+	outc->append_inplace = TRUE;
+#ifndef HAVE_ZLIB
+	if (outc->compress)
+		outc->append_inplace = FALSE;
+#endif
+	outc->analog_interleaved = g_strcmp0(g_variant_get_string(
+		g_hash_table_lookup(options, "analog_layout"), NULL),
+		"interleaved") == 0;
+	outc->analog_int16 = g_strcmp0(g_variant_get_string(
+		g_hash_table_lookup(options, "analog_type"), NULL),
+		"int16") == 0;
+	if (outc->analog_int16 && !outc->analog_interleaved) {
+		sr_warn("int16 analog data requires interleaved layout, using float32.");
+		outc->analog_int16 = FALSE;
+	}
 	o->priv = outc;
 
 	return SR_OK;
@@ -156,6 +181,12 @@ static int zip_create(const struct sr_output *o)
 	g_free(s);
 
 	g_key_file_set_integer(meta, devgroup, "total analog", enabled_analog_channels);
+	if (enabled_analog_channels && outc->analog_interleaved) {
+		g_key_file_set_string(meta, devgroup, "analog layout",
+			"interleaved");
+		g_key_file_set_string(meta, devgroup, "analog type",
+			outc->analog_int16 ? "int16" : "float32");
+	}
 
 	outc->analog_ch_count = enabled_analog_channels;
 	alloc_size = sizeof(gint) * outc->analog_ch_count + 1;
@@ -251,6 +282,42 @@ static int zip_create(const struct sr_output *o)
 	return SR_OK;
 }
 
+/**
+ * Select the compression method for a newly added sample data member.
+ *
+ * Uncompressed ("stored") members can get replayed from a memory
+ * mapping of the session file without libzip involvement.
+ *
+ * @param[in] o Output module instance.
+ * @param[in] archive The open ZIP archive.
+ * @param[in] index The archive member's index.
+ *
+ * @returns SR_OK et al error codes.
+ */
+static int zip_set_method(const struct sr_output *o,
+	struct zip *archive, int64_t index)
+{
+	struct out_context *outc;
+
+	outc = o->priv;
+	if (outc->compress)
+		return SR_OK;
+
+#if HAVE_ZIP_SET_FILE_COMPRESSION
+	if (zip_set_file_compression(archive, index, ZIP_CM_STORE, 0) < 0) {
+		sr_err("Failed to select store method: %s",
+			zip_strerror(archive));
+		return SR_ERR;
+	}
+#else
+	sr_dbg("libzip cannot store uncompressed members, compressing.");
+	(void)archive;
+	(void)index;
+#endif
+
+	return SR_OK;
+}
+
 /**
  * Append a block of logic data to an srzip archive.
  *
@@ -278,6 +345,8 @@ static int zip_append(const struct sr_output *o,
 	gsize metalen;
 	char *chunkname;
 	unsigned int next_chunk_num;
+	gboolean renamed;
+	int ret;
 
 	if (!length)
 		return SR_OK;
@@ -330,6 +399,7 @@ static int zip_append(const struct sr_output *o,
 	g_key_file_free(kf);
 
 	next_chunk_num = 1;
+	renamed = FALSE;
 	num_files = zip_get_num_entries(archive, 0);
 	for (i = 0; i < num_files; i++) {
 		entry_name = zip_get_name(archive, i, 0);
@@ -349,6 +419,7 @@ static int zip_append(const struct sr_output *o,
 				return SR_ERR;
 			}
 			next_chunk_num = 2;
+			renamed = TRUE;
 			break;
 		} else if (entry_name[7] == '-') {
 			chunk_num = g_ascii_strtoull(entry_name + 8, NULL, 10);
@@ -361,8 +432,24 @@ static int zip_append(const struct sr_output *o,
 		sr_warn("Chunk size %zu not a multiple of the"
 			" unit size %zu.", length, unitsize);
 	}
-	logicsrc = zip_source_buffer(archive, buf, length, FALSE);
 	chunkname = g_strdup_printf("logic-1-%u", next_chunk_num);
+	if (outc->append_inplace && !metabuf && !renamed) {
+		/*
+		 * No other changes pending, no need for libzip to rewrite.
+		 * The archive is left untouched when the chunk cannot get
+		 * compressed in place, have libzip add it in that case.
+		 */
+		ret = sr_sessionfile_append(outc->filename, chunkname,
+			buf, length, outc->compress);
+		if (ret != SR_ERR_NA) {
+			zip_discard(archive);
+			g_free(chunkname);
+			return ret;
+		}
+		sr_dbg("Cannot append '%s' in place, using libzip.", chunkname);
+	}
+
+	logicsrc = zip_source_buffer(archive, buf, length, FALSE);
 	i = zip_add(archive, chunkname, logicsrc);
 	g_free(chunkname);
 	if (i < 0) {
@@ -373,6 +460,11 @@ static int zip_append(const struct sr_output *o,
 		g_free(metabuf);
 		return SR_ERR;
 	}
+	if (zip_set_method(o, archive, i) != SR_OK) {
+		zip_discard(archive);
+		g_free(metabuf);
+		return SR_ERR;
+	}
 	if (zip_close(archive) < 0) {
 		sr_err("Error saving session file: %s", zip_strerror(archive));
 		zip_discard(archive);
@@ -500,30 +592,29 @@ static int zip_append_queue(const struct sr_output *o,
 }
 
 /**
- * Append analog data of a channel to an srzip archive.
+ * Append a chunk of sample data to an srzip archive.
  *
  * @param[in] o Output module instance.
- * @param[in] values Sample data as array of floating point values.
- * @param[in] count Number of samples (float items, not bytes).
- * @param[in] ch_nr 1-based channel number.
+ * @param[in] basename Archive member name, the chunk number gets appended.
+ * @param[in] data Sample data.
+ * @param[in] size Sample data size in bytes.
  *
  * @returns SR_OK et al error codes.
  */
-static int zip_append_analog(const struct sr_output *o,
-	const float *values, size_t count, size_t ch_nr)
+static int zip_append_chunk(const struct sr_output *o,
+	const char *basename, const void *data, size_t size)
 {
 	struct out_context *outc;
 	struct zip *archive;
-	struct zip_source *analogsrc;
+	struct zip_source *chunksrc;
 	int64_t i, num_files;
-	size_t size;
 	struct zip_stat zs;
 	uint64_t chunk_num;
 	const char *entry_name;
-	char *basename;
 	gsize baselen;
 	char *chunkname;
 	unsigned int next_chunk_num;
+	int ret;
 
 	outc = o->priv;
 
@@ -536,7 +627,6 @@ static int zip_append_analog(const struct sr_output *o,
 		return SR_ERR;
 	}
 
-	basename = g_strdup_printf("analog-1-%zu", ch_nr);
 	baselen = strlen(basename);
 	next_chunk_num = 1;
 	num_files = zip_get_num_entries(archive, 0);
@@ -551,33 +641,262 @@ static int zip_append_analog(const struct sr_output *o,
 		}
 	}
 
-	size = sizeof(values[0]) * count;
-	analogsrc = zip_source_buffer(archive, values, size, FALSE);
 	chunkname = g_strdup_printf("%s-%u", basename, next_chunk_num);
-	i = zip_add(archive, chunkname, analogsrc);
+	if (outc->append_inplace) {
+		ret = sr_sessionfile_append(outc->filename, chunkname,
+			data, size, outc->compress);
+		if (ret != SR_ERR_NA) {
+			zip_discard(archive);
+			g_free(chunkname);
+			return ret;
+		}
+		sr_dbg("Cannot append '%s' in place, using libzip.", chunkname);
+	}
+
+	chunksrc = zip_source_buffer(archive, data, size, FALSE);
+	i = zip_add(archive, chunkname, chunksrc);
 	if (i < 0) {
 		sr_err("Failed to add chunk '%s': %s", chunkname, zip_strerror(archive));
 		g_free(chunkname);
-		g_free(basename);
-		zip_source_free(analogsrc);
+		zip_source_free(chunksrc);
 		zip_discard(archive);
 		return SR_ERR;
 	}
 	g_free(chunkname);
+	if (zip_set_method(o, archive, i) != SR_OK) {
+		zip_discard(archive);
+		return SR_ERR;
+	}
 	if (zip_close(archive) < 0) {
 		sr_err("Error saving session file: %s", zip_strerror(archive));
-		g_free(basename);
 		zip_discard(archive);
 		return SR_ERR;
 	}
 
+	return SR_OK;
+}
+
+/**
+ * Append analog data of a channel to an srzip archive.
+ *
+ * @param[in] o Output module instance.
+ * @param[in] values Sample data as array of floating point values.
+ * @param[in] count Number of samples (float items, not bytes).
+ * @param[in] ch_nr 1-based channel number.
+ *
+ * @returns SR_OK et al error codes.
+ */
+static int zip_append_analog(const struct sr_output *o,
+	const float *values, size_t count, size_t ch_nr)
+{
+	char *basename;
+	int ret;
+
+	basename = g_strdup_printf("analog-1-%zu", ch_nr);
+	ret = zip_append_chunk(o, basename, values, sizeof(values[0]) * count);
 	g_free(basename);
 
+	return ret;
+}
+
+/**
+ * Append analog data of all channels to an srzip archive, interleaved.
+ *
+ * Takes as many samples from the channels' queues as all of them have
+ * available. Optionally pads channels which fall behind, so that queues
+ * of channels which are ahead get drained. Padding is NaN for float32
+ * data, and ANALOG_INT16_NAN for int16 data.
+ *
+ * The float32 layout holds frames of native float values, one for each
+ * channel. The int16 layout starts with a scale and offset (float32,
+ * little endian) for each channel, followed by frames of int16 values
+ * (little endian). A value's reading is: offset + scale * value.
+ *
+ * @param[in] o Output module instance.
+ * @param[in] pad Whether to pad channels with fewer queued samples.
+ *
+ * @returns SR_OK et al error codes.
+ */
+static int zip_append_analog_frames(const struct sr_output *o, gboolean pad)
+{
+	struct out_context *outc;
+	struct analog_buff *buff;
+	size_t ch_count, frame_count, idx, snum, remain;
+	size_t frame_size, size;
+	float value, vmin, vmax, *scales, *offsets, *wrptr;
+	uint8_t *data, *wrpos;
+	int ret;
+
+	outc = o->priv;
+	ch_count = outc->analog_ch_count;
+	if (!ch_count)
+		return SR_OK;
+
+	frame_count = outc->analog_buff[0].fill_size;
+	for (idx = 0; idx < ch_count; idx++) {
+		buff = &outc->analog_buff[idx];
+		if (pad)
+			frame_count = MAX(frame_count, buff->fill_size);
+		else
+			frame_count = MIN(frame_count, buff->fill_size);
+	}
+	if (!frame_count)
+		return SR_OK;
+	if (pad) {
+		for (idx = 0; idx < ch_count; idx++) {
+			if (outc->analog_buff[idx].fill_size == frame_count)
+				continue;
+			sr_warn("Analog channels out of lockstep, padding.");
+			break;
+		}
+	}
+
+	frame_size = ch_count;
+	frame_size *= outc->analog_int16 ? sizeof(int16_t) : sizeof(float);
+	size = frame_count * frame_size;
+	if (outc->analog_int16)
+		size += ch_count * 2 * sizeof(float);
+	data = g_try_malloc(size);
+	if (!data)
+		return SR_ERR_MALLOC;
+
+	if (!outc->analog_int16) {
+		wrptr = (float *)data;
+		for (snum = 0; snum < frame_count; snum++) {
+			for (idx = 0; idx < ch_count; idx++) {
+				buff = &outc->analog_buff[idx];
+				if (snum < buff->fill_size)
+					*wrptr++ = buff->samples[snum];
+				else
+					*wrptr++ = NAN;
+			}
+		}
+	} else {
+		/* Determine the channels' value ranges, emit scale and offset. */
+		scales = g_malloc0(ch_count * sizeof(scales[0]));
+		offsets = g_malloc0(ch_count * sizeof(offsets[0]));
+		wrpos = data;
+		for (idx = 0; idx < ch_count; idx++) {
+			buff = &outc->analog_buff[idx];
+			vmin = INFINITY;
+			vmax = -INFINITY;
+			for (snum = 0; snum < buff->fill_size && snum < frame_count; snum++) {
+				value = buff->samples[snum];
+				if (isnan(value))
+					continue;
+				vmin = MIN(vmin, value);
+				vmax = MAX(vmax, value);
+			}
+			if (vmin > vmax)
+				vmin = vmax = 0;
+			offsets[idx] = (vmin + vmax) / 2;
+			scales[idx] = (vmax - vmin) / (2 * G_MAXINT16);
+			if (!(scales[idx] > 0))
+				scales[idx] = 1;
+			write_fltle_inc(&wrpos, scales[idx]);
+			write_fltle_inc(&wrpos, offsets[idx]);
+		}
+		for (snum = 0; snum < frame_count; snum++) {
+			for (idx = 0; idx < ch_count; idx++) {
+				buff = &outc->analog_buff[idx];
+				value = NAN;
+				if (snum < buff->fill_size)
+					value = buff->samples[snum];
+				if (isnan(value)) {
+					write_u16le_inc(&wrpos, (uint16_t)ANALOG_INT16_NAN);
+					continue;
+				}
+				value = roundf((value - offsets[idx]) / scales[idx]);
+				value = CLAMP(value, -G_MAXINT16, G_MAXINT16);
+				write_u16le_inc(&wrpos, (uint16_t)(int16_t)value);
+			}
+		}
+		g_free(scales);
+		g_free(offsets);
+	}
+
+	ret = zip_append_chunk(o, ANALOG_FRAMES_NAME, data, size);
+	g_free(data);
+	if (ret != SR_OK)
+		return ret;
+
+	/* Keep the samples which were not taken yet. */
+	for (idx = 0; idx < ch_count; idx++) {
+		buff = &outc->analog_buff[idx];
+		if (buff->fill_size <= frame_count) {
+			buff->fill_size = 0;
+			continue;
+		}
+		remain = buff->fill_size - frame_count;
+		memmove(buff->samples, &buff->samples[frame_count],
+			remain * sizeof(buff->samples[0]));
+		buff->fill_size = remain;
+	}
+
 	return SR_OK;
 }
 
 /**
- * Queue analog data of a channel for srzip archive writes.
+ * Flush a channel's queue of analog data to the srzip archive.
+ *
+ * @param[in] o Output module instance.
+ * @param[in] idx Index of the channel among the analog channels.
+ * @param[in] pad Whether to pad other channels in interleaved layout.
+ *
+ * @returns SR_OK et al error codes.
+ */
+static int zip_append_analog_flush(const struct sr_output *o,
+	size_t idx, gboolean pad)
+{
+	struct out_context *outc;
+	struct analog_buff *buff;
+	int ret;
+
+	outc = o->priv;
+	if (outc->analog_interleaved)
+		return zip_append_analog_frames(o, pad);
+
+	buff = &outc->analog_buff[idx];
+	if (!buff->fill_size)
+		return SR_OK;
+	ret = zip_append_analog(o, buff->samples, buff->fill_size,
+		outc->first_analog_index + idx);
+	if (ret != SR_OK)
+		return ret;
+	buff->fill_size = 0;
+
+	return SR_OK;
+}
+
+/**
+ * Copy analog data of a channel to its queue, which must have room.
+ *
+ * @param[in] buff The channel's queue.
+ * @param[in] values Sample data, can be interleaved with other channels.
+ * @param[in] stride Distance of the channel's values (in float items).
+ * @param[in] count Number of samples.
+ */
+static void zip_append_analog_channel(struct analog_buff *buff,
+	const float *values, size_t stride, size_t count)
+{
+	if (stride == 1) {
+		memcpy(&buff->samples[buff->fill_size], values,
+			count * sizeof(values[0]));
+		buff->fill_size += count;
+		return;
+	}
+	while (count--) {
+		buff->samples[buff->fill_size++] = *values;
+		values += stride;
+	}
+}
+
+/**
+ * Queue analog data for srzip archive writes.
+ *
+ * Accepts packets which carry one or several channels. Samples are
+ * queued in slices which fit all involved channels' queues. Queues
+ * get flushed to the ZIP archive when their space is exhausted.
  *
  * @param[in] o Output module instance.
  * @param[in] analog Sample data (session feed packet format).
@@ -590,95 +909,92 @@ static int zip_append_analog_queue(const struct sr_output *o,
 {
 	struct out_context *outc;
 	const struct sr_channel *ch;
-	size_t idx, nr;
 	struct analog_buff *buff;
-	float *values, *wrptr, *rdptr;
-	size_t send_size, remain, copy_size;
+	size_t idx, ch_count, ch_nr, *ch_idx;
+	size_t offset, slice;
+	float *values;
+	GSList *l;
 	int ret;
 
 	outc = o->priv;
 
 	/* Is this the DF_END flush call without samples submission? */
 	if (!analog && flush) {
+		if (outc->analog_interleaved)
+			return zip_append_analog_frames(o, TRUE);
 		for (idx = 0; idx < outc->analog_ch_count; idx++) {
-			nr = outc->first_analog_index + idx;
-			buff = &outc->analog_buff[idx];
-			if (!buff->fill_size)
-				continue;
-			ret = zip_append_analog(o,
-				buff->samples, buff->fill_size, nr);
+			ret = zip_append_analog_flush(o, idx, TRUE);
 			if (ret != SR_OK)
 				return ret;
-			buff->fill_size = 0;
 		}
 		return SR_OK;
 	}
 
-	/* Lookup index and number of the analog channel. */
-	/* TODO: support packets covering multiple channels */
-	if (g_slist_length(analog->meaning->channels) != 1) {
-		sr_err("Analog packets covering multiple channels not supported yet");
-		return SR_ERR;
-	}
-	ch = g_slist_nth_data(analog->meaning->channels, 0);
-	for (idx = 0; idx < outc->analog_ch_count; idx++) {
-		if (outc->analog_index_map[idx] == ch->index)
-			break;
-	}
-	if (idx == outc->analog_ch_count)
+	/* Lookup the index of each of the packet's analog channels. */
+	ch_count = g_slist_length(analog->meaning->channels);
+	if (!ch_count)
 		return SR_ERR_ARG;
-	nr = outc->first_analog_index + idx;
-	buff = &outc->analog_buff[idx];
+	ch_idx = g_malloc0(ch_count * sizeof(ch_idx[0]));
+	for (l = analog->meaning->channels, ch_nr = 0; l; l = l->next, ch_nr++) {
+		ch = l->data;
+		for (idx = 0; idx < outc->analog_ch_count; idx++) {
+			if (outc->analog_index_map[idx] == ch->index)
+				break;
+		}
+		if (idx == outc->analog_ch_count) {
+			g_free(ch_idx);
+			return SR_ERR_ARG;
+		}
+		ch_idx[ch_nr] = idx;
+	}
 
 	/* Convert the analog data to an array of float values. */
-	values = g_try_malloc0(analog->num_samples * sizeof(values[0]));
-	if (!values)
+	values = g_try_malloc0(analog->num_samples * ch_count * sizeof(values[0]));
+	if (!values) {
+		g_free(ch_idx);
 		return SR_ERR_MALLOC;
-	ret = sr_analog_to_float(analog, values);
-	if (ret != SR_OK) {
-		g_free(values);
-		return ret;
 	}
+	ret = sr_analog_to_float(analog, values);
 
-	/*
-	 * Queue most recently received samples to the local buffer.
-	 * Flush to the ZIP archive when the buffer space is exhausted.
-	 */
-	rdptr = values;
-	send_size = analog->num_samples;
-	while (send_size) {
-		remain = buff->alloc_size - buff->fill_size;
-		if (remain) {
-			wrptr = &buff->samples[buff->fill_size];
-			copy_size = MIN(send_size, remain);
-			send_size -= copy_size;
-			buff->fill_size += copy_size;
-			memcpy(wrptr, rdptr, copy_size * sizeof(values[0]));
-			rdptr += copy_size;
-			remain -= copy_size;
+	offset = 0;
+	while (ret == SR_OK && offset < analog->num_samples) {
+		slice = analog->num_samples - offset;
+		for (ch_nr = 0; ch_nr < ch_count; ch_nr++) {
+			buff = &outc->analog_buff[ch_idx[ch_nr]];
+			slice = MIN(slice, buff->alloc_size - buff->fill_size);
 		}
-		if (send_size && !remain) {
-			ret = zip_append_analog(o,
-				buff->samples, buff->fill_size, nr);
-			if (ret != SR_OK) {
-				g_free(values);
-				return ret;
+		if (slice) {
+			for (ch_nr = 0; ch_nr < ch_count; ch_nr++) {
+				buff = &outc->analog_buff[ch_idx[ch_nr]];
+				zip_append_analog_channel(buff,
+					&values[offset * ch_count + ch_nr],
+					ch_count, slice);
 			}
-			buff->fill_size = 0;
-			remain = buff->alloc_size - buff->fill_size;
+			offset += slice;
+			continue;
+		}
+		/*
+		 * Some queue is full. Write out what the channels have in
+		 * common, only pad lagging channels when that made no room.
+		 */
+		for (ch_nr = 0; ret == SR_OK && ch_nr < ch_count; ch_nr++) {
+			idx = ch_idx[ch_nr];
+			buff = &outc->analog_buff[idx];
+			if (buff->fill_size < buff->alloc_size)
+				continue;
+			ret = zip_append_analog_flush(o, idx, FALSE);
+			if (ret == SR_OK && buff->fill_size == buff->alloc_size)
+				ret = zip_append_analog_flush(o, idx, TRUE);
 		}
 	}
-	g_free(values);
 
-	/* Flush to the ZIP archive if the caller wants us to. */
-	if (flush && buff->fill_size) {
-		ret = zip_append_analog(o, buff->samples, buff->fill_size, nr);
-		if (ret != SR_OK)
-			return ret;
-		buff->fill_size = 0;
-	}
+	for (ch_nr = 0; ret == SR_OK && flush && ch_nr < ch_count; ch_nr++)
+		ret = zip_append_analog_flush(o, ch_idx[ch_nr], TRUE);
 
-	return SR_OK;
+	g_free(values);
+	g_free(ch_idx);
+
+	return ret;
 }
 
 static int receive(const struct sr_output *o, const struct sr_datafeed_packet *packet,
@@ -746,11 +1062,30 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 }
 
 static struct sr_option options[] = {
+	{"compress", "Compress", "Compress sample data", NULL, NULL},
+	{"analog_layout", "Analog layout", "Store analog channels separately, or interleaved", NULL, NULL},
+	{"analog_type", "Analog type", "Analog sample data type (int16 requires interleaved layout)", NULL, NULL},
 	ALL_ZERO
 };
 
 static const struct sr_option *get_options(void)
 {
+	GSList *l;
+
+	if (!options[0].def) {
+		options[0].def = g_variant_ref_sink(g_variant_new_boolean(TRUE));
+		options[1].def = g_variant_ref_sink(g_variant_new_string("channels"));
+		l = NULL;
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("channels")));
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("interleaved")));
+		options[1].values = l;
+		options[2].def = g_variant_ref_sink(g_variant_new_string("float32"));
+		l = NULL;
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("float32")));
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("int16")));
+		options[2].values = l;
+	}
+
 	return options;
 }
 
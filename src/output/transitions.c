@@ -0,0 +1,473 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compact binary stream of value changes ("transitions").
+ *
+ * The stream only carries the sample positions where values change,
+ * which makes it tiny for sparse activity, and cheap to write and to
+ * parse. The "transitions" input module reads it back. All integers
+ * are unsigned LEB128 varints (see write_varint_inc()) unless noted.
+ *
+ * Header:
+ * - Magic "SRTRANS", followed by one version byte.
+ * - Channel count, then per channel: a type byte (0 logic, 1 analog),
+ *   the name's length, and the name's text. Logic channels come first.
+ *
+ * Records start with a type byte (enum transitions_record):
+ * - END: Total logic sample count, then each analog channel's total
+ *   sample count.
+ * - SAMPLERATE: Samplerate in Hz.
+ * - LOGIC_VALUES: Position delta, then the values of all logic
+ *   channels, packed into (logic channel count + 7) / 8 bytes, the
+ *   first logic channel in the LSB of the first byte.
+ * - LOGIC_TOGGLE: Position delta, then a mask of logic channels which
+ *   change their value, in the same layout as LOGIC_VALUES.
+ * - TRIGGER: Position delta.
+ * - ANALOG_META: Analog channel number, position delta, mq, mqflags,
+ *   unit, and digits (zigzag encoded).
+ * - ANALOG_VALUE: Analog channel number, position delta, then the
+ *   new value's IEEE754 single precision bit pattern XOR-ed with the
+ *   previous value's (which is 0.0 initially).
+ *
+ * Position deltas count samples since the previous record's position.
+ * Logic records (and TRIGGER) share the logic position, each analog
+ * channel has a position of its own. Values take effect at the record's
+ * position, and are kept until the next change. Logic data starts with
+ * a LOGIC_VALUES record, later changes use LOGIC_TOGGLE.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "output/transitions"
+
+struct out_analog {
+	struct sr_channel *ch;
+	uint64_t pos;
+	uint64_t rec_pos;
+	uint32_t bits;
+	gboolean meta_done;
+	enum sr_mq mq;
+	enum sr_mqflag mqflags;
+	enum sr_unit unit;
+	int digits;
+};
+
+struct context {
+	gboolean header_done;
+	uint64_t samplerate;
+	size_t num_logic;
+	size_t logic_bytes;
+	size_t *logic_index;
+	uint64_t logic_pos;
+	uint64_t logic_rec_pos;
+	gboolean logic_started;
+	uint8_t *logic_state;
+	uint8_t *logic_next;
+	uint8_t *prev_sample;
+	size_t prev_size;
+	size_t num_analog;
+	struct out_analog *analog;
+	float *fdata;
+	size_t fdata_size;
+};
+
+static int init(struct sr_output *o, GHashTable *options)
+{
+	struct context *ctx;
+	struct sr_channel *ch;
+	GSList *l;
+	size_t logic_idx, analog_idx;
+
+	(void)options;
+
+	if (!o || !o->sdi)
+		return SR_ERR_ARG;
+
+	ctx = g_malloc0(sizeof(*ctx));
+	o->priv = ctx;
+	for (l = o->sdi->channels; l; l = l->next) {
+		ch = l->data;
+		if (!ch->enabled)
+			continue;
+		if (ch->type == SR_CHANNEL_LOGIC)
+			ctx->num_logic++;
+		else if (ch->type == SR_CHANNEL_ANALOG)
+			ctx->num_analog++;
+	}
+	ctx->logic_bytes = (ctx->num_logic + 7) / 8;
+	ctx->logic_index = g_malloc0(ctx->num_logic * sizeof(ctx->logic_index[0]));
+	ctx->logic_state = g_malloc0(ctx->logic_bytes);
+	ctx->logic_next = g_malloc0(ctx->logic_bytes);
+	ctx->analog = g_malloc0(ctx->num_analog * sizeof(ctx->analog[0]));
+
+	logic_idx = analog_idx = 0;
+	for (l = o->sdi->channels; l; l = l->next) {
+		ch = l->data;
+		if (!ch->enabled)
+			continue;
+		if (ch->type == SR_CHANNEL_LOGIC)
+			ctx->logic_index[logic_idx++] = ch->index;
+		else if (ch->type == SR_CHANNEL_ANALOG)
+			ctx->analog[analog_idx++].ch = ch;
+	}
+
+	return SR_OK;
+}
+
+/*
+ * Make room for up to len more bytes of output. The caller writes to
+ * the returned position, and releases excess room by passing the end
+ * of what was written to out_done().
+ */
+static uint8_t *out_reserve(GString *out, size_t len)
+{
+	size_t pos;
+
+	pos = out->len;
+	g_string_set_size(out, pos + len);
+
+	return (uint8_t *)&out->str[pos];
+}
+
+static void out_done(GString *out, const uint8_t *wrptr)
+{
+	g_string_truncate(out, wrptr - (const uint8_t *)out->str);
+}
+
+static void append_header(const struct sr_output *o, GString *out)
+{
+	struct context *ctx;
+	struct sr_channel *ch;
+	GVariant *gvar;
+	GSList *l;
+	uint8_t *wrptr;
+	size_t i, len;
+
+	ctx = o->priv;
+	if (ctx->header_done)
+		return;
+	ctx->header_done = TRUE;
+
+	if (!ctx->samplerate && sr_config_get(o->sdi->driver, o->sdi, NULL,
+			SR_CONF_SAMPLERATE, &gvar) == SR_OK) {
+		ctx->samplerate = g_variant_get_uint64(gvar);
+		g_variant_unref(gvar);
+	}
+
+	g_string_append_len(out, TRANSITIONS_MAGIC, TRANSITIONS_MAGIC_LEN);
+	g_string_append_c(out, TRANSITIONS_VERSION);
+	wrptr = out_reserve(out, VARINT_MAX_LEN);
+	write_varint_inc(&wrptr, ctx->num_logic + ctx->num_analog);
+	out_done(out, wrptr);
+
+	/* Logic channels first, then analog channels. */
+	for (i = 0; i < 2; i++) {
+		for (l = o->sdi->channels; l; l = l->next) {
+			ch = l->data;
+			if (!ch->enabled)
+				continue;
+			if (ch->type != (i ? SR_CHANNEL_ANALOG : SR_CHANNEL_LOGIC))
+				continue;
+			len = strlen(ch->name);
+			wrptr = out_reserve(out, 1 + VARINT_MAX_LEN + len);
+			*wrptr++ = i ? TRANSITIONS_CHANNEL_ANALOG : TRANSITIONS_CHANNEL_LOGIC;
+			write_varint_inc(&wrptr, len);
+			memcpy(wrptr, ch->name, len);
+			out_done(out, wrptr + len);
+		}
+	}
+
+	if (ctx->samplerate) {
+		wrptr = out_reserve(out, 1 + VARINT_MAX_LEN);
+		*wrptr++ = TRANSITIONS_REC_SAMPLERATE;
+		write_varint_inc(&wrptr, ctx->samplerate);
+		out_done(out, wrptr);
+	}
+}
+
+/* Find the next sample which differs from its predecessor. */
+static size_t find_change(const uint8_t *data, size_t size,
+	size_t unitsize, size_t pos)
+{
+	while (pos + sizeof(uint64_t) <= size) {
+		if (read_u64le(&data[pos]) != read_u64le(&data[pos - unitsize]))
+			break;
+		pos += sizeof(uint64_t);
+	}
+	while (pos < size && data[pos] == data[pos - unitsize])
+		pos++;
+
+	return pos / unitsize;
+}
+
+/* Emit a logic record when the sample's channel values have changed. */
+static void append_logic_sample(struct context *ctx, GString *out,
+	const uint8_t *sample, size_t unitsize, uint64_t snum)
+{
+	size_t i, idx;
+	uint8_t *wrptr, changed;
+
+	memset(ctx->logic_next, 0, ctx->logic_bytes);
+	for (i = 0; i < ctx->num_logic; i++) {
+		idx = ctx->logic_index[i];
+		if (idx / 8 >= unitsize)
+			continue;
+		if (sample[idx / 8] & (1 << (idx % 8)))
+			ctx->logic_next[i / 8] |= 1 << (i % 8);
+	}
+
+	wrptr = out_reserve(out, 1 + VARINT_MAX_LEN + ctx->logic_bytes);
+	if (!ctx->logic_started) {
+		ctx->logic_started = TRUE;
+		*wrptr++ = TRANSITIONS_REC_LOGIC_VALUES;
+		write_varint_inc(&wrptr, snum - ctx->logic_rec_pos);
+		memcpy(wrptr, ctx->logic_next, ctx->logic_bytes);
+	} else {
+		changed = 0;
+		for (i = 0; i < ctx->logic_bytes; i++) {
+			ctx->logic_state[i] ^= ctx->logic_next[i];
+			changed |= ctx->logic_state[i];
+		}
+		if (!changed) {
+			/* Only disabled channels' bits differ. */
+			memcpy(ctx->logic_state, ctx->logic_next, ctx->logic_bytes);
+			out_done(out, wrptr);
+			return;
+		}
+		*wrptr++ = TRANSITIONS_REC_LOGIC_TOGGLE;
+		write_varint_inc(&wrptr, snum - ctx->logic_rec_pos);
+		memcpy(wrptr, ctx->logic_state, ctx->logic_bytes);
+	}
+	out_done(out, wrptr + ctx->logic_bytes);
+	memcpy(ctx->logic_state, ctx->logic_next, ctx->logic_bytes);
+	ctx->logic_rec_pos = snum;
+}
+
+static void append_logic(struct context *ctx, GString *out,
+	const struct sr_datafeed_logic *logic)
+{
+	const uint8_t *data;
+	size_t unitsize, count, size, idx;
+
+	unitsize = logic->unitsize;
+	if (!ctx->num_logic || !unitsize)
+		return;
+	count = logic->length / unitsize;
+	if (!count)
+		return;
+	data = logic->data;
+	size = count * unitsize;
+
+	/* The first sample compares against the previous packet's. */
+	if (ctx->prev_size != unitsize || memcmp(ctx->prev_sample, data, unitsize))
+		append_logic_sample(ctx, out, data, unitsize, ctx->logic_pos);
+
+	/* Skip over unchanged runs within the packet. */
+	idx = 0;
+	while ((idx = find_change(data, size, unitsize, (idx + 1) * unitsize)) < count)
+		append_logic_sample(ctx, out, &data[idx * unitsize], unitsize,
+			ctx->logic_pos + idx);
+
+	if (ctx->prev_size != unitsize) {
+		ctx->prev_sample = g_realloc(ctx->prev_sample, unitsize);
+		ctx->prev_size = unitsize;
+	}
+	memcpy(ctx->prev_sample, &data[size - unitsize], unitsize);
+	ctx->logic_pos += count;
+}
+
+static int append_analog(struct context *ctx, GString *out,
+	const struct sr_datafeed_analog *analog)
+{
+	struct out_analog *a;
+	struct sr_channel *ch;
+	GSList *l;
+	size_t num_channels, c, i, k, size;
+	uint32_t bits;
+	uint8_t *wrptr;
+	int ret;
+
+	num_channels = g_slist_length(analog->meaning->channels);
+	size = analog->num_samples * num_channels;
+	if (!size)
+		return SR_OK;
+	if (ctx->fdata_size < size) {
+		g_free(ctx->fdata);
+		ctx->fdata = g_try_malloc(size * sizeof(ctx->fdata[0]));
+		ctx->fdata_size = ctx->fdata ? size : 0;
+		if (!ctx->fdata)
+			return SR_ERR_MALLOC;
+	}
+	ret = sr_analog_to_float(analog, ctx->fdata);
+	if (ret != SR_OK)
+		return ret;
+
+	for (c = 0, l = analog->meaning->channels; l; l = l->next, c++) {
+		ch = l->data;
+		a = NULL;
+		for (i = 0; i < ctx->num_analog; i++) {
+			if (ctx->analog[i].ch == ch) {
+				a = &ctx->analog[i];
+				break;
+			}
+		}
+		if (!a)
+			continue;
+
+		/* Emit the channel's meaning when it has changed. */
+		if (!a->meta_done || a->mq != analog->meaning->mq ||
+				a->mqflags != analog->meaning->mqflags ||
+				a->unit != analog->meaning->unit ||
+				a->digits != analog->encoding->digits) {
+			a->meta_done = TRUE;
+			a->mq = analog->meaning->mq;
+			a->mqflags = analog->meaning->mqflags;
+			a->unit = analog->meaning->unit;
+			a->digits = analog->encoding->digits;
+			wrptr = out_reserve(out, 1 + 6 * VARINT_MAX_LEN);
+			*wrptr++ = TRANSITIONS_REC_ANALOG_META;
+			write_varint_inc(&wrptr, i);
+			write_varint_inc(&wrptr, a->pos - a->rec_pos);
+			write_varint_inc(&wrptr, a->mq);
+			write_varint_inc(&wrptr, a->mqflags);
+			write_varint_inc(&wrptr, a->unit);
+			write_varint_inc(&wrptr, ((uint64_t)a->digits << 1) ^
+				(a->digits < 0 ? ~UINT64_C(0) : 0));
+			out_done(out, wrptr);
+			a->rec_pos = a->pos;
+		}
+
+		for (k = 0; k < analog->num_samples; k++) {
+			memcpy(&bits, &ctx->fdata[k * num_channels + c], sizeof(bits));
+			if (bits == a->bits)
+				continue;
+			wrptr = out_reserve(out, 1 + 3 * VARINT_MAX_LEN);
+			*wrptr++ = TRANSITIONS_REC_ANALOG_VALUE;
+			write_varint_inc(&wrptr, i);
+			write_varint_inc(&wrptr, a->pos + k - a->rec_pos);
+			write_varint_inc(&wrptr, bits ^ a->bits);
+			out_done(out, wrptr);
+			a->bits = bits;
+			a->rec_pos = a->pos + k;
+		}
+		a->pos += analog->num_samples;
+	}
+
+	return SR_OK;
+}
+
+static int append(const struct sr_output *o, const struct sr_datafeed_packet *packet,
+		GString *out)
+{
+	struct context *ctx;
+	const struct sr_datafeed_meta *meta;
+	const struct sr_config *src;
+	GSList *l;
+	uint8_t *wrptr;
+	size_t i;
+
+	if (!o || !o->sdi)
+		return SR_ERR_ARG;
+	if (!(ctx = o->priv))
+		return SR_ERR_ARG;
+
+	switch (packet->type) {
+	case SR_DF_META:
+		meta = packet->payload;
+		for (l = meta->config; l; l = l->next) {
+			src = l->data;
+			if (src->key != SR_CONF_SAMPLERATE)
+				continue;
+			ctx->samplerate = g_variant_get_uint64(src->data);
+			if (!ctx->header_done)
+				continue;
+			wrptr = out_reserve(out, 1 + VARINT_MAX_LEN);
+			*wrptr++ = TRANSITIONS_REC_SAMPLERATE;
+			write_varint_inc(&wrptr, ctx->samplerate);
+			out_done(out, wrptr);
+		}
+		break;
+	case SR_DF_TRIGGER:
+		append_header(o, out);
+		wrptr = out_reserve(out, 1 + VARINT_MAX_LEN);
+		*wrptr++ = TRANSITIONS_REC_TRIGGER;
+		write_varint_inc(&wrptr, ctx->logic_pos - ctx->logic_rec_pos);
+		out_done(out, wrptr);
+		ctx->logic_rec_pos = ctx->logic_pos;
+		break;
+	case SR_DF_LOGIC:
+		append_header(o, out);
+		append_logic(ctx, out, packet->payload);
+		break;
+	case SR_DF_ANALOG:
+		append_header(o, out);
+		return append_analog(ctx, out, packet->payload);
+	case SR_DF_END:
+		append_header(o, out);
+		wrptr = out_reserve(out, 1 + (1 + ctx->num_analog) * VARINT_MAX_LEN);
+		*wrptr++ = TRANSITIONS_REC_END;
+		write_varint_inc(&wrptr, ctx->logic_pos);
+		for (i = 0; i < ctx->num_analog; i++)
+			write_varint_inc(&wrptr, ctx->analog[i].pos);
+		out_done(out, wrptr);
+		break;
+	}
+
+	return SR_OK;
+}
+
+static int cleanup(struct sr_output *o)
+{
+	struct context *ctx;
+
+	if (!o)
+		return SR_ERR_ARG;
+
+	if (!(ctx = o->priv))
+		return SR_OK;
+
+	g_free(ctx->logic_index);
+	g_free(ctx->logic_state);
+	g_free(ctx->logic_next);
+	g_free(ctx->prev_sample);
+	g_free(ctx->analog);
+	g_free(ctx->fdata);
+	g_free(ctx);
+	o->priv = NULL;
+
+	return SR_OK;
+}
+
+SR_PRIV struct sr_output_module output_transitions = {
+	.id = "transitions",
+	.name = "Transitions",
+	.desc = "Compact binary stream of logic and analog value changes",
+	.exts = (const char*[]){"srtr", NULL},
+	.flags = 0,
+	.options = NULL,
+	.init = init,
+	.append = append,
+	.cleanup = cleanup,
+};
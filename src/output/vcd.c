@@ -53,6 +53,14 @@ struct vcd_channel_desc {
 	uint64_t last_rcvd_snum;
 };
 
+/** Precomputed identifier table entry for a logic channel. */
+struct vcd_logic_ident {
+	size_t byte;		/**!< byte position within a sample */
+	uint8_t mask;		/**!< bit mask within that byte */
+	uint8_t len;		/**!< length of the identifier text */
+	char text[4];		/**!< identifier text, not NUL terminated */
+};
+
 /** Queued values for a given sample number. */
 struct vcd_queue_item {
 	uint64_t samplenum;	/**!< sample number, _not_ timestamp */
@@ -73,6 +81,12 @@ struct context {
 	GList *vcd_queue_last;
 	gboolean immediate_write;
 	uint8_t *last_logic;
+	size_t last_logic_size;
+	struct vcd_logic_ident *logic_idents;
+	size_t logic_text_max;
+	uint64_t ts_factor;
+	uint8_t *logic_mask;
+	size_t logic_mask_unitsize;
 };
 
 /*
@@ -208,8 +222,9 @@ static int init(struct sr_output *o, GHashTable *options)
 	size_t alloc_size;
 	struct sr_channel *ch;
 	GSList *l;
-	size_t num_enabled, num_logic, num_analog, desc_idx;
+	size_t num_enabled, num_logic, num_analog, desc_idx, ident_idx;
 	struct vcd_channel_desc *desc;
+	struct vcd_logic_ident *ident;
 
 	(void)options;
 
@@ -243,12 +258,15 @@ static int init(struct sr_output *o, GHashTable *options)
 	ctx->analog_count = num_analog;
 	alloc_size = sizeof(ctx->channels[0]) * ctx->enabled_count;
 	ctx->channels = g_malloc0(alloc_size);
+	alloc_size = sizeof(ctx->logic_idents[0]) * ctx->logic_count;
+	ctx->logic_idents = g_malloc0(alloc_size);
 
 	/*
 	 * Reiterate input descriptions, to fill in output descriptions.
 	 * Map channel indices, and assign symbols to VCD channels.
 	 */
 	desc_idx = 0;
+	ident_idx = 0;
 	for (l = o->sdi->channels; l; l = l->next) {
 		ch = l->data;
 		if (!ch->enabled)
@@ -264,6 +282,12 @@ static int init(struct sr_output *o, GHashTable *options)
 		if (desc->type == SR_CHANNEL_LOGIC && num_logic) {
 			num_logic--;
 			desc->last.logic = ~0;
+			ident = &ctx->logic_idents[ident_idx++];
+			ident->byte = desc->index / 8;
+			ident->mask = 1 << (desc->index % 8);
+			ident->len = desc->name->len;
+			memcpy(ident->text, desc->name->str, ident->len);
+			ctx->logic_text_max += 2 + ident->len;
 		} else if (desc->type == SR_CHANNEL_ANALOG && num_analog) {
 			num_analog--;
 			/* "Construct" NaN, avoid a compile time error. */
@@ -293,8 +317,8 @@ static int init(struct sr_output *o, GHashTable *options)
 	 * changed. The overhead of two byte array compares should
 	 * outweight the tenfold bit count compared to byte counts.
 	 */
-	alloc_size = (ctx->logic_count + 7) / 8;
-	ctx->last_logic = g_malloc0(alloc_size);
+	ctx->last_logic_size = (ctx->logic_count + 7) / 8;
+	ctx->last_logic = g_malloc0(ctx->last_logic_size);
 	if (ctx->logic_count && !ctx->last_logic)
 		return SR_ERR_MALLOC;
 
@@ -334,12 +358,11 @@ static uint64_t get_timescale_freq(uint64_t samplerate)
 }
 
 /* Emit a VCD file header. */
-static GString *gen_header(const struct sr_output *o)
+static void gen_header(const struct sr_output *o, GString *header)
 {
 	struct context *ctx;
 	struct sr_channel *ch;
 	GVariant *gvar;
-	GString *header;
 	GSList *l;
 	time_t t;
 	size_t num_channels, i;
@@ -361,6 +384,9 @@ static GString *gen_header(const struct sr_output *o)
 		}
 	}
 	ctx->period = get_timescale_freq(ctx->samplerate);
+	ctx->ts_factor = 0;
+	if (ctx->samplerate && ctx->period % ctx->samplerate == 0)
+		ctx->ts_factor = ctx->period / ctx->samplerate;
 	t = time(NULL);
 	timestamp = g_strdup(ctime(&t));
 	timestamp[strlen(timestamp) - 1] = '\0';
@@ -370,8 +396,7 @@ static GString *gen_header(const struct sr_output *o)
 	frequency_s = sr_period_string(1, ctx->period);
 
 	/* Construct the VCD output file header. */
-	header = g_string_sized_new(512);
-	g_string_printf(header, "$date %s $end\n", timestamp);
+	g_string_append_printf(header, "$date %s $end\n", timestamp);
 	g_string_append_printf(header, "$version %s %s $end\n",
 		PACKAGE_NAME, sr_package_version_string_get());
 	g_string_append_printf(header, "$comment\n");
@@ -410,31 +435,23 @@ static GString *gen_header(const struct sr_output *o)
 	g_free(timestamp);
 	g_free(samplerate_s);
 	g_free(frequency_s);
-
-	return header;
 }
 
 /*
- * Gets called when a session feed packet was received. Either creates
- * a VCD file header (once in the output module's lifetime), or an empty
- * GString. Callers will append the text representation of sample data
- * to that string as needed.
+ * Gets called when a session feed packet was received. Emits the VCD
+ * file header (once in the output module's lifetime). Callers will
+ * append the text representation of sample data after it.
  */
-static GString *chk_header(const struct sr_output *o)
+static void chk_header(const struct sr_output *o, GString *out)
 {
 	struct context *ctx;
-	GString *s;
 
 	ctx = o->priv;
 
 	if (!ctx->header_done) {
 		ctx->header_done = TRUE;
-		s = gen_header(o);
-	} else {
-		s = g_string_sized_new(512);
+		gen_header(o, out);
 	}
-
-	return s;
 }
 
 /*
@@ -979,9 +996,175 @@ static int write_completed_changes(struct context *ctx, GString *out)
 	return SR_OK;
 }
 
+/*
+ * Fast path for logic only setups. Consecutive samples get compared
+ * wordwise, unchanged runs are skipped without inspecting individual
+ * channels. Value changes are formatted from the precomputed identifier
+ * table straight into the output buffer, without intermediate strings.
+ */
+
+/* Longest text of a timestamp with integer formatting: "\n#" + 20 + " ". */
+#define VCD_TIMESTAMP_TEXT_MAX	(2 + 20 + 1)
+
+static char *format_vcd_timestamp_u64(char *p, uint64_t ts)
+{
+	char digits[20];
+	size_t len;
+
+	len = 0;
+	do {
+		digits[sizeof(digits) - ++len] = '0' + ts % 10;
+		ts /= 10;
+	} while (ts);
+	*p++ = '\n';
+	*p++ = '#';
+	memcpy(p, &digits[sizeof(digits) - len], len);
+	p += len;
+	*p++ = ' ';
+
+	return p;
+}
+
+/*
+ * Prepare the mask of enabled logic channels' bits for a given unit
+ * size. The mask gets repeated such that eight bytes can be read from
+ * any position within a sample, which matches the data image when the
+ * caller starts reading at that position of a sample.
+ */
+static void prep_logic_mask(struct context *ctx, size_t unit_size)
+{
+	size_t i;
+	struct vcd_logic_ident *ident;
+
+	if (ctx->logic_mask && ctx->logic_mask_unitsize == unit_size)
+		return;
+	g_free(ctx->logic_mask);
+	ctx->logic_mask = g_malloc0(unit_size + sizeof(uint64_t));
+	ctx->logic_mask_unitsize = unit_size;
+	for (i = 0; i < ctx->logic_count; i++) {
+		ident = &ctx->logic_idents[i];
+		if (ident->byte < unit_size)
+			ctx->logic_mask[ident->byte] |= ident->mask;
+	}
+	for (i = unit_size; i < unit_size + sizeof(uint64_t); i++)
+		ctx->logic_mask[i] = ctx->logic_mask[i % unit_size];
+}
+
+/*
+ * Find the next byte position which differs from the same position in
+ * the previous sample, considering enabled logic channels only. Starts
+ * at a position of the second or a later sample. Returns the data size
+ * when no more changes are found.
+ */
+static size_t find_logic_change(const uint8_t *data, size_t size,
+	size_t unit_size, const uint8_t *mask, size_t pos)
+{
+	uint64_t diff;
+
+	while (pos + sizeof(uint64_t) <= size) {
+		diff = read_u64le(&data[pos]) ^ read_u64le(&data[pos - unit_size]);
+		diff &= read_u64le(&mask[pos % unit_size]);
+		if (diff) {
+			while (!(diff & 0xff)) {
+				diff >>= 8;
+				pos++;
+			}
+			return pos;
+		}
+		pos += sizeof(uint64_t);
+	}
+	while (pos < size) {
+		if ((data[pos] ^ data[pos - unit_size]) & mask[pos % unit_size])
+			return pos;
+		pos++;
+	}
+
+	return size;
+}
+
+/*
+ * Emit the timestamp and the changed values of one logic sample. All
+ * enabled channels' values get emitted when no previous sample is given.
+ */
+static void append_vcd_logic_changes(struct context *ctx, GString *out,
+	uint64_t snum, const uint8_t *curr, const uint8_t *prev,
+	size_t unit_size)
+{
+	size_t pos, i;
+	char *p;
+	struct vcd_logic_ident *ident;
+
+	pos = out->len;
+	if (ctx->ts_factor) {
+		g_string_set_size(out, pos + VCD_TIMESTAMP_TEXT_MAX + ctx->logic_text_max);
+		p = format_vcd_timestamp_u64(&out->str[pos], snum * ctx->ts_factor);
+	} else {
+		append_vcd_timestamp(out, snum_to_ts(ctx, snum), FALSE);
+		pos = out->len;
+		g_string_set_size(out, pos + ctx->logic_text_max);
+		p = &out->str[pos];
+	}
+	for (i = 0; i < ctx->logic_count; i++) {
+		ident = &ctx->logic_idents[i];
+		if (ident->byte >= unit_size)
+			continue;
+		if (prev && !((curr[ident->byte] ^ prev[ident->byte]) & ident->mask))
+			continue;
+		*p++ = ' ';
+		*p++ = (curr[ident->byte] & ident->mask) ? '1' : '0';
+		memcpy(p, ident->text, ident->len);
+		p += ident->len;
+	}
+	g_string_truncate(out, p - out->str);
+}
+
+static void append_vcd_logic(struct context *ctx, GString *out,
+	const struct sr_datafeed_logic *logic)
+{
+	const uint8_t *data;
+	size_t unit_size, count, size, pos, idx;
+	uint64_t snum;
+
+	data = logic->data;
+	unit_size = logic->unitsize;
+	count = logic->length / unit_size;
+	if (!count)
+		return;
+	size = count * unit_size;
+	snum = get_last_snum_logic(ctx);
+	upd_last_snum_logic(ctx, count);
+	prep_logic_mask(ctx, unit_size);
+
+	/* The first sample compares against the previous packet's. */
+	if (snum == 0) {
+		append_vcd_logic_changes(ctx, out, snum, data, NULL, unit_size);
+	} else {
+		for (pos = 0; pos < unit_size; pos++) {
+			if ((data[pos] ^ ctx->last_logic[pos]) & ctx->logic_mask[pos])
+				break;
+		}
+		if (pos < unit_size)
+			append_vcd_logic_changes(ctx, out, snum, data,
+				ctx->last_logic, unit_size);
+	}
+
+	/* Skip over unchanged runs within the packet. */
+	pos = unit_size;
+	while ((pos = find_logic_change(data, size, unit_size,
+			ctx->logic_mask, pos)) < size) {
+		idx = pos / unit_size;
+		append_vcd_logic_changes(ctx, out, snum + idx,
+			&data[idx * unit_size], &data[(idx - 1) * unit_size],
+			unit_size);
+		pos = (idx + 1) * unit_size;
+	}
+
+	memcpy(ctx->last_logic, &data[size - unit_size], unit_size);
+}
+
 /* Get packets from the session feed, generate output text. */
-static int receive(const struct sr_output *o,
-	const struct sr_datafeed_packet *packet, GString **out)
+static int append(const struct sr_output *o,
+	const struct sr_datafeed_packet *packet, GString *out)
 {
 	struct context *ctx;
 	const struct sr_datafeed_meta *meta;
@@ -1001,7 +1184,6 @@ static int receive(const struct sr_output *o,
 	float *floats, value;
 	double ts;
 
-	*out = NULL;
 	if (!o || !o->priv)
 		return SR_ERR_BUG;
 	ctx = o->priv;
@@ -1017,11 +1199,21 @@ static int receive(const struct sr_output *o,
 		}
 		break;
 	case SR_DF_LOGIC:
-		*out = chk_header(o);
+		chk_header(o, out);
 
 		logic = packet->payload;
 		sample = logic->data;
 		unit_size = logic->unitsize;
+		if (ctx->last_logic_size < unit_size) {
+			ctx->last_logic = g_realloc(ctx->last_logic, unit_size);
+			memset(&ctx->last_logic[ctx->last_logic_size], 0,
+				unit_size - ctx->last_logic_size);
+			ctx->last_logic_size = unit_size;
+		}
+		if (!ctx->analog_count && ctx->logic_count) {
+			append_vcd_logic(ctx, out, logic);
+			break;
+		}
 		count = logic->length / unit_size;
 		snum_curr = get_last_snum_logic(ctx);
 		upd_last_snum_logic(ctx, count);
@@ -1041,7 +1233,7 @@ static int receive(const struct sr_output *o,
 			if (changed) {
 				if (ctx->immediate_write) {
 					ts = snum_to_ts(ctx, snum_curr);
-					append_vcd_timestamp(*out, ts, FALSE);
+					append_vcd_timestamp(out, ts, FALSE);
 				} else {
 					queue_samplenum(ctx, snum_curr);
 				}
@@ -1075,8 +1267,8 @@ static int receive(const struct sr_output *o,
 				 * the observed value change.
 				 */
 				if (ctx->immediate_write) {
-					g_string_append_c(*out, ' ');
-					s_val = *out;
+					g_string_append_c(out, ' ');
+					s_val = out;
 				} else {
 					s_val = queue_value_text_prep(ctx);
 					if (!s_val)
@@ -1089,10 +1281,10 @@ static int receive(const struct sr_output *o,
 			snum_curr++;
 			sample += unit_size;
 		}
-		write_completed_changes(ctx, *out);
+		write_completed_changes(ctx, out);
 		break;
 	case SR_DF_ANALOG:
-		*out = chk_header(o);
+		chk_header(o, out);
 
 		/*
 		 * This implementation expects one analog packet per
@@ -1150,8 +1342,8 @@ static int receive(const struct sr_output *o,
 			/* Queue, or emit the timestamp and the new value. */
 			if (ctx->immediate_write) {
 				ts = snum_to_ts(ctx, snum_curr + index);
-				append_vcd_timestamp(*out, ts, FALSE);
-				s_val = *out;
+				append_vcd_timestamp(out, ts, FALSE);
+				s_val = out;
 			} else {
 				queue_samplenum(ctx, snum_curr + index);
 				s_val = queue_value_text_prep(ctx);
@@ -1160,21 +1352,67 @@ static int receive(const struct sr_output *o,
 		}
 
 		g_free(floats);
-		write_completed_changes(ctx, *out);
+		write_completed_changes(ctx, out);
 		break;
 	case SR_DF_END:
-		*out = chk_header(o);
+		chk_header(o, out);
 		/* Push the final timestamp as length indicator. */
 		snum_curr = get_max_snum_flush(ctx);
 		queue_samplenum(ctx, snum_curr);
 		/* Flush previously queued value changes. */
-		write_completed_changes(ctx, *out);
+		write_completed_changes(ctx, out);
 		break;
 	}
 
 	return SR_OK;
 }
 
+/*
+ * Logic only captures take the fast path, which only depends on the
+ * sample number and the previous sample. Mixed signal data is queued.
+ */
+static size_t split_align(const struct sr_output *o)
+{
+	struct context *ctx;
+
+	ctx = o->priv;
+	if (!ctx->header_done || ctx->analog_count || !ctx->logic_count)
+		return 0;
+
+	return 1;
+}
+
+static int carry_in(struct sr_output *o, const struct sr_output_carry *carry)
+{
+	struct context *ctx;
+	const struct context *from;
+	struct vcd_channel_desc *desc;
+	size_t i;
+
+	ctx = o->priv;
+	from = carry->from->priv;
+	if (ctx->analog_count)
+		return SR_ERR_ARG;
+	ctx->header_done = TRUE;
+	ctx->samplerate = from->samplerate;
+	ctx->period = from->period;
+	ctx->ts_factor = from->ts_factor;
+	for (i = 0; i < ctx->enabled_count; i++) {
+		desc = &ctx->channels[i];
+		if (desc->type == SR_CHANNEL_LOGIC)
+			desc->last_rcvd_snum = carry->pos;
+	}
+	if (ctx->last_logic_size < carry->unitsize) {
+		ctx->last_logic = g_realloc(ctx->last_logic, carry->unitsize);
+		ctx->last_logic_size = carry->unitsize;
+	}
+	memset(ctx->last_logic, 0, ctx->last_logic_size);
+	if (carry->prev)
+		memcpy(ctx->last_logic, carry->prev, carry->unitsize);
+
+	return SR_OK;
+}
+
 static int cleanup(struct sr_output *o)
 {
 	struct context *ctx;
@@ -1198,6 +1436,9 @@ static int cleanup(struct sr_output *o)
 		g_string_free(desc->name, TRUE);
 	}
 	g_free(ctx->channels);
+	g_free(ctx->logic_idents);
+	g_free(ctx->logic_mask);
+	g_free(ctx->last_logic);
 	g_free(ctx);
 
 	return SR_OK;
@@ -1211,6 +1452,8 @@ struct sr_output_module output_vcd = {
 	.flags = 0,
 	.options = NULL,
 	.init = init,
-	.receive = receive,
+	.append = append,
+	.split_align = split_align,
+	.carry_in = carry_in,
 	.cleanup = cleanup,
 };
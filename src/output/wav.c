@@ -18,6 +18,7 @@
  */
 
 #include <config.h>
+#include <math.h>
 #include <string.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
@@ -27,6 +28,33 @@
 /* Minimum/maximum number of samples per channel to put in a data chunk */
 #define MIN_DATA_CHUNK_SAMPLES 10
 
+/* Size of the fmt chunk's payload. */
+#define FMT_SIZE 18
+
+enum wav_container {
+	CONTAINER_RIFF,
+	CONTAINER_RF64,
+	CONTAINER_W64,
+};
+
+/* Sony Wave64 chunk GUIDs. */
+static const uint8_t w64_riff[16] = {
+	0x72, 0x69, 0x66, 0x66, 0x2e, 0x91, 0xcf, 0x11,
+	0xa5, 0xd6, 0x28, 0xdb, 0x04, 0xc1, 0x00, 0x00,
+};
+static const uint8_t w64_wave[16] = {
+	0x77, 0x61, 0x76, 0x65, 0xf3, 0xac, 0xd3, 0x11,
+	0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a,
+};
+static const uint8_t w64_fmt[16] = {
+	0x66, 0x6d, 0x74, 0x20, 0xf3, 0xac, 0xd3, 0x11,
+	0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a,
+};
+static const uint8_t w64_data[16] = {
+	0x64, 0x61, 0x74, 0x61, 0xf3, 0xac, 0xd3, 0x11,
+	0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a,
+};
+
 struct out_context {
 	double scale;
 	gboolean header_done;
@@ -37,6 +65,18 @@ struct out_context {
 	int *chanbuf_used;
 	uint8_t **chanbuf;
 	float *fdata;
+	enum wav_container container;
+	gboolean native;
+	/*
+	 * Size of a stored sample in bytes. Floats take 4 bytes, native
+	 * samples are stored as integer PCM, in their original width.
+	 */
+	int sample_size;
+	gboolean is_float;
+	/* Encoding of native samples, taken from the first packet. */
+	struct sr_analog_encoding encoding;
+	uint64_t header_size;
+	uint64_t data_size;
 };
 
 static int realloc_chanbufs(const struct sr_output *o, int size)
@@ -60,14 +100,15 @@ static int realloc_chanbufs(const struct sr_output *o, int size)
 static int flush_chanbufs(const struct sr_output *o, GString *out)
 {
 	struct out_context *outc;
-	int num_samples, i, j;
+	int num_samples, size, i, j;
 	char *buf, *bufp;
 
 	outc = o->priv;
 
 	/* Any one of them will do. */
 	num_samples = outc->chanbuf_used[0];
-	if (!(buf = g_try_malloc(4 * num_samples * outc->num_channels))) {
+	size = outc->sample_size;
+	if (!(buf = g_try_malloc(size * num_samples * outc->num_channels))) {
 		sr_err("Unable to allocate enough interleaved output buffer memory.");
 		return SR_ERR;
 	}
@@ -75,11 +116,12 @@ static int flush_chanbufs(const struct sr_output *o, GString *out)
 	bufp = buf;
 	for (i = 0; i < num_samples; i++) {
 		for (j = 0; j < outc->num_channels; j++) {
-			memcpy(bufp, outc->chanbuf[j] + i * 4, 4);
-			bufp += 4;
+			memcpy(bufp, outc->chanbuf[j] + i * size, size);
+			bufp += size;
 		}
 	}
-	g_string_append_len(out, buf, 4 * num_samples * outc->num_channels);
+	g_string_append_len(out, buf, size * num_samples * outc->num_channels);
+	outc->data_size += size * num_samples * outc->num_channels;
 	g_free(buf);
 
 	for (i = 0; i < outc->num_channels; i++)
@@ -92,12 +134,37 @@ static int init(struct sr_output *o, GHashTable *options)
 {
 	struct out_context *outc;
 	struct sr_channel *ch;
+	const char *s;
 	GSList *l;
 
 	outc = g_malloc0(sizeof(struct out_context));
 	o->priv = outc;
 	outc->scale = g_variant_get_double(g_hash_table_lookup(options, "scale"));
 
+	s = g_variant_get_string(g_hash_table_lookup(options, "format"), NULL);
+	if (!g_ascii_strcasecmp(s, "wav")) {
+		outc->container = CONTAINER_RIFF;
+	} else if (!g_ascii_strcasecmp(s, "rf64")) {
+		outc->container = CONTAINER_RF64;
+	} else if (!g_ascii_strcasecmp(s, "w64")) {
+		outc->container = CONTAINER_W64;
+	} else {
+		sr_err("Unknown file format '%s'.", s);
+		g_free(outc);
+		o->priv = NULL;
+		return SR_ERR_ARG;
+	}
+
+	s = g_variant_get_string(g_hash_table_lookup(options, "samples"), NULL);
+	if (!g_ascii_strcasecmp(s, "native")) {
+		outc->native = TRUE;
+	} else if (g_ascii_strcasecmp(s, "float")) {
+		sr_err("Unknown sample format '%s'.", s);
+		g_free(outc);
+		o->priv = NULL;
+		return SR_ERR_ARG;
+	}
+
 	for (l = o->sdi->channels; l; l = l->next) {
 		ch = l->data;
 		if (ch->type != SR_CHANNEL_ANALOG)
@@ -117,18 +184,38 @@ static int init(struct sr_output *o, GHashTable *options)
 	return SR_OK;
 }
 
-static void add_data_chunk(const struct sr_output *o, GString *gs)
+/*
+ * Native samples are stored as integer PCM. WAV files can't hold
+ * anything wider than 24 bits in a useful way, and floats are stored
+ * as such anyway.
+ */
+static void select_sample_format(struct out_context *outc,
+		const struct sr_analog_encoding *encoding)
+{
+	outc->sample_size = sizeof(float);
+	outc->is_float = TRUE;
+	if (!outc->native)
+		return;
+
+	if (encoding->is_float || encoding->unitsize < 1 || encoding->unitsize > 3) {
+		sr_warn("Cannot store %d-byte %s samples natively, using float.",
+			encoding->unitsize, encoding->is_float ? "float" : "integer");
+		return;
+	}
+	outc->sample_size = encoding->unitsize;
+	outc->is_float = FALSE;
+	outc->encoding = *encoding;
+	sr_dbg("Storing samples as %d-bit integers.", 8 * outc->sample_size);
+}
+
+static void add_fmt_data(const struct sr_output *o, GString *gs)
 {
 	struct out_context *outc;
 	char tmp[4];
 
 	outc = o->priv;
-	g_string_append(gs, "fmt ");
-	/* Remaining chunk size */
-	WL32(tmp, 0x12);
-	g_string_append_len(gs, tmp, 4);
-	/* Format code 3 = IEEE float */
-	WL16(tmp, 0x0003);
+	/* Format code 1 = PCM, 3 = IEEE float */
+	WL16(tmp, outc->is_float ? 0x0003 : 0x0001);
 	g_string_append_len(gs, tmp, 2);
 	/* Number of channels */
 	WL16(tmp, outc->num_channels);
@@ -136,17 +223,28 @@ static void add_data_chunk(const struct sr_output *o, GString *gs)
 	/* Samplerate */
 	WL32(tmp, outc->samplerate);
 	g_string_append_len(gs, tmp, 4);
-	/* Byterate, using 32-bit floats. */
-	WL32(tmp, outc->samplerate * outc->num_channels * 4);
+	/* Byterate */
+	WL32(tmp, outc->samplerate * outc->num_channels * outc->sample_size);
 	g_string_append_len(gs, tmp, 4);
 	/* Blockalign */
-	WL16(tmp, outc->num_channels * 4);
+	WL16(tmp, outc->num_channels * outc->sample_size);
 	g_string_append_len(gs, tmp, 2);
 	/* Bits per sample */
-	WL16(tmp, 32);
+	WL16(tmp, 8 * outc->sample_size);
 	g_string_append_len(gs, tmp, 2);
 	WL16(tmp, 0);
 	g_string_append_len(gs, tmp, 2);
+}
+
+static void add_data_chunk(const struct sr_output *o, GString *gs)
+{
+	char tmp[4];
+
+	g_string_append(gs, "fmt ");
+	/* Remaining chunk size */
+	WL32(tmp, FMT_SIZE);
+	g_string_append_len(gs, tmp, 4);
+	add_fmt_data(o, gs);
 
 	g_string_append(gs, "data");
 	/* Data chunk size, max it out. */
@@ -154,6 +252,55 @@ static void add_data_chunk(const struct sr_output *o, GString *gs)
 	g_string_append_len(gs, tmp, 4);
 }
 
+/*
+ * RF64 (EBU Tech 3306) keeps the 32-bit RIFF sizes maxed out, and puts
+ * the real ones into a ds64 chunk. They're maxed out as well until the
+ * end of the capture, when they can be filled in.
+ */
+static void add_ds64_chunk(GString *gs)
+{
+	char tmp[8];
+
+	g_string_append(gs, "ds64");
+	WL32(tmp, 28);
+	g_string_append_len(gs, tmp, 4);
+	/* RIFF size, data size, sample count */
+	memset(tmp, 0xff, sizeof(tmp));
+	g_string_append_len(gs, tmp, 8);
+	g_string_append_len(gs, tmp, 8);
+	g_string_append_len(gs, tmp, 8);
+	/* No table of other chunk sizes. */
+	WL32(tmp, 0);
+	g_string_append_len(gs, tmp, 4);
+}
+
+/*
+ * Sony Wave64 uses GUIDs instead of FOURCCs, and 64-bit chunk sizes
+ * which include the chunk header. Chunks are aligned to 8 bytes.
+ */
+static void add_w64_chunks(const struct sr_output *o, GString *gs)
+{
+	char tmp[8];
+
+	g_string_append_len(gs, (const char *)w64_riff, 16);
+	/* Total size. Max out the field. */
+	memset(tmp, 0xff, sizeof(tmp));
+	g_string_append_len(gs, tmp, 8);
+	g_string_append_len(gs, (const char *)w64_wave, 16);
+
+	g_string_append_len(gs, (const char *)w64_fmt, 16);
+	WL64(tmp, 24 + FMT_SIZE);
+	g_string_append_len(gs, tmp, 8);
+	add_fmt_data(o, gs);
+	while (gs->len % 8)
+		g_string_append_c(gs, 0);
+
+	g_string_append_len(gs, (const char *)w64_data, 16);
+	/* Data chunk size, max it out. */
+	memset(tmp, 0xff, sizeof(tmp));
+	g_string_append_len(gs, tmp, 8);
+}
+
 static GString *gen_header(const struct sr_output *o)
 {
 	struct out_context *outc;
@@ -171,16 +318,76 @@ static GString *gen_header(const struct sr_output *o)
 	}
 
 	header = g_string_sized_new(512);
-	g_string_append(header, "RIFF");
-	/* Total size. Max out the field. */
-	WL32(tmp, 0xffffffff);
-	g_string_append_len(header, tmp, 4);
-	g_string_append(header, "WAVE");
-	add_data_chunk(o, header);
+	if (outc->container == CONTAINER_W64) {
+		add_w64_chunks(o, header);
+	} else {
+		g_string_append(header,
+			outc->container == CONTAINER_RF64 ? "RF64" : "RIFF");
+		/* Total size. Max out the field. */
+		WL32(tmp, 0xffffffff);
+		g_string_append_len(header, tmp, 4);
+		g_string_append(header, "WAVE");
+		if (outc->container == CONTAINER_RF64)
+			add_ds64_chunk(header);
+		add_data_chunk(o, header);
+	}
+	outc->header_size = header->len;
 
 	return header;
 }
 
+/*
+ * Fill in the sizes which were maxed out in the header. This needs an
+ * output sink which writes to a seekable file, otherwise the header
+ * is left as it is. Readers generally cope with that.
+ */
+static int patch_header(const struct sr_output *o, uint64_t pad)
+{
+	struct out_context *outc;
+	uint64_t total, frames;
+	uint8_t tmp[24];
+	int ret;
+
+	outc = o->priv;
+	total = outc->header_size + outc->data_size + pad;
+	frames = outc->data_size / (outc->num_channels * outc->sample_size);
+	switch (outc->container) {
+	case CONTAINER_RIFF:
+		if (total - 8 > 0xffffffff) {
+			sr_warn("Capture is too large for a WAV file, try RF64 or W64.");
+			return SR_OK;
+		}
+		WL32(&tmp[0], total - 8);
+		WL32(&tmp[4], outc->data_size);
+		ret = sr_output_rewrite(o, 4, &tmp[0], 4);
+		if (ret == SR_OK)
+			ret = sr_output_rewrite(o, outc->header_size - 4, &tmp[4], 4);
+		break;
+	case CONTAINER_RF64:
+		WL64(&tmp[0], total - 8);
+		WL64(&tmp[8], outc->data_size);
+		WL64(&tmp[16], frames);
+		ret = sr_output_rewrite(o, 20, tmp, 24);
+		break;
+	case CONTAINER_W64:
+		WL64(&tmp[0], total);
+		WL64(&tmp[8], 24 + outc->data_size);
+		ret = sr_output_rewrite(o, 16, &tmp[0], 8);
+		if (ret == SR_OK)
+			ret = sr_output_rewrite(o, outc->header_size - 8, &tmp[8], 8);
+		break;
+	default:
+		ret = SR_ERR_BUG;
+		break;
+	}
+	if (ret == SR_ERR_NA) {
+		sr_dbg("Output is not seekable, keeping maxed out sizes.");
+		return SR_OK;
+	}
+
+	return ret;
+}
+
 /*
  * Stores the float in little-endian BINARY32 IEEE-754 2008 format.
  */
@@ -202,6 +409,79 @@ static void float_to_le(uint8_t *buf, float value)
 #endif
 }
 
+static gboolean same_encoding(const struct sr_analog_encoding *a,
+		const struct sr_analog_encoding *b)
+{
+	return a->unitsize == b->unitsize && a->is_signed == b->is_signed &&
+		a->is_float == b->is_float && a->is_bigendian == b->is_bigendian &&
+		a->scale.p == b->scale.p && a->scale.q == b->scale.q &&
+		a->offset.p == b->offset.p && a->offset.q == b->offset.q;
+}
+
+/*
+ * Get a raw sample value, as a signed number. Unsigned encodings are
+ * shifted down by half their range, like 8-bit WAV samples are.
+ */
+static int64_t read_code(const uint8_t *p, const struct sr_analog_encoding *encoding)
+{
+	uint64_t value, mid;
+	int i;
+
+	value = 0;
+	for (i = 0; i < encoding->unitsize; i++) {
+		value <<= 8;
+		value |= p[encoding->is_bigendian ? i : encoding->unitsize - 1 - i];
+	}
+	mid = 1ULL << (8 * encoding->unitsize - 1);
+	if (encoding->is_signed)
+		return (int64_t)(value ^ mid) - (int64_t)mid;
+
+	return (int64_t)value - (int64_t)mid;
+}
+
+/*
+ * Map a value back to the raw sample value of the first packet's
+ * encoding, for packets which are encoded differently.
+ */
+static int64_t value_to_code(const struct out_context *outc, float value)
+{
+	const struct sr_analog_encoding *encoding;
+	double code;
+	int64_t max;
+
+	encoding = &outc->encoding;
+	if (!encoding->scale.p || !encoding->offset.q)
+		return 0;
+	code = value - (double)encoding->offset.p / encoding->offset.q;
+	code = code * encoding->scale.q / encoding->scale.p;
+	if (!encoding->is_signed)
+		code -= 1ULL << (8 * encoding->unitsize - 1);
+	max = (1LL << (8 * outc->sample_size - 1)) - 1;
+	if (code > max)
+		return max;
+	if (code < -max - 1)
+		return -max - 1;
+
+	return (int64_t)round(code);
+}
+
+/* Stores an integer sample in little-endian PCM format. */
+static void code_to_le(uint8_t *buf, int64_t code, int size)
+{
+	switch (size) {
+	case 1:
+		/* 8-bit samples are unsigned. */
+		buf[0] = code + 0x80;
+		break;
+	case 2:
+		WL16(buf, code);
+		break;
+	case 3:
+		WL24(buf, code);
+		break;
+	}
+}
+
 /*
  * Returns the number of samples used in the current channel buffers,
  * or -1 if they're not all the same.
@@ -243,10 +523,13 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 	struct sr_channel *ch;
 	GSList *l;
 	const GSList *channels;
+	const uint8_t *raw;
 	float f;
 	int num_channels, num_samples, size, *chan_idx, idx, i, j, ret;
+	gboolean copy_raw;
 	float *data;
 	uint8_t *buf;
+	uint64_t pad;
 
 	*out = NULL;
 	if (!o || !o->sdi || !(outc = o->priv))
@@ -263,23 +546,33 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 		}
 		break;
 	case SR_DF_ANALOG:
+		analog = packet->payload;
 		if (!outc->header_done) {
+			select_sample_format(outc, analog->encoding);
 			*out = gen_header(o);
 			outc->header_done = TRUE;
 		} else {
 			*out = g_string_sized_new(512);
 		}
 
-		analog = packet->payload;
 		num_samples = analog->num_samples;
 		channels = analog->meaning->channels;
 		num_channels = g_slist_length(analog->meaning->channels);
-		if (!(data = g_try_realloc(outc->fdata, sizeof(float) * num_samples * num_channels)))
-			return SR_ERR_MALLOC;
-		outc->fdata = data;
-		ret = sr_analog_to_float(analog, data);
-		if (ret != SR_OK)
-			return ret;
+
+		/*
+		 * Native samples which are encoded as before are copied as is,
+		 * unless they have to be scaled.
+		 */
+		copy_raw = !outc->is_float && outc->scale == 1.0 &&
+			same_encoding(analog->encoding, &outc->encoding);
+		if (!copy_raw) {
+			if (!(data = g_try_realloc(outc->fdata, sizeof(float) * num_samples * num_channels)))
+				return SR_ERR_MALLOC;
+			outc->fdata = data;
+			ret = sr_analog_to_float(analog, data);
+			if (ret != SR_OK)
+				return ret;
+		}
 
 		if (num_samples == 0)
 			return SR_OK;
@@ -302,14 +595,24 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 			chan_idx[i] = g_slist_index(outc->channels, ch);
 		}
 
+		size = outc->sample_size;
+		raw = analog->data;
 		for (i = 0; i < num_samples; i++) {
 			for (j = 0; j < num_channels; j++) {
 				idx = chan_idx[j];
-				buf = outc->chanbuf[idx] + outc->chanbuf_used[idx]++ * 4;
-				f = data[i * num_channels + j];
+				buf = outc->chanbuf[idx] + outc->chanbuf_used[idx]++ * size;
+				if (copy_raw) {
+					code_to_le(buf, read_code(raw, &outc->encoding), size);
+					raw += size;
+					continue;
+				}
+				f = outc->fdata[i * num_channels + j];
 				if (outc->scale != 1.0)
 					f /= outc->scale;
-				float_to_le(buf, f);
+				if (outc->is_float)
+					float_to_le(buf, f);
+				else
+					code_to_le(buf, value_to_code(outc, f), size);
 			}
 		}
 		g_free(chan_idx);
@@ -322,10 +625,25 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 	case SR_DF_END:
 		size = check_chanbuf_size(o);
 		if (size > 0) {
-			*out = g_string_sized_new(4 * size * outc->num_channels);
+			*out = g_string_sized_new(outc->sample_size * size * outc->num_channels);
 			if (flush_chanbufs(o, *out) != SR_OK)
 				return SR_ERR;
 		}
+		if (!outc->header_done)
+			break;
+		/* Chunks are aligned to 2 (RIFF) or 8 (W64) bytes. */
+		if (outc->container == CONTAINER_W64)
+			pad = (8 - outc->data_size % 8) % 8;
+		else
+			pad = outc->data_size % 2;
+		if (pad) {
+			if (!*out)
+				*out = g_string_sized_new(8);
+			g_string_append_len(*out, "\0\0\0\0\0\0\0", pad);
+		}
+		ret = patch_header(o, pad);
+		if (ret != SR_OK)
+			return ret;
 		break;
 	}
 
@@ -334,13 +652,29 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 
 static struct sr_option options[] = {
 	{ "scale", "Scale", "Scale values by factor", NULL, NULL },
+	{ "format", "File format", "Container format: wav, rf64 (more than 4GiB) or w64", NULL, NULL },
+	{ "samples", "Sample format", "Store samples as float, or in their native integer format", NULL, NULL },
 	ALL_ZERO
 };
 
 static const struct sr_option *get_options(void)
 {
-	if (!options[0].def)
+	GSList *l;
+
+	if (!options[0].def) {
 		options[0].def = g_variant_ref_sink(g_variant_new_double(1.0));
+		options[1].def = g_variant_ref_sink(g_variant_new_string("wav"));
+		l = NULL;
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("wav")));
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("rf64")));
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("w64")));
+		options[1].values = l;
+		options[2].def = g_variant_ref_sink(g_variant_new_string("float"));
+		l = NULL;
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("float")));
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("native")));
+		options[2].values = l;
+	}
 
 	return options;
 }
@@ -352,7 +686,6 @@ static int cleanup(struct sr_output *o)
 
 	outc = o->priv;
 	g_slist_free(outc->channels);
-	g_variant_unref(options[0].def);
 	for (i = 0; i < outc->num_channels; i++)
 		g_free(outc->chanbuf[i]);
 	g_free(outc->chanbuf_used);
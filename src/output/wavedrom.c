@@ -18,66 +18,173 @@
  */
 
 #include <config.h>
+#include <errno.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
 
 #define LOG_PREFIX "output/wavedrom"
 
+/* Wave text gets copied from the spill file in blocks of this size. */
+#define SPILL_BLOCK_SIZE (64 * 1024)
+
+/* A piece of a channel's wave text, in the spill file. */
+struct spill_chunk {
+	uint64_t offset;
+	size_t length;
+};
+
 struct context {
 	uint32_t channel_count;
 	struct sr_channel **channels;
 	GString **channel_outputs; /* output strings */
+	char *last_chars;
+	/*
+	 * WaveDrom wants all of a channel's samples in one piece. When
+	 * the wave text exceeds the memory limit, it gets moved to a
+	 * temporary file, and is collected from there at the end.
+	 */
+	size_t buffered;
+	size_t memory_limit;
+	FILE *spill;
+	char *spill_name;
+	uint64_t spill_size;
+	GArray **spill_chunks;
 };
 
+static int spill_open(struct context *ctx)
+{
+	GError *error;
+	int fd;
+
+	error = NULL;
+	fd = g_file_open_tmp("sigrok-wavedrom-XXXXXX", &ctx->spill_name, &error);
+	if (fd < 0) {
+		sr_err("Cannot create temporary file: %s.", error->message);
+		g_error_free(error);
+		return SR_ERR_IO;
+	}
+	if (!(ctx->spill = fdopen(fd, "w+b"))) {
+		sr_err("Cannot open temporary file: %s.", g_strerror(errno));
+		close(fd);
+		return SR_ERR_IO;
+	}
+	sr_dbg("Moving wave text to %s.", ctx->spill_name);
+
+	return SR_OK;
+}
+
+/* Move the channels' wave text from memory to the spill file. */
+static int spill_buffers(struct context *ctx)
+{
+	struct spill_chunk chunk;
+	GString *accu;
+	size_t ch;
+	int ret;
+
+	if (!ctx->spill && (ret = spill_open(ctx)) != SR_OK)
+		return ret;
+
+	for (ch = 0; ch < ctx->channel_count; ch++) {
+		accu = ctx->channel_outputs[ch];
+		if (!accu || !accu->len)
+			continue;
+		if (fwrite(accu->str, accu->len, 1, ctx->spill) != 1) {
+			sr_err("Cannot write temporary file: %s.", g_strerror(errno));
+			return SR_ERR_IO;
+		}
+		chunk.offset = ctx->spill_size;
+		chunk.length = accu->len;
+		g_array_append_val(ctx->spill_chunks[ch], chunk);
+		ctx->spill_size += accu->len;
+		g_string_truncate(accu, 0);
+	}
+	ctx->buffered = 0;
+
+	return SR_OK;
+}
+
+/* Copy a channel's wave text from the spill file, and from memory. */
+static int render_wave(const struct sr_output *o, size_t ch, GString *out)
+{
+	struct context *ctx;
+	const struct spill_chunk *chunk;
+	size_t i, pos, len, old_len;
+	int ret;
+
+	ctx = o->priv;
+	if (ctx->spill && ctx->spill_chunks[ch]->len) {
+		if (fflush(ctx->spill) != 0) {
+			sr_err("Cannot write temporary file: %s.", g_strerror(errno));
+			return SR_ERR_IO;
+		}
+		for (i = 0; i < ctx->spill_chunks[ch]->len; i++) {
+			chunk = &g_array_index(ctx->spill_chunks[ch], struct spill_chunk, i);
+			if (fseeko(ctx->spill, chunk->offset, SEEK_SET) < 0) {
+				sr_err("Cannot seek temporary file: %s.", g_strerror(errno));
+				return SR_ERR_IO;
+			}
+			for (pos = 0; pos < chunk->length; pos += len) {
+				len = MIN(chunk->length - pos, SPILL_BLOCK_SIZE);
+				old_len = out->len;
+				g_string_set_size(out, old_len + len);
+				if (fread(out->str + old_len, len, 1, ctx->spill) != 1) {
+					sr_err("Cannot read temporary file.");
+					return SR_ERR_IO;
+				}
+				if ((ret = sr_output_drain(o, out)) != SR_OK)
+					return ret;
+			}
+		}
+	}
+	g_string_append_len(out, ctx->channel_outputs[ch]->str,
+		ctx->channel_outputs[ch]->len);
+
+	return sr_output_drain(o, out);
+}
+
 /* Converts accumulated output data to a JSON string. */
-static GString *wavedrom_render(const struct context *ctx)
+static int wavedrom_render(const struct sr_output *o, GString *out)
 {
-	GString *output;
-	size_t ch, i;
-	char last_char, curr_char;
+	const struct context *ctx;
+	size_t ch;
+	int ret;
 
-	output = g_string_new("{ \"signal\": [");
+	ctx = o->priv;
+	g_string_append(out, "{ \"signal\": [");
 	for (ch = 0; ch < ctx->channel_count; ch++) {
 		if (!ctx->channel_outputs[ch])
 			continue;
 
 		/* Channel strip. */
-		g_string_append_printf(output,
+		g_string_append_printf(out,
 			"{ \"name\": \"%s\", \"wave\": \"", ctx->channels[ch]->name);
-
-		last_char = 0;
-		for (i = 0; i < ctx->channel_outputs[ch]->len; i++) {
-			curr_char = ctx->channel_outputs[ch]->str[i];
-			/* Data point. */
-			if (curr_char == last_char) {
-				g_string_append_c(output, '.');
-			} else {
-				g_string_append_c(output, curr_char);
-				last_char = curr_char;
-			}
-		}
+		if ((ret = render_wave(o, ch, out)) != SR_OK)
+			return ret;
 		if (ch < ctx->channel_count - 1) {
-			g_string_append(output, "\" },");
+			g_string_append(out, "\" },");
 		} else {
 			/* Last channel, no comma. */
-			g_string_append(output, "\" }");
+			g_string_append(out, "\" }");
 		}
 	}
-	g_string_append(output, "], \"config\": { \"skin\": \"narrow\" }}");
+	g_string_append(out, "], \"config\": { \"skin\": \"narrow\" }}");
 
-	return output;
+	return SR_OK;
 }
 
-static void process_logic(const struct context *ctx,
+static int process_logic(struct context *ctx,
 	const struct sr_datafeed_logic *logic)
 {
 	size_t sample_count, ch, i;
-	uint8_t *sample, bit;
+	char *wave, last_char;
 	GString *accu;
 
-	if (!ctx->channel_count)
-		return;
+	if (!ctx->channel_count || !logic->unitsize)
+		return SR_OK;
 
 	/*
 	 * Extract the logic bits for each channel and store them
@@ -85,46 +192,40 @@ static void process_logic(const struct context *ctx,
 	 * This transforms the input which consists of sample sets
 	 * that span multiple channels into output stripes per logic
 	 * channel which consist of bits for that individual channel.
-	 *
-	 * TODO Reduce memory consumption during accumulation of
-	 * output data.
-	 *
-	 * Ideally we'd accumulate binary chunks, and defer conversion
-	 * to the text format. Analog data already won't get here, only
-	 * logic data does. When the per-channel transformation also
-	 * gets deferred until later, then the only overhead would be
-	 * for disabled logic channels. Which may be acceptable or even
-	 * negligable.
-	 *
-	 * An optional addition to the above mentioned accumulation of
-	 * binary data is RLE compression. Mark both the position in the
-	 * accumulated data as well as a repetition counter, instead of
-	 * repeatedly storing the same sample set. The efficiency of
-	 * this approach of course depends on the change rate of input
-	 * data. But the approach perfectly matches the WaveDrom syntax
-	 * for repeated bit patterns, and thus is easily handled in the
-	 * text rendering stage of the output module.
+	 * Repeated values are marked with '.' right away, as the
+	 * WaveDrom syntax wants it.
 	 */
 	sample_count = logic->length / logic->unitsize;
-	for (i = 0; i < sample_count; i++) {
-		sample = logic->data + i * logic->unitsize;
-		for (ch = 0; ch < ctx->channel_count; ch++) {
-			accu = ctx->channel_outputs[ch];
-			if (!accu)
-				continue;
-			bit = sample[ch / 8] & (1 << (ch % 8));
-			g_string_append_c(accu, bit ? '1' : '0');
+	for (ch = 0; ch < ctx->channel_count; ch++) {
+		accu = ctx->channel_outputs[ch];
+		if (!accu || ch >= 8 * logic->unitsize)
+			continue;
+		g_string_set_size(accu, accu->len + sample_count);
+		wave = accu->str + accu->len - sample_count;
+		sr_logic_text_format(wave, logic->data, logic->unitsize,
+			sample_count, ch, '0', '1');
+		last_char = ctx->last_chars[ch];
+		for (i = 0; i < sample_count; i++) {
+			if (wave[i] == last_char)
+				wave[i] = '.';
+			else
+				last_char = wave[i];
 		}
+		ctx->last_chars[ch] = last_char;
+		ctx->buffered += sample_count;
 	}
+
+	if (ctx->buffered > ctx->memory_limit)
+		return spill_buffers(ctx);
+
+	return SR_OK;
 }
 
-static int receive(const struct sr_output *o,
-	const struct sr_datafeed_packet *packet, GString **out)
+static int append(const struct sr_output *o,
+	const struct sr_datafeed_packet *packet, GString *out)
 {
 	struct context *ctx;
 
-	*out = NULL;
-
 	if (!o || !o->sdi || !o->priv)
 		return SR_ERR_ARG;
 
@@ -132,11 +233,9 @@ static int receive(const struct sr_output *o,
 
 	switch (packet->type) {
 	case SR_DF_LOGIC:
-		process_logic(ctx, packet->payload);
-		break;
+		return process_logic(ctx, packet->payload);
 	case SR_DF_END:
-		*out = wavedrom_render(ctx);
-		break;
+		return wavedrom_render(o, out);
 	}
 
 	return SR_OK;
@@ -149,34 +248,52 @@ static int init(struct sr_output *o, GHashTable *options)
 	GSList *l;
 	size_t i;
 
-	(void)options;
-
 	if (!o || !o->sdi)
 		return SR_ERR_ARG;
 
 	o->priv = ctx = g_malloc0(sizeof(*ctx));
 
+	ctx->memory_limit = (size_t)g_variant_get_uint32(
+		g_hash_table_lookup(options, "memory")) * 1024 * 1024;
 	ctx->channel_count = g_slist_length(o->sdi->channels);
 	ctx->channels = g_malloc0(
 		sizeof(ctx->channels[0]) * ctx->channel_count);
 	ctx->channel_outputs = g_malloc0(
 		sizeof(ctx->channel_outputs[0]) * ctx->channel_count);
+	ctx->last_chars = g_malloc0(ctx->channel_count);
+	ctx->spill_chunks = g_malloc0(
+		sizeof(ctx->spill_chunks[0]) * ctx->channel_count);
 
 	for (i = 0, l = o->sdi->channels; l; l = l->next, i++) {
 		channel = l->data;
 		if (channel->enabled && channel->type == SR_CHANNEL_LOGIC) {
 			ctx->channels[i] = channel;
 			ctx->channel_outputs[i] = g_string_new(NULL);
+			ctx->spill_chunks[i] = g_array_new(FALSE, FALSE,
+				sizeof(struct spill_chunk));
 		}
 	}
 
 	return SR_OK;
 }
 
+static struct sr_option options[] = {
+	{ "memory", "Memory limit", "Wave text to keep in memory (MiB), before using a temporary file", NULL, NULL },
+	ALL_ZERO
+};
+
+static const struct sr_option *get_options(void)
+{
+	if (!options[0].def)
+		options[0].def = g_variant_ref_sink(g_variant_new_uint32(64));
+
+	return options;
+}
+
 static int cleanup(struct sr_output *o)
 {
 	struct context *ctx;
-	GString *s;
+	size_t i;
 
 	if (!o)
 		return SR_ERR_ARG;
@@ -185,11 +302,19 @@ static int cleanup(struct sr_output *o)
 	o->priv = NULL;
 
 	if (ctx) {
-		while (--ctx->channel_count) {
-			s = ctx->channel_outputs[ctx->channel_count];
-			if (s)
-				g_string_free(s, TRUE);
+		for (i = 0; i < ctx->channel_count; i++) {
+			if (ctx->channel_outputs[i])
+				g_string_free(ctx->channel_outputs[i], TRUE);
+			if (ctx->spill_chunks[i])
+				g_array_free(ctx->spill_chunks[i], TRUE);
+		}
+		if (ctx->spill) {
+			fclose(ctx->spill);
+			g_unlink(ctx->spill_name);
 		}
+		g_free(ctx->spill_name);
+		g_free(ctx->spill_chunks);
+		g_free(ctx->last_chars);
 		g_free(ctx->channel_outputs);
 		g_free(ctx->channels);
 		g_free(ctx);
@@ -204,8 +329,8 @@ SR_PRIV struct sr_output_module output_wavedrom = {
 	.desc = "WaveDrom.com file format",
 	.exts = (const char *[]){"wavedrom", "json", NULL},
 	.flags = 0,
-	.options = NULL,
+	.options = get_options,
 	.init = init,
-	.receive = receive,
+	.append = append,
 	.cleanup = cleanup,
 };
@@ -23,6 +23,8 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <math.h>
+#include <string.h>
 #include <zip.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
@@ -34,13 +36,46 @@
 #define CHUNKSIZE (4 * 1024 * 1024)
 /** @endcond */
 
+/* Number of chunks which get decompressed ahead of their submission. */
+#define DEFAULT_PREFETCH_DEPTH	4
+#define MAX_PREFETCH_DEPTH	64
+
+/* Packets cover at most this fraction of a second in paced replay. */
+#define REPLAY_SLICES_PER_SEC	100
+/* Packets which are later than this are accounted as underruns. */
+#define REPLAY_LAG_TOLERANCE_US	(2000)
+/* Timer interval of paced replay, and the packets sent per callback. */
+#define REPLAY_POLL_MS		1
+#define REPLAY_MAX_BURST	16
+
+/* Archive member for interleaved analog data, see output/srzip.c. */
+#define ANALOG_FRAMES_NAME	"analog-frames-1"
+#define ANALOG_INT16_NAN	G_MININT16
+
 SR_PRIV struct sr_dev_driver session_driver_info;
 
+/*
+ * A block of sample data which was read from the session archive. The
+ * analog channel is 0 for logic data, -1 for interleaved analog data
+ * of all channels.
+ */
+struct session_block {
+	int analog_channel;
+	uint8_t *data;
+	size_t size;
+	uint8_t *buf;
+};
+
 struct session_vdev {
 	char *sessionfile;
 	char *capturefile;
+	char *cur_entry;
 	struct zip *archive;
 	struct zip_file *capfile;
+	struct sr_sessionfile_map *map;
+	uint8_t *map_data;
+	size_t map_size;
+	size_t map_pos;
 	int bytes_read;
 	uint64_t samplerate;
 	int unitsize;
@@ -50,6 +85,35 @@ struct session_vdev {
 	GArray *analog_channels;
 	int cur_chunk;
 	gboolean finished;
+	struct {
+		uint64_t depth;
+		size_t block_count;
+		struct session_block *blocks;
+		GAsyncQueue *free_blocks;
+		GAsyncQueue *full_blocks;
+		GThread *thread;
+		gint stop;
+	} prefetch;
+	struct session_block *cur_block;
+	size_t cur_block_pos;
+	struct {
+		gboolean interleaved;
+		gboolean is_int16;
+		float *scale;
+		float *offset;
+		uint8_t *raw;
+	} frames;
+	struct {
+		double speed;
+		gboolean paced;
+		gboolean waiting;
+		int stream;
+		int64_t start_us;
+		uint64_t samples;
+		uint64_t packets;
+		uint64_t underruns;
+		int64_t max_lag_us;
+	} replay;
 };
 
 static const uint32_t devopts[] = {
@@ -59,151 +123,538 @@ static const uint32_t devopts[] = {
 	SR_CONF_NUM_ANALOG_CHANNELS | SR_CONF_SET,
 	SR_CONF_SAMPLERATE | SR_CONF_GET | SR_CONF_SET,
 	SR_CONF_SESSIONFILE | SR_CONF_SET,
+	SR_CONF_PREFETCH_DEPTH | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_REPLAY_SPEED | SR_CONF_GET | SR_CONF_SET,
 };
 
-static gboolean stream_session_data(struct sr_dev_inst *sdi)
+/*
+ * Open an archive member for reading. Prefer the memory mapping for
+ * members which were stored without compression, fall back to libzip
+ * for everything else.
+ */
+static gboolean capture_entry_open(struct session_vdev *vdev, const char *name)
+{
+	if (sr_sessionfile_map_lookup(vdev->map, name,
+			&vdev->map_data, &vdev->map_size)) {
+		vdev->map_pos = 0;
+		sr_dbg("Mapped %s.", name);
+		return TRUE;
+	}
+
+	vdev->capfile = zip_fopen(vdev->archive, name, 0);
+	if (!vdev->capfile)
+		return FALSE;
+	sr_dbg("Opened %s.", name);
+
+	return TRUE;
+}
+
+static void capture_entry_close(struct session_vdev *vdev)
+{
+	if (vdev->capfile) {
+		zip_fclose(vdev->capfile);
+		vdev->capfile = NULL;
+	}
+	vdev->map_data = NULL;
+	vdev->map_size = 0;
+	vdev->map_pos = 0;
+}
+
+/*
+ * Advance to the next archive member which holds sample data. Logic
+ * data comes first ("logic-1" or its chunks "logic-1-<n>"), analog
+ * channels follow ("analog-1-<ch>-<n>", or "analog-frames-1-<n>" when
+ * all channels are interleaved).
+ */
+static gboolean capture_entry_next(struct session_vdev *vdev)
 {
-	struct session_vdev *vdev;
-	struct sr_datafeed_packet packet;
-	struct sr_datafeed_logic logic;
-	struct sr_datafeed_analog analog;
-	struct sr_analog_encoding encoding;
-	struct sr_analog_meaning meaning;
-	struct sr_analog_spec spec;
 	struct zip_stat zs;
-	int ret, got_data;
 	char capturefile[128];
-	void *buf;
 
-	got_data = FALSE;
-	vdev = sdi->priv;
-
-	if (!vdev->capfile) {
-		/* No capture file opened yet, or finished with the last
-		 * chunked one. */
-		if (vdev->capturefile && (vdev->cur_chunk == 0)) {
-			/* capturefile is always the unchunked base name. */
-			if (zip_stat(vdev->archive, vdev->capturefile, 0, &zs) != -1) {
-				/* No chunks, just a single capture file. */
-				vdev->cur_chunk = 0;
-				if (!(vdev->capfile = zip_fopen(vdev->archive,
-						vdev->capturefile, 0)))
-					return FALSE;
-				sr_dbg("Opened %s.", vdev->capturefile);
-			} else {
-				/* Try as first chunk filename. */
-				snprintf(capturefile, sizeof(capturefile) - 1, "%s-1", vdev->capturefile);
-				if (zip_stat(vdev->archive, capturefile, 0, &zs) != -1) {
-					vdev->cur_chunk = 1;
-					if (!(vdev->capfile = zip_fopen(vdev->archive,
-							capturefile, 0)))
-						return FALSE;
-					sr_dbg("Opened %s.", capturefile);
-				} else {
-					sr_err("No capture file '%s' in " "session file '%s'.",
-							vdev->capturefile, vdev->sessionfile);
-					return FALSE;
-				}
-			}
-		} else {
-			/* Capture data is chunked, advance to the next chunk. */
-			vdev->cur_chunk++;
-			snprintf(capturefile, sizeof(capturefile) - 1, "%s-%d", vdev->capturefile,
-					vdev->cur_chunk);
+	while (TRUE) {
+		if (vdev->cur_entry && vdev->cur_chunk == 0 &&
+				zip_stat(vdev->archive, vdev->cur_entry, 0, &zs) != -1) {
+			/* No chunks, just a single capture file. */
+			vdev->cur_chunk = -1;
+			return capture_entry_open(vdev, vdev->cur_entry);
+		}
+		if (vdev->cur_entry && vdev->cur_chunk >= 0) {
+			snprintf(capturefile, sizeof(capturefile) - 1, "%s-%d",
+				vdev->cur_entry, vdev->cur_chunk + 1);
 			if (zip_stat(vdev->archive, capturefile, 0, &zs) != -1) {
-				if (!(vdev->capfile = zip_fopen(vdev->archive,
-						capturefile, 0)))
-					return FALSE;
-				sr_dbg("Opened %s.", capturefile);
-			} else if (vdev->cur_analog_channel < vdev->num_analog_channels) {
-				vdev->capturefile = g_strdup_printf("analog-1-%d",
-						vdev->num_logic_channels + vdev->cur_analog_channel + 1);
-				vdev->cur_analog_channel++;
-				vdev->cur_chunk = 0;
-				return TRUE;
-			} else {
-				/* We got all the chunks, finish up. */
-				g_free(vdev->capturefile);
-
-				/* If the file has logic channels, the initial value for
-				 * capturefile is set by stream_session_data() - however only
-				 * once. In order to not mess this mechanism up, we simulate
-				 * this here if needed. For purely analog files, capturefile
-				 * is not set.
-				 */
-				if (vdev->num_logic_channels)
-					vdev->capturefile = g_strdup("logic-1");
-				else
-					vdev->capturefile = NULL;
+				vdev->cur_chunk++;
+				return capture_entry_open(vdev, capturefile);
+			}
+			if (vdev->cur_chunk == 0) {
+				sr_err("No capture file '%s' in " "session file '%s'.",
+					vdev->cur_entry, vdev->sessionfile);
 				return FALSE;
 			}
 		}
+
+		/* Done with this member's chunks, continue with analog data. */
+		if (vdev->cur_analog_channel >= vdev->num_analog_channels)
+			return FALSE;
+		g_free(vdev->cur_entry);
+		if (vdev->frames.interleaved) {
+			/* A single member holds all channels. */
+			vdev->cur_entry = g_strdup(ANALOG_FRAMES_NAME);
+			vdev->cur_analog_channel = vdev->num_analog_channels;
+			vdev->cur_chunk = 0;
+			continue;
+		}
+		vdev->cur_entry = g_strdup_printf("analog-1-%d",
+			vdev->num_logic_channels + vdev->cur_analog_channel + 1);
+		vdev->cur_analog_channel++;
+		vdev->cur_chunk = 0;
+	}
+}
+
+/* Read from the current archive member, mapped or via libzip. */
+static size_t capture_entry_read(struct session_vdev *vdev,
+	uint8_t *buf, size_t size, const uint8_t **data)
+{
+	zip_int64_t ret;
+
+	if (vdev->map_data) {
+		size = MIN(size, vdev->map_size - vdev->map_pos);
+		*data = &vdev->map_data[vdev->map_pos];
+		vdev->map_pos += size;
+		return size;
+	}
+
+	ret = zip_fread(vdev->capfile, buf, size);
+	*data = buf;
+
+	return ret > 0 ? (size_t)ret : 0;
+}
+
+/*
+ * Interleaved int16 members start with the channels' scale and offset.
+ * Get these before the member's sample data gets read.
+ */
+static gboolean frames_header_read(struct session_vdev *vdev)
+{
+	const uint8_t *data;
+	size_t size, idx;
+
+	size = vdev->num_analog_channels * 2 * sizeof(float);
+	if (capture_entry_read(vdev, vdev->frames.raw, size, &data) != size) {
+		sr_err("Truncated analog frames header.");
+		return FALSE;
+	}
+	for (idx = 0; idx < (size_t)vdev->num_analog_channels; idx++) {
+		vdev->frames.scale[idx] = read_fltle_inc(&data);
+		vdev->frames.offset[idx] = read_fltle_inc(&data);
+	}
+
+	return TRUE;
+}
+
+/* Convert interleaved int16 frames to float values, in place order. */
+static size_t frames_int16_read(struct session_vdev *vdev,
+	struct session_block *block, size_t size)
+{
+	const uint8_t *data;
+	size_t ch_count, frame_count, idx, ch;
+	float *values;
+	int16_t raw;
+
+	ch_count = vdev->num_analog_channels;
+	frame_count = size / (ch_count * sizeof(float));
+	size = capture_entry_read(vdev, vdev->frames.raw,
+		frame_count * ch_count * sizeof(int16_t), &data);
+	frame_count = size / (ch_count * sizeof(int16_t));
+
+	values = (float *)block->buf;
+	for (idx = 0; idx < frame_count; idx++) {
+		for (ch = 0; ch < ch_count; ch++) {
+			raw = (int16_t)read_u16le_inc(&data);
+			if (raw == ANALOG_INT16_NAN)
+				*values++ = NAN;
+			else
+				*values++ = vdev->frames.offset[ch] +
+					vdev->frames.scale[ch] * raw;
+		}
 	}
+	block->data = block->buf;
 
-	buf = g_malloc(CHUNKSIZE);
+	return frame_count * ch_count * sizeof(float);
+}
+
+/*
+ * Get the next block of sample data from the session archive. Mapped
+ * members are not copied, the block references the mapping. Analog
+ * data which is not suitably aligned for float access gets copied to
+ * the block's buffer.
+ *
+ * This can run in the prefetch thread. It must not access the session.
+ */
+static gboolean session_block_read(struct session_vdev *vdev,
+	struct session_block *block)
+{
+	size_t size, frame_size;
+	const uint8_t *data;
+	gboolean frames;
 
 	/* unitsize is not defined for purely analog session files. */
 	if (vdev->unitsize)
-		ret = zip_fread(vdev->capfile, buf,
-				CHUNKSIZE / vdev->unitsize * vdev->unitsize);
+		size = CHUNKSIZE / vdev->unitsize * vdev->unitsize;
 	else
-		ret = zip_fread(vdev->capfile, buf, CHUNKSIZE);
-
-	if (ret > 0) {
-		if (vdev->cur_analog_channel != 0) {
-			got_data = TRUE;
-			packet.type = SR_DF_ANALOG;
-			packet.payload = &analog;
-			/* TODO: Use proper 'digits' value for this device (and its modes). */
-			sr_analog_init(&analog, &encoding, &meaning, &spec, 2);
-			analog.meaning->channels = g_slist_prepend(NULL,
-					g_array_index(vdev->analog_channels,
-						struct sr_channel *, vdev->cur_analog_channel - 1));
-			analog.num_samples = ret / sizeof(float);
-			analog.meaning->mq = SR_MQ_VOLTAGE;
-			analog.meaning->unit = SR_UNIT_VOLT;
-			analog.meaning->mqflags = SR_MQFLAG_DC;
-			analog.data = (float *) buf;
-		} else if (vdev->unitsize) {
-			got_data = TRUE;
-			if (ret % vdev->unitsize != 0)
-				sr_warn("Read size %d not a multiple of the"
-					" unit size %d.", ret, vdev->unitsize);
-			packet.type = SR_DF_LOGIC;
-			packet.payload = &logic;
-			logic.length = ret;
-			logic.unitsize = vdev->unitsize;
-			logic.data = buf;
+		size = CHUNKSIZE;
+
+	while (TRUE) {
+		frames = vdev->frames.interleaved && vdev->cur_analog_channel;
+		if (!vdev->capfile && !vdev->map_data) {
+			if (!capture_entry_next(vdev))
+				return FALSE;
+			frames = vdev->frames.interleaved && vdev->cur_analog_channel;
+			if (frames && vdev->frames.is_int16 &&
+					!frames_header_read(vdev))
+				return FALSE;
+		}
+
+		if (frames) {
+			/* Don't split frames across packets. */
+			block->analog_channel = -1;
+			frame_size = vdev->num_analog_channels * sizeof(float);
+			size = CHUNKSIZE / frame_size * frame_size;
 		} else {
-			/*
-			 * Neither analog data, nor logic which has
-			 * unitsize, must be an unexpected API use.
-			 */
-			sr_warn("Neither analog nor logic data. Ignoring.");
+			block->analog_channel = vdev->cur_analog_channel;
 		}
-		if (got_data) {
-			vdev->bytes_read += ret;
-			sr_session_send(sdi, &packet);
+
+		if (frames && vdev->frames.is_int16) {
+			block->size = frames_int16_read(vdev, block, size);
+		} else {
+			block->size = capture_entry_read(vdev, block->buf,
+				size, &data);
+			block->data = (uint8_t *)data;
+			if (block->analog_channel && block->data != block->buf &&
+					((uintptr_t)block->data % sizeof(float))) {
+				memcpy(block->buf, block->data, block->size);
+				block->data = block->buf;
+			}
 		}
-	} else {
+		if (block->size > 0)
+			return TRUE;
+
 		/* done with this capture file */
-		zip_fclose(vdev->capfile);
-		vdev->capfile = NULL;
-		if (vdev->cur_chunk != 0) {
-			/* There might be more chunks, so don't fall through
-			 * to the SR_DF_END here. */
-			got_data = TRUE;
+		capture_entry_close(vdev);
+	}
+}
+
+static void session_block_send(struct sr_dev_inst *sdi,
+	const struct session_block *block, size_t offset, size_t size)
+{
+	struct session_vdev *vdev;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	guint idx;
+
+	vdev = sdi->priv;
+
+	if (block->analog_channel < 0) {
+		/* Interleaved frames, all analog channels in one packet. */
+		packet.type = SR_DF_ANALOG;
+		packet.payload = &analog;
+		sr_analog_init(&analog, &encoding, &meaning, &spec, 2);
+		analog.meaning->channels = NULL;
+		for (idx = vdev->analog_channels->len; idx > 0; idx--) {
+			analog.meaning->channels = g_slist_prepend(
+				analog.meaning->channels,
+				g_array_index(vdev->analog_channels,
+					struct sr_channel *, idx - 1));
+		}
+		analog.num_samples = size / sizeof(float) /
+			vdev->num_analog_channels;
+		analog.meaning->mq = SR_MQ_VOLTAGE;
+		analog.meaning->unit = SR_UNIT_VOLT;
+		analog.meaning->mqflags = SR_MQFLAG_DC;
+		analog.data = (float *)&block->data[offset];
+		vdev->bytes_read += size;
+		sr_session_send(sdi, &packet);
+		g_slist_free(analog.meaning->channels);
+	} else if (block->analog_channel != 0) {
+		packet.type = SR_DF_ANALOG;
+		packet.payload = &analog;
+		/* TODO: Use proper 'digits' value for this device (and its modes). */
+		sr_analog_init(&analog, &encoding, &meaning, &spec, 2);
+		analog.meaning->channels = g_slist_prepend(NULL,
+				g_array_index(vdev->analog_channels,
+					struct sr_channel *, block->analog_channel - 1));
+		analog.num_samples = size / sizeof(float);
+		analog.meaning->mq = SR_MQ_VOLTAGE;
+		analog.meaning->unit = SR_UNIT_VOLT;
+		analog.meaning->mqflags = SR_MQFLAG_DC;
+		analog.data = (float *)&block->data[offset];
+		vdev->bytes_read += size;
+		sr_session_send(sdi, &packet);
+		g_slist_free(analog.meaning->channels);
+	} else if (vdev->unitsize) {
+		if (size % vdev->unitsize != 0)
+			sr_warn("Read size %zu not a multiple of the"
+				" unit size %d.", size, vdev->unitsize);
+		packet.type = SR_DF_LOGIC;
+		packet.payload = &logic;
+		logic.length = size;
+		logic.unitsize = vdev->unitsize;
+		logic.data = &block->data[offset];
+		vdev->bytes_read += size;
+		sr_session_send(sdi, &packet);
+	} else {
+		/*
+		 * Neither analog data, nor logic which has
+		 * unitsize, must be an unexpected API use.
+		 */
+		sr_warn("Neither analog nor logic data. Ignoring.");
+	}
+}
+
+/*
+ * The prefetch thread reads (and decompresses) archive members ahead
+ * of their submission to the session. Filled blocks are handed to the
+ * session thread in order, an empty block marks the end of the data.
+ */
+static gpointer prefetch_thread(gpointer data)
+{
+	struct session_vdev *vdev;
+	struct session_block *block;
+	gboolean got_data;
+
+	vdev = data;
+	do {
+		block = g_async_queue_pop(vdev->prefetch.free_blocks);
+		if (g_atomic_int_get(&vdev->prefetch.stop))
+			break;
+		got_data = session_block_read(vdev, block);
+		if (!got_data)
+			block->size = 0;
+		g_async_queue_push(vdev->prefetch.full_blocks, block);
+	} while (got_data);
+
+	return NULL;
+}
+
+static int prefetch_start(struct session_vdev *vdev)
+{
+	struct session_block *block;
+	size_t idx;
+	GError *error;
+
+	/* One block in flight in the session thread, more are queued. */
+	vdev->prefetch.block_count = vdev->prefetch.depth + 1;
+	vdev->prefetch.blocks = g_malloc0(vdev->prefetch.block_count *
+		sizeof(vdev->prefetch.blocks[0]));
+	for (idx = 0; idx < vdev->prefetch.block_count; idx++) {
+		block = &vdev->prefetch.blocks[idx];
+		block->buf = g_try_malloc(CHUNKSIZE);
+		if (!block->buf)
+			return SR_ERR_MALLOC;
+	}
+	if (!vdev->prefetch.depth)
+		return SR_OK;
+
+	vdev->prefetch.free_blocks = g_async_queue_new();
+	vdev->prefetch.full_blocks = g_async_queue_new();
+	for (idx = 0; idx < vdev->prefetch.block_count; idx++) {
+		block = &vdev->prefetch.blocks[idx];
+		g_async_queue_push(vdev->prefetch.free_blocks, block);
+	}
+	g_atomic_int_set(&vdev->prefetch.stop, 0);
+	error = NULL;
+	vdev->prefetch.thread = g_thread_try_new("session-prefetch",
+		prefetch_thread, vdev, &error);
+	if (!vdev->prefetch.thread) {
+		sr_err("Cannot create prefetch thread: %s.", error->message);
+		g_error_free(error);
+		return SR_ERR;
+	}
+	sr_dbg("Prefetching %" PRIu64 " chunks.", vdev->prefetch.depth);
+
+	return SR_OK;
+}
+
+static void prefetch_stop(struct session_vdev *vdev)
+{
+	size_t idx;
+
+	if (vdev->prefetch.thread) {
+		/* Wake up the thread in case it waits for a free block. */
+		g_atomic_int_set(&vdev->prefetch.stop, 1);
+		g_async_queue_push(vdev->prefetch.free_blocks,
+			&vdev->prefetch.blocks[0]);
+		g_thread_join(vdev->prefetch.thread);
+		vdev->prefetch.thread = NULL;
+	}
+	if (vdev->prefetch.free_blocks) {
+		g_async_queue_unref(vdev->prefetch.free_blocks);
+		vdev->prefetch.free_blocks = NULL;
+	}
+	if (vdev->prefetch.full_blocks) {
+		g_async_queue_unref(vdev->prefetch.full_blocks);
+		vdev->prefetch.full_blocks = NULL;
+	}
+	for (idx = 0; idx < vdev->prefetch.block_count; idx++)
+		g_free(vdev->prefetch.blocks[idx].buf);
+	g_free(vdev->prefetch.blocks);
+	vdev->prefetch.blocks = NULL;
+	vdev->prefetch.block_count = 0;
+}
+
+static struct session_block *session_block_get(struct session_vdev *vdev)
+{
+	struct session_block *block;
+
+	if (!vdev->prefetch.thread) {
+		block = &vdev->prefetch.blocks[0];
+		if (!session_block_read(vdev, block))
+			return NULL;
+		return block;
+	}
+
+	block = g_async_queue_pop(vdev->prefetch.full_blocks);
+	if (!block->size) {
+		g_async_queue_push(vdev->prefetch.free_blocks, block);
+		return NULL;
+	}
+
+	return block;
+}
+
+static void session_block_put(struct session_vdev *vdev,
+	struct session_block *block)
+{
+	if (vdev->prefetch.thread)
+		g_async_queue_push(vdev->prefetch.free_blocks, block);
+}
+
+/*
+ * Pace the replay to the capture's samplerate, scaled by the replay
+ * speed. Limits the packet to a slice of time, returns 0 while the
+ * slice is not due yet (the caller retries from its next timer
+ * callback, never sleeps), and accounts for packets which could not
+ * be sent in time.
+ * Logic data and each of the analog channels are separate streams,
+ * each of them starts its own timeline. Interleaved analog channels
+ * share one timeline.
+ */
+static size_t replay_pace(struct session_vdev *vdev,
+	const struct session_block *block, size_t size)
+{
+	size_t sample_size;
+	double rate;
+	uint64_t count, slice;
+	int64_t now, due, lag;
+
+	if (block->analog_channel < 0)
+		sample_size = vdev->num_analog_channels * sizeof(float);
+	else if (block->analog_channel)
+		sample_size = sizeof(float);
+	else
+		sample_size = vdev->unitsize;
+	rate = vdev->samplerate * vdev->replay.speed;
+	if (!sample_size || rate < 1.0)
+		return size;
+
+	now = g_get_monotonic_time();
+	if (!vdev->replay.start_us || block->analog_channel != vdev->replay.stream) {
+		vdev->replay.stream = block->analog_channel;
+		vdev->replay.start_us = now;
+		vdev->replay.samples = 0;
+	}
+
+	/* Submit at most one slice worth of samples per packet. */
+	slice = rate / REPLAY_SLICES_PER_SEC;
+	if (!slice)
+		slice = 1;
+	count = size / sample_size;
+	if (!count)
+		return size;
+	if (count > slice)
+		count = slice;
+
+	due = vdev->replay.start_us;
+	due += vdev->replay.samples * (double)G_USEC_PER_SEC / rate;
+	if (due > now)
+		return 0;
+	lag = now - due;
+	if (lag > REPLAY_LAG_TOLERANCE_US)
+		vdev->replay.underruns++;
+	if (lag > vdev->replay.max_lag_us)
+		vdev->replay.max_lag_us = lag;
+	vdev->replay.samples += count;
+
+	return count * sample_size;
+}
+
+static gboolean stream_session_data(struct sr_dev_inst *sdi)
+{
+	struct session_vdev *vdev;
+	struct session_block *block;
+	size_t size;
+
+	vdev = sdi->priv;
+
+	if (!vdev->cur_block) {
+		vdev->cur_block = session_block_get(vdev);
+		if (!vdev->cur_block)
+			return FALSE;
+		vdev->cur_block_pos = 0;
+	}
+	block = vdev->cur_block;
+
+	size = block->size - vdev->cur_block_pos;
+	if (vdev->replay.paced) {
+		size = replay_pace(vdev, block, size);
+		if (!size) {
+			vdev->replay.waiting = TRUE;
+			return TRUE;
 		}
 	}
-	g_free(buf);
+	session_block_send(sdi, block, vdev->cur_block_pos, size);
+	vdev->replay.packets++;
+	vdev->cur_block_pos += size;
+
+	if (vdev->cur_block_pos >= block->size) {
+		session_block_put(vdev, block);
+		vdev->cur_block = NULL;
+	}
 
-	return got_data;
+	return TRUE;
+}
+
+static void session_data_release(struct session_vdev *vdev)
+{
+	vdev->cur_block = NULL;
+	prefetch_stop(vdev);
+	capture_entry_close(vdev);
+	if (vdev->archive) {
+		zip_discard(vdev->archive);
+		vdev->archive = NULL;
+	}
+	sr_sessionfile_map_free(vdev->map);
+	vdev->map = NULL;
+	g_free(vdev->cur_entry);
+	vdev->cur_entry = NULL;
+	if (vdev->analog_channels) {
+		g_array_free(vdev->analog_channels, TRUE);
+		vdev->analog_channels = NULL;
+	}
+	g_free(vdev->frames.scale);
+	g_free(vdev->frames.offset);
+	g_free(vdev->frames.raw);
+	memset(&vdev->frames, 0, sizeof(vdev->frames));
 }
 
 static int receive_data(int fd, int revents, void *cb_data)
 {
 	struct sr_dev_inst *sdi;
 	struct session_vdev *vdev;
+	int burst;
 
 	(void)fd;
 	(void)revents;
@@ -211,18 +662,27 @@ static int receive_data(int fd, int revents, void *cb_data)
 	sdi = cb_data;
 	vdev = sdi->priv;
 
-	if (!vdev->finished && !stream_session_data(sdi))
-		vdev->finished = TRUE;
+	/*
+	 * Send one packet per callback when replaying as fast as possible.
+	 * Paced replay sends the packets which are due, and returns to the
+	 * main loop until the timer fires again.
+	 */
+	for (burst = 0; !vdev->finished && burst < REPLAY_MAX_BURST; burst++) {
+		vdev->replay.waiting = FALSE;
+		if (!stream_session_data(sdi))
+			vdev->finished = TRUE;
+		else if (!vdev->replay.paced || vdev->replay.waiting)
+			break;
+	}
 	if (!vdev->finished)
 		return G_SOURCE_CONTINUE;
 
-	if (vdev->capfile) {
-		zip_fclose(vdev->capfile);
-		vdev->capfile = NULL;
-	}
-	if (vdev->archive) {
-		zip_discard(vdev->archive);
-		vdev->archive = NULL;
+	session_data_release(vdev);
+
+	if (vdev->replay.paced) {
+		sr_info("Replayed %" PRIu64 " packets, %" PRIu64 " underruns, "
+			"max lag %" PRId64 " us.", vdev->replay.packets,
+			vdev->replay.underruns, vdev->replay.max_lag_us);
 	}
 
 	std_session_send_df_end(sdi);
@@ -241,6 +701,7 @@ static int dev_open(struct sr_dev_inst *sdi)
 	di = sdi->driver;
 	drvc = di->context;
 	vdev = g_malloc0(sizeof(struct session_vdev));
+	vdev->prefetch.depth = DEFAULT_PREFETCH_DEPTH;
 	sdi->priv = vdev;
 	drvc->instances = g_slist_append(drvc->instances, sdi);
 
@@ -249,7 +710,10 @@ static int dev_open(struct sr_dev_inst *sdi)
 
 static int dev_close(struct sr_dev_inst *sdi)
 {
-	const struct session_vdev *const vdev = sdi->priv;
+	struct session_vdev *vdev;
+
+	vdev = sdi->priv;
+	session_data_release(vdev);
 	g_free(vdev->sessionfile);
 	g_free(vdev->capturefile);
 
@@ -278,6 +742,12 @@ static int config_get(uint32_t key, GVariant **data,
 	case SR_CONF_CAPTURE_UNITSIZE:
 		*data = g_variant_new_uint64(vdev->unitsize);
 		break;
+	case SR_CONF_PREFETCH_DEPTH:
+		*data = g_variant_new_uint64(vdev->prefetch.depth);
+		break;
+	case SR_CONF_REPLAY_SPEED:
+		*data = g_variant_new_double(vdev->replay.speed);
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -318,6 +788,16 @@ static int config_set(uint32_t key, GVariant *data,
 	case SR_CONF_NUM_ANALOG_CHANNELS:
 		vdev->num_analog_channels = g_variant_get_int32(data);
 		break;
+	case SR_CONF_PREFETCH_DEPTH:
+		if (g_variant_get_uint64(data) > MAX_PREFETCH_DEPTH)
+			return SR_ERR_ARG;
+		vdev->prefetch.depth = g_variant_get_uint64(data);
+		break;
+	case SR_CONF_REPLAY_SPEED:
+		if (g_variant_get_double(data) < 0)
+			return SR_ERR_ARG;
+		vdev->replay.speed = g_variant_get_double(data);
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -331,6 +811,53 @@ static int config_list(uint32_t key, GVariant **data,
 	return STD_CONFIG_LIST(key, data, sdi, cg, NO_OPTS, NO_OPTS, devopts);
 }
 
+/*
+ * Check the archive's metadata for the layout of analog data. Separate
+ * members per channel is the default, all channels can be interleaved.
+ */
+static int frames_setup(struct session_vdev *vdev)
+{
+	struct zip_stat zs;
+	GKeyFile *kf;
+	char *layout, *type;
+	size_t ch_count;
+
+	if (!vdev->num_analog_channels)
+		return SR_OK;
+	if (zip_stat(vdev->archive, "metadata", 0, &zs) < 0)
+		return SR_ERR_DATA;
+	kf = sr_sessionfile_read_metadata(vdev->archive, &zs);
+	if (!kf)
+		return SR_ERR_DATA;
+	layout = g_key_file_get_string(kf, "device 1", "analog layout", NULL);
+	type = g_key_file_get_string(kf, "device 1", "analog type", NULL);
+	g_key_file_free(kf);
+
+	vdev->frames.interleaved = g_strcmp0(layout, "interleaved") == 0;
+	vdev->frames.is_int16 = g_strcmp0(type, "int16") == 0;
+	if (vdev->frames.interleaved && type &&
+			!vdev->frames.is_int16 && strcmp(type, "float32") != 0) {
+		sr_err("Unsupported analog type '%s'.", type);
+		g_free(layout);
+		g_free(type);
+		return SR_ERR_DATA;
+	}
+	g_free(layout);
+	g_free(type);
+	if (!vdev->frames.interleaved || !vdev->frames.is_int16)
+		return SR_OK;
+
+	ch_count = vdev->num_analog_channels;
+	vdev->frames.scale = g_malloc0(ch_count * sizeof(float));
+	vdev->frames.offset = g_malloc0(ch_count * sizeof(float));
+	vdev->frames.raw = g_try_malloc(MAX(CHUNKSIZE / 2,
+		ch_count * 2 * sizeof(float)));
+	if (!vdev->frames.raw)
+		return SR_ERR_MALLOC;
+
+	return SR_OK;
+}
+
 static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 {
 	struct session_vdev *vdev;
@@ -348,8 +875,16 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 		if (ch->type == SR_CHANNEL_ANALOG)
 			g_array_append_val(vdev->analog_channels, ch);
 	}
+	vdev->cur_entry = g_strdup(vdev->capturefile);
 	vdev->cur_chunk = 0;
 	vdev->finished = FALSE;
+	vdev->replay.start_us = 0;
+	vdev->replay.packets = 0;
+	vdev->replay.underruns = 0;
+	vdev->replay.max_lag_us = 0;
+	vdev->replay.paced = vdev->replay.speed > 0 && vdev->samplerate;
+	if (vdev->replay.speed > 0 && !vdev->samplerate)
+		sr_warn("Unknown samplerate, cannot pace the replay.");
 
 	sr_info("Opening archive %s file %s", vdev->sessionfile,
 		vdev->capturefile);
@@ -357,13 +892,26 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 	if (!(vdev->archive = zip_open(vdev->sessionfile, 0, &ret))) {
 		sr_err("Failed to open session file '%s': "
 		       "zip error %d.", vdev->sessionfile, ret);
+		session_data_release(vdev);
 		return SR_ERR;
 	}
+	vdev->map = sr_sessionfile_map_open(vdev->sessionfile);
+
+	if ((ret = frames_setup(vdev)) != SR_OK) {
+		session_data_release(vdev);
+		return ret;
+	}
+
+	if ((ret = prefetch_start(vdev)) != SR_OK) {
+		session_data_release(vdev);
+		return ret;
+	}
 
 	std_session_send_df_header(sdi);
 
-	/* freewheeling source */
-	sr_session_source_add(sdi->session, -1, 0, 0, receive_data, (void *)sdi);
+	/* Freewheeling source, or a timer when the replay gets paced. */
+	sr_session_source_add(sdi->session, -1, 0,
+		vdev->replay.paced ? REPLAY_POLL_MS : 0, receive_data, (void *)sdi);
 
 	return SR_OK;
 }
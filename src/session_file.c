@@ -19,11 +19,16 @@
 
 #include <config.h>
 #include <string.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <zip.h>
 #include <errno.h>
 #include <glib.h>
 #include <glib/gstdio.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
 
@@ -111,6 +116,619 @@ SR_PRIV GKeyFile *sr_sessionfile_read_metadata(struct zip *archive,
 	return keyfile;
 }
 
+/*
+ * Memory mapped access to uncompressed session archive members.
+ *
+ * Archive members which were written with the "store" method hold
+ * the raw sample data verbatim. Such members can be handed out as
+ * spans of a memory mapping of the archive, which avoids libzip's
+ * read path and the associated buffer copies during replay. Parse
+ * the ZIP central directory (including ZIP64 extensions) to learn
+ * the file offsets of these members. Compressed or encrypted members
+ * are not indexed, callers fall back to libzip for those.
+ */
+
+/** @cond PRIVATE */
+#define ZIP_SIG_LOCAL		0x04034b50
+#define ZIP_SIG_CENTRAL		0x02014b50
+#define ZIP_SIG_EOCD		0x06054b50
+#define ZIP_SIG_EOCD64		0x06064b50
+#define ZIP_SIG_EOCD64_LOC	0x07064b50
+#define ZIP_LEN_LOCAL		30
+#define ZIP_LEN_CENTRAL		46
+#define ZIP_LEN_EOCD		22
+#define ZIP_LEN_EOCD64		56
+#define ZIP_LEN_EOCD64_LOC	20
+#define ZIP_EXTRA_ZIP64		0x0001
+#define ZIP_METHOD_STORE	0
+#define ZIP_METHOD_DEFLATE	8
+#define ZIP_VERSION_DEFAULT	20
+#define ZIP_VERSION_ZIP64	45
+#define ZIP_FLAG_ENCRYPTED	(1UL << 0)
+/** @endcond */
+
+struct sessionfile_map_entry {
+	uint64_t offset;
+	uint64_t size;
+};
+
+static const uint8_t *sessionfile_map_find_eocd(const uint8_t *data,
+	size_t size)
+{
+	size_t pos, limit;
+
+	if (size < ZIP_LEN_EOCD)
+		return NULL;
+
+	/* The EOCD record is followed by a comment of up to 64KiB. */
+	pos = size - ZIP_LEN_EOCD;
+	limit = (pos > G_MAXUINT16) ? pos - G_MAXUINT16 : 0;
+	while (TRUE) {
+		if (read_u32le(&data[pos]) == ZIP_SIG_EOCD)
+			return &data[pos];
+		if (pos == limit)
+			break;
+		pos--;
+	}
+
+	return NULL;
+}
+
+static int sessionfile_map_index(struct sr_sessionfile_map *map)
+{
+	const uint8_t *eocd, *loc, *rec, *extra, *extra_end, *hdr;
+	uint64_t entry_count, cd_offset, cd_size, idx;
+	uint64_t comp_size, size, local_offset;
+	size_t name_len, extra_len, comment_len, field_len;
+	uint16_t method, flags, field_id;
+	struct sessionfile_map_entry *entry;
+	char *name;
+
+	eocd = sessionfile_map_find_eocd(map->data, map->size);
+	if (!eocd)
+		return SR_ERR_DATA;
+	entry_count = read_u16le(&eocd[10]);
+	cd_size = read_u32le(&eocd[12]);
+	cd_offset = read_u32le(&eocd[16]);
+
+	/* Large archives keep their directory location in ZIP64 records. */
+	loc = NULL;
+	if (eocd - map->data >= ZIP_LEN_EOCD64_LOC)
+		loc = eocd - ZIP_LEN_EOCD64_LOC;
+	if (loc && read_u32le(loc) == ZIP_SIG_EOCD64_LOC) {
+		idx = read_u64le(&loc[8]);
+		if (map->size < ZIP_LEN_EOCD64 || idx > map->size - ZIP_LEN_EOCD64)
+			return SR_ERR_DATA;
+		rec = &map->data[idx];
+		if (read_u32le(rec) != ZIP_SIG_EOCD64)
+			return SR_ERR_DATA;
+		entry_count = read_u64le(&rec[32]);
+		cd_size = read_u64le(&rec[40]);
+		cd_offset = read_u64le(&rec[48]);
+	}
+	if (cd_offset > map->size || cd_size > map->size - cd_offset)
+		return SR_ERR_DATA;
+
+	rec = &map->data[cd_offset];
+	for (idx = 0; idx < entry_count; idx++) {
+		if (rec + ZIP_LEN_CENTRAL > map->data + cd_offset + cd_size)
+			return SR_ERR_DATA;
+		if (read_u32le(rec) != ZIP_SIG_CENTRAL)
+			return SR_ERR_DATA;
+		flags = read_u16le(&rec[8]);
+		method = read_u16le(&rec[10]);
+		comp_size = read_u32le(&rec[20]);
+		size = read_u32le(&rec[24]);
+		name_len = read_u16le(&rec[28]);
+		extra_len = read_u16le(&rec[30]);
+		comment_len = read_u16le(&rec[32]);
+		local_offset = read_u32le(&rec[42]);
+		if (rec + ZIP_LEN_CENTRAL + name_len + extra_len + comment_len >
+				map->data + cd_offset + cd_size)
+			return SR_ERR_DATA;
+
+		/* ZIP64 values are present for saturated 32bit fields only. */
+		extra = &rec[ZIP_LEN_CENTRAL + name_len];
+		extra_end = extra + extra_len;
+		while (extra + 4 <= extra_end) {
+			field_id = read_u16le(&extra[0]);
+			field_len = read_u16le(&extra[2]);
+			extra += 4;
+			if (extra + field_len > extra_end)
+				break;
+			if (field_id == ZIP_EXTRA_ZIP64) {
+				hdr = extra;
+				if (size == G_MAXUINT32 && hdr + 8 <= extra + field_len)
+					size = read_u64le_inc(&hdr);
+				if (comp_size == G_MAXUINT32 && hdr + 8 <= extra + field_len)
+					comp_size = read_u64le_inc(&hdr);
+				if (local_offset == G_MAXUINT32 && hdr + 8 <= extra + field_len)
+					local_offset = read_u64le_inc(&hdr);
+			}
+			extra += field_len;
+		}
+
+		if (method == ZIP_METHOD_STORE && !(flags & ZIP_FLAG_ENCRYPTED) &&
+				comp_size == size &&
+				local_offset <= map->size - ZIP_LEN_LOCAL) {
+			hdr = &map->data[local_offset];
+			if (read_u32le(hdr) != ZIP_SIG_LOCAL)
+				return SR_ERR_DATA;
+			local_offset += ZIP_LEN_LOCAL;
+			local_offset += read_u16le(&hdr[26]);
+			local_offset += read_u16le(&hdr[28]);
+			if (local_offset <= map->size &&
+					size <= map->size - local_offset) {
+				name = g_strndup((const char *)&rec[ZIP_LEN_CENTRAL],
+					name_len);
+				entry = g_malloc0(sizeof(*entry));
+				entry->offset = local_offset;
+				entry->size = size;
+				g_hash_table_replace(map->entries, name, entry);
+			}
+		}
+
+		rec += ZIP_LEN_CENTRAL + name_len + extra_len + comment_len;
+	}
+
+	return SR_OK;
+}
+
+/**
+ * Memory map a session archive for zero-copy access to stored members.
+ *
+ * The mapping is private and writable, so that in-place processing of
+ * session feed packets (transforms) won't modify the file on disk.
+ *
+ * @param[in] filename The session file's name.
+ *
+ * @return A new mapping, or NULL when the archive could not get mapped,
+ *   or none of its members are stored without compression.
+ *
+ * @private
+ */
+SR_PRIV struct sr_sessionfile_map *sr_sessionfile_map_open(const char *filename)
+{
+	struct sr_sessionfile_map *map;
+	GError *error;
+
+	if (!filename)
+		return NULL;
+
+	map = g_malloc0(sizeof(*map));
+	error = NULL;
+	map->file = g_mapped_file_new(filename, TRUE, &error);
+	if (!map->file) {
+		sr_dbg("Cannot map session file: %s.", error->message);
+		g_error_free(error);
+		g_free(map);
+		return NULL;
+	}
+	map->data = (uint8_t *)g_mapped_file_get_contents(map->file);
+	map->size = g_mapped_file_get_length(map->file);
+	map->entries = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, g_free);
+
+	if (!map->data || sessionfile_map_index(map) != SR_OK) {
+		sr_dbg("Cannot index session file '%s' for mapped access.",
+			filename);
+		sr_sessionfile_map_free(map);
+		return NULL;
+	}
+	if (!g_hash_table_size(map->entries)) {
+		sr_spew("No stored members in session file '%s'.", filename);
+		sr_sessionfile_map_free(map);
+		return NULL;
+	}
+	sr_dbg("Mapped %u stored members of session file '%s'.",
+		g_hash_table_size(map->entries), filename);
+
+	return map;
+}
+
+/**
+ * Lookup an uncompressed member of a mapped session archive.
+ *
+ * @param[in] map The mapped session archive.
+ * @param[in] name The archive member's name.
+ * @param[out] data Start of the member's content within the mapping.
+ * @param[out] size Size of the member's content in bytes.
+ *
+ * @return TRUE when the member is available in the mapping.
+ *
+ * @private
+ */
+SR_PRIV gboolean sr_sessionfile_map_lookup(const struct sr_sessionfile_map *map,
+	const char *name, uint8_t **data, size_t *size)
+{
+	const struct sessionfile_map_entry *entry;
+
+	if (!map || !name)
+		return FALSE;
+
+	entry = g_hash_table_lookup(map->entries, name);
+	if (!entry)
+		return FALSE;
+	if (data)
+		*data = &map->data[entry->offset];
+	if (size)
+		*size = entry->size;
+
+	return TRUE;
+}
+
+/** @private */
+SR_PRIV void sr_sessionfile_map_free(struct sr_sessionfile_map *map)
+{
+	if (!map)
+		return;
+
+	if (map->entries)
+		g_hash_table_destroy(map->entries);
+	if (map->file)
+		g_mapped_file_unref(map->file);
+	g_free(map);
+}
+
+/*
+ * Appending members to a session archive via libzip has zip_close()
+ * write a complete copy of the archive, and replace the original file.
+ * For large captures this costs time and disk space which is
+ * proportional to the archive's size, not the appended data's size.
+ *
+ * Instead, the in-place path below overwrites the central directory
+ * with the new member's local header and data, and writes an extended
+ * copy of the previous central directory after it.
+ */
+
+#ifndef HAVE_ZLIB
+static uint32_t sessionfile_crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+	uint32_t table[256], c;
+	size_t idx, bit;
+
+	for (idx = 0; idx < ARRAY_SIZE(table); idx++) {
+		c = idx;
+		for (bit = 0; bit < 8; bit++)
+			c = (c & 1) ? 0xedb88320UL ^ (c >> 1) : c >> 1;
+		table[idx] = c;
+	}
+
+	crc = ~crc;
+	while (size--)
+		crc = table[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+
+	return ~crc;
+}
+#else
+static uint32_t sessionfile_crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+	uInt len;
+
+	while (size) {
+		len = MIN(size, G_MAXUINT32);
+		crc = crc32(crc, data, len);
+		data += len;
+		size -= len;
+	}
+
+	return crc;
+}
+
+static uint8_t *sessionfile_deflate(const uint8_t *data, size_t size,
+	size_t *comp_size)
+{
+	z_stream strm;
+	uint8_t *buf;
+	size_t buf_size;
+	int ret;
+
+	memset(&strm, 0, sizeof(strm));
+	if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+			-MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return NULL;
+	buf_size = deflateBound(&strm, size);
+	buf = g_try_malloc(buf_size);
+	if (!buf || size > G_MAXUINT32 || buf_size > G_MAXUINT32) {
+		deflateEnd(&strm);
+		g_free(buf);
+		return NULL;
+	}
+	strm.next_in = (Bytef *)data;
+	strm.avail_in = size;
+	strm.next_out = buf;
+	strm.avail_out = buf_size;
+	ret = deflate(&strm, Z_FINISH);
+	*comp_size = strm.total_out;
+	deflateEnd(&strm);
+	if (ret != Z_STREAM_END) {
+		g_free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+#endif
+
+/* Get the current time in MS-DOS format, as used in ZIP headers. */
+static void sessionfile_dos_time(uint16_t *dos_time, uint16_t *dos_date)
+{
+	GDateTime *now;
+
+	now = g_date_time_new_now_local();
+	*dos_time = (g_date_time_get_hour(now) << 11) |
+		(g_date_time_get_minute(now) << 5) |
+		(g_date_time_get_second(now) / 2);
+	*dos_date = ((MAX(g_date_time_get_year(now), 1980) - 1980) << 9) |
+		(g_date_time_get_month(now) << 5) |
+		g_date_time_get_day_of_month(now);
+	g_date_time_unref(now);
+}
+
+/* Locate the central directory at the end of an archive file. */
+static int sessionfile_find_cd(FILE *file, uint64_t *cd_offset,
+	uint64_t *cd_size, uint64_t *entry_count)
+{
+	uint8_t *tail, rec[ZIP_LEN_EOCD64];
+	const uint8_t *eocd, *loc;
+	off_t file_size, tail_size;
+	uint64_t pos;
+	int ret;
+
+	if (fseeko(file, 0, SEEK_END) < 0)
+		return SR_ERR_IO;
+	file_size = ftello(file);
+	if (file_size < ZIP_LEN_EOCD)
+		return SR_ERR_DATA;
+
+	/* EOCD record, comment, and an optional ZIP64 locator. */
+	tail_size = MIN(file_size,
+		ZIP_LEN_EOCD64_LOC + ZIP_LEN_EOCD + G_MAXUINT16);
+	tail = g_malloc(tail_size);
+	if (fseeko(file, file_size - tail_size, SEEK_SET) < 0 ||
+			fread(tail, tail_size, 1, file) != 1) {
+		g_free(tail);
+		return SR_ERR_IO;
+	}
+	eocd = sessionfile_map_find_eocd(tail, tail_size);
+	if (!eocd) {
+		g_free(tail);
+		return SR_ERR_DATA;
+	}
+	*entry_count = read_u16le(&eocd[10]);
+	*cd_size = read_u32le(&eocd[12]);
+	*cd_offset = read_u32le(&eocd[16]);
+
+	ret = SR_OK;
+	loc = NULL;
+	if (eocd - tail >= ZIP_LEN_EOCD64_LOC)
+		loc = eocd - ZIP_LEN_EOCD64_LOC;
+	if (loc && read_u32le(loc) == ZIP_SIG_EOCD64_LOC) {
+		pos = read_u64le(&loc[8]);
+		if (pos > (uint64_t)file_size - ZIP_LEN_EOCD64 ||
+				fseeko(file, pos, SEEK_SET) < 0 ||
+				fread(rec, sizeof(rec), 1, file) != 1 ||
+				read_u32le(rec) != ZIP_SIG_EOCD64) {
+			ret = SR_ERR_DATA;
+		} else {
+			*entry_count = read_u64le(&rec[32]);
+			*cd_size = read_u64le(&rec[40]);
+			*cd_offset = read_u64le(&rec[48]);
+		}
+	}
+	g_free(tail);
+	if (ret == SR_OK && (*cd_offset > (uint64_t)file_size ||
+			*cd_size > (uint64_t)file_size - *cd_offset))
+		ret = SR_ERR_DATA;
+
+	return ret;
+}
+
+/**
+ * Append a member to a session archive, without rewriting the archive.
+ *
+ * Costs time and disk space in proportion to the appended data (and
+ * the archive's central directory). The caller must make sure that no
+ * member of the same name exists.
+ *
+ * @param[in] filename The session file's name.
+ * @param[in] name The new archive member's name.
+ * @param[in] data The new member's content.
+ * @param[in] size The content's size in bytes.
+ * @param[in] compress Whether to deflate the content.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_NA Compression is not available, use libzip instead.
+ * @retval other Error code. The archive may be damaged after I/O errors.
+ *
+ * @private
+ */
+SR_PRIV int sr_sessionfile_append(const char *filename, const char *name,
+	const uint8_t *data, size_t size, gboolean compress)
+{
+	FILE *file;
+	uint64_t cd_offset, cd_size, entry_count, new_cd_offset, new_cd_size;
+	uint64_t comp_size64, eocd64_offset;
+	uint8_t *comp_data, *cd, *wrpos, zip64_extra[28], local[ZIP_LEN_LOCAL];
+	uint8_t eocd[ZIP_LEN_EOCD64 + ZIP_LEN_EOCD64_LOC + ZIP_LEN_EOCD];
+	uint16_t dos_time, dos_date, method, version;
+	size_t comp_size, name_len, extra_len, cd_alloc;
+	uint32_t crc;
+	gboolean zip64;
+	int ret;
+
+	if (!filename || !name || (!data && size))
+		return SR_ERR_ARG;
+	name_len = strlen(name);
+	if (name_len > G_MAXUINT16)
+		return SR_ERR_ARG;
+
+	/* Prepare the member's content before touching the archive. */
+	comp_data = NULL;
+	comp_size = size;
+	method = ZIP_METHOD_STORE;
+	if (compress) {
+#ifdef HAVE_ZLIB
+		comp_data = sessionfile_deflate(data, size, &comp_size);
+		if (!comp_data)
+			return SR_ERR_NA;
+		method = ZIP_METHOD_DEFLATE;
+#else
+		return SR_ERR_NA;
+#endif
+	}
+	crc = sessionfile_crc32(0, data, size);
+	sessionfile_dos_time(&dos_time, &dos_date);
+
+	file = g_fopen(filename, "r+b");
+	if (!file) {
+		sr_err("Cannot open session file '%s': %s.",
+			filename, g_strerror(errno));
+		g_free(comp_data);
+		return SR_ERR_IO;
+	}
+	ret = sessionfile_find_cd(file, &cd_offset, &cd_size, &entry_count);
+	if (ret != SR_OK) {
+		sr_err("Cannot locate central directory of '%s'.", filename);
+		fclose(file);
+		g_free(comp_data);
+		return ret;
+	}
+
+	/* Keep the previous central directory, extend it later. */
+	cd_alloc = cd_size + ZIP_LEN_CENTRAL + name_len + sizeof(zip64_extra);
+	cd = g_try_malloc(cd_alloc);
+	if (!cd) {
+		fclose(file);
+		g_free(comp_data);
+		return SR_ERR_MALLOC;
+	}
+	if (fseeko(file, cd_offset, SEEK_SET) < 0 ||
+			(cd_size && fread(cd, cd_size, 1, file) != 1)) {
+		fclose(file);
+		g_free(cd);
+		g_free(comp_data);
+		return SR_ERR_IO;
+	}
+
+	/* ZIP64 extensions are only used when 32bit fields overflow. */
+	comp_size64 = comp_size;
+	zip64 = size >= G_MAXUINT32 || comp_size64 >= G_MAXUINT32;
+	version = zip64 ? ZIP_VERSION_ZIP64 : ZIP_VERSION_DEFAULT;
+
+	/* Local header, followed by the member's data. */
+	wrpos = local;
+	write_u32le_inc(&wrpos, ZIP_SIG_LOCAL);
+	write_u16le_inc(&wrpos, version);
+	write_u16le_inc(&wrpos, 0);
+	write_u16le_inc(&wrpos, method);
+	write_u16le_inc(&wrpos, dos_time);
+	write_u16le_inc(&wrpos, dos_date);
+	write_u32le_inc(&wrpos, crc);
+	write_u32le_inc(&wrpos, zip64 ? G_MAXUINT32 : comp_size64);
+	write_u32le_inc(&wrpos, zip64 ? G_MAXUINT32 : size);
+	write_u16le_inc(&wrpos, name_len);
+	write_u16le_inc(&wrpos, zip64 ? 20 : 0);
+	wrpos = zip64_extra;
+	write_u16le_inc(&wrpos, ZIP_EXTRA_ZIP64);
+	write_u16le_inc(&wrpos, 16);
+	write_u64le_inc(&wrpos, size);
+	write_u64le_inc(&wrpos, comp_size64);
+	ret = SR_OK;
+	if (fseeko(file, cd_offset, SEEK_SET) < 0 ||
+			fwrite(local, sizeof(local), 1, file) != 1 ||
+			fwrite(name, name_len, 1, file) != 1 ||
+			(zip64 && fwrite(zip64_extra, 20, 1, file) != 1) ||
+			(comp_size && fwrite(comp_data ? comp_data : data,
+				comp_size, 1, file) != 1))
+		ret = SR_ERR_IO;
+	g_free(comp_data);
+	new_cd_offset = cd_offset + sizeof(local) + name_len + (zip64 ? 20 : 0);
+	new_cd_offset += comp_size64;
+
+	/* Central directory record of the new member. */
+	wrpos = &cd[cd_size];
+	zip64 = zip64 || cd_offset >= G_MAXUINT32;
+	version = zip64 ? ZIP_VERSION_ZIP64 : ZIP_VERSION_DEFAULT;
+	extra_len = 0;
+	if (zip64)
+		extra_len = 4 + 3 * sizeof(uint64_t);
+	write_u32le_inc(&wrpos, ZIP_SIG_CENTRAL);
+	write_u16le_inc(&wrpos, version);
+	write_u16le_inc(&wrpos, version);
+	write_u16le_inc(&wrpos, 0);
+	write_u16le_inc(&wrpos, method);
+	write_u16le_inc(&wrpos, dos_time);
+	write_u16le_inc(&wrpos, dos_date);
+	write_u32le_inc(&wrpos, crc);
+	write_u32le_inc(&wrpos, zip64 ? G_MAXUINT32 : comp_size64);
+	write_u32le_inc(&wrpos, zip64 ? G_MAXUINT32 : size);
+	write_u16le_inc(&wrpos, name_len);
+	write_u16le_inc(&wrpos, extra_len);
+	write_u16le_inc(&wrpos, 0);
+	write_u16le_inc(&wrpos, 0);
+	write_u16le_inc(&wrpos, 0);
+	write_u32le_inc(&wrpos, 0);
+	write_u32le_inc(&wrpos, zip64 ? G_MAXUINT32 : cd_offset);
+	memcpy(wrpos, name, name_len);
+	wrpos += name_len;
+	if (zip64) {
+		write_u16le_inc(&wrpos, ZIP_EXTRA_ZIP64);
+		write_u16le_inc(&wrpos, extra_len - 4);
+		write_u64le_inc(&wrpos, size);
+		write_u64le_inc(&wrpos, comp_size64);
+		write_u64le_inc(&wrpos, cd_offset);
+	}
+	new_cd_size = wrpos - cd;
+	entry_count++;
+
+	/* End of central directory, with ZIP64 records when needed. */
+	zip64 = entry_count >= G_MAXUINT16 || new_cd_size >= G_MAXUINT32 ||
+		new_cd_offset >= G_MAXUINT32;
+	eocd64_offset = new_cd_offset + new_cd_size;
+	wrpos = eocd;
+	if (zip64) {
+		write_u32le_inc(&wrpos, ZIP_SIG_EOCD64);
+		write_u64le_inc(&wrpos, ZIP_LEN_EOCD64 - 12);
+		write_u16le_inc(&wrpos, ZIP_VERSION_ZIP64);
+		write_u16le_inc(&wrpos, ZIP_VERSION_ZIP64);
+		write_u32le_inc(&wrpos, 0);
+		write_u32le_inc(&wrpos, 0);
+		write_u64le_inc(&wrpos, entry_count);
+		write_u64le_inc(&wrpos, entry_count);
+		write_u64le_inc(&wrpos, new_cd_size);
+		write_u64le_inc(&wrpos, new_cd_offset);
+		write_u32le_inc(&wrpos, ZIP_SIG_EOCD64_LOC);
+		write_u32le_inc(&wrpos, 0);
+		write_u64le_inc(&wrpos, eocd64_offset);
+		write_u32le_inc(&wrpos, 1);
+	}
+	write_u32le_inc(&wrpos, ZIP_SIG_EOCD);
+	write_u16le_inc(&wrpos, 0);
+	write_u16le_inc(&wrpos, 0);
+	write_u16le_inc(&wrpos, zip64 ? G_MAXUINT16 : entry_count);
+	write_u16le_inc(&wrpos, zip64 ? G_MAXUINT16 : entry_count);
+	write_u32le_inc(&wrpos, zip64 ? G_MAXUINT32 : new_cd_size);
+	write_u32le_inc(&wrpos, zip64 ? G_MAXUINT32 : new_cd_offset);
+	write_u16le_inc(&wrpos, 0);
+
+	if (ret == SR_OK && (fwrite(cd, new_cd_size, 1, file) != 1 ||
+			fwrite(eocd, wrpos - eocd, 1, file) != 1 ||
+			fflush(file) != 0))
+		ret = SR_ERR_IO;
+	/* Drop what's left of a previous (longer) archive comment. */
+	if (ret == SR_OK && ftruncate(fileno(file), ftello(file)) < 0)
+		ret = SR_ERR_IO;
+	if (fclose(file) != 0)
+		ret = SR_ERR_IO;
+	g_free(cd);
+	if (ret != SR_OK)
+		sr_err("Cannot append '%s' to session file '%s'.",
+			name, filename);
+
+	return ret;
+}
+
 /** @private */
 SR_PRIV int sr_sessionfile_check(const char *filename)
 {
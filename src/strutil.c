@@ -294,6 +294,94 @@ SR_PRIV int sr_atof(const char *str, float *ret)
 	return SR_OK;
 }
 
+/*
+ * Fast path for sr_atod_ascii(): Convert plain decimal text like "-1.25"
+ * or "3.3e-6" without a library call. Only handles input where the
+ * result is exact or correctly rounded by a single multiplication or
+ * division (mantissa up to 2^53, decimal exponent up to 22). Returns
+ * FALSE for everything else, callers fall back to g_ascii_strtod().
+ */
+static gboolean atod_ascii_simple(const char *str, double *ret)
+{
+	static const double pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+		1e21, 1e22,
+	};
+	const char *p;
+	gboolean negative, exp_negative, have_digits;
+	uint64_t mantissa;
+	int digits, exponent, exp_value;
+	double value;
+
+	p = str;
+	negative = *p == '-';
+	if (*p == '-' || *p == '+')
+		p++;
+
+	mantissa = 0;
+	digits = 0;
+	exponent = 0;
+	have_digits = FALSE;
+	while (g_ascii_isdigit(*p)) {
+		have_digits = TRUE;
+		if (mantissa || *p != '0') {
+			if (++digits > 19)
+				return FALSE;
+			mantissa = mantissa * 10 + (*p - '0');
+		}
+		p++;
+	}
+	if (*p == '.') {
+		p++;
+		while (g_ascii_isdigit(*p)) {
+			have_digits = TRUE;
+			if (mantissa || *p != '0') {
+				if (++digits > 19)
+					return FALSE;
+				mantissa = mantissa * 10 + (*p - '0');
+			}
+			exponent--;
+			p++;
+		}
+	}
+	if (!have_digits)
+		return FALSE;
+	if (*p == 'e' || *p == 'E') {
+		p++;
+		exp_negative = *p == '-';
+		if (*p == '-' || *p == '+')
+			p++;
+		if (!g_ascii_isdigit(*p))
+			return FALSE;
+		exp_value = 0;
+		while (g_ascii_isdigit(*p)) {
+			if (exp_value > 1000)
+				return FALSE;
+			exp_value = exp_value * 10 + (*p - '0');
+			p++;
+		}
+		exponent += exp_negative ? -exp_value : exp_value;
+	}
+	if (*p)
+		return FALSE;
+	if (mantissa > (UINT64_C(1) << 53))
+		return FALSE;
+	if (!mantissa)
+		exponent = 0;
+	if (exponent < -22 || exponent > 22)
+		return FALSE;
+
+	value = (double)mantissa;
+	if (exponent < 0)
+		value /= pow10[-exponent];
+	else
+		value *= pow10[exponent];
+	*ret = negative ? -value : value;
+
+	return TRUE;
+}
+
 /**
  * Convert a string representation of a numeric value to a double. The
  * conversion is strict and will fail if the complete string does not represent
@@ -313,6 +401,9 @@ SR_PRIV int sr_atod_ascii(const char *str, double *ret)
 	double tmp;
 	char *endptr = NULL;
 
+	if (atod_ascii_simple(str, ret))
+		return SR_OK;
+
 	errno = 0;
 	tmp = g_ascii_strtod(str, &endptr);
 
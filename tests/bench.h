@@ -0,0 +1,103 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Resource accounting for the benchmarks. Only include this from one
+ * source file of a benchmark program, it defines the allocator entry
+ * points.
+ */
+
+#ifndef LIBSIGROK_TESTS_BENCH_H
+#define LIBSIGROK_TESTS_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __GLIBC__
+/*
+ * Count heap allocations, including the ones in libsigrok and glib,
+ * by interposing the allocator entry points. A full benchmark run
+ * easily does more than 2^32 of them.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static volatile uint64_t alloc_count;
+
+void *malloc(size_t size)
+{
+	__atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	__atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	__atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+	return __libc_realloc(ptr, size);
+}
+
+#define ALLOC_COUNT() __atomic_load_n(&alloc_count, __ATOMIC_RELAXED)
+#else
+#define ALLOC_COUNT() ((uint64_t)0)
+#endif
+
+/* Peak RSS in KiB, since the last reset_peak_rss(), or 0. */
+static long peak_rss(void)
+{
+#ifdef __linux__
+	FILE *f;
+	char line[128];
+	long kib;
+
+	kib = 0;
+	if (!(f = fopen("/proc/self/status", "r")))
+		return 0;
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "VmHWM: %ld kB", &kib) == 1)
+			break;
+	}
+	fclose(f);
+
+	return kib;
+#else
+	return 0;
+#endif
+}
+
+static void reset_peak_rss(void)
+{
+#ifdef __linux__
+	FILE *f;
+
+	if ((f = fopen("/proc/self/clear_refs", "w"))) {
+		fputs("5", f);
+		fclose(f);
+	}
+#endif
+}
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Throughput benchmark for the logic feed queue, run with "make bench".
+ *
+ * Runs of sample values are submitted one at a time, as run length
+ * encoded arrays, and as contiguous blocks. Each combination of unit
+ * size and run length is reported as one line of JSON on stdout.
+ *
+ * Usage: bench_feed_queue [-s <MiB per run>]
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define QUEUE_SIZE	(1024 * 1024)
+#define NUM_RUNS	4096
+
+enum submit_mode {
+	SUBMIT_ONE,
+	SUBMIT_RUNS,
+	SUBMIT_MANY,
+};
+
+static const char *mode_names[] = { "one", "runs", "many", };
+
+static const size_t unitsizes[] = { 1, 2, 3, 4, 8, };
+static const size_t run_lengths[] = { 1, 4, 64, 4096, 1024 * 1024, };
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	uint64_t *bytes_out;
+
+	(void)sdi;
+
+	bytes_out = cb_data;
+	if (packet->type == SR_DF_LOGIC) {
+		logic = packet->payload;
+		*bytes_out += logic->length;
+	}
+}
+
+/*
+ * Submit runs of random values until the requested amount of sample
+ * data was queued. Up to NUM_RUNS runs go in one iteration, fewer when
+ * they would exceed the total. Contiguous blocks get expanded before
+ * the timing starts, which is what callers of submit_many() do themselves.
+ */
+static double run(struct feed_queue_logic *q, enum submit_mode mode,
+	size_t unitsize, size_t run_length, uint64_t total)
+{
+	uint8_t *values, *block;
+	size_t *counts, idx, num_runs, block_count;
+	uint64_t queued;
+	gint64 start;
+	int ret;
+
+	num_runs = total / ((uint64_t)run_length * unitsize);
+	num_runs = CLAMP(num_runs, 1, NUM_RUNS);
+	values = g_malloc(num_runs * unitsize);
+	for (idx = 0; idx < num_runs * unitsize; idx++)
+		values[idx] = g_random_int();
+	counts = g_malloc_n(num_runs, sizeof(counts[0]));
+	for (idx = 0; idx < num_runs; idx++)
+		counts[idx] = run_length;
+	block = NULL;
+	block_count = MIN(num_runs * run_length, 4 * QUEUE_SIZE / unitsize);
+	if (mode == SUBMIT_MANY) {
+		block = g_malloc(block_count * unitsize);
+		for (idx = 0; idx < block_count; idx++) {
+			memcpy(&block[idx * unitsize],
+				&values[(idx / run_length) % num_runs * unitsize],
+				unitsize);
+		}
+	}
+
+	ret = SR_OK;
+	queued = 0;
+	start = g_get_monotonic_time();
+	while (ret == SR_OK && queued < total) {
+		switch (mode) {
+		case SUBMIT_ONE:
+			for (idx = 0; ret == SR_OK && idx < num_runs; idx++) {
+				ret = feed_queue_logic_submit_one(q,
+					&values[idx * unitsize], run_length);
+			}
+			queued += (uint64_t)num_runs * run_length * unitsize;
+			break;
+		case SUBMIT_RUNS:
+			ret = feed_queue_logic_submit_runs(q,
+				values, counts, num_runs);
+			queued += (uint64_t)num_runs * run_length * unitsize;
+			break;
+		case SUBMIT_MANY:
+			ret = feed_queue_logic_submit_many(q, block, block_count);
+			queued += block_count * unitsize;
+			break;
+		}
+	}
+	if (ret == SR_OK)
+		ret = feed_queue_logic_flush(q);
+
+	g_free(values);
+	g_free(counts);
+	g_free(block);
+
+	if (ret != SR_OK)
+		return -1;
+
+	return (g_get_monotonic_time() - start) / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	struct sr_context *ctx;
+	struct sr_session *session;
+	const struct sr_input *in;
+	struct sr_dev_inst *sdi;
+	struct feed_queue_logic *q;
+	GString *empty;
+	uint64_t total, bytes_out;
+	size_t unit_idx, len_idx, unitsize, run_length;
+	int mode;
+	double seconds;
+
+	total = 256 * 1024 * 1024;
+	if (argc > 2 && !strcmp(argv[1], "-s"))
+		total = g_ascii_strtoull(argv[2], NULL, 10) * 1024 * 1024;
+
+	if (sr_init(&ctx) != SR_OK) {
+		fprintf(stderr, "Cannot initialize libsigrok.\n");
+		return 1;
+	}
+	sr_log_loglevel_set(SR_LOG_WARN);
+	g_random_set_seed(1);
+
+	/*
+	 * Borrow an input's device, sr_input_free() releases it. It is
+	 * ready once the input has seen data, even none.
+	 */
+	in = sr_input_new(sr_input_find("binary"), NULL);
+	empty = g_string_new(NULL);
+	sr_input_send(in, empty);
+	g_string_free(empty, TRUE);
+	sdi = sr_input_dev_inst_get(in);
+	sr_session_new(ctx, &session);
+	sr_session_dev_add(session, sdi);
+	sr_session_datafeed_callback_add(session, datafeed_in, &bytes_out);
+
+	for (unit_idx = 0; unit_idx < G_N_ELEMENTS(unitsizes); unit_idx++) {
+		unitsize = unitsizes[unit_idx];
+		q = feed_queue_logic_alloc(sdi, QUEUE_SIZE / unitsize, unitsize);
+		for (len_idx = 0; len_idx < G_N_ELEMENTS(run_lengths); len_idx++) {
+			run_length = run_lengths[len_idx];
+			for (mode = 0; mode < (int)G_N_ELEMENTS(mode_names); mode++) {
+				bytes_out = 0;
+				seconds = run(q, mode, unitsize, run_length, total);
+				printf("{ \"submit\": \"%s\", \"unitsize\": %zu, "
+					"\"run_length\": %zu, \"ok\": %s, "
+					"\"bytes_out\": %" PRIu64 ", "
+					"\"seconds\": %.6f, \"mb_per_s\": %.2f }\n",
+					mode_names[mode], unitsize, run_length,
+					seconds >= 0 ? "true" : "false", bytes_out,
+					seconds, seconds > 0 ? bytes_out / seconds / 1e6 : 0);
+				fflush(stdout);
+			}
+		}
+		feed_queue_logic_free(q);
+	}
+
+	sr_session_destroy(session);
+	sr_input_free(in);
+	sr_exit(ctx);
+
+	return 0;
+}
@@ -0,0 +1,652 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Throughput benchmark for the input modules, run with "make bench".
+ *
+ * A large synthetic file gets generated in memory for every input
+ * module, and is then imported in chunks the way frontends read files.
+ * Each import is reported as one line of JSON on stdout, with the input
+ * and sample rates, the number of heap allocations per packet (glibc
+ * only), and the peak RSS (Linux only). With -t the results are printed
+ * as a Markdown table instead, ready to paste into a report. Modules
+ * which support parsing on several threads use as many as requested
+ * with -j.
+ *
+ * Usage: bench_input [-t] [-s <MiB per file>] [-j <threads>] [<module id>...]
+ */
+
+#include <config.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "bench.h"
+
+#define CHUNK_SIZE	(4 * 1024 * 1024)
+
+/* The ChronoVu LA8 file size is fixed: 8MiB samples and 5 bytes trailer. */
+#define LA8_DATASIZE	(8 * 1024 * 1024)
+#define LA8_HDRSIZE	5
+
+/* Layout of Sigma Test File records, see src/input/stf.c. */
+#define STF_CHUNK_SIZE	1440
+#define STF_CLUSTERS	64
+#define STF_SAMPLES	7
+#define STF_REC_CHUNKS	512
+
+struct result {
+	uint64_t bytes_in;
+	uint64_t samples;
+	uint64_t packets;
+	uint64_t allocs;
+	double seconds;
+};
+
+struct input_format {
+	const char *id;
+	const char *variant;
+	/* Fraction of the requested size, for expensive expansions. */
+	unsigned int size_divider;
+	GString *(*generate)(uint64_t size);
+	void (*options)(GHashTable *options);
+};
+
+static void append_u16le(GString *s, uint16_t value)
+{
+	g_string_append_c(s, value & 0xff);
+	g_string_append_c(s, value >> 8);
+}
+
+static void append_u32le(GString *s, uint32_t value)
+{
+	append_u16le(s, value & 0xffff);
+	append_u16le(s, value >> 16);
+}
+
+static void append_u64le(GString *s, uint64_t value)
+{
+	append_u32le(s, value & 0xffffffff);
+	append_u32le(s, value >> 32);
+}
+
+static void put_u32le(GString *s, size_t pos, uint32_t value)
+{
+	s->str[pos + 0] = value & 0xff;
+	s->str[pos + 1] = (value >> 8) & 0xff;
+	s->str[pos + 2] = (value >> 16) & 0xff;
+	s->str[pos + 3] = value >> 24;
+}
+
+static GString *random_bytes(uint64_t size)
+{
+	GString *data;
+	uint32_t value;
+	size_t i;
+
+	data = g_string_sized_new(size);
+	for (i = 0; i < size; i += sizeof(value)) {
+		value = g_random_int();
+		g_string_append_len(data, (const char *)&value,
+			MIN(sizeof(value), size - i));
+	}
+
+	return data;
+}
+
+/* 16 channels of raw logic data. */
+static GString *binary_data(uint64_t size)
+{
+	return random_bytes(size & ~(uint64_t)1);
+}
+
+static void binary_options(GHashTable *options)
+{
+	g_hash_table_insert(options, "numchannels",
+		g_variant_ref_sink(g_variant_new_int32(16)));
+}
+
+/* A timestamp, a hex logic column, and an analog column. */
+static GString *csv_data(uint64_t size)
+{
+	GString *text;
+	size_t i;
+
+	text = g_string_sized_new(size + 64);
+	for (i = 0; text->len < size; i++) {
+		g_string_append_printf(text, "%zu.0e-6,%02x,%.3f\n",
+			i + 1, g_random_int_range(0, 256),
+			g_random_double_range(-5.0, 5.0));
+	}
+
+	return text;
+}
+
+static void csv_options(GHashTable *options)
+{
+	g_hash_table_insert(options, "column_formats",
+		g_variant_ref_sink(g_variant_new_string("t,x8,a")));
+	g_hash_table_insert(options, "header",
+		g_variant_ref_sink(g_variant_new_boolean(FALSE)));
+}
+
+/* Sparse value changes of bits, vectors and reals. */
+static GString *vcd_data(uint64_t size)
+{
+	static const char *ids[] = { "!", "\"", "#", "$", };
+	GString *text;
+	uint64_t timestamp;
+	int changes;
+
+	text = g_string_sized_new(size + 256);
+	g_string_append(text, "$timescale 1 ns $end\n$scope module top $end\n"
+		"$var wire 1 ! d0 $end\n$var wire 1 \" d1 $end\n"
+		"$var wire 1 # d2 $end\n$var wire 1 $ d3 $end\n"
+		"$var wire 4 % bus $end\n$var real 1 & volt $end\n"
+		"$upscope $end\n$enddefinitions $end\n"
+		"#0\n$dumpvars\n0!\n0\"\n0#\n0$\nb0 %\nr0.5 &\n$end\n");
+	timestamp = 0;
+	while (text->len < size) {
+		timestamp += g_random_int_range(1, 20);
+		g_string_append_printf(text, "#%" PRIu64 "\n", timestamp);
+		for (changes = g_random_int_range(1, 3); changes; changes--) {
+			switch (g_random_int_range(0, 4)) {
+			case 0:
+				g_string_append_printf(text, "b%d%d %%\n",
+					g_random_int_range(0, 2),
+					g_random_int_range(0, 2));
+				break;
+			case 1:
+				g_string_append_printf(text, "r%.3f &\n",
+					g_random_double_range(-5.0, 5.0));
+				break;
+			default:
+				g_string_append_printf(text, "%d%s\n",
+					g_random_int_range(0, 2),
+					ids[g_random_int_range(0, G_N_ELEMENTS(ids))]);
+				break;
+			}
+		}
+	}
+
+	return text;
+}
+
+/* Stereo 16bit PCM, a sine on either channel. */
+static GString *wav_data(uint64_t size)
+{
+	GString *data;
+	uint32_t frames, i;
+
+	frames = MIN(size, UINT32_MAX - 64) / 4;
+	data = g_string_sized_new(44 + frames * 4);
+	g_string_append_len(data, "RIFF", 4);
+	append_u32le(data, 36 + frames * 4);
+	g_string_append_len(data, "WAVEfmt ", 8);
+	append_u32le(data, 16);
+	append_u16le(data, 1);
+	append_u16le(data, 2);
+	append_u32le(data, 48000);
+	append_u32le(data, 48000 * 4);
+	append_u16le(data, 4);
+	append_u16le(data, 16);
+	g_string_append_len(data, "data", 4);
+	append_u32le(data, frames * 4);
+	for (i = 0; i < frames; i++) {
+		append_u16le(data, (int16_t)(sinf(i * 0.01) * 30000));
+		append_u16le(data, (int16_t)(sinf(i * 0.003) * 30000));
+	}
+
+	return data;
+}
+
+/* Four channels of interleaved 16bit values. */
+static GString *raw_analog_data(uint64_t size)
+{
+	return random_bytes(size & ~(uint64_t)7);
+}
+
+static void raw_analog_options(GHashTable *options)
+{
+	g_hash_table_insert(options, "numchannels",
+		g_variant_ref_sink(g_variant_new_int32(4)));
+	g_hash_table_insert(options, "format",
+		g_variant_ref_sink(g_variant_new_string("S16_LE (-1..1)")));
+}
+
+/*
+ * An iprobe capture with the version 1 binary header, and records of
+ * a 64bit timestamp, 16 data bits and the clock. The timestamps are
+ * apart by one to four samples at the default samplerate. A practice
+ * script trailer ends the file, which is longer than a record so that
+ * the last record gets processed.
+ */
+static GString *trace32_ad_data(uint64_t size)
+{
+	GString *data;
+	uint64_t timestamp;
+	uint32_t count, i;
+
+	count = MIN((size - 0x50) / 11, INT32_MAX);
+	data = g_string_sized_new(0x50 + count * 11 + 16);
+	g_string_append(data, "trace32 iprobe data");
+	while (data->len < 0x50)
+		g_string_append_c(data, '\0');
+	data->str[0x36] = 0x0a;
+	data->str[0x38] = 11;
+	put_u32le(data, 0x3c, count);
+	put_u32le(data, 0x40, count - 1);
+	timestamp = 0;
+	for (i = 0; i < count; i++) {
+		append_u64le(data, timestamp);
+		append_u16le(data, g_random_int());
+		g_string_append_c(data, i & 1);
+		timestamp += 64 * g_random_int_range(1, 5);
+	}
+	g_string_append(data, "(B::\n ENDDO\n)");
+
+	return data;
+}
+
+/* 8MiB of 8 channel samples, the size is fixed by the format. */
+static GString *chronovu_la8_data(uint64_t size)
+{
+	GString *data;
+
+	(void)size;
+
+	data = random_bytes(LA8_DATASIZE);
+	g_string_append_len(data, "\x00\x00\x00\x00\x00", LA8_HDRSIZE);
+
+	return data;
+}
+
+/* LogicPort text with 16 wires, short runs of repeated samples. */
+static GString *logicport_data(uint64_t size)
+{
+	GString *text, *lines;
+	size_t count, wire;
+	uint32_t bits;
+
+	lines = g_string_sized_new(size);
+	for (count = 0; lines->len < size; count++) {
+		g_string_append_c(lines, ' ');
+		bits = g_random_int();
+		for (wire = 0; wire < 16; wire++) {
+			g_string_append_c(lines, bits & 1 ? '1' : '0');
+			g_string_append_c(lines, ',');
+			bits >>= 1;
+		}
+		g_string_append_printf(lines, "%d\r\n", g_random_int_range(1, 9));
+	}
+
+	text = g_string_sized_new(lines->len + 1024);
+	g_string_append(text, "Version\x11" "1.0\x11" "100\x11"
+		" CAUTION: Do not change the contents of this file.\r\n"
+		"AcquiredSamplePeriod\x11" "1e-08\r\n");
+	g_string_append_printf(text, "SampleData\x11" "16\x11%zu\r\n{\r\n ", count);
+	for (wire = 0; wire < 16; wire++)
+		g_string_append_printf(text, "D%zu,", wire);
+	g_string_append(text, "Count\r\n");
+	g_string_append_len(text, lines->str, lines->len);
+	g_string_append(text, "}\r\nAcquiredChannelList");
+	for (wire = 0; wire < 16; wire++)
+		g_string_append(text, "\x11True");
+	g_string_append(text, "\r\nNotesString/\x11\x11/\r\n");
+	g_string_free(lines, TRUE);
+
+	return text;
+}
+
+/* The CRC-32 which zlib's crc32() computes. */
+static uint32_t crc32_calc(const uint8_t *data, size_t len)
+{
+	static uint32_t table[256];
+	uint32_t crc;
+	size_t i;
+	int bit;
+
+	if (!table[1]) {
+		for (i = 0; i < 256; i++) {
+			crc = i;
+			for (bit = 0; bit < 8; bit++)
+				crc = (crc >> 1) ^ (crc & 1 ? 0xedb88320 : 0);
+			table[i] = crc;
+		}
+	}
+	crc = 0xffffffff;
+	for (i = 0; i < len; i++)
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+	return crc ^ 0xffffffff;
+}
+
+/*
+ * Wrap a record's payload in an LZO1X stream which consists of one
+ * literal run and the end of stream marker. The parser's cost is in
+ * the decompressed data, the compression ratio doesn't matter here.
+ */
+static void stf_append_record(GString *data, const GString *raw)
+{
+	size_t start, count;
+
+	start = data->len;
+	append_u32le(data, 0);
+	append_u32le(data, 0);
+	count = raw->len - 3;
+	if (count <= 15) {
+		g_string_append_c(data, count);
+	} else {
+		g_string_append_c(data, 0);
+		for (count -= 15; count > 255; count -= 255)
+			g_string_append_c(data, 0);
+		g_string_append_c(data, count);
+	}
+	g_string_append_len(data, raw->str, raw->len);
+	g_string_append_len(data, "\x11\x00\x00", 3);
+	put_u32le(data, start, data->len - start - 8);
+	put_u32le(data, start + 4, crc32_calc((const uint8_t *)
+		&data->str[start + 8], data->len - start - 8));
+}
+
+/*
+ * Sigma Test File, 16 inputs at 50MHz. Records hold chunks of clusters
+ * with a timestamp and seven samples each, which get stored as all
+ * chunk infos, then all timestamps, then all sample values.
+ */
+static GString *stf_data(uint64_t size)
+{
+	GString *data, *infos, *stamps, *samples;
+	uint64_t chunks, chunk, timestamp;
+	size_t cluster, sample, in_rec;
+
+	chunks = MAX(size / STF_CHUNK_SIZE, 1);
+	data = g_string_sized_new(size + 4096);
+	g_string_append_len(data, "Sigma Test File", 16);
+	g_string_append_printf(data, "TestFirstTS=0\r\n"
+		"TestLengthTS=%" PRIu64 "\r\n"
+		"Sigma.ClockSource=ClockScheme=0;Period=1\r\n"
+		"Sigma.SigmaInputs=1;2;3;4;5;6;7;8;9;10;11;12;13;14;15;16\r\n"
+		"Traces.Traces=", chunks * STF_CLUSTERS * STF_SAMPLES - 1);
+	for (sample = 0; sample < 16; sample++) {
+		g_string_append_printf(data, "%sType=Input:Caption=D%zu:Input0=%zu",
+			sample ? ";" : "", sample, sample);
+	}
+	g_string_append(data, "\r\n");
+	g_string_append_c(data, '\0');
+
+	infos = g_string_new(NULL);
+	stamps = g_string_new(NULL);
+	samples = g_string_new(NULL);
+	timestamp = 0;
+	for (chunk = 0; chunk < chunks; chunk++) {
+		in_rec = chunk % STF_REC_CHUNKS;
+		append_u32le(infos, 0);
+		append_u32le(infos, in_rec);
+		append_u64le(infos, timestamp);
+		append_u64le(infos, timestamp + STF_CLUSTERS * STF_SAMPLES - 1);
+		append_u64le(infos, STF_CLUSTERS * STF_SAMPLES);
+		for (cluster = 0; cluster < STF_CLUSTERS; cluster++) {
+			append_u64le(stamps, timestamp);
+			for (sample = 0; sample < STF_SAMPLES; sample++)
+				append_u16le(samples, g_random_int());
+			timestamp += STF_SAMPLES;
+		}
+		if (in_rec == STF_REC_CHUNKS - 1 || chunk == chunks - 1) {
+			g_string_append_len(infos, stamps->str, stamps->len);
+			g_string_append_len(infos, samples->str, samples->len);
+			stf_append_record(data, infos);
+			g_string_truncate(infos, 0);
+			g_string_truncate(stamps, 0);
+			g_string_truncate(samples, 0);
+		}
+	}
+	append_u32le(data, 0xffffffff);
+	append_u32le(data, 0);
+	g_string_free(infos, TRUE);
+	g_string_free(stamps, TRUE);
+	g_string_free(samples, TRUE);
+
+	return data;
+}
+
+/* Raw data bytes, each of which becomes a UART frame. */
+static GString *protocoldata_data(uint64_t size)
+{
+	return random_bytes(size);
+}
+
+static void protocoldata_options(GHashTable *options)
+{
+	g_hash_table_insert(options, "protocol",
+		g_variant_ref_sink(g_variant_new_string("uart")));
+}
+
+static const struct input_format formats[] = {
+	{ "binary", "logic16", 1, binary_data, binary_options, },
+	{ "csv", "t,x8,a", 1, csv_data, csv_options, },
+	{ "vcd", "sparse", 1, vcd_data, NULL, },
+	{ "wav", "pcm16-x2", 1, wav_data, NULL, },
+	{ "raw_analog", "s16-x4", 1, raw_analog_data, raw_analog_options, },
+	{ "trace32_ad", "iprobe", 1, trace32_ad_data, NULL, },
+	/* The line parser erases every line from the front of the buffer. */
+	{ "logicport", "logic16", 64, logicport_data, NULL, },
+	{ "chronovu-la8", "logic8", 1, chronovu_la8_data, NULL, },
+	{ "stf", "sigma-50mhz", 1, stf_data, NULL, },
+	{ "protocoldata", "uart-bytes", 64, protocoldata_data, protocoldata_options, },
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_analog *analog;
+	struct result *res;
+
+	(void)sdi;
+
+	res = cb_data;
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		if (logic->unitsize)
+			res->samples += logic->length / logic->unitsize;
+		res->packets++;
+		break;
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		res->samples += analog->num_samples;
+		res->packets++;
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Create the input, and send the file content in chunks. The time for
+ * the module's setup and its end of input processing is included.
+ */
+static gboolean run(struct sr_context *ctx, const struct input_format *format,
+		const GString *data, unsigned int threads, struct result *res,
+		unsigned int *threads_used)
+{
+	const struct sr_input *in;
+	struct sr_session *session;
+	GHashTable *options;
+	GString *chunk;
+	gint64 start;
+	uint64_t allocs;
+	size_t pos, len;
+	gboolean ok, added;
+
+	memset(res, 0, sizeof(*res));
+	*threads_used = 1;
+
+	options = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify)g_variant_unref);
+	if (format->options)
+		format->options(options);
+	chunk = g_string_sized_new(CHUNK_SIZE);
+	sr_session_new(ctx, &session);
+	sr_session_datafeed_callback_add(session, datafeed_in, res);
+
+	start = g_get_monotonic_time();
+	allocs = ALLOC_COUNT();
+	in = sr_input_new(sr_input_find(format->id), options);
+	ok = in != NULL;
+	if (ok && threads > 1 && sr_input_threads_set(in, threads) == SR_OK)
+		*threads_used = threads;
+	added = FALSE;
+	for (pos = 0; ok && pos < data->len; pos += len) {
+		len = MIN(data->len - pos, CHUNK_SIZE);
+		g_string_truncate(chunk, 0);
+		g_string_append_len(chunk, &data->str[pos], len);
+		ok = sr_input_send(in, chunk) == SR_OK;
+		res->bytes_in += len;
+		/* The device is ready before the module sends packets. */
+		if (ok && !added && sr_input_dev_inst_get(in)) {
+			ok = sr_session_dev_add(session,
+				sr_input_dev_inst_get(in)) == SR_OK;
+			added = TRUE;
+		}
+	}
+	ok = ok && sr_input_end(in) == SR_OK;
+	sr_input_free(in);
+	res->allocs = ALLOC_COUNT() - allocs;
+	res->seconds = (g_get_monotonic_time() - start) / 1e6;
+
+	sr_session_destroy(session);
+	g_string_free(chunk, TRUE);
+	g_hash_table_destroy(options);
+
+	return ok && res->samples;
+}
+
+static void report_row(const struct input_format *format,
+		unsigned int threads, gboolean ok, const struct result *res)
+{
+	printf("| %s | %s | %u | %s | %.1f | %.2f | %.2f | %.1f | %.1f |\n",
+		format->id, format->variant, threads, ok ? "ok" : "FAIL",
+		res->bytes_in / 1048576.0,
+		res->seconds > 0 ? res->bytes_in / res->seconds / 1e6 : 0,
+		res->seconds > 0 ? res->samples / res->seconds / 1e6 : 0,
+		res->packets ? (double)res->allocs / res->packets : 0,
+		peak_rss() / 1024.0);
+	fflush(stdout);
+}
+
+static void report(const struct input_format *format, unsigned int threads,
+		gboolean ok, const struct result *res)
+{
+	printf("{ \"module\": \"%s\", \"data\": \"%s\", \"threads\": %u, "
+		"\"ok\": %s, \"bytes_in\": %" PRIu64 ", "
+		"\"samples\": %" PRIu64 ", \"packets\": %" PRIu64 ", "
+		"\"seconds\": %.6f, \"mb_per_s\": %.2f, "
+		"\"msamples_per_s\": %.2f, \"allocs\": %" PRIu64 ", "
+		"\"allocs_per_packet\": %.2f, \"peak_rss_kib\": %ld }\n",
+		format->id, format->variant, threads, ok ? "true" : "false",
+		res->bytes_in, res->samples, res->packets, res->seconds,
+		res->seconds > 0 ? res->bytes_in / res->seconds / 1e6 : 0,
+		res->seconds > 0 ? res->samples / res->seconds / 1e6 : 0,
+		res->allocs,
+		res->packets ? (double)res->allocs / res->packets : 0,
+		peak_rss());
+	fflush(stdout);
+}
+
+static int usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-t] [-s <MiB per file>] [-j <threads>] "
+		"[<module id>...]\n", name);
+
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	const struct input_format *format;
+	struct sr_context *ctx;
+	struct result res;
+	GString *data;
+	uint64_t total;
+	unsigned int threads, threads_used;
+	size_t n;
+	int i, first;
+	gboolean ok, table;
+
+	total = 64 * 1024 * 1024;
+	threads = 1;
+	table = FALSE;
+	for (first = 1; first < argc && argv[first][0] == '-'; first++) {
+		if (!strcmp(argv[first], "-t")) {
+			table = TRUE;
+			continue;
+		}
+		if (first + 1 == argc)
+			return usage(argv[0]);
+		if (!strcmp(argv[first], "-s"))
+			total = g_ascii_strtoull(argv[++first], NULL, 10) * 1024 * 1024;
+		else if (!strcmp(argv[first], "-j"))
+			threads = g_ascii_strtoull(argv[++first], NULL, 10);
+		else
+			return usage(argv[0]);
+	}
+
+	if (sr_init(&ctx) != SR_OK) {
+		fprintf(stderr, "Cannot initialize libsigrok.\n");
+		return 1;
+	}
+	sr_log_loglevel_set(SR_LOG_WARN);
+	g_random_set_seed(1);
+	if (table) {
+		printf("| Module | Data | Threads | Result | MiB | MB/s | "
+			"MSamples/s | Allocs/packet | Peak RSS MiB |\n");
+		printf("|---|---|---:|---|---:|---:|---:|---:|---:|\n");
+	}
+
+	for (n = 0; n < G_N_ELEMENTS(formats); n++) {
+		format = &formats[n];
+		if (first < argc) {
+			for (i = first; i < argc; i++) {
+				if (!strcmp(argv[i], format->id))
+					break;
+			}
+			if (i == argc)
+				continue;
+		}
+		/* Modules can be disabled at build time. */
+		if (!sr_input_find(format->id))
+			continue;
+		data = format->generate(total / format->size_divider);
+		reset_peak_rss();
+		ok = run(ctx, format, data, threads, &res, &threads_used);
+		if (table)
+			report_row(format, threads_used, ok, &res);
+		else
+			report(format, threads_used, ok, &res);
+		g_string_free(data, TRUE);
+	}
+
+	sr_exit(ctx);
+
+	return 0;
+}
@@ -0,0 +1,356 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Throughput benchmark for the output modules, run with "make bench".
+ *
+ * Synthetic logic and analog packets get fed through every output
+ * module. Each run is reported as one line of JSON on stdout, with
+ * the input rate, the number of heap allocations per packet (glibc
+ * only), and the peak RSS (Linux only).
+ *
+ * Usage: bench_output [-s <MiB per run>] [<module id>...]
+ */
+
+#include <config.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <libsigrok/libsigrok.h>
+#include "bench.h"
+
+#define SAMPLERATE	SR_MHZ(100)
+#define LOGIC_PACKET	(64 * 1024)
+#define ANALOG_PACKET	4096
+
+enum activity {
+	ACTIVITY_STATIC,
+	ACTIVITY_SPARSE,
+	ACTIVITY_DENSE,
+};
+
+static const char *activity_names[] = { "static", "sparse", "dense", };
+
+static const size_t logic_unitsizes[] = { 1, 2, 4, 8, };
+
+struct analog_format {
+	const char *name;
+	int unitsize;
+	gboolean is_signed;
+	gboolean is_float;
+	int num_channels;
+};
+
+static const struct analog_format analog_formats[] = {
+	{ "float", 4, TRUE, TRUE, 1, },
+	{ "float-x4", 4, TRUE, TRUE, 4, },
+	{ "int16", 2, TRUE, FALSE, 1, },
+	{ "uint8-x2", 1, FALSE, FALSE, 2, },
+};
+
+struct result {
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	uint64_t packets;
+	uint64_t allocs;
+	double seconds;
+};
+
+static uint8_t *logic_data(size_t unitsize, size_t count, enum activity activity)
+{
+	uint8_t *data, *sample;
+	size_t i, bit;
+
+	data = g_malloc0(unitsize * count);
+	sample = g_malloc0(unitsize);
+	for (i = 0; i < count; i++) {
+		if (activity == ACTIVITY_DENSE) {
+			for (bit = 0; bit < unitsize; bit++)
+				sample[bit] = g_random_int();
+		} else if (activity == ACTIVITY_SPARSE && !g_random_int_range(0, 1000)) {
+			bit = g_random_int_range(0, 8 * unitsize);
+			sample[bit / 8] ^= 1 << (bit % 8);
+		}
+		memcpy(&data[i * unitsize], sample, unitsize);
+	}
+	g_free(sample);
+
+	return data;
+}
+
+static uint8_t *analog_data(const struct analog_format *format, size_t count)
+{
+	uint8_t *data;
+	float value;
+	size_t i;
+
+	data = g_malloc(format->unitsize * format->num_channels * count);
+	for (i = 0; i < count * format->num_channels; i++) {
+		value = sinf(i * 0.001) * 0.9;
+		if (format->is_float) {
+			memcpy(&data[i * 4], &value, 4);
+		} else if (format->unitsize == 2) {
+			data[i * 2] = (int16_t)(value * 32767) & 0xff;
+			data[i * 2 + 1] = (int16_t)(value * 32767) >> 8;
+		} else {
+			data[i] = 128 + value * 127;
+		}
+	}
+
+	return data;
+}
+
+static gboolean send_packet(const struct sr_output *o, int type,
+		const void *payload, struct result *res)
+{
+	struct sr_datafeed_packet packet;
+	GString *text;
+
+	packet.type = type;
+	packet.payload = payload;
+	if (sr_output_send(o, &packet, &text) != SR_OK)
+		return FALSE;
+	if (text) {
+		res->bytes_out += text->len;
+		g_string_free(text, TRUE);
+	}
+
+	return TRUE;
+}
+
+/*
+ * Feed a header, the samplerate, and then the same data packet until
+ * the requested amount of input was sent.
+ */
+static gboolean run(const struct sr_output_module *omod,
+		struct sr_dev_inst *sdi, int type, const void *payload,
+		size_t packet_bytes, uint64_t total, struct result *res)
+{
+	const struct sr_output *o;
+	struct sr_datafeed_header header;
+	struct sr_datafeed_meta meta;
+	struct sr_config src;
+	char *filename;
+	gint64 start;
+	uint64_t allocs;
+	gboolean ok;
+	int fd;
+
+	memset(res, 0, sizeof(*res));
+
+	/* Modules which write their own files need a name. */
+	filename = NULL;
+	if ((fd = g_file_open_tmp("sigrok-bench-XXXXXX", &filename, NULL)) >= 0)
+		g_close(fd, NULL);
+	o = sr_output_new(omod, NULL, sdi, filename);
+	if (!o) {
+		if (filename)
+			g_unlink(filename);
+		g_free(filename);
+		return FALSE;
+	}
+
+	header.feed_version = 1;
+	gettimeofday(&header.starttime, NULL);
+	src.key = SR_CONF_SAMPLERATE;
+	src.data = g_variant_new_uint64(SAMPLERATE);
+	meta.config = g_slist_append(NULL, &src);
+
+	ok = send_packet(o, SR_DF_HEADER, &header, res);
+	ok = ok && send_packet(o, SR_DF_META, &meta, res);
+
+	start = g_get_monotonic_time();
+	allocs = ALLOC_COUNT();
+	while (ok && res->bytes_in < total) {
+		ok = send_packet(o, type, payload, res);
+		res->bytes_in += packet_bytes;
+		res->packets++;
+	}
+	ok = ok && send_packet(o, SR_DF_END, NULL, res);
+	res->allocs = ALLOC_COUNT() - allocs;
+	res->seconds = (g_get_monotonic_time() - start) / 1e6;
+
+	sr_output_free(o);
+	g_slist_free(meta.config);
+	g_variant_unref(src.data);
+	if (filename)
+		g_unlink(filename);
+	g_free(filename);
+
+	return ok;
+}
+
+static void report(const char *module, const char *kind, const char *format,
+		const char *activity, gboolean ok, const struct result *res)
+{
+	printf("{ \"module\": \"%s\", \"data\": \"%s\", \"format\": \"%s\", "
+		"\"activity\": \"%s\", \"ok\": %s, \"bytes_in\": %" PRIu64 ", "
+		"\"bytes_out\": %" PRIu64 ", \"packets\": %" PRIu64 ", "
+		"\"seconds\": %.6f, \"mb_per_s\": %.2f, "
+		"\"allocs_per_packet\": %.2f, \"peak_rss_kib\": %ld }\n",
+		module, kind, format, activity, ok ? "true" : "false",
+		res->bytes_in, res->bytes_out, res->packets, res->seconds,
+		res->seconds > 0 ? res->bytes_in / res->seconds / 1e6 : 0,
+		res->packets ? (double)res->allocs / res->packets : 0,
+		peak_rss());
+	fflush(stdout);
+}
+
+static void bench_logic(const struct sr_output_module *omod,
+		struct sr_dev_inst **sdis, uint64_t total)
+{
+	struct sr_datafeed_logic logic;
+	struct result res;
+	char format[16];
+	size_t i;
+	int activity;
+	gboolean ok;
+
+	for (i = 0; i < G_N_ELEMENTS(logic_unitsizes); i++) {
+		snprintf(format, sizeof(format), "unitsize%zu", logic_unitsizes[i]);
+		for (activity = 0; activity < (int)G_N_ELEMENTS(activity_names); activity++) {
+			logic.unitsize = logic_unitsizes[i];
+			logic.length = LOGIC_PACKET * logic.unitsize;
+			logic.data = logic_data(logic.unitsize, LOGIC_PACKET, activity);
+			reset_peak_rss();
+			ok = run(omod, sdis[i], SR_DF_LOGIC, &logic, logic.length,
+				total, &res);
+			report(sr_output_id_get(omod), "logic", format,
+				activity_names[activity], ok, &res);
+			g_free(logic.data);
+		}
+	}
+}
+
+static void bench_analog(const struct sr_output_module *omod,
+		struct sr_dev_inst **sdis, uint64_t total)
+{
+	const struct analog_format *format;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	struct result res;
+	size_t i;
+	gboolean ok;
+
+	for (i = 0; i < G_N_ELEMENTS(analog_formats); i++) {
+		format = &analog_formats[i];
+		memset(&encoding, 0, sizeof(encoding));
+		encoding.unitsize = format->unitsize;
+		encoding.is_signed = format->is_signed;
+		encoding.is_float = format->is_float;
+		encoding.digits = 4;
+		encoding.is_digits_decimal = TRUE;
+		encoding.scale.p = 1;
+		encoding.scale.q = format->is_float ? 1 : 1000;
+		encoding.offset.p = 0;
+		encoding.offset.q = 1;
+		memset(&meaning, 0, sizeof(meaning));
+		meaning.mq = SR_MQ_VOLTAGE;
+		meaning.unit = SR_UNIT_VOLT;
+		meaning.channels = sr_dev_inst_channels_get(sdis[i]);
+		memset(&spec, 0, sizeof(spec));
+		spec.spec_digits = 4;
+
+		analog.data = analog_data(format, ANALOG_PACKET);
+		analog.num_samples = ANALOG_PACKET;
+		analog.encoding = &encoding;
+		analog.meaning = &meaning;
+		analog.spec = &spec;
+		reset_peak_rss();
+		ok = run(omod, sdis[i], SR_DF_ANALOG, &analog,
+			ANALOG_PACKET * format->unitsize * format->num_channels,
+			total, &res);
+		report(sr_output_id_get(omod), "analog", format->name, "sine",
+			ok, &res);
+		g_free(analog.data);
+	}
+}
+
+static struct sr_dev_inst *dev_new(const char *model, int type,
+		const char *prefix, size_t num_channels)
+{
+	struct sr_dev_inst *sdi;
+	char name[16];
+	size_t i;
+
+	sdi = sr_dev_inst_user_new("Bench", model, NULL);
+	for (i = 0; i < num_channels; i++) {
+		snprintf(name, sizeof(name), "%s%zu", prefix, i);
+		sr_dev_inst_channel_add(sdi, i, type, name);
+	}
+
+	return sdi;
+}
+
+int main(int argc, char **argv)
+{
+	const struct sr_output_module **omods, *omod;
+	struct sr_context *ctx;
+	struct sr_dev_inst *logic_sdis[G_N_ELEMENTS(logic_unitsizes)];
+	struct sr_dev_inst *analog_sdis[G_N_ELEMENTS(analog_formats)];
+	uint64_t total;
+	size_t n;
+	int i, first;
+
+	total = 64 * 1024 * 1024;
+	first = 1;
+	if (argc > 2 && !strcmp(argv[1], "-s")) {
+		total = g_ascii_strtoull(argv[2], NULL, 10) * 1024 * 1024;
+		first = 3;
+	}
+
+	if (sr_init(&ctx) != SR_OK) {
+		fprintf(stderr, "Cannot initialize libsigrok.\n");
+		return 1;
+	}
+	sr_log_loglevel_set(SR_LOG_WARN);
+	g_random_set_seed(1);
+
+	for (n = 0; n < G_N_ELEMENTS(logic_unitsizes); n++)
+		logic_sdis[n] = dev_new("Logic", SR_CHANNEL_LOGIC, "D",
+			8 * logic_unitsizes[n]);
+	for (n = 0; n < G_N_ELEMENTS(analog_formats); n++)
+		analog_sdis[n] = dev_new("Analog", SR_CHANNEL_ANALOG, "A",
+			analog_formats[n].num_channels);
+
+	omods = sr_output_list();
+	for (; *omods; omods++) {
+		omod = *omods;
+		if (first < argc) {
+			for (i = first; i < argc; i++) {
+				if (!strcmp(argv[i], sr_output_id_get(omod)))
+					break;
+			}
+			if (i == argc)
+				continue;
+		}
+		bench_logic(omod, logic_sdis, total);
+		bench_analog(omod, analog_sdis, total / 4);
+	}
+
+	sr_exit(ctx);
+
+	return 0;
+}
@@ -0,0 +1,427 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "lib.h"
+
+/* Samples per packet, runs below cross several of these boundaries. */
+#define QUEUE_SIZE 100
+
+/* Sets of analog values, submitted in blocks of the sizes below. */
+#define NUM_SETS 1000
+
+#ifdef WORDS_BIGENDIAN
+#define HOST_BIGENDIAN TRUE
+#else
+#define HOST_BIGENDIAN FALSE
+#endif
+
+/*
+ * Run lengths: empty runs, runs which end at, or just before or after
+ * the flush boundary, runs longer than the queue, and runs which are
+ * long enough to take the memset() path.
+ */
+static const size_t counts[] = {
+	0, 1, 99, 2, 100, 64, 0, 250, 3, 63, 65, 1000, 0, 7, 97, 300,
+};
+
+/* Analog encodings, and the number of channels with interleaved values. */
+static const struct analog_format {
+	size_t unitsize;
+	gboolean is_signed;
+	gboolean is_float;
+	gboolean is_bigendian;
+	size_t num_channels;
+} analog_formats[] = {
+	{ 4, TRUE, TRUE, HOST_BIGENDIAN, 1, },
+	{ 4, TRUE, TRUE, !HOST_BIGENDIAN, 1, },
+	{ 4, TRUE, TRUE, HOST_BIGENDIAN, 3, },
+	{ 8, TRUE, TRUE, FALSE, 2, },
+	{ 1, FALSE, FALSE, FALSE, 1, },
+	{ 1, TRUE, FALSE, FALSE, 2, },
+	{ 2, TRUE, FALSE, FALSE, 2, },
+	{ 2, FALSE, FALSE, TRUE, 1, },
+	{ 4, TRUE, FALSE, TRUE, 3, },
+};
+
+/* Block sizes for feed_queue_analog_submit_many(), used in turn. */
+static const size_t block_sizes[] = { 1, 99, 100, 0, 37, 250, 13, };
+
+struct collected {
+	GString *logic;
+	GString *analog;
+	size_t packets;
+	size_t unitsize;
+	gboolean bad_length;
+	const struct analog_format *format;
+	gboolean bad_encoding;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	struct collected *c;
+
+	(void)sdi;
+
+	c = cb_data;
+	if (packet->type != SR_DF_LOGIC)
+		return;
+	logic = packet->payload;
+
+	/* All but the last packet are full. */
+	if (c->logic->len % (QUEUE_SIZE * c->unitsize))
+		c->bad_length = TRUE;
+	if (logic->unitsize != c->unitsize || !logic->length ||
+			logic->length > QUEUE_SIZE * c->unitsize)
+		c->bad_length = TRUE;
+	g_string_append_len(c->logic, logic->data, logic->length);
+	c->packets++;
+}
+
+static void datafeed_analog_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_analog *analog;
+	const struct analog_format *f;
+	struct collected *c;
+	size_t set_size;
+
+	(void)sdi;
+
+	c = cb_data;
+	if (packet->type != SR_DF_ANALOG)
+		return;
+	analog = packet->payload;
+	f = c->format;
+	set_size = f->unitsize * f->num_channels;
+
+	/* All but the last packet are full. */
+	if (c->analog->len % (QUEUE_SIZE * set_size))
+		c->bad_length = TRUE;
+	if (!analog->num_samples || analog->num_samples > QUEUE_SIZE)
+		c->bad_length = TRUE;
+	if (analog->encoding->unitsize != f->unitsize ||
+			analog->encoding->is_signed != f->is_signed ||
+			analog->encoding->is_float != f->is_float ||
+			analog->encoding->is_bigendian != f->is_bigendian ||
+			analog->encoding->scale.p != 1 ||
+			analog->encoding->scale.q != 1000 ||
+			g_slist_length(analog->meaning->channels) != f->num_channels)
+		c->bad_encoding = TRUE;
+	g_string_append_len(c->analog, analog->data,
+		analog->num_samples * set_size);
+	c->packets++;
+}
+
+/*
+ * The queues send packets for a device. Borrow one from an input
+ * instance, which takes care of releasing it. The binary input has
+ * its device ready once it has seen data, even none.
+ */
+static const struct sr_input *queue_input(struct sr_dev_inst **sdi)
+{
+	const struct sr_input *in;
+	GString *buf;
+	int ret;
+
+	in = sr_input_new(sr_input_find("binary"), NULL);
+	fail_unless(in != NULL, "Couldn't create 'binary' input.");
+	buf = g_string_new(NULL);
+	ret = sr_input_send(in, buf);
+	g_string_free(buf, TRUE);
+	fail_unless(ret == SR_OK, "sr_input_send() error: %d", ret);
+	*sdi = sr_input_dev_inst_get(in);
+	fail_unless(*sdi != NULL, "No device from the 'binary' input.");
+
+	return in;
+}
+
+/*
+ * Values for the runs. Every third value has equal bytes, like idle
+ * levels have.
+ */
+static uint8_t *run_values(size_t unitsize)
+{
+	uint8_t *values;
+	size_t i, j;
+
+	values = g_malloc(ARRAY_SIZE(counts) * unitsize);
+	for (i = 0; i < ARRAY_SIZE(counts); i++) {
+		for (j = 0; j < unitsize; j++)
+			values[i * unitsize + j] = g_random_int_range(0, 256);
+		if (!(i % 3))
+			memset(&values[i * unitsize], values[i * unitsize],
+				unitsize);
+	}
+
+	return values;
+}
+
+/* Expand the runs one sample at a time. */
+static GString *expand_runs(const uint8_t *values, size_t unitsize)
+{
+	GString *expected;
+	size_t i, n;
+
+	expected = g_string_new(NULL);
+	for (i = 0; i < ARRAY_SIZE(counts); i++) {
+		for (n = 0; n < counts[i]; n++)
+			g_string_append_len(expected,
+				(const char *)&values[i * unitsize], unitsize);
+	}
+
+	return expected;
+}
+
+/*
+ * Submit the runs through a queue. 'split' runs go in one call to
+ * feed_queue_logic_submit_runs(), the others one at a time.
+ */
+static void queue_runs(const uint8_t *values, size_t unitsize, size_t split,
+	struct collected *c)
+{
+	struct sr_session *session;
+	const struct sr_input *in;
+	struct sr_dev_inst *sdi;
+	struct feed_queue_logic *q;
+	size_t i;
+	int ret;
+
+	memset(c, 0, sizeof(*c));
+	c->logic = g_string_new(NULL);
+	c->unitsize = unitsize;
+	in = queue_input(&sdi);
+	sr_session_new(srtest_ctx, &session);
+	sr_session_datafeed_callback_add(session, datafeed_in, c);
+	sr_session_dev_add(session, sdi);
+
+	q = feed_queue_logic_alloc(sdi, QUEUE_SIZE, unitsize);
+	fail_unless(q != NULL, "feed_queue_logic_alloc() failed.");
+	ret = feed_queue_logic_submit_runs(q, values, counts, split);
+	fail_unless(ret == SR_OK, "Submitting runs failed.");
+	for (i = split; i < ARRAY_SIZE(counts); i++) {
+		ret = feed_queue_logic_submit_one(q, &values[i * unitsize],
+			counts[i]);
+		fail_unless(ret == SR_OK, "Submitting a run failed.");
+	}
+	ret = feed_queue_logic_flush(q);
+	fail_unless(ret == SR_OK, "Flushing the queue failed.");
+	feed_queue_logic_free(q);
+
+	sr_session_destroy(session);
+	sr_input_free(in);
+}
+
+/*
+ * Check that runs of all unit sizes yield their samples, across the
+ * flush boundary. Sizes other than 1, 2, 4 and 8 take the path which
+ * doubles the filled part of the buffer.
+ */
+START_TEST(test_feed_queue_logic_runs)
+{
+	static const size_t unitsizes[] = { 1, 2, 3, 4, 5, 7, 8, 12, };
+	struct collected c;
+	GString *expected;
+	uint8_t *values;
+	size_t i, split;
+
+	for (i = 0; i < ARRAY_SIZE(unitsizes); i++) {
+		values = run_values(unitsizes[i]);
+		expected = expand_runs(values, unitsizes[i]);
+		for (split = 0; split <= ARRAY_SIZE(counts); split += 4) {
+			queue_runs(values, unitsizes[i], split, &c);
+			fail_unless(c.packets == (expected->len / unitsizes[i] +
+				QUEUE_SIZE - 1) / QUEUE_SIZE,
+				"Unit size %zu: unexpected %zu packets.",
+				unitsizes[i], c.packets);
+			fail_unless(!c.bad_length,
+				"Unit size %zu: bad packet length.", unitsizes[i]);
+			fail_unless(g_string_equal(c.logic, expected),
+				"Unit size %zu, split %zu: samples differ.",
+				unitsizes[i], split);
+			g_string_free(c.logic, TRUE);
+		}
+		g_string_free(expected, TRUE);
+		g_free(values);
+	}
+}
+END_TEST
+
+/* Random values, which are valid numbers for float encodings. */
+static uint8_t *analog_values(const struct analog_format *f, size_t count)
+{
+	uint8_t *values, *p, b;
+	size_t i, j;
+	float fvalue;
+	double dvalue;
+
+	values = g_malloc(count * f->unitsize);
+	for (i = 0, p = values; i < count; i++, p += f->unitsize) {
+		if (f->is_float && f->unitsize == sizeof(float)) {
+			fvalue = g_random_double_range(-1000, 1000);
+			memcpy(p, &fvalue, sizeof(fvalue));
+		} else if (f->is_float) {
+			dvalue = g_random_double_range(-1000, 1000);
+			memcpy(p, &dvalue, sizeof(dvalue));
+		} else {
+			for (j = 0; j < f->unitsize; j++)
+				p[j] = g_random_int_range(0, 256);
+		}
+		if (!f->is_float || f->is_bigendian == HOST_BIGENDIAN)
+			continue;
+		for (j = 0; j < f->unitsize / 2; j++) {
+			b = p[j];
+			p[j] = p[f->unitsize - 1 - j];
+			p[f->unitsize - 1 - j] = b;
+		}
+	}
+
+	return values;
+}
+
+/* The first channels of the device, one for each value of a set. */
+static GSList *analog_channels(const struct sr_dev_inst *sdi, size_t count)
+{
+	GSList *l, *channels;
+
+	channels = NULL;
+	for (l = sr_dev_inst_channels_get(sdi); l && count; l = l->next, count--)
+		channels = g_slist_append(channels, l->data);
+	fail_unless(!count, "Too few channels.");
+
+	return channels;
+}
+
+/*
+ * Check that sets of values in all encodings go through the queue
+ * unchanged, in blocks across the flush boundary, and that packets
+ * carry the queue's encoding, scale and channels. Only one channel's
+ * native float values can be submitted one at a time.
+ */
+START_TEST(test_feed_queue_analog_encoded)
+{
+	const struct analog_format *f;
+	const struct sr_input *in;
+	struct sr_session *session;
+	struct sr_dev_inst *sdi;
+	struct feed_queue_analog *q;
+	struct sr_rational scale;
+	struct collected c;
+	GSList *channels;
+	uint8_t *values;
+	const float *repeated;
+	size_t i, j, offset, count, set_size;
+	gboolean is_native;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(analog_formats); i++) {
+		f = &analog_formats[i];
+		set_size = f->unitsize * f->num_channels;
+		is_native = f->is_float && f->unitsize == sizeof(float) &&
+			f->is_bigendian == HOST_BIGENDIAN && f->num_channels == 1;
+		values = analog_values(f, NUM_SETS * f->num_channels);
+
+		memset(&c, 0, sizeof(c));
+		c.analog = g_string_new(NULL);
+		c.format = f;
+		in = queue_input(&sdi);
+		sr_session_new(srtest_ctx, &session);
+		sr_session_datafeed_callback_add(session, datafeed_analog_in, &c);
+		sr_session_dev_add(session, sdi);
+
+		channels = analog_channels(sdi, f->num_channels);
+		q = feed_queue_analog_alloc_encoded(sdi, QUEUE_SIZE, 3,
+			channels, f->unitsize, f->is_signed, f->is_float,
+			f->is_bigendian);
+		g_slist_free(channels);
+		fail_unless(q != NULL, "feed_queue_analog_alloc_encoded() failed.");
+		sr_rational_set(&scale, 1, 1000);
+		ret = feed_queue_analog_scale_offset(q, &scale, NULL);
+		fail_unless(ret == SR_OK, "Setting the scale failed.");
+
+		ret = feed_queue_analog_submit_one(q, 0.5, 2 * QUEUE_SIZE + 50);
+		if (is_native) {
+			fail_unless(ret == SR_OK, "Submitting a value failed.");
+			ret = feed_queue_analog_flush(q);
+			fail_unless(ret == SR_OK, "Flushing the queue failed.");
+			fail_unless(c.packets == 3 && !c.bad_length &&
+				c.analog->len == (2 * QUEUE_SIZE + 50) * sizeof(float),
+				"Unexpected packets of a repeated value.");
+			repeated = (const float *)c.analog->str;
+			for (j = 0; j < 2 * QUEUE_SIZE + 50; j++)
+				fail_unless(repeated[j] == 0.5, "Bad repeated value.");
+			g_string_truncate(c.analog, 0);
+			c.packets = 0;
+		} else {
+			fail_unless(ret == SR_ERR_ARG,
+				"Format %zu: value submitted in a foreign encoding.", i);
+			fail_unless(!c.packets, "Format %zu: unexpected packet.", i);
+		}
+
+		for (offset = 0, j = 0; offset < NUM_SETS; offset += count, j++) {
+			count = block_sizes[j % ARRAY_SIZE(block_sizes)];
+			count = MIN(count, NUM_SETS - offset);
+			ret = feed_queue_analog_submit_many(q,
+				&values[offset * set_size], count);
+			fail_unless(ret == SR_OK, "Submitting values failed.");
+		}
+		ret = feed_queue_analog_flush(q);
+		fail_unless(ret == SR_OK, "Flushing the queue failed.");
+		feed_queue_analog_free(q);
+		sr_session_destroy(session);
+		sr_input_free(in);
+
+		fail_unless(c.packets == (NUM_SETS + QUEUE_SIZE - 1) / QUEUE_SIZE,
+			"Format %zu: unexpected %zu packets.", i, c.packets);
+		fail_unless(!c.bad_length, "Format %zu: bad packet length.", i);
+		fail_unless(!c.bad_encoding, "Format %zu: bad encoding.", i);
+		fail_unless(c.analog->len == NUM_SETS * set_size &&
+			!memcmp(c.analog->str, values, c.analog->len),
+			"Format %zu: values differ.", i);
+		g_string_free(c.analog, TRUE);
+		g_free(values);
+	}
+}
+END_TEST
+
+Suite *suite_feed_queue(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("feed-queue");
+
+	tc = tcase_create("logic");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_feed_queue_logic_runs);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("analog");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_feed_queue_analog_encoded);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
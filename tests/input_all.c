@@ -18,7 +18,9 @@
  */
 
 #include <config.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
@@ -33,6 +35,193 @@ START_TEST(test_input_available)
 }
 END_TEST
 
+/* What a caller has read from a stream before detecting its format. */
+static const char prefix[] = "consumed by the caller\n";
+
+struct collected {
+	GString *logic;
+	gboolean ended;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	struct collected *c;
+
+	(void)sdi;
+
+	c = cb_data;
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		g_string_append_len(c->logic, logic->data, logic->length);
+		break;
+	case SR_DF_END:
+		c->ended = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Write data after the prefix, and position the stream after the prefix. */
+static FILE *prefixed_stream(const char *data, size_t len)
+{
+	FILE *stream;
+
+	stream = tmpfile();
+	fail_unless(stream != NULL, "Couldn't create temporary file.");
+	fail_unless(fwrite(prefix, strlen(prefix), 1, stream) == 1 &&
+		(!len || fwrite(data, len, 1, stream) == 1),
+		"Couldn't write temporary file.");
+	fail_unless(fseek(stream, strlen(prefix), SEEK_SET) == 0,
+		"Couldn't seek in temporary file.");
+
+	return stream;
+}
+
+/*
+ * Send data to an input instance, collect the samples. The stream
+ * is read to its end, when one is given.
+ */
+static void import_logic(const struct sr_input *in, const GString *data,
+	FILE *stream, struct collected *c)
+{
+	struct sr_session *session;
+	GString *buf;
+	size_t offset, len;
+	int ret;
+
+	memset(c, 0, sizeof(*c));
+	c->logic = g_string_new(NULL);
+	sr_session_new(srtest_ctx, &session);
+	sr_session_datafeed_callback_add(session, datafeed_in, c);
+	/* Scans pass data to the instance, its device may be ready. */
+	if (sr_input_dev_inst_get(in))
+		sr_session_dev_add(session, sr_input_dev_inst_get(in));
+
+	buf = g_string_sized_new(64 * 1024);
+	offset = 0;
+	while (TRUE) {
+		if (stream) {
+			len = fread(buf->str, 1, 64 * 1024, stream);
+		} else {
+			len = MIN(data->len - offset, 64 * 1024);
+			memcpy(buf->str, &data->str[offset], len);
+			offset += len;
+		}
+		if (!len)
+			break;
+		g_string_set_size(buf, len);
+		ret = srtest_input_send(in, session, buf);
+		fail_unless(ret == SR_OK, "sr_input_send() error: %d", ret);
+	}
+	g_string_free(buf, TRUE);
+	ret = sr_input_end(in);
+	fail_unless(ret == SR_OK, "sr_input_end() error: %d", ret);
+	fail_unless(c->ended, "No end of data.");
+
+	sr_session_destroy(session);
+}
+
+/* A value change dump which is larger than what gets read for the detection. */
+static GString *vcd_text(void)
+{
+	GString *text;
+	size_t i;
+
+	text = g_string_new("$timescale 1 ns $end\n$scope module top $end\n"
+		"$var wire 1 ! d0 $end\n$upscope $end\n$enddefinitions $end\n");
+	for (i = 0; i < 100000; i++)
+		g_string_append_printf(text, "#%zu\n%d!\n", 10 * i,
+			g_random_int_range(0, 2));
+
+	return text;
+}
+
+/* A Logic2 digital export, without transitions. */
+static GString *logic2_digital(void)
+{
+	/* Version, type, initial state, begin and end time, count. */
+	static const uint8_t header[] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0,
+	};
+	GString *data;
+
+	data = g_string_new("<SALEAE>");
+	g_string_append_len(data, (const char *)header, sizeof(header));
+
+	return data;
+}
+
+/*
+ * Check that formats get detected from a stream, from its current
+ * position. The data which was read for the detection and the rest
+ * of the stream together yield what the whole data yields. Without
+ * a match, and at the stream's end, the stream is put back to where
+ * it was.
+ */
+START_TEST(test_input_scan_stream)
+{
+	static const char *unknown = "This is not a capture.\n";
+	static const struct {
+		const char *id;
+		GString *(*data)(void);
+	} tests[] = {
+		{ "vcd", vcd_text, },
+		{ "saleae", logic2_digital, },
+	};
+	const struct sr_input *in;
+	struct collected streamed, sent;
+	GString *data;
+	FILE *stream;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(tests); i++) {
+		data = tests[i].data();
+		stream = prefixed_stream(data->str, data->len);
+		ret = sr_input_scan_stream(stream, NULL, &in);
+		fail_unless(ret == SR_OK && in != NULL,
+			"'%s' stream was not detected.", tests[i].id);
+		fail_unless(!strcmp(sr_input_id_get(sr_input_module_get(in)),
+			tests[i].id), "'%s' stream was detected as '%s'.",
+			tests[i].id, sr_input_id_get(sr_input_module_get(in)));
+		if (!strcmp(tests[i].id, "vcd")) {
+			import_logic(in, NULL, stream, &streamed);
+			sr_input_free(in);
+			in = sr_input_new(sr_input_find("vcd"), NULL);
+			import_logic(in, data, NULL, &sent);
+			fail_unless(streamed.logic->len != 0, "No samples.");
+			fail_unless(g_string_equal(streamed.logic, sent.logic),
+				"Samples of the stream differ.");
+			g_string_free(streamed.logic, TRUE);
+			g_string_free(sent.logic, TRUE);
+		}
+		sr_input_free(in);
+		fclose(stream);
+		g_string_free(data, TRUE);
+	}
+
+	stream = prefixed_stream(unknown, strlen(unknown));
+	ret = sr_input_scan_stream(stream, NULL, &in);
+	fail_unless(ret == SR_ERR && in == NULL, "Unknown format was detected.");
+	fail_unless(ftell(stream) == (long)strlen(prefix),
+		"Stream position was not restored.");
+	fclose(stream);
+
+	stream = prefixed_stream("", 0);
+	ret = sr_input_scan_stream(stream, NULL, &in);
+	fail_unless(ret == SR_ERR && in == NULL, "Empty stream was detected.");
+	fail_unless(ftell(stream) == (long)strlen(prefix),
+		"Stream position was not restored.");
+	fclose(stream);
+}
+END_TEST
+
 Suite *suite_input_all(void)
 {
 	Suite *s;
@@ -44,5 +233,10 @@ Suite *suite_input_all(void)
 	tcase_add_test(tc, test_input_available);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("scan");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_input_scan_stream);
+	suite_add_tcase(s, tc);
+
 	return s;
 }
@@ -18,6 +18,8 @@
  */
 
 #include <config.h>
+#include <string.h>
+#include <unistd.h>
 #include <check.h>
 #include <glib/gstdio.h>
 #include <libsigrok/libsigrok.h>
@@ -308,6 +310,204 @@ START_TEST(test_input_binary_hello_world)
 }
 END_TEST
 
+struct collected {
+	GString *logic;
+	GArray *lengths;
+	uint64_t samples;
+	gboolean ended;
+};
+
+static void datafeed_collect(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	struct collected *c;
+
+	(void)sdi;
+
+	c = cb_data;
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		g_string_append_len(c->logic, logic->data, logic->length);
+		g_array_append_val(c->lengths, logic->length);
+		c->samples += logic->length / logic->unitsize;
+		break;
+	case SR_DF_END:
+		c->ended = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+static const struct sr_input *collect_start(int num_channels,
+	struct sr_session **session, struct collected *c)
+{
+	const struct sr_input *in;
+	GHashTable *options;
+
+	options = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+			(GDestroyNotify)g_variant_unref);
+	g_hash_table_insert(options, g_strdup("numchannels"),
+		g_variant_ref_sink(g_variant_new_int32(num_channels)));
+	in = sr_input_new(sr_input_find("binary"), options);
+	g_hash_table_destroy(options);
+	fail_unless(in != NULL, "Failed to create input instance.");
+
+	memset(c, 0, sizeof(*c));
+	c->logic = g_string_new(NULL);
+	c->lengths = g_array_new(FALSE, FALSE, sizeof(uint64_t));
+	sr_session_new(srtest_ctx, session);
+	sr_session_datafeed_callback_add(*session, datafeed_collect, c);
+
+	return in;
+}
+
+static void collect_end(const struct sr_input *in,
+	struct sr_session *session, struct collected *c)
+{
+	int ret;
+
+	ret = sr_input_end(in);
+	fail_unless(ret == SR_OK, "sr_input_end() error: %d", ret);
+	fail_unless(c->ended, "No end of data.");
+	sr_input_free(in);
+	sr_session_destroy(session);
+}
+
+static void collected_free(struct collected *c)
+{
+	g_string_free(c->logic, TRUE);
+	g_array_free(c->lengths, TRUE);
+}
+
+/* Import data in chunks of the given sizes, which get repeated. */
+static void import_chunks(int num_channels, const uint8_t *data, size_t len,
+	const size_t *chunk_sizes, size_t num_sizes, struct collected *c)
+{
+	const struct sr_input *in;
+	struct sr_session *session;
+	GString *gbuf;
+	size_t offset, chunk, i;
+	int ret;
+
+	in = collect_start(num_channels, &session, c);
+	for (offset = 0, i = 0; offset < len; offset += chunk, i++) {
+		chunk = MIN(chunk_sizes[i % num_sizes], len - offset);
+		gbuf = g_string_new_len((const gchar *)&data[offset], chunk);
+		ret = srtest_input_send(in, session, gbuf);
+		fail_unless(ret == SR_OK, "sr_input_send() error: %d", ret);
+		g_string_free(gbuf, TRUE);
+	}
+	collect_end(in, session, c);
+}
+
+static void import_mapped(int num_channels, const char *filename,
+	struct collected *c)
+{
+	const struct sr_input *in;
+	struct sr_session *session;
+	gboolean done, added;
+	int ret;
+
+	in = collect_start(num_channels, &session, c);
+	added = FALSE;
+	ret = sr_input_open_mapped(in, filename);
+	fail_unless(ret == SR_OK, "sr_input_open_mapped() error: %d", ret);
+	do {
+		ret = sr_input_send_mapped(in, &done);
+		fail_unless(ret == SR_OK, "sr_input_send_mapped() error: %d",
+			ret);
+		/* Returns when the device became ready, add it then. */
+		if (sr_input_dev_inst_get(in) && !added) {
+			ret = sr_session_dev_add(session,
+				sr_input_dev_inst_get(in));
+			fail_unless(ret == SR_OK,
+				"sr_session_dev_add() error: %d", ret);
+			added = TRUE;
+		}
+	} while (!done);
+	collect_end(in, session, c);
+}
+
+/*
+ * Check that chunks which end within a sample don't change the samples,
+ * for more than one byte per sample. The trailing partial sample gets
+ * dropped.
+ */
+START_TEST(test_input_binary_split_samples)
+{
+	static const size_t whole[] = { 3 * 1000 + 2, };
+	static const size_t split[] = { 1, 2, 4, 5, 7, 11, 301, };
+	struct collected c_whole, c_split;
+	uint8_t data[3 * 1000 + 2];
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		data[i] = g_random_int();
+
+	/* 20 channels, 3 bytes per sample. */
+	import_chunks(20, data, sizeof(data), whole, ARRAY_SIZE(whole),
+		&c_whole);
+	import_chunks(20, data, sizeof(data), split, ARRAY_SIZE(split),
+		&c_split);
+	fail_unless(c_whole.samples == 1000, "Expected 1000 samples, got %"
+		PRIu64 ".", c_whole.samples);
+	fail_unless(c_split.samples == c_whole.samples,
+		"Expected %" PRIu64 " samples, got %" PRIu64 ".",
+		c_whole.samples, c_split.samples);
+	fail_unless(g_string_equal(c_whole.logic, c_split.logic),
+		"Samples depend on the chunk sizes.");
+	fail_unless(!memcmp(c_whole.logic->str, data, c_whole.logic->len),
+		"Samples differ from the input data.");
+	collected_free(&c_whole);
+	collected_free(&c_split);
+}
+END_TEST
+
+/* Check that a mapped file yields the same packets as sending it. */
+START_TEST(test_input_binary_mapped)
+{
+	const size_t size = 5 * 1024 * 1024 + 1;
+	struct collected c_sent, c_mapped;
+	uint8_t *data;
+	char *filename;
+	size_t i;
+	int fd;
+
+	data = g_malloc(size);
+	for (i = 0; i < size; i++)
+		data[i] = g_random_int();
+	fd = g_file_open_tmp("sigrok-test-XXXXXX", &filename, NULL);
+	fail_unless(fd >= 0, "Couldn't create temporary file.");
+	fail_unless(write(fd, data, size) == (ssize_t)size,
+		"Couldn't write temporary file.");
+	close(fd);
+
+	/* 16 channels, the file ends within a sample. */
+	import_chunks(16, data, size, &size, 1, &c_sent);
+	import_mapped(16, filename, &c_mapped);
+	fail_unless(c_sent.samples == size / 2, "Expected %zu samples, got %"
+		PRIu64 ".", size / 2, c_sent.samples);
+	fail_unless(c_mapped.lengths->len == c_sent.lengths->len,
+		"Expected %u packets, got %u.", c_sent.lengths->len,
+		c_mapped.lengths->len);
+	for (i = 0; i < c_sent.lengths->len; i++)
+		fail_unless(g_array_index(c_mapped.lengths, uint64_t, i) ==
+			g_array_index(c_sent.lengths, uint64_t, i),
+			"Packet %zu differs in length.", i);
+	fail_unless(g_string_equal(c_sent.logic, c_mapped.logic),
+		"Mapped file yields different samples.");
+
+	g_unlink(filename);
+	g_free(filename);
+	g_free(data);
+	collected_free(&c_sent);
+	collected_free(&c_mapped);
+}
+END_TEST
+
 Suite *suite_input_binary(void)
 {
 	Suite *s;
@@ -321,6 +521,8 @@ Suite *suite_input_binary(void)
 	tcase_add_test(tc, test_input_binary_all_high);
 	tcase_add_loop_test(tc, test_input_binary_all_high_loop, 1, 10);
 	tcase_add_test(tc, test_input_binary_hello_world);
+	tcase_add_test(tc, test_input_binary_split_samples);
+	tcase_add_test(tc, test_input_binary_mapped);
 	suite_add_tcase(s, tc);
 
 	return s;
@@ -0,0 +1,211 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+/*
+ * Analog column texts. The number parser has a fast path for simple
+ * input, the rest is up to the C library.
+ */
+static const char *analog_texts[] = {
+	"0", "+0", "-0", "-0.0", "-.0e-5", "0e400", "00001.2500",
+	"1", "-1.25", "3.3e-6", ".5", "5.", "1e0", "1E+5", "0.1",
+	"0.3", "43.737E-3", "-123.456e7",
+	/* Exponent limits of the fast path. */
+	"1e22", "1e-22", "1e23", "1e-23", "9.5e22", "1.5e-23",
+	"123e20", "123e-25", "0.001e25", "1000e-25",
+	/* Mantissas of 15, 16 and more digits. */
+	"123456789012345", "0.123456789012345",
+	"1234567890123456", "9.876543210987654e-10",
+	"9007199254740992", "9007199254740993", "-9007199254740993e-5",
+	"12345678901234567", "1234567890123456789",
+	"12345678901234567890", "0.30000000000000004",
+	"1.00000000000000000000000001",
+	/* Handled by the library. */
+	"1.7976931348623157e308", "2.2250738585072014e-308",
+	"4.9e-324", "1e1000", "1e-1000", "inf", "-infinity", "nan",
+	"0x10", "-", "+", ".", "e5", "1e", "1e+", "1.2.3", "--1",
+};
+
+struct collected {
+	GString *analog;
+	gboolean ended;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_analog *analog;
+	struct collected *c;
+
+	(void)sdi;
+
+	c = cb_data;
+	switch (packet->type) {
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		fail_unless(analog->encoding->unitsize == sizeof(double),
+			"Analog values are not double.");
+		g_string_append_len(c->analog, analog->data,
+			analog->num_samples * analog->encoding->unitsize);
+		break;
+	case SR_DF_END:
+		c->ended = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Import text of one analog column. Returns the first error. */
+static int import_analog(GString *text, struct collected *c)
+{
+	const struct sr_input *in;
+	struct sr_session *session;
+	GHashTable *options;
+	int ret;
+
+	options = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify)g_variant_unref);
+	g_hash_table_insert(options, "column_formats",
+		g_variant_ref_sink(g_variant_new_string("a")));
+	g_hash_table_insert(options, "header",
+		g_variant_ref_sink(g_variant_new_boolean(FALSE)));
+	in = sr_input_new(sr_input_find("csv"), options);
+	g_hash_table_destroy(options);
+	fail_unless(in != NULL, "Couldn't create 'csv' input.");
+
+	memset(c, 0, sizeof(*c));
+	c->analog = g_string_new(NULL);
+	sr_session_new(srtest_ctx, &session);
+	sr_session_datafeed_callback_add(session, datafeed_in, c);
+
+	ret = srtest_input_send(in, session, text);
+	if (ret == SR_OK)
+		ret = sr_input_end(in);
+
+	sr_input_free(in);
+	sr_session_destroy(session);
+
+	return ret;
+}
+
+/* Whether and to what g_ascii_strtod() converts the whole text. */
+static gboolean strtod_value(const char *text, double *value)
+{
+	char *end;
+
+	errno = 0;
+	*value = g_ascii_strtod(text, &end);
+
+	return *text && !*end && !errno;
+}
+
+/*
+ * Check that analog column texts are accepted and rejected like
+ * g_ascii_strtod() does, and that they convert to the same bits.
+ */
+START_TEST(test_input_csv_analog_values)
+{
+	struct collected c;
+	GString *text, *accepted;
+	const double *values;
+	double expected;
+	char number[64], *line, *next;
+	size_t i, count;
+	int loglevel, digits, ret;
+
+	/*
+	 * Rejected texts fail the import, one at a time. They follow a
+	 * valid line, the format detection doesn't see the first line's
+	 * last character.
+	 */
+	accepted = g_string_new(NULL);
+	loglevel = sr_log_loglevel_get();
+	sr_log_loglevel_set(SR_LOG_NONE);
+	for (i = 0; i < ARRAY_SIZE(analog_texts); i++) {
+		if (strtod_value(analog_texts[i], &expected)) {
+			g_string_append_printf(accepted, "%s\n", analog_texts[i]);
+			continue;
+		}
+		text = g_string_new(NULL);
+		g_string_printf(text, "1\n%s\n", analog_texts[i]);
+		ret = import_analog(text, &c);
+		fail_unless(ret != SR_OK, "'%s' was accepted.", analog_texts[i]);
+		g_string_free(c.analog, TRUE);
+		g_string_free(text, TRUE);
+	}
+	sr_log_loglevel_set(loglevel);
+
+	/* Random mantissas and exponents around the fast path's limits. */
+	for (i = 0; i < 100000; i++) {
+		digits = g_random_int_range(1, 19);
+		g_snprintf(number, sizeof(number), "%s%.*f%s%d",
+			g_random_boolean() ? "-" : "",
+			g_random_int_range(0, digits),
+			g_random_double_range(0, 1) * pow(10, digits),
+			g_random_boolean() ? "e" : "E",
+			g_random_int_range(-30, 30));
+		g_string_append_printf(accepted, "%s\n", number);
+	}
+
+	ret = import_analog(accepted, &c);
+	fail_unless(ret == SR_OK, "Import of valid values failed: %d.", ret);
+	fail_unless(c.ended, "No end of data.");
+	values = (const double *)c.analog->str;
+	count = c.analog->len / sizeof(values[0]);
+	line = accepted->str;
+	for (i = 0; i < count && *line; i++) {
+		next = strchr(line, '\n');
+		*next++ = '\0';
+		fail_unless(strtod_value(line, &expected),
+			"Bad test value '%s'.", line);
+		fail_unless(!memcmp(&values[i], &expected, sizeof(expected)),
+			"'%s' converts to %.17g, expected %.17g.", line,
+			values[i], expected);
+		line = next;
+	}
+	fail_unless(i == count && !*line, "Line count and value count differ.");
+
+	g_string_free(c.analog, TRUE);
+	g_string_free(accepted, TRUE);
+}
+END_TEST
+
+Suite *suite_input_csv(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("input-csv");
+
+	tc = tcase_create("analog");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_set_timeout(tc, 60);
+	tcase_add_test(tc, test_input_csv_analog_values);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,191 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#define SAMPLERATE	SR_MHZ(10)
+#define NUM_THREADS	4
+
+/*
+ * The module converts 64Ki transitions at once, and sends chunks of
+ * 1Mi samples. Have two full batches and an odd remainder, which add
+ * up to several chunks of samples.
+ */
+#define NUM_TRANSITIONS	(2 * 64 * 1024 + 4321)
+
+/* Pieces of the file which end within a timestamp. */
+#define SEND_SIZE	(8 * 60001 + 5)
+
+struct collected {
+	GString *logic;
+	gboolean ended;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	struct collected *c;
+
+	(void)sdi;
+
+	c = cb_data;
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		g_string_append_len(c->logic, logic->data, logic->length);
+		break;
+	case SR_DF_END:
+		c->ended = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+static void append_le(GString *s, uint64_t value, size_t len)
+{
+	while (len--) {
+		g_string_append_c(s, value & 0xff);
+		value >>= 8;
+	}
+}
+
+static void append_double(GString *s, double value)
+{
+	uint64_t bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	append_le(s, bits, sizeof(bits));
+}
+
+/*
+ * A Logic2 digital export. Some transitions have the timestamp of the
+ * previous one, which results in runs of zero length.
+ */
+static GString *logic2_digital_file(void)
+{
+	GString *s;
+	uint64_t sample;
+	size_t i;
+
+	s = g_string_new("<SALEAE>");
+	append_le(s, 0, 4);		/* version */
+	append_le(s, 0, 4);		/* digital */
+	append_le(s, 1, 4);		/* initial state */
+	append_double(s, 0.0);		/* begin time */
+	append_double(s, 0.0);		/* end time, patched below */
+	append_le(s, NUM_TRANSITIONS, 8);
+	sample = 0;
+	for (i = 0; i < NUM_TRANSITIONS; i++) {
+		if (g_random_int_range(0, 16))
+			sample += g_random_int_range(1, 100);
+		append_double(s, (double)sample / SAMPLERATE);
+	}
+	memcpy(&s->str[28], &s->str[s->len - 8], 8);
+
+	return s;
+}
+
+static void import_logic2(const GString *file, size_t send_size,
+	unsigned int threads, struct collected *c)
+{
+	const struct sr_input *in;
+	struct sr_session *session;
+	GHashTable *options;
+	GString *buf;
+	size_t offset, len;
+	int ret;
+
+	options = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify)g_variant_unref);
+	g_hash_table_insert(options, "samplerate",
+		g_variant_ref_sink(g_variant_new_uint64(SAMPLERATE)));
+	in = sr_input_new(sr_input_find("saleae"), options);
+	g_hash_table_destroy(options);
+	fail_unless(in != NULL, "Couldn't create 'saleae' input.");
+	if (threads) {
+		ret = sr_input_threads_set(in, threads);
+		fail_unless(ret == SR_OK, "'saleae' input has no threads.");
+	}
+
+	memset(c, 0, sizeof(*c));
+	c->logic = g_string_new(NULL);
+	sr_session_new(srtest_ctx, &session);
+	sr_session_datafeed_callback_add(session, datafeed_in, c);
+
+	for (offset = 0; offset < file->len; offset += len) {
+		len = MIN(file->len - offset, send_size);
+		buf = g_string_new_len(&file->str[offset], len);
+		ret = srtest_input_send(in, session, buf);
+		fail_unless(ret == SR_OK, "sr_input_send() error: %d", ret);
+		g_string_free(buf, TRUE);
+	}
+	ret = sr_input_end(in);
+	fail_unless(ret == SR_OK, "sr_input_end() error: %d", ret);
+	fail_unless(c->ended, "No end of data.");
+
+	sr_input_free(in);
+	sr_session_destroy(session);
+}
+
+/* Check that expanding transitions on several threads yields the same samples. */
+START_TEST(test_input_saleae_threads)
+{
+	struct collected serial, parallel, pieces;
+	GString *file;
+
+	file = logic2_digital_file();
+	import_logic2(file, file->len, 0, &serial);
+	import_logic2(file, file->len, NUM_THREADS, &parallel);
+	import_logic2(file, SEND_SIZE, NUM_THREADS, &pieces);
+	fail_unless(serial.logic->len > 2 * 1024 * 1024 * sizeof(uint32_t),
+		"Expected more than two chunks of samples, got %zu bytes.",
+		serial.logic->len);
+	fail_unless(g_string_equal(serial.logic, parallel.logic),
+		"Samples differ with threads.");
+	fail_unless(g_string_equal(serial.logic, pieces.logic),
+		"Samples differ with threads and pieces of input.");
+
+	g_string_free(serial.logic, TRUE);
+	g_string_free(parallel.logic, TRUE);
+	g_string_free(pieces.logic, TRUE);
+	g_string_free(file, TRUE);
+}
+END_TEST
+
+Suite *suite_input_saleae(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("input-saleae");
+
+	tc = tcase_create("threads");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_set_timeout(tc, 60);
+	tcase_add_test(tc, test_input_saleae_threads);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,241 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "lib.h"
+
+#define NUM_LINES	100000
+#define NUM_THREADS	4
+#define SEND_SIZE	(768 * 1024)
+
+struct collected {
+	GString *logic;
+	GString *analog;
+	gboolean ended;
+	size_t parallel_jobs;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	struct collected *c;
+	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_analog *analog;
+
+	(void)sdi;
+
+	c = cb_data;
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		g_string_append_len(c->logic, logic->data, logic->length);
+		break;
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		g_string_append_len(c->analog, analog->data,
+			analog->num_samples * analog->encoding->unitsize);
+		break;
+	case SR_DF_END:
+		c->ended = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Logic and analog columns, with a leading timestamp. */
+static GString *csv_text(void)
+{
+	GString *text;
+	size_t i;
+
+	text = g_string_new(NULL);
+	for (i = 0; i < NUM_LINES; i++) {
+		g_string_append_printf(text, "%zu.0e-6,%d,%d,%d,%x,%.3f\n",
+			i + 1, g_random_int_range(0, 2), g_random_int_range(0, 2),
+			g_random_int_range(0, 2), g_random_int_range(0, 256),
+			g_random_double_range(-5.0, 5.0));
+		if (g_random_int_range(0, 5000) == 0)
+			g_string_append(text, "; comment\n\n");
+	}
+
+	return text;
+}
+
+/* Sparse value changes of bits, vectors and reals, and a few sections. */
+static GString *vcd_text(void)
+{
+	static const char *ids[] = { "!", "\"", "#", "$", };
+	GString *text;
+	uint64_t timestamp;
+	size_t i;
+	int changes;
+
+	text = g_string_new("$timescale 1 ns $end\n$scope module top $end\n"
+		"$var wire 1 ! d0 $end\n$var wire 1 \" d1 $end\n"
+		"$var wire 1 # d2 $end\n$var wire 1 $ d3 $end\n"
+		"$var wire 4 % bus $end\n$var real 1 & volt $end\n"
+		"$upscope $end\n$enddefinitions $end\n"
+		"#0\n$dumpvars\n0!\n0\"\n0#\n0$\nb0 %\nr0.5 &\n$end\n");
+	timestamp = 0;
+	for (i = 0; i < NUM_LINES; i++) {
+		timestamp += g_random_int_range(1, 20);
+		g_string_append_printf(text, "#%" PRIu64 "\n", timestamp);
+		for (changes = g_random_int_range(0, 3); changes; changes--) {
+			switch (g_random_int_range(0, 4)) {
+			case 0:
+				g_string_append_printf(text, "b%d%d %%\n",
+					g_random_int_range(0, 2),
+					g_random_int_range(0, 2));
+				break;
+			case 1:
+				g_string_append_printf(text, "r%.3f &\n",
+					g_random_double_range(-5.0, 5.0));
+				break;
+			default:
+				g_string_append_printf(text, "%d%s\n",
+					g_random_int_range(0, 2),
+					ids[g_random_int_range(0, ARRAY_SIZE(ids))]);
+				break;
+			}
+		}
+		if (g_random_int_range(0, 10000) == 0)
+			g_string_append(text, "$comment\n#1 within a comment\n$end\n");
+	}
+
+	return text;
+}
+
+/*
+ * Import text in several pieces, so that modules don't see all of it
+ * before they know the samplerate, like when reading from a file.
+ */
+static void import_text(const char *id, const char *column_formats,
+	uint64_t samplerate, const GString *text, unsigned int threads,
+	struct collected *c)
+{
+	const struct sr_input *in;
+	struct sr_session *session;
+	GHashTable *options;
+	GString *buf;
+	size_t offset, len;
+	int ret;
+
+	options = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify)g_variant_unref);
+	/* The CSV text has no caption line. */
+	if (column_formats) {
+		g_hash_table_insert(options, "column_formats",
+			g_variant_ref_sink(g_variant_new_string(column_formats)));
+		g_hash_table_insert(options, "header",
+			g_variant_ref_sink(g_variant_new_boolean(FALSE)));
+	}
+	if (samplerate)
+		g_hash_table_insert(options, "samplerate",
+			g_variant_ref_sink(g_variant_new_uint64(samplerate)));
+	in = sr_input_new(sr_input_find(id), options);
+	g_hash_table_destroy(options);
+	fail_unless(in != NULL, "Couldn't create '%s' input.", id);
+	if (threads) {
+		ret = sr_input_threads_set(in, threads);
+		fail_unless(ret == SR_OK, "'%s' input has no threads.", id);
+	}
+
+	memset(c, 0, sizeof(*c));
+	c->logic = g_string_new(NULL);
+	c->analog = g_string_new(NULL);
+	sr_session_new(srtest_ctx, &session);
+	sr_session_datafeed_callback_add(session, datafeed_in, c);
+
+	for (offset = 0; offset < text->len; offset += len) {
+		len = MIN(text->len - offset, SEND_SIZE);
+		buf = g_string_new_len(&text->str[offset], len);
+		ret = srtest_input_send(in, session, buf);
+		fail_unless(ret == SR_OK, "sr_input_send() error: %d", ret);
+		g_string_free(buf, TRUE);
+	}
+	ret = sr_input_end(in);
+	fail_unless(ret == SR_OK, "sr_input_end() error: %d", ret);
+	fail_unless(c->ended, "No end of data.");
+	c->parallel_jobs = sr_input_parallel_jobs_get(in);
+
+	sr_input_free(in);
+	sr_session_destroy(session);
+}
+
+static void check_threads(const char *id, const char *column_formats,
+	uint64_t samplerate, GString *text)
+{
+	struct collected serial, parallel;
+
+	import_text(id, column_formats, samplerate, text, 0, &serial);
+	import_text(id, column_formats, samplerate, text, NUM_THREADS,
+		&parallel);
+	fail_unless(serial.parallel_jobs == 0,
+		"'%s' text was split without threads.", id);
+	fail_unless(parallel.parallel_jobs != 0,
+		"'%s' text was not split with threads.", id);
+	fail_unless(serial.logic->len != 0, "No '%s' logic data.", id);
+	fail_unless(serial.analog->len != 0, "No '%s' analog data.", id);
+	fail_unless(g_string_equal(serial.logic, parallel.logic),
+		"'%s' logic data differs with threads.", id);
+	fail_unless(g_string_equal(serial.analog, parallel.analog),
+		"'%s' analog data differs with threads.", id);
+
+	g_string_free(serial.logic, TRUE);
+	g_string_free(serial.analog, TRUE);
+	g_string_free(parallel.logic, TRUE);
+	g_string_free(parallel.analog, TRUE);
+}
+
+/* Check that parsing on several threads yields the same samples. */
+START_TEST(test_input_text_threads)
+{
+	GString *text;
+
+	/* The rate is taken from the timestamps, or provided. */
+	text = csv_text();
+	check_threads("csv", "t,3b,x8,a", 0, text);
+	check_threads("csv", "t,3b,x8,a", 1000000, text);
+	g_string_free(text, TRUE);
+	text = vcd_text();
+	check_threads("vcd", NULL, 0, text);
+	g_string_free(text, TRUE);
+}
+END_TEST
+
+Suite *suite_input_text(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("input-text");
+
+	tc = tcase_create("threads");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_set_timeout(tc, 60);
+	tcase_add_test(tc, test_input_text_threads);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,187 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#define NUM_SAMPLES	20000
+/* Pieces which end within identifiers. */
+#define SEND_SIZE	4093
+
+/*
+ * Identifiers of one and two characters at the edges of the printable
+ * range, and longer ones. The last wire shares its identifier with the
+ * first one.
+ */
+static const char *ids[] = {
+	"!", "~", "!!", "~~", "!~", "~!", "a", "ab",
+	"!!!", "~~~", "abc", "long_identifier", "!",
+};
+#define NUM_IDS		(ARRAY_SIZE(ids) - 1)
+
+struct collected {
+	GString *logic;
+	size_t unitsize;
+	gboolean ended;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	struct collected *c;
+
+	(void)sdi;
+
+	c = cb_data;
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		c->unitsize = logic->unitsize;
+		g_string_append_len(c->logic, logic->data, logic->length);
+		break;
+	case SR_DF_END:
+		c->ended = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Value changes of random identifiers at every time unit. The state
+ * of the identifiers at each time goes to 'expected'.
+ */
+static GString *vcd_text(uint8_t *expected)
+{
+	GString *text;
+	uint8_t state[NUM_IDS];
+	size_t i, id_idx;
+	int changes, value;
+
+	text = g_string_new("$timescale 1 ns $end\n$scope module top $end\n");
+	for (i = 0; i < ARRAY_SIZE(ids); i++)
+		g_string_append_printf(text, "$var wire 1 %s d%zu $end\n",
+			ids[i], i);
+	g_string_append(text, "$upscope $end\n$enddefinitions $end\n");
+
+	memset(state, 0, sizeof(state));
+	g_string_append(text, "#0\n$dumpvars\n");
+	for (id_idx = 0; id_idx < NUM_IDS; id_idx++)
+		g_string_append_printf(text, "0%s\n", ids[id_idx]);
+	g_string_append(text, "$end\n");
+	for (i = 0; i < NUM_SAMPLES; i++) {
+		if (i)
+			g_string_append_printf(text, "#%zu\n", i);
+		for (changes = g_random_int_range(0, 4); changes; changes--) {
+			id_idx = g_random_int_range(0, NUM_IDS);
+			value = g_random_int_range(0, 2);
+			g_string_append_printf(text, "%d%s\n", value, ids[id_idx]);
+			state[id_idx] = value;
+		}
+		memcpy(&expected[i * NUM_IDS], state, sizeof(state));
+	}
+	g_string_append_printf(text, "#%d\n", NUM_SAMPLES);
+
+	return text;
+}
+
+static void import_vcd(const GString *text, struct collected *c)
+{
+	const struct sr_input *in;
+	struct sr_session *session;
+	GString *buf;
+	size_t offset, len;
+	int ret;
+
+	in = sr_input_new(sr_input_find("vcd"), NULL);
+	fail_unless(in != NULL, "Couldn't create 'vcd' input.");
+
+	memset(c, 0, sizeof(*c));
+	c->logic = g_string_new(NULL);
+	sr_session_new(srtest_ctx, &session);
+	sr_session_datafeed_callback_add(session, datafeed_in, c);
+
+	for (offset = 0; offset < text->len; offset += len) {
+		len = MIN(text->len - offset, SEND_SIZE);
+		buf = g_string_new_len(&text->str[offset], len);
+		ret = srtest_input_send(in, session, buf);
+		fail_unless(ret == SR_OK, "sr_input_send() error: %d", ret);
+		g_string_free(buf, TRUE);
+	}
+	ret = sr_input_end(in);
+	fail_unless(ret == SR_OK, "sr_input_end() error: %d", ret);
+	fail_unless(c->ended, "No end of data.");
+
+	sr_input_free(in);
+	sr_session_destroy(session);
+}
+
+/* Check that value changes reach the channels of their identifier. */
+START_TEST(test_input_vcd_identifiers)
+{
+	struct collected c;
+	GString *text;
+	uint8_t *expected;
+	const uint8_t *sample;
+	size_t i, ch_idx, id_idx;
+	int bit;
+
+	expected = g_malloc(NUM_SAMPLES * NUM_IDS);
+	text = vcd_text(expected);
+	import_vcd(text, &c);
+	fail_unless(c.unitsize == (ARRAY_SIZE(ids) + 7) / 8,
+		"Unexpected unit size %zu.", c.unitsize);
+	fail_unless(c.logic->len == NUM_SAMPLES * c.unitsize,
+		"Unexpected %zu bytes of samples.", c.logic->len);
+	for (i = 0; i < NUM_SAMPLES; i++) {
+		sample = (const uint8_t *)&c.logic->str[i * c.unitsize];
+		for (ch_idx = 0; ch_idx < ARRAY_SIZE(ids); ch_idx++) {
+			/* Wires with the same identifier have the same data. */
+			id_idx = ch_idx < NUM_IDS ? ch_idx : 0;
+			bit = (sample[ch_idx / 8] >> (ch_idx % 8)) & 1;
+			fail_unless(bit == expected[i * NUM_IDS + id_idx],
+				"Sample %zu, identifier '%s' of channel %zu: "
+				"got %d.", i, ids[ch_idx], ch_idx, bit);
+		}
+	}
+
+	g_string_free(c.logic, TRUE);
+	g_string_free(text, TRUE);
+	g_free(expected);
+}
+END_TEST
+
+Suite *suite_input_vcd(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("input-vcd");
+
+	tc = tcase_create("identifiers");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_input_vcd_identifiers);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,228 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#define NUM_CHANNELS	2
+#define NUM_SAMPLES	5000
+/* Pieces which end within the header, and within sets of values. */
+#define SEND_SIZE	999
+
+#define WAVE_FORMAT_PCM		0x0001
+#define WAVE_FORMAT_IEEE_FLOAT	0x0003
+
+struct collected {
+	GString *values;
+	gboolean bad_channels;
+	gboolean ended;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_analog *analog;
+	struct collected *c;
+	size_t count;
+	float *values;
+
+	(void)sdi;
+
+	c = cb_data;
+	switch (packet->type) {
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		if (g_slist_length(analog->meaning->channels) != NUM_CHANNELS)
+			c->bad_channels = TRUE;
+		count = analog->num_samples * NUM_CHANNELS;
+		values = g_malloc(count * sizeof(values[0]));
+		fail_unless(sr_analog_to_float(analog, values) == SR_OK,
+			"Analog values can't be converted.");
+		g_string_append_len(c->values, (const char *)values,
+			count * sizeof(values[0]));
+		g_free(values);
+		break;
+	case SR_DF_END:
+		c->ended = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+static void append_le(GString *s, uint32_t value, size_t len)
+{
+	while (len--) {
+		g_string_append_c(s, value & 0xff);
+		value >>= 8;
+	}
+}
+
+/*
+ * A WAV file of random values, the first ones at the limits of the
+ * sample format. Their expected float values go to 'expected'.
+ */
+static GString *wav_file(uint16_t fmt_code, size_t unitsize, float *expected)
+{
+	static const uint32_t limits[][4] = {
+		{ 0, UINT8_MAX, 0x80, 0x7f, },
+		{ 0x8000, INT16_MAX, 0, 0xffff, },
+		{ 0x80000000, INT32_MAX, 0, 0xffffffff, },
+	};
+	GString *file;
+	size_t data_len, i;
+	uint32_t value;
+	float fvalue;
+
+	data_len = NUM_SAMPLES * NUM_CHANNELS * unitsize;
+	file = g_string_new("RIFF");
+	append_le(file, 36 + data_len, 4);
+	g_string_append(file, "WAVEfmt ");
+	append_le(file, 16, 4);
+	append_le(file, fmt_code, 2);
+	append_le(file, NUM_CHANNELS, 2);
+	append_le(file, SR_KHZ(48), 4);
+	append_le(file, SR_KHZ(48) * NUM_CHANNELS * unitsize, 4);
+	append_le(file, NUM_CHANNELS * unitsize, 2);
+	append_le(file, 8 * unitsize, 2);
+	g_string_append(file, "data");
+	append_le(file, data_len, 4);
+
+	for (i = 0; i < NUM_SAMPLES * NUM_CHANNELS; i++) {
+		if (fmt_code == WAVE_FORMAT_IEEE_FLOAT) {
+			fvalue = g_random_double_range(-1.0, 1.0);
+			memcpy(&value, &fvalue, sizeof(value));
+			expected[i] = fvalue;
+		} else {
+			if (i < ARRAY_SIZE(limits[0]))
+				value = limits[unitsize / 2][i];
+			else
+				value = g_random_int();
+			/* 8-bit PCM samples are unsigned, others signed. */
+			switch (unitsize) {
+			case 1:
+				value &= 0xff;
+				expected[i] = value / (double)UINT8_MAX;
+				break;
+			case 2:
+				value &= 0xffff;
+				expected[i] = (int16_t)value / (double)INT16_MAX;
+				break;
+			default:
+				expected[i] = (int32_t)value / (double)INT32_MAX;
+				break;
+			}
+		}
+		append_le(file, value, unitsize);
+	}
+
+	return file;
+}
+
+static void import_wav(const GString *file, struct collected *c)
+{
+	const struct sr_input *in;
+	struct sr_session *session;
+	GString *buf;
+	size_t offset, len;
+	int ret;
+
+	in = sr_input_new(sr_input_find("wav"), NULL);
+	fail_unless(in != NULL, "Couldn't create 'wav' input.");
+
+	memset(c, 0, sizeof(*c));
+	c->values = g_string_new(NULL);
+	sr_session_new(srtest_ctx, &session);
+	sr_session_datafeed_callback_add(session, datafeed_in, c);
+
+	for (offset = 0; offset < file->len; offset += len) {
+		len = MIN(file->len - offset, SEND_SIZE);
+		buf = g_string_new_len(&file->str[offset], len);
+		ret = srtest_input_send(in, session, buf);
+		fail_unless(ret == SR_OK, "sr_input_send() error: %d", ret);
+		g_string_free(buf, TRUE);
+	}
+	ret = sr_input_end(in);
+	fail_unless(ret == SR_OK, "sr_input_end() error: %d", ret);
+	fail_unless(c->ended, "No end of data.");
+
+	sr_input_free(in);
+	sr_session_destroy(session);
+}
+
+/*
+ * Check that PCM samples of 8, 16 and 32 bits, and float samples,
+ * reach consumers as the float values they stand for.
+ */
+START_TEST(test_input_wav_values)
+{
+	static const struct {
+		uint16_t fmt_code;
+		size_t unitsize;
+	} formats[] = {
+		{ WAVE_FORMAT_PCM, 1, },
+		{ WAVE_FORMAT_PCM, 2, },
+		{ WAVE_FORMAT_PCM, 4, },
+		{ WAVE_FORMAT_IEEE_FLOAT, 4, },
+	};
+	struct collected c;
+	GString *file;
+	float *expected;
+	const float *values;
+	size_t i, j;
+
+	expected = g_malloc(NUM_SAMPLES * NUM_CHANNELS * sizeof(expected[0]));
+	for (i = 0; i < ARRAY_SIZE(formats); i++) {
+		file = wav_file(formats[i].fmt_code, formats[i].unitsize,
+			expected);
+		import_wav(file, &c);
+		fail_unless(!c.bad_channels, "Format %zu: bad channels.", i);
+		fail_unless(c.values->len ==
+			NUM_SAMPLES * NUM_CHANNELS * sizeof(expected[0]),
+			"Format %zu: unexpected %zu bytes of values.", i,
+			c.values->len);
+		values = (const float *)c.values->str;
+		for (j = 0; j < NUM_SAMPLES * NUM_CHANNELS; j++)
+			fail_unless(values[j] == expected[j],
+				"Format %zu, value %zu: got %.9g, expected %.9g.",
+				i, j, values[j], expected[j]);
+		g_string_free(c.values, TRUE);
+		g_string_free(file, TRUE);
+	}
+	g_free(expected);
+}
+END_TEST
+
+Suite *suite_input_wav(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("input-wav");
+
+	tc = tcase_create("values");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_input_wav_values);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
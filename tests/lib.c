@@ -160,3 +160,22 @@ GArray *srtest_get_enabled_logic_channels(const struct sr_dev_inst *sdi)
 
 	return channels;
 }
+
+/*
+ * Send data to an input instance. Its device gets added to the session
+ * as soon as the input module has it ready, which is before the module
+ * sends any packets for it.
+ */
+int srtest_input_send(const struct sr_input *in, struct sr_session *session,
+		GString *buf)
+{
+	gboolean was_ready;
+	int ret;
+
+	was_ready = sr_input_dev_inst_get(in) != NULL;
+	ret = sr_input_send(in, buf);
+	if (ret == SR_OK && !was_ready && sr_input_dev_inst_get(in))
+		ret = sr_session_dev_add(session, sr_input_dev_inst_get(in));
+
+	return ret;
+}
@@ -41,12 +41,26 @@ void srtest_check_samplerate(struct sr_context *sr_ctx, const char *drivername,
 
 GArray *srtest_get_enabled_logic_channels(const struct sr_dev_inst *sdi);
 
+int srtest_input_send(const struct sr_input *in, struct sr_session *session,
+		GString *buf);
+
 Suite *suite_core(void);
 Suite *suite_driver_all(void);
+Suite *suite_feed_queue(void);
 Suite *suite_input_all(void);
 Suite *suite_input_binary(void);
+Suite *suite_input_csv(void);
+Suite *suite_input_saleae(void);
+Suite *suite_input_text(void);
+Suite *suite_input_vcd(void);
+Suite *suite_input_wav(void);
 Suite *suite_output_all(void);
+Suite *suite_output_analog(void);
+Suite *suite_output_text(void);
+Suite *suite_output_wav(void);
+Suite *suite_output_wavedrom(void);
 Suite *suite_transform_all(void);
+Suite *suite_transitions(void);
 Suite *suite_session(void);
 Suite *suite_strutil(void);
 Suite *suite_version(void);
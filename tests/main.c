@@ -35,10 +35,21 @@ int main(void)
 	/* Add all testsuites to the master suite. */
 	srunner_add_suite(srunner, suite_core());
 	srunner_add_suite(srunner, suite_driver_all());
+	srunner_add_suite(srunner, suite_feed_queue());
 	srunner_add_suite(srunner, suite_input_all());
 	srunner_add_suite(srunner, suite_input_binary());
+	srunner_add_suite(srunner, suite_input_csv());
+	srunner_add_suite(srunner, suite_input_saleae());
+	srunner_add_suite(srunner, suite_input_text());
+	srunner_add_suite(srunner, suite_input_vcd());
+	srunner_add_suite(srunner, suite_input_wav());
 	srunner_add_suite(srunner, suite_output_all());
+	srunner_add_suite(srunner, suite_output_analog());
+	srunner_add_suite(srunner, suite_output_text());
+	srunner_add_suite(srunner, suite_output_wav());
+	srunner_add_suite(srunner, suite_output_wavedrom());
 	srunner_add_suite(srunner, suite_transform_all());
+	srunner_add_suite(srunner, suite_transitions());
 	srunner_add_suite(srunner, suite_session());
 	srunner_add_suite(srunner, suite_strutil());
 	srunner_add_suite(srunner, suite_version());
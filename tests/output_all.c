@@ -19,6 +19,7 @@
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
@@ -96,6 +97,64 @@ START_TEST(test_output_options)
 }
 END_TEST
 
+static int sink_collect(const uint8_t *data, size_t length, void *cb_data)
+{
+	g_string_append_len(cb_data, (const char *)data, length);
+
+	return SR_OK;
+}
+
+/* Check whether GString and sink outputs of a module are identical. */
+START_TEST(test_output_sink)
+{
+	const struct sr_output_module *omod;
+	const struct sr_output *o;
+	struct sr_output_sink *sink;
+	struct sr_datafeed_packet packet, end;
+	struct sr_datafeed_logic logic;
+	uint8_t data[] = { 0x00, 0x55, 0xaa, 0xff, };
+	GString *text, *collected;
+	int ret;
+
+	omod = sr_output_find("binary");
+	fail_unless(omod != NULL, "Couldn't find the 'binary' output module.");
+	logic.length = sizeof(data);
+	logic.unitsize = 1;
+	logic.data = data;
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+	end.type = SR_DF_END;
+	end.payload = NULL;
+
+	o = sr_output_new(omod, NULL, NULL, NULL);
+	fail_unless(o != NULL, "Couldn't create output instance.");
+	ret = sr_output_send(o, &packet, &text);
+	fail_unless(ret == SR_OK && text != NULL, "No GString output.");
+	fail_unless(text->len == sizeof(data), "Unexpected output length.");
+	fail_unless(!memcmp(text->str, data, sizeof(data)), "Output mismatch.");
+	g_string_free(text, TRUE);
+	sr_output_free(o);
+
+	collected = g_string_new(NULL);
+	sink = sr_output_sink_new_callback(sink_collect, collected);
+	fail_unless(sink != NULL, "Couldn't create output sink.");
+	o = sr_output_new_sink(omod, NULL, NULL, NULL, sink);
+	fail_unless(o != NULL, "Couldn't create output instance.");
+	ret = sr_output_send(o, &packet, NULL);
+	ret |= sr_output_send(o, &packet, NULL);
+	fail_unless(ret == SR_OK, "Sink output failed.");
+	fail_unless(collected->len == 0, "Output was not buffered.");
+	ret = sr_output_send(o, &end, NULL);
+	fail_unless(ret == SR_OK, "Sink output failed.");
+	fail_unless(collected->len == 2 * sizeof(data),
+		"Unexpected output length.");
+	fail_unless(!memcmp(&collected->str[sizeof(data)], data, sizeof(data)),
+		"Output mismatch.");
+	sr_output_free(o);
+	g_string_free(collected, TRUE);
+}
+END_TEST
+
 Suite *suite_output_all(void)
 {
 	Suite *s;
@@ -110,6 +169,7 @@ Suite *suite_output_all(void)
 	tcase_add_test(tc, test_output_desc);
 	tcase_add_test(tc, test_output_find);
 	tcase_add_test(tc, test_output_options);
+	tcase_add_test(tc, test_output_sink);
 	suite_add_tcase(s, tc);
 
 	return s;
@@ -0,0 +1,232 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#define MAX_DIGITS 12
+
+static struct sr_dev_inst *analog_sdi(void)
+{
+	struct sr_dev_inst *sdi;
+
+	sdi = sr_dev_inst_user_new("Vendor", "Model", "Version");
+	fail_unless(sdi != NULL, "sr_dev_inst_user_new() failed.");
+	sr_dev_inst_channel_add(sdi, 0, SR_CHANNEL_ANALOG, "A0");
+
+	return sdi;
+}
+
+/* Run one packet of float values through the analog output. */
+static GString *analog_run(const struct sr_output *o,
+	const struct sr_dev_inst *sdi, const float *values, size_t count,
+	enum sr_unit unit, int digits)
+{
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	GString *out;
+	int ret;
+
+	memset(&encoding, 0, sizeof(encoding));
+	encoding.unitsize = sizeof(float);
+	encoding.is_signed = TRUE;
+	encoding.is_float = TRUE;
+#ifdef WORDS_BIGENDIAN
+	encoding.is_bigendian = TRUE;
+#endif
+	encoding.digits = digits;
+	encoding.is_digits_decimal = TRUE;
+	sr_rational_set(&encoding.scale, 1, 1);
+	sr_rational_set(&encoding.offset, 0, 1);
+	memset(&meaning, 0, sizeof(meaning));
+	meaning.mq = SR_MQ_VOLTAGE;
+	meaning.unit = unit;
+	meaning.channels = sr_dev_inst_channels_get(sdi);
+	memset(&spec, 0, sizeof(spec));
+	spec.spec_digits = digits;
+	analog.data = (void *)values;
+	analog.num_samples = count;
+	analog.encoding = &encoding;
+	analog.meaning = &meaning;
+	analog.spec = &spec;
+	packet.type = SR_DF_ANALOG;
+	packet.payload = &analog;
+
+	out = NULL;
+	ret = sr_output_send(o, &packet, &out);
+	fail_unless(ret == SR_OK && out != NULL, "Sending analog packet failed.");
+
+	return out;
+}
+
+/*
+ * Values for each number of digits: exact ties and their neighbours,
+ * the limits of the formatter's fast path, special values, and random
+ * values of all magnitudes.
+ */
+static GArray *test_values(int digits)
+{
+	static const float specials[] = {
+		0.0f, -0.0f, 1e-30f, -1e-30f, 0.4f, -0.4f, 0.5f, -0.5f,
+		0.9999999f, 1.0f, 9.5f, 99.5f, 1e20f, -1e20f, FLT_MAX,
+		-FLT_MAX, FLT_MIN, INFINITY, -INFINITY, NAN,
+	};
+	GArray *values;
+	float value, scale, tie[4];
+	size_t i;
+	int j, m;
+
+	values = g_array_new(FALSE, FALSE, sizeof(float));
+	g_array_append_vals(values, specials, ARRAY_SIZE(specials));
+
+	/* Multiples of powers of two are ties at some number of digits. */
+	for (j = 1; j <= 20; j++) {
+		for (m = 1; m < 64; m += 2) {
+			tie[0] = ldexpf(m, -j);
+			tie[1] = -tie[0];
+			tie[2] = nextafterf(tie[0], INFINITY);
+			tie[3] = nextafterf(tie[0], 0);
+			g_array_append_vals(values, tie, ARRAY_SIZE(tie));
+		}
+	}
+
+	/* Around 2^40 after scaling. */
+	scale = powf(10, digits);
+	value = ldexpf(1, 40) / scale;
+	for (i = 0; i < 5; i++) {
+		g_array_append_val(values, value);
+		value = nextafterf(value, i < 2 ? INFINITY : 0);
+	}
+
+	for (i = 0; i < 2000; i++) {
+		value = g_random_double_range(0, 1) *
+			powf(10, g_random_int_range(-8, 15));
+		if (g_random_boolean())
+			value = -value;
+		g_array_append_val(values, value);
+	}
+
+	return values;
+}
+
+/* Check that values are printed like "%.*f" does, at 0 to 12 digits. */
+START_TEST(test_output_analog_digits)
+{
+	const struct sr_output *o;
+	struct sr_dev_inst *sdi;
+	GArray *values;
+	GString *out;
+	char expected[512], *line, *next, *number;
+	float value;
+	size_t i;
+	int digits;
+
+	sdi = analog_sdi();
+	o = sr_output_new(sr_output_find("analog"), NULL, sdi, NULL);
+	fail_unless(o != NULL, "Couldn't create 'analog' output.");
+	for (digits = 0; digits <= MAX_DIGITS; digits++) {
+		values = test_values(digits);
+		/* Percentages don't take an SI prefix, values stay as they are. */
+		out = analog_run(o, sdi, (const float *)values->data,
+			values->len, SR_UNIT_PERCENTAGE, digits);
+		line = out->str;
+		for (i = 0; i < values->len; i++) {
+			value = g_array_index(values, float, i);
+			next = strchr(line, '\n');
+			fail_unless(next != NULL, "Missing line for %.9g.", value);
+			*next++ = '\0';
+			fail_unless(!strncmp(line, "A0: ", 4) &&
+				strrchr(line, ' ') > line + 4, "Bad line '%s'.", line);
+			number = line + 4;
+			*strrchr(number, ' ') = '\0';
+			snprintf(expected, sizeof(expected), "%.*f", digits, value);
+			fail_unless(!strcmp(number, expected),
+				"%.9g at %d digits: got '%s', expected '%s'.",
+				value, digits, number, expected);
+			line = next;
+		}
+		fail_unless(!*line, "Unexpected text '%s'.", line);
+		g_string_free(out, TRUE);
+		g_array_free(values, TRUE);
+	}
+	sr_output_free(o);
+}
+END_TEST
+
+/*
+ * Check that the SI prefix gets picked once per packet, from the
+ * largest value of the channel.
+ */
+START_TEST(test_output_analog_prefix)
+{
+	static const float small[] = { 0.25f, -0.0125f, 0.002f, };
+	static const float large[] = { 12.5f, 0.5f, };
+	const struct sr_output *o;
+	struct sr_dev_inst *sdi;
+	GString *out;
+
+	sdi = analog_sdi();
+	o = sr_output_new(sr_output_find("analog"), NULL, sdi, NULL);
+	fail_unless(o != NULL, "Couldn't create 'analog' output.");
+
+	out = analog_run(o, sdi, small, ARRAY_SIZE(small), SR_UNIT_VOLT, 3);
+	fail_unless(!strcmp(out->str,
+		"A0: 250 mV\nA0: -12 mV\nA0: 2 mV\n"),
+		"Unexpected output: %s", out->str);
+	g_string_free(out, TRUE);
+
+	/* Small values take the prefix of the packet's largest. */
+	out = analog_run(o, sdi, large, ARRAY_SIZE(large), SR_UNIT_VOLT, 3);
+	fail_unless(!strcmp(out->str, "A0: 12.500 V\nA0: 0.500 V\n"),
+		"Unexpected output: %s", out->str);
+	g_string_free(out, TRUE);
+
+	/* A single value gets its own prefix, like before. */
+	out = analog_run(o, sdi, &large[1], 1, SR_UNIT_VOLT, 3);
+	fail_unless(!strcmp(out->str, "A0: 500 mV\n"),
+		"Unexpected output: %s", out->str);
+	g_string_free(out, TRUE);
+
+	sr_output_free(o);
+}
+END_TEST
+
+Suite *suite_output_analog(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("output-analog");
+
+	tc = tcase_create("format");
+	tcase_add_test(tc, test_output_analog_digits);
+	tcase_add_test(tc, test_output_analog_prefix);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,247 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#define BENCH_SIZE	(1024 * 1024)
+#define BENCH_CHUNK	(64 * 1024)
+
+static const char *text_formats[] = { "csv", "bits", "hex", "ascii", };
+
+static struct sr_dev_inst *text_sdi(int num_channels)
+{
+	struct sr_dev_inst *sdi;
+	char name[8];
+	int i;
+
+	sdi = sr_dev_inst_user_new("Vendor", "Model", "Version");
+	fail_unless(sdi != NULL, "sr_dev_inst_user_new() failed.");
+	for (i = 0; i < num_channels; i++) {
+		snprintf(name, sizeof(name), "D%d", i);
+		sr_dev_inst_channel_add(sdi, i, SR_CHANNEL_LOGIC, name);
+	}
+
+	return sdi;
+}
+
+/*
+ * Run logic data through a text output module, in packets of the
+ * given sizes (in samples, zero terminated list). Returns all text.
+ */
+static GString *text_run(const char *id, const struct sr_dev_inst *sdi,
+	uint32_t width, const uint8_t *data, size_t unitsize,
+	const size_t *packet_sizes, unsigned int threads)
+{
+	const struct sr_output *o;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	GHashTable *params;
+	GString *text, *all;
+	int ret;
+
+	params = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify)g_variant_unref);
+	/* The csv header has a timestamp, suppress it. */
+	if (strcmp(id, "csv") == 0)
+		g_hash_table_insert(params, "header",
+			g_variant_ref_sink(g_variant_new_boolean(FALSE)));
+	else
+		g_hash_table_insert(params, "width",
+			g_variant_ref_sink(g_variant_new_uint32(width)));
+	o = sr_output_new(sr_output_find((char *)id), params, sdi, NULL);
+	g_hash_table_destroy(params);
+	fail_unless(o != NULL, "Couldn't create '%s' output.", id);
+	if (threads) {
+		ret = sr_output_threads_set(o, threads);
+		fail_unless(ret == SR_OK, "'%s' output has no threads.", id);
+	}
+
+	all = g_string_new(NULL);
+	logic.unitsize = unitsize;
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+	while (*packet_sizes) {
+		logic.length = *packet_sizes++ * unitsize;
+		logic.data = (void *)data;
+		data += logic.length;
+		ret = sr_output_send(o, &packet, &text);
+		fail_unless(ret == SR_OK, "'%s' output failed.", id);
+		if (text) {
+			g_string_append_len(all, text->str, text->len);
+			g_string_free(text, TRUE);
+		}
+	}
+	packet.type = SR_DF_END;
+	packet.payload = NULL;
+	ret = sr_output_send(o, &packet, &text);
+	fail_unless(ret == SR_OK, "'%s' output failed.", id);
+	if (text) {
+		g_string_append_len(all, text->str, text->len);
+		g_string_free(text, TRUE);
+	}
+	sr_output_free(o);
+
+	return all;
+}
+
+/* Check the text representation of known logic data. */
+START_TEST(test_output_text_values)
+{
+	static const struct {
+		const char *id;
+		const char *expected;
+	} tests[] = {
+		{ "csv", "1,0\n0,1\n1,1\n0,0\n1,0\n0,1\n" },
+		{ "bits", "D0:01010101 01010101\nD1:00110011 00110011\n" },
+		{ "hex", "D0:55 55 \nD1:33 33 \n" },
+		{ "ascii", "D0:./\\/\\/\\/\\/\\/\\/\\/\n"
+			"D1:../\"\\./\"\\./\"\\./\"\n" },
+	};
+	static const size_t packet_sizes[] = { 16, 0, };
+	struct sr_dev_inst *sdi;
+	uint8_t data[16];
+	GString *text;
+	size_t i;
+
+	sdi = text_sdi(2);
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		data[i] = i & 0x3;
+	for (i = 0; i < ARRAY_SIZE(tests); i++) {
+		text = text_run(tests[i].id, sdi, 16, data, 1, packet_sizes,
+			0);
+		fail_unless(strstr(text->str, tests[i].expected) != NULL,
+			"Unexpected '%s' output: %s", tests[i].id, text->str);
+		g_string_free(text, TRUE);
+	}
+}
+END_TEST
+
+/* Check that packet boundaries don't change the text output. */
+START_TEST(test_output_text_packets)
+{
+	static const size_t whole[] = { 100, 0, };
+	static const size_t split[] = { 1, 3, 7, 8, 9, 15, 17, 40, 0, };
+	struct sr_dev_inst *sdi;
+	uint8_t data[100 * 2];
+	GString *text_whole, *text_split;
+	size_t i;
+
+	sdi = text_sdi(12);
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		data[i] = g_random_int();
+	for (i = 0; i < ARRAY_SIZE(text_formats); i++) {
+		text_whole = text_run(text_formats[i], sdi, 20, data, 2, whole, 0);
+		text_split = text_run(text_formats[i], sdi, 20, data, 2, split, 0);
+		fail_unless(g_string_equal(text_whole, text_split),
+			"'%s' output depends on packet sizes.", text_formats[i]);
+		g_string_free(text_whole, TRUE);
+		g_string_free(text_split, TRUE);
+	}
+}
+END_TEST
+
+/* Check that formatting on several threads doesn't change the text. */
+START_TEST(test_output_text_threads)
+{
+	static const size_t packet_sizes[] = { 1000, 300001, 200000, 0, };
+	struct sr_dev_inst *sdi;
+	uint8_t *data;
+	GString *text_serial, *text_threads;
+	size_t i, size;
+
+	sdi = text_sdi(12);
+	size = 501001 * 2;
+	data = g_malloc(size);
+	for (i = 0; i < size; i++)
+		data[i] = g_random_int();
+	for (i = 0; i < ARRAY_SIZE(text_formats); i++) {
+		text_serial = text_run(text_formats[i], sdi, 64, data, 2,
+			packet_sizes, 0);
+		text_threads = text_run(text_formats[i], sdi, 64, data, 2,
+			packet_sizes, 4);
+		fail_unless(g_string_equal(text_serial, text_threads),
+			"'%s' output depends on threads.", text_formats[i]);
+		g_string_free(text_serial, TRUE);
+		g_string_free(text_threads, TRUE);
+	}
+	g_free(data);
+}
+END_TEST
+
+/* Measure text output throughput, in MB of logic data per second. */
+START_TEST(test_output_text_bench)
+{
+	size_t packet_sizes[BENCH_SIZE / BENCH_CHUNK + 1];
+	struct sr_dev_inst *sdi;
+	uint8_t *data;
+	GString *text;
+	gint64 start, elapsed;
+	size_t i;
+
+	sdi = text_sdi(8);
+	data = g_malloc(BENCH_SIZE);
+	for (i = 0; i < BENCH_SIZE; i++)
+		data[i] = g_random_int();
+	for (i = 0; i < BENCH_SIZE / BENCH_CHUNK; i++)
+		packet_sizes[i] = BENCH_CHUNK;
+	packet_sizes[i] = 0;
+
+	for (i = 0; i < ARRAY_SIZE(text_formats); i++) {
+		start = g_get_monotonic_time();
+		text = text_run(text_formats[i], sdi, 64, data, 1, packet_sizes,
+			0);
+		elapsed = MAX(g_get_monotonic_time() - start, 1);
+		fprintf(stderr, "output/%s: %.1f MB/s (%zu bytes of text)\n",
+			text_formats[i], (double)BENCH_SIZE / elapsed, text->len);
+		g_string_free(text, TRUE);
+	}
+	g_free(data);
+}
+END_TEST
+
+Suite *suite_output_text(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("output-text");
+
+	tc = tcase_create("logic");
+	tcase_add_test(tc, test_output_text_values);
+	tcase_add_test(tc, test_output_text_packets);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("threads");
+	tcase_set_timeout(tc, 60);
+	tcase_add_test(tc, test_output_text_threads);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("bench");
+	tcase_set_timeout(tc, 60);
+	tcase_add_test(tc, test_output_text_bench);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
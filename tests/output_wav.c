@@ -0,0 +1,285 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#define SAMPLERATE 48000
+
+static const int16_t samples[] = { 1000, -2000, 3000, -32768, 32766, };
+
+static uint64_t read_le(const uint8_t *p, size_t len)
+{
+	uint64_t value;
+
+	value = 0;
+	while (len--)
+		value = (value << 8) | p[len];
+
+	return value;
+}
+
+/*
+ * Run 16-bit signed samples of one analog channel through the WAV
+ * output, into a temporary file. The first packet has 'split' samples.
+ * When 'flush' is set, the header is written out to the file before
+ * the rest of the samples, so that the sizes have to be patched in
+ * the file. Returns the file's content.
+ */
+static GString *wav_run(const char *format, const char *sample_format,
+	double scale, size_t split, gboolean flush)
+{
+	const struct sr_output *o;
+	struct sr_output_sink *sink;
+	struct sr_dev_inst *sdi;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_meta meta;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	struct sr_config src;
+	GHashTable *params;
+	GString *contents;
+	uint8_t data[sizeof(samples)];
+	char buf[256];
+	FILE *file;
+	size_t i, len;
+	int ret;
+
+	sdi = sr_dev_inst_user_new("Vendor", "Model", "Version");
+	fail_unless(sdi != NULL, "sr_dev_inst_user_new() failed.");
+	sr_dev_inst_channel_add(sdi, 0, SR_CHANNEL_ANALOG, "A0");
+	file = tmpfile();
+	fail_unless(file != NULL, "Couldn't create temporary file.");
+	sink = sr_output_sink_new_file(file);
+	fail_unless(sink != NULL, "Couldn't create output sink.");
+
+	params = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify)g_variant_unref);
+	g_hash_table_insert(params, "format",
+		g_variant_ref_sink(g_variant_new_string(format)));
+	g_hash_table_insert(params, "samples",
+		g_variant_ref_sink(g_variant_new_string(sample_format)));
+	g_hash_table_insert(params, "scale",
+		g_variant_ref_sink(g_variant_new_double(scale)));
+	o = sr_output_new_sink(sr_output_find("wav"), params, sdi, NULL, sink);
+	g_hash_table_destroy(params);
+	fail_unless(o != NULL, "Couldn't create '%s' output.", format);
+
+	src.key = SR_CONF_SAMPLERATE;
+	src.data = g_variant_ref_sink(g_variant_new_uint64(SAMPLERATE));
+	meta.config = g_slist_append(NULL, &src);
+	packet.type = SR_DF_META;
+	packet.payload = &meta;
+	ret = sr_output_send(o, &packet, NULL);
+	fail_unless(ret == SR_OK, "Sending meta packet failed.");
+	g_slist_free(meta.config);
+	g_variant_unref(src.data);
+
+	for (i = 0; i < ARRAY_SIZE(samples); i++) {
+		data[2 * i] = samples[i] & 0xff;
+		data[2 * i + 1] = (samples[i] >> 8) & 0xff;
+	}
+	memset(&encoding, 0, sizeof(encoding));
+	encoding.unitsize = 2;
+	encoding.is_signed = TRUE;
+	sr_rational_set(&encoding.scale, 1, 1);
+	sr_rational_set(&encoding.offset, 0, 1);
+	memset(&meaning, 0, sizeof(meaning));
+	meaning.mq = SR_MQ_VOLTAGE;
+	meaning.unit = SR_UNIT_VOLT;
+	meaning.channels = sr_dev_inst_channels_get(sdi);
+	memset(&spec, 0, sizeof(spec));
+	analog.encoding = &encoding;
+	analog.meaning = &meaning;
+	analog.spec = &spec;
+	packet.type = SR_DF_ANALOG;
+	packet.payload = &analog;
+
+	analog.data = data;
+	analog.num_samples = split;
+	ret = sr_output_send(o, &packet, NULL);
+	fail_unless(ret == SR_OK, "Sending analog packet failed.");
+	if (flush) {
+		ret = sr_output_flush(o);
+		fail_unless(ret == SR_OK, "Flushing the output failed.");
+	}
+	analog.data = &data[2 * split];
+	analog.num_samples = ARRAY_SIZE(samples) - split;
+	ret = sr_output_send(o, &packet, NULL);
+	fail_unless(ret == SR_OK, "Sending analog packet failed.");
+	packet.type = SR_DF_END;
+	packet.payload = NULL;
+	ret = sr_output_send(o, &packet, NULL);
+	fail_unless(ret == SR_OK, "Sending end packet failed.");
+	sr_output_free(o);
+
+	contents = g_string_new(NULL);
+	rewind(file);
+	while ((len = fread(buf, 1, sizeof(buf), file)) > 0)
+		g_string_append_len(contents, buf, len);
+	fclose(file);
+
+	return contents;
+}
+
+/* Check the headers of all containers, and the sizes patched in at the end. */
+START_TEST(test_output_wav_containers)
+{
+	static const uint8_t w64_riff[] = {
+		'r', 'i', 'f', 'f', 0x2e, 0x91, 0xcf, 0x11,
+		0xa5, 0xd6, 0x28, 0xdb, 0x04, 0xc1, 0x00, 0x00,
+	};
+	static const uint8_t w64_data[] = {
+		'd', 'a', 't', 'a', 0xf3, 0xac, 0xd3, 0x11,
+		0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a,
+	};
+	/* 5 samples of 16 bits, W64 pads the data to 8 bytes. */
+	static const struct {
+		const char *format;
+		const char *magic;
+		size_t header_size, fmt_offset, pad;
+		struct {
+			size_t offset, len;
+			uint64_t value;
+		} sizes[4];
+	} tests[] = {
+		{ "wav", "RIFF", 46, 20, 0,
+			{ { 4, 4, 46 + 10 - 8 }, { 42, 4, 10 }, { 0, 0, 0 }, }, },
+		{ "rf64", "RF64", 82, 56, 0,
+			{ { 4, 4, 0xffffffff }, { 20, 8, 82 + 10 - 8 },
+			{ 28, 8, 10 }, { 36, 8, 5 }, }, },
+		{ "w64", NULL, 112, 64, 6,
+			{ { 16, 8, 112 + 10 + 6 }, { 104, 8, 24 + 10 },
+			{ 0, 0, 0 }, }, },
+	};
+	const uint8_t *p, *fmt;
+	GString *contents;
+	size_t i, j, split;
+
+	for (i = 0; i < ARRAY_SIZE(tests); i++) {
+		for (split = 1; split <= 3; split += 2) {
+			/* Patch the sizes in the sink's buffer, then in the file. */
+			contents = wav_run(tests[i].format, "native", 1.0, split,
+				split == 3);
+			p = (const uint8_t *)contents->str;
+			fail_unless(contents->len == tests[i].header_size + 10 +
+				tests[i].pad, "Unexpected '%s' file size %zu.",
+				tests[i].format, contents->len);
+			if (tests[i].magic) {
+				fail_unless(!memcmp(p, tests[i].magic, 4) &&
+					!memcmp(&p[8], "WAVE", 4),
+					"Bad '%s' header.", tests[i].format);
+				fail_unless(!memcmp(&p[tests[i].header_size - 8],
+					"data", 4), "Bad '%s' data chunk.",
+					tests[i].format);
+			} else {
+				fail_unless(!memcmp(p, w64_riff, 16),
+					"Bad W64 header.");
+				fail_unless(!memcmp(&p[tests[i].header_size - 24],
+					w64_data, 16), "Bad W64 data chunk.");
+			}
+			if (!strcmp(tests[i].format, "rf64"))
+				fail_unless(!memcmp(&p[12], "ds64", 4),
+					"No ds64 chunk.");
+
+			/* PCM, one channel, 16 bits per sample. */
+			fmt = &p[tests[i].fmt_offset];
+			fail_unless(read_le(&fmt[0], 2) == 1,
+				"'%s' samples are not PCM.", tests[i].format);
+			fail_unless(read_le(&fmt[2], 2) == 1 &&
+				read_le(&fmt[4], 4) == SAMPLERATE &&
+				read_le(&fmt[8], 4) == 2 * SAMPLERATE &&
+				read_le(&fmt[12], 2) == 2 &&
+				read_le(&fmt[14], 2) == 16,
+				"Bad '%s' fmt chunk.", tests[i].format);
+
+			for (j = 0; j < ARRAY_SIZE(tests[i].sizes); j++) {
+				if (!tests[i].sizes[j].len)
+					continue;
+				fail_unless(read_le(&p[tests[i].sizes[j].offset],
+					tests[i].sizes[j].len) == tests[i].sizes[j].value,
+					"Bad '%s' size at offset %zu.", tests[i].format,
+					tests[i].sizes[j].offset);
+			}
+
+			/* The native samples are stored as they are. */
+			p += tests[i].header_size;
+			for (j = 0; j < ARRAY_SIZE(samples); j++)
+				fail_unless((int16_t)read_le(&p[2 * j], 2) == samples[j],
+					"Bad '%s' sample %zu.", tests[i].format, j);
+			g_string_free(contents, TRUE);
+		}
+	}
+}
+END_TEST
+
+/* Check that the scale option applies to float and native samples. */
+START_TEST(test_output_wav_scale)
+{
+	const uint8_t *p;
+	GString *contents;
+	union {
+		uint32_t u;
+		float f;
+	} value;
+	size_t i;
+
+	contents = wav_run("wav", "native", 2.0, 2, FALSE);
+	fail_unless(contents->len == 46 + 10, "Unexpected file size.");
+	p = (const uint8_t *)contents->str + 46;
+	for (i = 0; i < ARRAY_SIZE(samples); i++)
+		fail_unless((int16_t)read_le(&p[2 * i], 2) == samples[i] / 2,
+			"Native sample %zu was not scaled.", i);
+	g_string_free(contents, TRUE);
+
+	contents = wav_run("wav", "float", 2.0, 2, FALSE);
+	fail_unless(contents->len == 46 + 20, "Unexpected file size.");
+	p = (const uint8_t *)contents->str;
+	fail_unless(read_le(&p[20], 2) == 3, "Samples are not float.");
+	p += 46;
+	for (i = 0; i < ARRAY_SIZE(samples); i++) {
+		value.u = read_le(&p[4 * i], 4);
+		fail_unless(value.f == samples[i] / 2.0f,
+			"Float sample %zu was not scaled.", i);
+	}
+	g_string_free(contents, TRUE);
+}
+END_TEST
+
+Suite *suite_output_wav(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("output-wav");
+
+	tc = tcase_create("containers");
+	tcase_add_test(tc, test_output_wav_containers);
+	tcase_add_test(tc, test_output_wav_scale);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
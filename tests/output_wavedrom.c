@@ -0,0 +1,197 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#define NUM_CHANNELS	12
+#define UNITSIZE	2
+
+/*
+ * Enough samples for a temporary file chunk of a 1 MiB limit to be
+ * copied back in several blocks, in packets which don't divide it
+ * evenly.
+ */
+#define NUM_SAMPLES	(200 * 1000)
+#define PACKET_SIZE	10007
+
+static struct sr_dev_inst *wavedrom_sdi(void)
+{
+	struct sr_dev_inst *sdi;
+	char name[8];
+	int i;
+
+	sdi = sr_dev_inst_user_new("Vendor", "Model", "Version");
+	fail_unless(sdi != NULL, "sr_dev_inst_user_new() failed.");
+	for (i = 0; i < NUM_CHANNELS; i++) {
+		snprintf(name, sizeof(name), "D%d", i);
+		sr_dev_inst_channel_add(sdi, i, SR_CHANNEL_LOGIC, name);
+	}
+
+	return sdi;
+}
+
+/* Random runs, which turn into wave text of mixed repetitions. */
+static uint8_t *wavedrom_data(void)
+{
+	uint8_t *data;
+	size_t i;
+
+	data = g_malloc(NUM_SAMPLES * UNITSIZE);
+	for (i = 0; i < NUM_SAMPLES * UNITSIZE; i++) {
+		if (i < UNITSIZE || g_random_int_range(0, 8) == 0)
+			data[i] = g_random_int();
+		else
+			data[i] = data[i - UNITSIZE];
+	}
+
+	return data;
+}
+
+/*
+ * Run logic data through the wavedrom output, with the given memory
+ * limit (in MiB). The text is either returned by sr_output_send(), or
+ * written to a temporary file through a sink. Returns all of the text.
+ */
+static GString *wavedrom_run(const struct sr_dev_inst *sdi,
+	const uint8_t *data, uint32_t memory, gboolean use_sink)
+{
+	const struct sr_output *o;
+	struct sr_output_sink *sink;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	GHashTable *params;
+	GString *text, *all;
+	char buf[4096];
+	FILE *file;
+	size_t offset, len;
+	int ret;
+
+	params = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify)g_variant_unref);
+	g_hash_table_insert(params, "memory",
+		g_variant_ref_sink(g_variant_new_uint32(memory)));
+	file = NULL;
+	if (use_sink) {
+		file = tmpfile();
+		fail_unless(file != NULL, "Couldn't create temporary file.");
+		sink = sr_output_sink_new_file(file);
+		fail_unless(sink != NULL, "Couldn't create output sink.");
+		o = sr_output_new_sink(sr_output_find("wavedrom"), params, sdi,
+			NULL, sink);
+	} else {
+		o = sr_output_new(sr_output_find("wavedrom"), params, sdi, NULL);
+	}
+	g_hash_table_destroy(params);
+	fail_unless(o != NULL, "Couldn't create 'wavedrom' output.");
+
+	all = g_string_new(NULL);
+	logic.unitsize = UNITSIZE;
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+	for (offset = 0; offset < NUM_SAMPLES; offset += len) {
+		len = MIN(NUM_SAMPLES - offset, PACKET_SIZE);
+		logic.data = (void *)&data[offset * UNITSIZE];
+		logic.length = len * UNITSIZE;
+		text = NULL;
+		ret = sr_output_send(o, &packet, &text);
+		fail_unless(ret == SR_OK, "Sending logic packet failed.");
+		fail_unless(!text, "Unexpected text before the end.");
+	}
+	packet.type = SR_DF_END;
+	packet.payload = NULL;
+	text = NULL;
+	ret = sr_output_send(o, &packet, &text);
+	fail_unless(ret == SR_OK, "Sending end packet failed.");
+	if (text) {
+		fail_unless(!use_sink, "Text was returned with a sink.");
+		g_string_append_len(all, text->str, text->len);
+		g_string_free(text, TRUE);
+	}
+	sr_output_free(o);
+
+	if (file) {
+		rewind(file);
+		while ((len = fread(buf, 1, sizeof(buf), file)) > 0)
+			g_string_append_len(all, buf, len);
+		fclose(file);
+	}
+
+	return all;
+}
+
+/*
+ * Check that moving wave text to a temporary file yields the same
+ * output as keeping it in memory, with and without a sink. A limit of
+ * 0 moves the text of every packet, 1 MiB moves larger chunks.
+ */
+START_TEST(test_output_wavedrom_memory)
+{
+	static const uint32_t limits[] = { 1, 0, };
+	struct sr_dev_inst *sdi;
+	GString *memory, *spilled;
+	uint8_t *data;
+	size_t i;
+	int sink;
+
+	sdi = wavedrom_sdi();
+	data = wavedrom_data();
+	memory = wavedrom_run(sdi, data, 64, FALSE);
+	fail_unless(memory->len > NUM_CHANNELS * NUM_SAMPLES,
+		"Unexpected output size %zu.", memory->len);
+	fail_unless(g_str_has_prefix(memory->str,
+		"{ \"signal\": [{ \"name\": \"D0\", \"wave\": \""),
+		"Unexpected output start.");
+
+	for (sink = 0; sink <= 1; sink++) {
+		spilled = wavedrom_run(sdi, data, 64, sink);
+		fail_unless(g_string_equal(memory, spilled),
+			"Output differs with a sink.");
+		g_string_free(spilled, TRUE);
+		for (i = 0; i < ARRAY_SIZE(limits); i++) {
+			spilled = wavedrom_run(sdi, data, limits[i], sink);
+			fail_unless(g_string_equal(memory, spilled),
+				"Output differs at %u MiB%s.", limits[i],
+				sink ? " with a sink" : "");
+			g_string_free(spilled, TRUE);
+		}
+	}
+
+	g_string_free(memory, TRUE);
+	g_free(data);
+}
+END_TEST
+
+Suite *suite_output_wavedrom(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("output-wavedrom");
+
+	tc = tcase_create("memory");
+	tcase_add_test(tc, test_output_wavedrom_memory);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
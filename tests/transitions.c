@@ -0,0 +1,229 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 sigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#define NUM_CHANNELS	12
+#define UNITSIZE	2
+#define NUM_SAMPLES	50000
+#define TRIGGER_POS	20000
+#define SAMPLERATE	SR_MHZ(1)
+
+struct collected {
+	GString *logic;
+	uint64_t samplerate;
+	uint64_t trigger_pos;
+	int triggers;
+	gboolean ended;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	struct collected *c;
+	const struct sr_datafeed_meta *meta;
+	const struct sr_datafeed_logic *logic;
+	const struct sr_config *src;
+	GSList *l;
+
+	(void)sdi;
+
+	c = cb_data;
+	switch (packet->type) {
+	case SR_DF_META:
+		meta = packet->payload;
+		for (l = meta->config; l; l = l->next) {
+			src = l->data;
+			if (src->key == SR_CONF_SAMPLERATE)
+				c->samplerate = g_variant_get_uint64(src->data);
+		}
+		break;
+	case SR_DF_TRIGGER:
+		c->triggers++;
+		c->trigger_pos = c->logic->len / UNITSIZE;
+		break;
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		fail_unless(logic->unitsize == UNITSIZE, "Unexpected unitsize.");
+		g_string_append_len(c->logic, logic->data, logic->length);
+		break;
+	case SR_DF_END:
+		c->ended = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Sparse activity: a channel toggles every few hundred samples. */
+static uint8_t *sparse_data(void)
+{
+	uint8_t *data;
+	uint16_t value;
+	size_t i;
+
+	data = g_malloc(NUM_SAMPLES * UNITSIZE);
+	value = 0;
+	for (i = 0; i < NUM_SAMPLES; i++) {
+		if (g_random_int_range(0, 300) == 0)
+			value ^= 1 << g_random_int_range(0, NUM_CHANNELS);
+		data[i * UNITSIZE + 0] = value & 0xff;
+		data[i * UNITSIZE + 1] = value >> 8;
+	}
+
+	return data;
+}
+
+static void export_packet(const struct sr_output *o, int type,
+	const void *payload, GString *all)
+{
+	struct sr_datafeed_packet packet;
+	GString *text;
+	int ret;
+
+	packet.type = type;
+	packet.payload = payload;
+	ret = sr_output_send(o, &packet, &text);
+	fail_unless(ret == SR_OK, "Output failed.");
+	if (text) {
+		g_string_append_len(all, text->str, text->len);
+		g_string_free(text, TRUE);
+	}
+}
+
+static GString *export_transitions(const uint8_t *data)
+{
+	static const size_t packet_sizes[] = { 1, 999, TRIGGER_POS - 1000,
+		NUM_SAMPLES - TRIGGER_POS, };
+	struct sr_dev_inst *sdi;
+	const struct sr_output *o;
+	struct sr_datafeed_logic logic;
+	struct sr_datafeed_meta meta;
+	struct sr_config src;
+	GString *all;
+	char name[8];
+	size_t i, pos;
+
+	sdi = sr_dev_inst_user_new("Vendor", "Model", "Version");
+	for (i = 0; i < NUM_CHANNELS; i++) {
+		snprintf(name, sizeof(name), "D%zu", i);
+		sr_dev_inst_channel_add(sdi, i, SR_CHANNEL_LOGIC, name);
+	}
+	o = sr_output_new(sr_output_find("transitions"), NULL, sdi, NULL);
+	fail_unless(o != NULL, "Couldn't create output instance.");
+	all = g_string_new(NULL);
+
+	src.key = SR_CONF_SAMPLERATE;
+	src.data = g_variant_new_uint64(SAMPLERATE);
+	meta.config = g_slist_append(NULL, &src);
+	export_packet(o, SR_DF_META, &meta, all);
+	g_slist_free(meta.config);
+	g_variant_unref(src.data);
+
+	logic.unitsize = UNITSIZE;
+	pos = 0;
+	for (i = 0; i < ARRAY_SIZE(packet_sizes); i++) {
+		if (pos == TRIGGER_POS)
+			export_packet(o, SR_DF_TRIGGER, NULL, all);
+		logic.length = packet_sizes[i] * UNITSIZE;
+		logic.data = (void *)&data[pos * UNITSIZE];
+		export_packet(o, SR_DF_LOGIC, &logic, all);
+		pos += packet_sizes[i];
+	}
+	export_packet(o, SR_DF_END, NULL, all);
+	sr_output_free(o);
+
+	return all;
+}
+
+/* Check that logic data, samplerate and triggers round-trip. */
+START_TEST(test_transitions_roundtrip)
+{
+	struct collected c;
+	const struct sr_input *in;
+	struct sr_session *session;
+	uint8_t *data;
+	GString *stream, *part;
+	size_t split;
+	int ret;
+
+	data = sparse_data();
+	stream = export_transitions(data);
+	fail_unless(stream->len < NUM_SAMPLES * UNITSIZE / 10,
+		"Transitions stream is not compact (%zu bytes).", stream->len);
+
+	/* Split the stream within the header, and within some record. */
+	for (split = 5; split < stream->len; split += stream->len / 3) {
+		memset(&c, 0, sizeof(c));
+		c.logic = g_string_new(NULL);
+
+		in = sr_input_new(sr_input_find("transitions"), NULL);
+		fail_unless(in != NULL, "Couldn't create input instance.");
+		sr_session_new(srtest_ctx, &session);
+		sr_session_datafeed_callback_add(session, datafeed_in, &c);
+
+		part = g_string_new_len(stream->str, split);
+		ret = srtest_input_send(in, session, part);
+		fail_unless(ret == SR_OK, "sr_input_send() error: %d", ret);
+		g_string_assign(part, "");
+		g_string_append_len(part, stream->str + split, stream->len - split);
+		ret = srtest_input_send(in, session, part);
+		fail_unless(ret == SR_OK, "sr_input_send() error: %d", ret);
+		ret = sr_input_end(in);
+		fail_unless(ret == SR_OK, "sr_input_end() error: %d", ret);
+		g_string_free(part, TRUE);
+
+		fail_unless(c.ended, "No end of data.");
+		fail_unless(c.samplerate == SAMPLERATE, "Samplerate mismatch.");
+		fail_unless(c.triggers == 1 && c.trigger_pos == TRIGGER_POS,
+			"Trigger mismatch.");
+		fail_unless(c.logic->len == NUM_SAMPLES * UNITSIZE,
+			"Sample count mismatch (%zu bytes).", c.logic->len);
+		fail_unless(!memcmp(c.logic->str, data, c.logic->len),
+			"Logic data mismatch.");
+
+		sr_input_free(in);
+		sr_session_destroy(session);
+		g_string_free(c.logic, TRUE);
+	}
+
+	g_string_free(stream, TRUE);
+	g_free(data);
+}
+END_TEST
+
+Suite *suite_transitions(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("transitions");
+
+	tc = tcase_create("roundtrip");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_transitions_roundtrip);
+	suite_add_tcase(s, tc);
+
+	return s;
+}